@@ -209,6 +209,10 @@ extern const char *(*MEM_name_ptr)(void *vmemh);
 /* Switch allocator to slower but fully guarded mode. */
 void MEM_use_guarded_allocator(void);
 
+/* Let each thread keep small freed blocks for reuse, instead of returning
+ * them to the system allocator (only affects the lock-free allocator). */
+void MEM_use_thread_cache(void);
+
 #ifdef __cplusplus
 /* alloc funcs for C++ only */
 #define MEM_CXX_CLASS_ALLOC_FUNCS(_id)                                        \
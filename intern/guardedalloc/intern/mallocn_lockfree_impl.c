@@ -24,6 +24,9 @@
 #include <string.h> /* memcpy */
 #include <stdarg.h>
 #include <sys/types.h>
+#ifndef WIN32
+#  include <pthread.h>
+#endif
 
 #include "MEM_guardedalloc.h"
 
@@ -43,8 +46,42 @@ typedef struct MemHeadAligned {
 	size_t len;
 } MemHeadAligned;
 
-static unsigned int totblock = 0;
-static size_t mem_in_use = 0, mmap_in_use = 0, peak_mem = 0;
+/* Memory statistics are sharded, every thread updates the counters of its own
+ * shard (on their own cache line), they are only summed when queried.
+ * Counters of a shard can be negative, when blocks are freed from another
+ * thread than the one which allocated them. */
+#define MEM_STATS_SHARDS 64
+
+/* Only changes of in-use memory bigger than this are reported to the global
+ * counter used for the peak memory, so the peak can be underestimated by at
+ * most MEM_STATS_SHARDS times this value. */
+#define MEM_STATS_REPORT_THRESHOLD ((int64_t)256 * 1024)
+
+#ifdef _MSC_VER
+#  define MEM_THREAD_LOCAL __declspec(thread)
+#  define MEM_ALIGN_CACHE_LINE __declspec(align(64))
+#else
+#  define MEM_THREAD_LOCAL __thread
+#  define MEM_ALIGN_CACHE_LINE __attribute__((aligned(64)))
+#endif
+
+typedef struct MemStatsShard {
+	int64_t totblock;
+	int64_t mem_in_use;
+	int64_t mmap_in_use;
+	/* Part of mem_in_use already added to mem_in_use_reported. */
+	int64_t mem_reported;
+	char _pad[64 - 4 * sizeof(int64_t)];
+} MemStatsShard;
+
+static MEM_ALIGN_CACHE_LINE MemStatsShard stats_shards[MEM_STATS_SHARDS];
+static unsigned int stats_shard_next = 0;
+static MEM_THREAD_LOCAL int stats_shard_index = -1;
+
+/* Approximation of the total memory in use, only used to track the peak. */
+static size_t mem_in_use_reported = 0;
+static size_t peak_mem = 0;
+
 static bool malloc_debug_memset = false;
 
 static void (*error_callback)(const char *) = NULL;
@@ -56,11 +93,16 @@ enum {
 	MEMHEAD_ALIGN_FLAG = 2,
 };
 
+/* Block allocated with the capacity of its size class, see thread cache below.
+ * Lengths are never that big, so the highest bit of the length is used. */
+#define MEMHEAD_CACHE_FLAG ((size_t)1 << (sizeof(size_t) * 8 - 1))
+
 #define MEMHEAD_FROM_PTR(ptr) (((MemHead*) ptr) - 1)
 #define PTR_FROM_MEMHEAD(memhead) (memhead + 1)
 #define MEMHEAD_ALIGNED_FROM_PTR(ptr) (((MemHeadAligned*) ptr) - 1)
 #define MEMHEAD_IS_MMAP(memhead) ((memhead)->len & (size_t) MEMHEAD_MMAP_FLAG)
 #define MEMHEAD_IS_ALIGNED(memhead) ((memhead)->len & (size_t) MEMHEAD_ALIGN_FLAG)
+#define MEMHEAD_IS_CACHED(memhead) ((memhead)->len & MEMHEAD_CACHE_FLAG)
 
 /* Uncomment this to have proper peak counter. */
 #define USE_ATOMIC_MAX
@@ -74,6 +116,148 @@ MEM_INLINE void update_maximum(size_t *maximum_value, size_t value)
 #endif
 }
 
+MEM_INLINE MemStatsShard *stats_shard_get(void)
+{
+	int index = stats_shard_index;
+	if (UNLIKELY(index == -1)) {
+		/* Spread threads over the shards in the order they first allocate. */
+		index = (int)(atomic_fetch_and_add_u(&stats_shard_next, 1) % MEM_STATS_SHARDS);
+		stats_shard_index = index;
+	}
+	return &stats_shards[index];
+}
+
+/* Propagate big enough changes of the shard's memory to the approximate total. */
+MEM_INLINE void stats_shard_report(MemStatsShard *shard, const int64_t mem_in_use)
+{
+	const int64_t mem_reported = shard->mem_reported;
+	const int64_t delta = mem_in_use - mem_reported;
+	if (UNLIKELY(delta > MEM_STATS_REPORT_THRESHOLD || delta < -MEM_STATS_REPORT_THRESHOLD)) {
+		if (atomic_cas_int64(&shard->mem_reported, mem_reported, mem_in_use) == mem_reported) {
+			/* Unsigned wrap-around also handles negative deltas. */
+			const size_t total = atomic_add_and_fetch_z(&mem_in_use_reported, (size_t)delta);
+			if (delta > 0) {
+				update_maximum(&peak_mem, total);
+			}
+		}
+	}
+}
+
+MEM_INLINE void stats_alloc(const size_t len, const bool is_mmap)
+{
+	MemStatsShard *shard = stats_shard_get();
+	atomic_add_and_fetch_int64(&shard->totblock, 1);
+	if (UNLIKELY(is_mmap)) {
+		atomic_add_and_fetch_int64(&shard->mmap_in_use, (int64_t)len);
+	}
+	stats_shard_report(shard, atomic_add_and_fetch_int64(&shard->mem_in_use, (int64_t)len));
+}
+
+MEM_INLINE void stats_free(const size_t len, const bool is_mmap)
+{
+	MemStatsShard *shard = stats_shard_get();
+	atomic_sub_and_fetch_int64(&shard->totblock, 1);
+	if (UNLIKELY(is_mmap)) {
+		atomic_sub_and_fetch_int64(&shard->mmap_in_use, (int64_t)len);
+	}
+	stats_shard_report(shard, atomic_sub_and_fetch_int64(&shard->mem_in_use, (int64_t)len));
+}
+
+/* Optional per-thread cache of small blocks, grouped in size classes.
+ *
+ * Blocks allocated while the cache is enabled get the capacity of their size
+ * class, and are kept in a free list of the thread freeing them for reuse,
+ * instead of going back to the system allocator. Statistics still count
+ * cached blocks as freed. */
+#define MEM_CACHE_CLASS_SIZE 16
+#define MEM_CACHE_CLASSES 16
+#define MEM_CACHE_MAX_LEN ((size_t)(MEM_CACHE_CLASS_SIZE * MEM_CACHE_CLASSES))
+/* Maximum number of blocks of each class kept by a thread. */
+#define MEM_CACHE_MAX_BLOCKS 64
+
+typedef struct MemThreadCache {
+	/* Single linked lists, stored in the first bytes of the blocks data. */
+	MemHead *blocks[MEM_CACHE_CLASSES];
+	unsigned int blocks_len[MEM_CACHE_CLASSES];
+	bool is_initialized;
+	/* Thread is exiting, blocks can't be cached anymore. */
+	bool is_freed;
+} MemThreadCache;
+
+static bool use_thread_cache = false;
+static MEM_THREAD_LOCAL MemThreadCache thread_cache;
+#ifndef WIN32
+static pthread_key_t thread_cache_key;
+#endif
+
+#define MEMHEAD_CACHE_NEXT(memhead) (*(MemHead **)PTR_FROM_MEMHEAD(memhead))
+
+MEM_INLINE unsigned int thread_cache_class(const size_t len)
+{
+	return (len != 0) ? (unsigned int)((len - 1) / MEM_CACHE_CLASS_SIZE) : 0;
+}
+
+#ifndef WIN32
+/* Called on thread exit. */
+static void thread_cache_free_all(void *cache_v)
+{
+	MemThreadCache *cache = cache_v;
+	for (int i = 0; i < MEM_CACHE_CLASSES; i++) {
+		MemHead *memh = cache->blocks[i];
+		while (memh) {
+			MemHead *memh_next = MEMHEAD_CACHE_NEXT(memh);
+			free(memh);
+			memh = memh_next;
+		}
+		cache->blocks[i] = NULL;
+		cache->blocks_len[i] = 0;
+	}
+	cache->is_freed = true;
+}
+#endif
+
+/* Returns a block with the capacity of the size class of len, its len is not set. */
+MEM_INLINE MemHead *thread_cache_alloc(const size_t len)
+{
+	const unsigned int class_index = thread_cache_class(len);
+	MemThreadCache *cache = &thread_cache;
+	MemHead *memh = cache->blocks[class_index];
+
+	if (memh != NULL) {
+		cache->blocks[class_index] = MEMHEAD_CACHE_NEXT(memh);
+		cache->blocks_len[class_index]--;
+		return memh;
+	}
+
+	if (UNLIKELY(!cache->is_initialized)) {
+		cache->is_initialized = true;
+#ifndef WIN32
+		/* Only so the cache gets released on thread exit. */
+		pthread_setspecific(thread_cache_key, cache);
+#endif
+	}
+
+	return (MemHead *)malloc((class_index + 1) * MEM_CACHE_CLASS_SIZE + sizeof(MemHead));
+}
+
+/* Returns false when the block could not be cached and has to be freed. */
+MEM_INLINE bool thread_cache_free(MemHead *memh, const size_t len)
+{
+	const unsigned int class_index = thread_cache_class(len);
+	MemThreadCache *cache = &thread_cache;
+
+	if (!cache->is_initialized || cache->is_freed ||
+	    cache->blocks_len[class_index] >= MEM_CACHE_MAX_BLOCKS)
+	{
+		return false;
+	}
+
+	MEMHEAD_CACHE_NEXT(memh) = cache->blocks[class_index];
+	cache->blocks[class_index] = memh;
+	cache->blocks_len[class_index]++;
+	return true;
+}
+
 #ifdef __GNUC__
 __attribute__ ((format(printf, 1, 2)))
 #endif
@@ -109,7 +293,7 @@ static void mem_unlock_thread(void)
 size_t MEM_lockfree_allocN_len(const void *vmemh)
 {
 	if (vmemh) {
-		return MEMHEAD_FROM_PTR(vmemh)->len & ~((size_t) (MEMHEAD_MMAP_FLAG | MEMHEAD_ALIGN_FLAG));
+		return MEMHEAD_FROM_PTR(vmemh)->len & ~((size_t) (MEMHEAD_MMAP_FLAG | MEMHEAD_ALIGN_FLAG) | MEMHEAD_CACHE_FLAG);
 	}
 	else {
 		return 0;
@@ -129,11 +313,9 @@ void MEM_lockfree_freeN(void *vmemh)
 		return;
 	}
 
-	atomic_sub_and_fetch_u(&totblock, 1);
-	atomic_sub_and_fetch_z(&mem_in_use, len);
+	stats_free(len, MEMHEAD_IS_MMAP(memh) != 0);
 
 	if (MEMHEAD_IS_MMAP(memh)) {
-		atomic_sub_and_fetch_z(&mmap_in_use, len);
 #if defined(WIN32)
 		/* our windows mmap implementation is not thread safe */
 		mem_lock_thread();
@@ -152,6 +334,9 @@ void MEM_lockfree_freeN(void *vmemh)
 			MemHeadAligned *memh_aligned = MEMHEAD_ALIGNED_FROM_PTR(vmemh);
 			aligned_free(MEMHEAD_REAL_PTR(memh_aligned));
 		}
+		else if (MEMHEAD_IS_CACHED(memh) && thread_cache_free(memh, len)) {
+			/* pass */
+		}
 		else {
 			free(memh);
 		}
@@ -271,18 +456,27 @@ void *MEM_lockfree_callocN(size_t len, const char *str)
 
 	len = SIZET_ALIGN_4(len);
 
-	memh = (MemHead *)calloc(1, len + sizeof(MemHead));
+	if (use_thread_cache && len <= MEM_CACHE_MAX_LEN) {
+		memh = thread_cache_alloc(len);
+		if (LIKELY(memh)) {
+			memset(memh + 1, 0, len);
+			memh->len = len | MEMHEAD_CACHE_FLAG;
+		}
+	}
+	else {
+		memh = (MemHead *)calloc(1, len + sizeof(MemHead));
+		if (LIKELY(memh)) {
+			memh->len = len;
+		}
+	}
 
 	if (LIKELY(memh)) {
-		memh->len = len;
-		atomic_add_and_fetch_u(&totblock, 1);
-		atomic_add_and_fetch_z(&mem_in_use, len);
-		update_maximum(&peak_mem, mem_in_use);
+		stats_alloc(len, false);
 
 		return PTR_FROM_MEMHEAD(memh);
 	}
 	print_error("Calloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
-	            SIZET_ARG(len), str, (unsigned int) mem_in_use);
+	            SIZET_ARG(len), str, (unsigned int) MEM_lockfree_get_memory_in_use());
 	return NULL;
 }
 
@@ -293,7 +487,7 @@ void *MEM_lockfree_calloc_arrayN(size_t len, size_t size, const char *str)
 		print_error("Calloc array aborted due to integer overflow: "
 		            "len=" SIZET_FORMAT "x" SIZET_FORMAT " in %s, total %u\n",
 		            SIZET_ARG(len), SIZET_ARG(size), str,
-		            (unsigned int) mem_in_use);
+		            (unsigned int) MEM_lockfree_get_memory_in_use());
 		abort();
 		return NULL;
 	}
@@ -307,22 +501,21 @@ void *MEM_lockfree_mallocN(size_t len, const char *str)
 
 	len = SIZET_ALIGN_4(len);
 
-	memh = (MemHead *)malloc(len + sizeof(MemHead));
+	const bool use_cache = use_thread_cache && len <= MEM_CACHE_MAX_LEN;
+	memh = use_cache ? thread_cache_alloc(len) : (MemHead *)malloc(len + sizeof(MemHead));
 
 	if (LIKELY(memh)) {
 		if (UNLIKELY(malloc_debug_memset && len)) {
 			memset(memh + 1, 255, len);
 		}
 
-		memh->len = len;
-		atomic_add_and_fetch_u(&totblock, 1);
-		atomic_add_and_fetch_z(&mem_in_use, len);
-		update_maximum(&peak_mem, mem_in_use);
+		memh->len = use_cache ? (len | MEMHEAD_CACHE_FLAG) : len;
+		stats_alloc(len, false);
 
 		return PTR_FROM_MEMHEAD(memh);
 	}
 	print_error("Malloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
-	            SIZET_ARG(len), str, (unsigned int) mem_in_use);
+	            SIZET_ARG(len), str, (unsigned int) MEM_lockfree_get_memory_in_use());
 	return NULL;
 }
 
@@ -333,7 +526,7 @@ void *MEM_lockfree_malloc_arrayN(size_t len, size_t size, const char *str)
 		print_error("Malloc array aborted due to integer overflow: "
 		            "len=" SIZET_FORMAT "x" SIZET_FORMAT " in %s, total %u\n",
 		            SIZET_ARG(len), SIZET_ARG(size), str,
-		            (unsigned int) mem_in_use);
+		            (unsigned int) MEM_lockfree_get_memory_in_use());
 		abort();
 		return NULL;
 	}
@@ -379,14 +572,12 @@ void *MEM_lockfree_mallocN_aligned(size_t len, size_t alignment, const char *str
 
 		memh->len = len | (size_t) MEMHEAD_ALIGN_FLAG;
 		memh->alignment = (short) alignment;
-		atomic_add_and_fetch_u(&totblock, 1);
-		atomic_add_and_fetch_z(&mem_in_use, len);
-		update_maximum(&peak_mem, mem_in_use);
+		stats_alloc(len, false);
 
 		return PTR_FROM_MEMHEAD(memh);
 	}
 	print_error("Malloc returns null: len=" SIZET_FORMAT " in %s, total %u\n",
-	            SIZET_ARG(len), str, (unsigned int) mem_in_use);
+	            SIZET_ARG(len), str, (unsigned int) MEM_lockfree_get_memory_in_use());
 	return NULL;
 }
 
@@ -414,18 +605,13 @@ void *MEM_lockfree_mapallocN(size_t len, const char *str)
 
 	if (memh != (MemHead *)-1) {
 		memh->len = len | (size_t) MEMHEAD_MMAP_FLAG;
-		atomic_add_and_fetch_u(&totblock, 1);
-		atomic_add_and_fetch_z(&mem_in_use, len);
-		atomic_add_and_fetch_z(&mmap_in_use, len);
-
-		update_maximum(&peak_mem, mem_in_use);
-		update_maximum(&peak_mem, mmap_in_use);
+		stats_alloc(len, true);
 
 		return PTR_FROM_MEMHEAD(memh);
 	}
 	print_error("Mapalloc returns null, fallback to regular malloc: "
 	            "len=" SIZET_FORMAT " in %s, total %u\n",
-	            SIZET_ARG(len), str, (unsigned int) mmap_in_use);
+	            SIZET_ARG(len), str, (unsigned int) MEM_lockfree_get_mapped_memory_in_use());
 	return MEM_lockfree_callocN(len, str);
 }
 
@@ -446,9 +632,9 @@ void MEM_lockfree_callbackmemlist(void (*func)(void *))
 void MEM_lockfree_printmemlist_stats(void)
 {
 	printf("\ntotal memory len: %.3f MB\n",
-	       (double)mem_in_use / (double)(1024 * 1024));
+	       (double)MEM_lockfree_get_memory_in_use() / (double)(1024 * 1024));
 	printf("peak memory len: %.3f MB\n",
-	       (double)peak_mem / (double)(1024 * 1024));
+	       (double)MEM_lockfree_get_peak_memory() / (double)(1024 * 1024));
 	printf("\nFor more detailed per-block statistics run Blender with memory debugging command line argument.\n");
 
 #ifdef HAVE_MALLOC_STATS
@@ -478,29 +664,59 @@ void MEM_lockfree_set_memory_debug(void)
 	malloc_debug_memset = true;
 }
 
+/**
+ * Enable the per-thread cache of small blocks, can't be disabled again.
+ *
+ * \note Not supported on Windows, where there is no simple way to release
+ * the blocks cached by a thread on its exit.
+ */
+void MEM_lockfree_use_thread_cache(void)
+{
+#ifndef WIN32
+	if (!use_thread_cache) {
+		pthread_key_create(&thread_cache_key, thread_cache_free_all);
+		use_thread_cache = true;
+	}
+#endif
+}
+
 size_t MEM_lockfree_get_memory_in_use(void)
 {
-	return mem_in_use;
+	int64_t mem_in_use = 0;
+	for (int i = 0; i < MEM_STATS_SHARDS; i++) {
+		mem_in_use += stats_shards[i].mem_in_use;
+	}
+	return (size_t)mem_in_use;
 }
 
 size_t MEM_lockfree_get_mapped_memory_in_use(void)
 {
-	return mmap_in_use;
+	int64_t mmap_in_use = 0;
+	for (int i = 0; i < MEM_STATS_SHARDS; i++) {
+		mmap_in_use += stats_shards[i].mmap_in_use;
+	}
+	return (size_t)mmap_in_use;
 }
 
 unsigned int MEM_lockfree_get_memory_blocks_in_use(void)
 {
-	return totblock;
+	int64_t totblock = 0;
+	for (int i = 0; i < MEM_STATS_SHARDS; i++) {
+		totblock += stats_shards[i].totblock;
+	}
+	return (unsigned int)totblock;
 }
 
 /* dummy */
 void MEM_lockfree_reset_peak_memory(void)
 {
-	peak_mem = mem_in_use;
+	peak_mem = MEM_lockfree_get_memory_in_use();
 }
 
 size_t MEM_lockfree_get_peak_memory(void)
 {
+	/* The peak is only tracked approximately on allocation, account for the exact current value. */
+	update_maximum(&peak_mem, MEM_lockfree_get_memory_in_use());
 	return peak_mem;
 }
 
@@ -682,6 +682,13 @@ class USERPREF_PT_system_memory(PreferencePanel, Panel):
 
         flow = layout.grid_flow(row_major=False, columns=0, even_columns=True, even_rows=False, align=False)
 
+        flow.prop(system, "playback_lookahead_frames", text="Playback Lookahead Frames")
+        flow.prop(system, "playback_lookahead_memory", text="Playback Lookahead Memory Limit")
+
+        layout.separator()
+
+        flow = layout.grid_flow(row_major=False, columns=0, even_columns=True, even_rows=False, align=False)
+
         flow.prop(system, "texture_time_out", text="Texture Time Out")
         flow.prop(system, "texture_collection_rate", text="Garbage Collection Rate")
 
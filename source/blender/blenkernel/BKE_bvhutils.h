@@ -188,6 +188,7 @@ bool     bvhcache_find(const BVHCache *cache, int type, BVHTree **r_tree);
 bool     bvhcache_has_tree(const BVHCache *cache, const BVHTree *tree);
 void     bvhcache_insert(BVHCache **cache_p, BVHTree *tree, int type);
 void     bvhcache_free(BVHCache **cache_p);
+void     bvhcache_tag_deformed(BVHCache **cache_p, const struct Mesh *mesh);
 
 
 #endif
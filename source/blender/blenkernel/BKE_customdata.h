@@ -67,6 +67,10 @@ typedef enum eCDAllocType {
 	CD_REFERENCE = 3,  /* use data pointers, set layer flag NOFREE */
 	CD_DUPLICATE = 4,  /* do a full copy of all layers, only allowed if source
 	                    * has same number of elements */
+	CD_UNINITIALIZED = 5,  /* allocate without clearing, every element will be written by the caller
+	                        * (types owning memory are still cleared) */
+	CD_SHARE     = 6,  /* share data of the source layers, copied once made writable with
+	                    * CustomData_duplicate_referenced_layer(), layers which can't be shared are duplicated */
 } eCDAllocType;
 
 #define CD_TYPE_AS_MASK(_type) (CustomDataMask)((CustomDataMask)1 << (CustomDataMask)(_type))
@@ -203,6 +207,8 @@ void *CustomData_duplicate_referenced_layer(struct CustomData *data, const int t
 void *CustomData_duplicate_referenced_layer_n(struct CustomData *data, const int type, const int n, const int totelem);
 void *CustomData_duplicate_referenced_layer_named(struct CustomData *data,
                                                   const int type, const char *name, const int totelem);
+/* same for all layers of the types in mask, also making shared layers writable (see CD_SHARE) */
+void CustomData_duplicate_referenced_layers(struct CustomData *data, CustomDataMask mask, const int totelem);
 bool CustomData_is_referenced_layer(struct CustomData *data, int type);
 
 /* set the CD_FLAG_NOCOPY flag in custom data layers where the mask is
@@ -152,6 +152,7 @@ enum {
 	G_DEBUG_IO =        (1 << 17),  /* IO Debugging (for Collada, ...)*/
 	G_DEBUG_GPU_SHADERS = (1 << 18),  /* GLSL shaders */
 	G_DEBUG_GPU_FORCE_WORKAROUNDS = (1 << 19),  /* force gpu workarounds bypassing detections. */
+	G_DEBUG_DEPSGRAPH_VALIDATE   = (1 << 20),  /* compare partial depsgraph rebuilds against full ones */
 };
 
 #define G_DEBUG_ALL \
@@ -181,11 +182,13 @@ enum {
 	/** On write, restore paths after editing them (G_FILE_RELATIVE_REMAP) */
 	G_FILE_SAVE_COPY         = (1 << 27),
 /* #define G_FILE_GLSL_NO_ENV_LIGHTING (1 << 28) */ /* deprecated */
+	/** On write, serialize data-blocks on multiple threads (the file is the same) */
+	G_FILE_SAVE_PARALLEL     = (1 << 29),
 };
 
 /** Don't overwrite these flags when reading a file. */
 #define G_FILE_FLAG_ALL_RUNTIME \
-	(G_FILE_NO_UI | G_FILE_RELATIVE_REMAP | G_FILE_SAVE_COPY)
+	(G_FILE_NO_UI | G_FILE_RELATIVE_REMAP | G_FILE_SAVE_COPY | G_FILE_SAVE_PARALLEL)
 
 /** ENDIAN_ORDER: indicates what endianness the platform where the file was written had. */
 #if !defined(__BIG_ENDIAN__) && !defined(__LITTLE_ENDIAN__)
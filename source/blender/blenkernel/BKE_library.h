@@ -96,6 +96,8 @@ enum {
 	LIB_ID_COPY_NO_ANIMDATA        = 1 << 19,
 	/* Mesh: Reference CD data layers instead of doing real copy - USE WITH CAUTION! */
 	LIB_ID_COPY_CD_REFERENCE       = 1 << 20,
+	/* Mesh: Share CD data layers with the source, they're copied when made writable. */
+	LIB_ID_COPY_CD_SHARE           = 1 << 21,
 
 	/* *** XXX Hackish/not-so-nice specific behaviors needed for some corner cases. *** */
 	/* *** Ideally we should not have those, but we need them for now... *** */
@@ -106,6 +106,7 @@ struct Mesh *BKE_mesh_add(struct Main *bmain, const char *name);
 void BKE_mesh_copy_data(struct Main *bmain, struct Mesh *me_dst, const struct Mesh *me_src, const int flag);
 struct Mesh *BKE_mesh_copy(struct Main *bmain, const struct Mesh *me);
 void BKE_mesh_update_customdata_pointers(struct Mesh *me, const bool do_ensure_tess_cd);
+void BKE_mesh_ensure_writable(struct Mesh *me, const struct CustomData_MeshMasks *mask);
 void BKE_mesh_ensure_skin_customdata(struct Mesh *me);
 
 struct Mesh *BKE_mesh_new_nomain(
@@ -115,6 +116,11 @@ struct Mesh *BKE_mesh_new_nomain_from_template(
         const struct Mesh *me_src,
         int verts_len, int edges_len, int tessface_len,
         int loops_len, int polys_len);
+struct Mesh *BKE_mesh_new_nomain_from_template_ex(
+        const struct Mesh *me_src,
+        int verts_len, int edges_len, int tessface_len,
+        int loops_len, int polys_len,
+        const bool fully_written);
 
 /* Performs copy for use during evaluation, optional referencing original arrays to reduce memory. */
 struct Mesh *BKE_mesh_copy_for_eval(struct Mesh *source, bool reference);
@@ -523,9 +529,11 @@ enum {
 };
 void BKE_mesh_batch_cache_dirty_tag(struct Mesh *me, int mode);
 void BKE_mesh_batch_cache_free(struct Mesh *me);
+size_t BKE_mesh_batch_cache_memory_get(struct Mesh *me);
 
 extern void (*BKE_mesh_batch_cache_dirty_tag_cb)(struct Mesh *me, int mode);
 extern void (*BKE_mesh_batch_cache_free_cb)(struct Mesh *me);
+extern size_t (*BKE_mesh_batch_cache_memory_get_cb)(struct Mesh *me);
 
 
 /* Inlines */
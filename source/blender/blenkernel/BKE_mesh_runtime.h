@@ -32,6 +32,7 @@ struct CustomData;
 struct CustomData_MeshMasks;
 struct Depsgraph;
 struct KeyBlock;
+struct LinkNode;
 struct MLoop;
 struct MLoopTri;
 struct MVertTri;
@@ -55,6 +56,8 @@ bool BKE_mesh_runtime_ensure_edit_data(struct Mesh *mesh);
 bool BKE_mesh_runtime_clear_edit_data(struct Mesh *mesh);
 void BKE_mesh_runtime_clear_geometry(struct Mesh *mesh);
 void BKE_mesh_runtime_clear_cache(struct Mesh *mesh);
+struct LinkNode *BKE_mesh_runtime_bvh_cache_take(struct Mesh *mesh);
+void BKE_mesh_runtime_bvh_cache_reuse(struct Mesh *mesh, struct LinkNode **bvh_cache_p);
 
 void BKE_mesh_runtime_verttri_from_looptri(
         struct MVertTri *r_verttri,
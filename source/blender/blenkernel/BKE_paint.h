@@ -281,6 +281,7 @@ void BKE_sculptsession_bm_to_me_for_render(struct Object *object);
 void BKE_sculpt_update_mesh_elements(
         struct Depsgraph *depsgraph, struct Scene *scene, struct Sculpt *sd, struct Object *ob,
         bool need_pmap, bool need_mask);
+void BKE_sculpt_mesh_ensure_writable(struct Object *ob);
 struct MultiresModifierData *BKE_sculpt_multires_active(struct Scene *scene, struct Object *ob);
 int BKE_sculpt_mask_layers_ensure(struct Object *ob,
                                   struct MultiresModifierData *mmd);
@@ -225,6 +225,7 @@ void BKE_pbvh_get_grid_updates(PBVH *bvh, bool clear, void ***r_gridfaces, int *
 void BKE_pbvh_grids_update(PBVH *bvh, struct CCGElem **grid_elems,
                            void **gridfaces,
                            struct DMFlagMat *flagmats, unsigned int **grid_hidden);
+void BKE_pbvh_mesh_verts_update(PBVH *bvh, struct MVert *verts);
 
 /* Layer displacement */
 
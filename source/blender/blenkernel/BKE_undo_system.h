@@ -74,6 +74,12 @@ typedef struct UndoStep {
 	bool use_memfile_step;
 	/** For use by undo systems that accumulate changes (text editor, painting). */
 	bool is_applied;
+	/** Statistics of the last encode & decode (only for debugging & profiling). */
+	struct {
+		double encode_time, decode_time;
+		/** Data-blocks read and reused from the current state when decoding (memfile only). */
+		int decode_ids_len, decode_ids_reused;
+	} stats;
 	/* Over alloc 'type->struct_size'. */
 } UndoStep;
 
@@ -2102,6 +2102,12 @@ static void mesh_build_data(
 	 * they aren't cleaned up properly on mode switch, causing crashes, e.g T58150. */
 	BLI_assert(ob->id.tag & LIB_TAG_COPIED_ON_WRITE);
 
+	/* When only the vertex positions change, BVH trees of the previous result are refit. */
+	struct LinkNode *bvh_cache_prev = NULL;
+	if (ob->runtime.mesh_eval != NULL) {
+		bvh_cache_prev = BKE_mesh_runtime_bvh_cache_take(ob->runtime.mesh_eval);
+	}
+
 	BKE_object_free_derived_caches(ob);
 	BKE_object_sculpt_modifiers_changed(ob);
 
@@ -2118,6 +2124,8 @@ static void mesh_build_data(
 	        depsgraph, scene, ob, NULL, 1, need_mapping, dataMask, -1, true, build_shapekey_layers,
 	        &ob->runtime.mesh_deform_eval, &ob->runtime.mesh_eval);
 
+	BKE_mesh_runtime_bvh_cache_reuse(ob->runtime.mesh_eval, &bvh_cache_prev);
+
 #ifdef USE_DERIVEDMESH
 	/* TODO(campbell): remove these copies, they are expected in various places over the code. */
 	ob->derivedDeform = CDDM_from_mesh_ex(ob->runtime.mesh_deform_eval, CD_REFERENCE, &CD_MASK_MESH);
@@ -1723,13 +1723,38 @@ static void animsys_write_orig_anim_rna(
 	}
 }
 
+typedef struct AnimsysSyncToOriginal {
+	PointerRNA ptr;
+	/* Path of the evaluated F-Curve. */
+	const char *rna_path;
+	int array_index;
+	float value;
+} AnimsysSyncToOriginal;
+
+static void animsys_sync_to_original_cb(Depsgraph *UNUSED(depsgraph), void *sync_v)
+{
+	AnimsysSyncToOriginal *sync = sync_v;
+	animsys_write_orig_anim_rna(&sync->ptr, sync->rna_path, sync->array_index, sync->value);
+}
+
+/* Write the evaluated value to the original datablock, for the interface. */
+static void animsys_sync_to_original(
+        Depsgraph *depsgraph,
+        PointerRNA *ptr,
+        const char *rna_path,
+        int array_index,
+        float value)
+{
+	AnimsysSyncToOriginal sync = {*ptr, rna_path, array_index, value};
+	DEG_sync_to_original(depsgraph, animsys_sync_to_original_cb, &sync, sizeof(sync));
+}
+
 /* Evaluate all the F-Curves in the given list
  * This performs a set of standard checks. If extra checks are required, separate code should be used
  */
 static void animsys_evaluate_fcurves(
         Depsgraph *depsgraph, PointerRNA *ptr, ListBase *list, float ctime)
 {
-	const bool is_active_depsgraph = DEG_is_active(depsgraph);
 	/* Calculate then execute each curve. */
 	for (FCurve *fcu = list->first; fcu; fcu = fcu->next) {
 		/* Check if this F-Curve doesn't belong to a muted group. */
@@ -1744,9 +1769,7 @@ static void animsys_evaluate_fcurves(
 		if (animsys_store_rna_setting(ptr, fcu->rna_path, fcu->array_index, &anim_rna)) {
 			const float curval = calculate_fcurve(&anim_rna, fcu, ctime);
 			animsys_write_rna_setting(&anim_rna, curval);
-			if (is_active_depsgraph) {
-				animsys_write_orig_anim_rna(ptr, fcu->rna_path, fcu->array_index, curval);
-			}
+			animsys_sync_to_original(depsgraph, ptr, fcu->rna_path, fcu->array_index, curval);
 		}
 	}
 }
@@ -3022,8 +3045,6 @@ void nladata_flush_channels(Depsgraph *depsgraph, PointerRNA *ptr, NlaEvalData *
 	if (channels == NULL)
 		return;
 
-	const bool is_active_depsgraph = DEG_is_active(depsgraph);
-
 	/* for each channel with accumulated values, write its value on the property it affects */
 	for (NlaEvalChannel *nec = channels->channels.first; nec; nec = nec->next) {
 		NlaEvalChannelSnapshot *nec_snapshot = nlaeval_snapshot_find_channel(snapshot, nec);
@@ -3037,9 +3058,7 @@ void nladata_flush_channels(Depsgraph *depsgraph, PointerRNA *ptr, NlaEvalData *
 					rna.prop_index = i;
 				}
 				animsys_write_rna_setting(&rna, value);
-				if (is_active_depsgraph) {
-					animsys_write_orig_anim_rna(ptr, nec->rna_path, rna.prop_index, value);
-				}
+				animsys_sync_to_original(depsgraph, ptr, nec->rna_path, rna.prop_index, value);
 			}
 		}
 	}
@@ -3722,6 +3741,42 @@ void BKE_animsys_update_driver_array(ID *id)
 	}
 }
 
+typedef struct DriverSyncToOriginal {
+	PointerRNA id_ptr;
+	FCurve *fcu;
+	ChannelDriver *driver_orig;
+	float curval;
+} DriverSyncToOriginal;
+
+static void driver_sync_to_original_cb(Depsgraph *UNUSED(depsgraph), void *sync_v)
+{
+	DriverSyncToOriginal *sync = sync_v;
+	FCurve *fcu = sync->fcu;
+	ChannelDriver *driver_orig = sync->driver_orig;
+
+	animsys_write_orig_anim_rna(&sync->id_ptr, fcu->rna_path, fcu->array_index, sync->curval);
+
+	/* curval is displayed in the UI, and flag contains error-status codes */
+	driver_orig->curval = fcu->driver->curval;
+	driver_orig->flag = fcu->driver->flag;
+
+	DriverVar *dvar_orig = driver_orig->variables.first;
+	DriverVar *dvar = fcu->driver->variables.first;
+	for (;
+	     dvar_orig && dvar;
+	     dvar_orig = dvar_orig->next, dvar = dvar->next)
+	{
+		DriverTarget *dtar_orig = &dvar_orig->targets[0];
+		DriverTarget *dtar = &dvar->targets[0];
+		for (int i = 0; i < MAX_DRIVER_TARGETS; i++, dtar_orig++, dtar++) {
+			dtar_orig->flag = dtar->flag;
+		}
+
+		dvar_orig->curval = dvar->curval;
+		dvar_orig->flag = dvar->flag;
+	}
+}
+
 void BKE_animsys_eval_driver(Depsgraph *depsgraph,
                              ID *id,
                              int driver_index,
@@ -3765,28 +3820,9 @@ void BKE_animsys_eval_driver(Depsgraph *depsgraph,
 				ok = animsys_write_rna_setting(&anim_rna, curval);
 
 				/* Flush results & status codes to original data for UI (T59984) */
-				if (ok && DEG_is_active(depsgraph)) {
-					animsys_write_orig_anim_rna(&id_ptr, fcu->rna_path, fcu->array_index, curval);
-
-					/* curval is displayed in the UI, and flag contains error-status codes */
-					driver_orig->curval = fcu->driver->curval;
-					driver_orig->flag = fcu->driver->flag;
-
-					DriverVar *dvar_orig = driver_orig->variables.first;
-					DriverVar *dvar = fcu->driver->variables.first;
-					for (;
-					     dvar_orig && dvar;
-					     dvar_orig = dvar_orig->next, dvar = dvar->next)
-					{
-						DriverTarget *dtar_orig = &dvar_orig->targets[0];
-						DriverTarget *dtar = &dvar->targets[0];
-						for (int i = 0; i < MAX_DRIVER_TARGETS; i++, dtar_orig++, dtar++) {
-							dtar_orig->flag = dtar->flag;
-						}
-
-						dvar_orig->curval = dvar->curval;
-						dvar_orig->flag = dvar->flag;
-					}
+				if (ok) {
+					DriverSyncToOriginal sync = {id_ptr, fcu, driver_orig, curval};
+					DEG_sync_to_original(depsgraph, driver_sync_to_original_cb, &sync, sizeof(sync));
 				}
 			}
 
@@ -3798,3 +3834,4 @@ void BKE_animsys_eval_driver(Depsgraph *depsgraph,
 		}
 	}
 }
+
@@ -694,6 +694,20 @@ void BKE_pose_constraints_evaluate(struct Depsgraph *depsgraph,
 	}
 }
 
+static void pose_bone_sync_to_original(struct Depsgraph *UNUSED(depsgraph), void *pchan_v)
+{
+	bPoseChannel *pchan = *(bPoseChannel **)pchan_v;
+	bPoseChannel *pchan_orig = pchan->orig_pchan;
+	copy_m4_m4(pchan_orig->pose_mat, pchan->pose_mat);
+	copy_m4_m4(pchan_orig->chan_mat, pchan->chan_mat);
+	copy_v3_v3(pchan_orig->pose_head, pchan->pose_mat[3]);
+	copy_m4_m4(pchan_orig->constinv, pchan->constinv);
+	BKE_pose_where_is_bone_tail(pchan_orig);
+	if (pchan->bone == NULL || pchan->bone->segments <= 1) {
+		BKE_pose_channel_free_bbone_cache(pchan_orig);
+	}
+}
+
 void BKE_pose_bone_done(struct Depsgraph *depsgraph,
                         struct Object *object,
                         int pchan_index)
@@ -711,19 +725,17 @@ void BKE_pose_bone_done(struct Depsgraph *depsgraph,
 		invert_m4_m4(imat, pchan->bone->arm_mat);
 		mul_m4_m4m4(pchan->chan_mat, pchan->pose_mat, imat);
 	}
-	if (DEG_is_active(depsgraph) && armature->edbo == NULL) {
-		bPoseChannel *pchan_orig = pchan->orig_pchan;
-		copy_m4_m4(pchan_orig->pose_mat, pchan->pose_mat);
-		copy_m4_m4(pchan_orig->chan_mat, pchan->chan_mat);
-		copy_v3_v3(pchan_orig->pose_head, pchan->pose_mat[3]);
-		copy_m4_m4(pchan_orig->constinv, pchan->constinv);
-		BKE_pose_where_is_bone_tail(pchan_orig);
-		if (pchan->bone == NULL || pchan->bone->segments <= 1) {
-			BKE_pose_channel_free_bbone_cache(pchan_orig);
-		}
+	if (armature->edbo == NULL) {
+		DEG_sync_to_original(depsgraph, pose_bone_sync_to_original, &pchan, sizeof(pchan));
 	}
 }
 
+static void pose_bbone_segments_sync_to_original(struct Depsgraph *UNUSED(depsgraph), void *pchan_v)
+{
+	bPoseChannel *pchan = *(bPoseChannel **)pchan_v;
+	BKE_pchan_bbone_segments_cache_copy(pchan->orig_pchan, pchan);
+}
+
 void BKE_pose_eval_bbone_segments(struct Depsgraph *depsgraph,
                                   struct Object *object,
                                   int pchan_index)
@@ -738,9 +750,7 @@ void BKE_pose_eval_bbone_segments(struct Depsgraph *depsgraph,
 	        "pchan", pchan->name, pchan);
 	if (pchan->bone != NULL && pchan->bone->segments > 1) {
 		BKE_pchan_bbone_segments_cache_compute(pchan);
-		if (DEG_is_active(depsgraph)) {
-			BKE_pchan_bbone_segments_cache_copy(pchan->orig_pchan, pchan);
-		}
+		DEG_sync_to_original(depsgraph, pose_bbone_segments_sync_to_original, &pchan, sizeof(pchan));
 	}
 }
 
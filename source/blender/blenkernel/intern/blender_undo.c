@@ -47,6 +47,7 @@
 #include "BKE_blendfile.h"
 #include "BKE_context.h"
 #include "BKE_global.h"
+#include "BKE_library.h"
 #include "BKE_main.h"
 
 #include "BLO_undofile.h"
@@ -123,6 +124,8 @@ MemFileUndoData *BKE_memfile_undo_encode(Main *bmain, MemFileUndoData *mfu_prev)
 		mfu->undo_size = mfu->memfile.size;
 	}
 
+	/* The next step is compared to this one. */
+	BKE_main_id_tag_all(bmain, LIB_TAG_UNDO_CHANGED, false);
 	bmain->is_memfile_undo_written = true;
 
 	return mfu;
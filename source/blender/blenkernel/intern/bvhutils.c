@@ -32,6 +32,7 @@
 #include "BLI_utildefines.h"
 #include "BLI_linklist.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "BKE_bvhutils.h"
@@ -43,6 +44,14 @@
 
 static ThreadRWMutex cache_rwlock = BLI_RWLOCK_INITIALIZER;
 
+typedef struct BVHCacheItem {
+	int type;
+	BVHTree *tree;
+
+	/* Vertex positions changed since the tree was built, see #bvhcache_tag_deformed. */
+	bool needs_refit;
+} BVHCacheItem;
+
 /* -------------------------------------------------------------------- */
 /** \name Local Callbacks
  * \{ */
@@ -1025,6 +1034,128 @@ BVHTree *bvhtree_from_mesh_looptri_ex(
 	return tree;
 }
 
+/* Refit of cached trees tagged by #bvhcache_tag_deformed. */
+
+typedef struct BVHRefitData {
+	BVHTree *tree;
+	const MVert *vert;
+	const MEdge *edge;
+	const MFace *face;
+	const MLoop *loop;
+	const MLoopTri *looptri;
+} BVHRefitData;
+
+static void bvhtree_refit_verts_cb(
+        void *__restrict userdata, const int i, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BVHRefitData *data = userdata;
+	BLI_bvhtree_update_node(data->tree, i, data->vert[i].co, NULL, 1);
+}
+
+static void bvhtree_refit_edges_cb(
+        void *__restrict userdata, const int i, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BVHRefitData *data = userdata;
+	float co[2][3];
+	copy_v3_v3(co[0], data->vert[data->edge[i].v1].co);
+	copy_v3_v3(co[1], data->vert[data->edge[i].v2].co);
+	BLI_bvhtree_update_node(data->tree, i, co[0], NULL, 2);
+}
+
+static void bvhtree_refit_faces_cb(
+        void *__restrict userdata, const int i, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BVHRefitData *data = userdata;
+	const MFace *face = &data->face[i];
+	float co[4][3];
+	copy_v3_v3(co[0], data->vert[face->v1].co);
+	copy_v3_v3(co[1], data->vert[face->v2].co);
+	copy_v3_v3(co[2], data->vert[face->v3].co);
+	if (face->v4) {
+		copy_v3_v3(co[3], data->vert[face->v4].co);
+	}
+	BLI_bvhtree_update_node(data->tree, i, co[0], NULL, face->v4 ? 4 : 3);
+}
+
+static void bvhtree_refit_looptri_cb(
+        void *__restrict userdata, const int i, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BVHRefitData *data = userdata;
+	const MLoopTri *lt = &data->looptri[i];
+	float co[3][3];
+	copy_v3_v3(co[0], data->vert[data->loop[lt->tri[0]].v].co);
+	copy_v3_v3(co[1], data->vert[data->loop[lt->tri[1]].v].co);
+	copy_v3_v3(co[2], data->vert[data->loop[lt->tri[2]].v].co);
+	BLI_bvhtree_update_node(data->tree, i, co[0], NULL, 3);
+}
+
+/**
+ * Update the leaves of a cached tree from the new vertex positions and refit its branches,
+ * this keeps the tree layout so it's much faster than building it again.
+ * The leaves are inserted in element order, so a leaf index is also its element index.
+ */
+static void bvhtree_from_mesh_refit(Mesh *mesh, BVHCacheItem *item)
+{
+	BVHRefitData data = {.tree = item->tree, .vert = mesh->mvert};
+	TaskParallelRangeFunc refit_cb = NULL;
+	int leaf_len = 0;
+
+	item->needs_refit = false;
+
+	if (item->tree == NULL) {
+		return;
+	}
+
+	switch (item->type) {
+		case BVHTREE_FROM_VERTS:
+			refit_cb = bvhtree_refit_verts_cb;
+			leaf_len = mesh->totvert;
+			break;
+		case BVHTREE_FROM_EDGES:
+			refit_cb = bvhtree_refit_edges_cb;
+			data.edge = mesh->medge;
+			leaf_len = mesh->totedge;
+			break;
+		case BVHTREE_FROM_FACES:
+			refit_cb = bvhtree_refit_faces_cb;
+			data.face = mesh->mface;
+			leaf_len = mesh->totface;
+			break;
+		case BVHTREE_FROM_LOOPTRI:
+			refit_cb = bvhtree_refit_looptri_cb;
+			data.loop = mesh->mloop;
+			data.looptri = BKE_mesh_runtime_looptri_ensure(mesh);
+			leaf_len = BKE_mesh_runtime_looptri_len(mesh);
+			break;
+		default:
+			BLI_assert(!"Only trees without a mask can be refit");
+			return;
+	}
+
+	BLI_assert(leaf_len == BLI_bvhtree_get_len(item->tree));
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (leaf_len > 1024);
+	BLI_task_parallel_range(0, leaf_len, &data, refit_cb, &settings);
+
+	BLI_bvhtree_update_tree(item->tree);
+}
+
+/* Call with the cache locked for writing, another thread may have refit the tree already. */
+static void bvhcache_refit_if_needed(Mesh *mesh, const int type)
+{
+	for (LinkNode *cache = mesh->runtime.bvh_cache; cache; cache = cache->next) {
+		BVHCacheItem *item = cache->link;
+		if (item->type == type) {
+			if (item->needs_refit) {
+				bvhtree_from_mesh_refit(mesh, item);
+			}
+			break;
+		}
+	}
+}
+
 static BLI_bitmap *loose_verts_map_get(
         const MEdge *medge, int edges_num,
         const MVert *UNUSED(mvert), int verts_num,
@@ -1082,11 +1213,22 @@ BVHTree *BKE_bvhtree_from_mesh_get(
         const int type, const int tree_type)
 {
 	struct BVHTreeFromMesh data_cp = {0};
+	bool needs_refit = false;
 
 	BLI_rw_mutex_lock(&cache_rwlock, THREAD_LOCK_READ);
 	data_cp.cached = bvhcache_find(mesh->runtime.bvh_cache, type, &data_cp.tree);
+	if (data_cp.cached) {
+		needs_refit = !bvhcache_has_tree(mesh->runtime.bvh_cache, data_cp.tree);
+	}
 	BLI_rw_mutex_unlock(&cache_rwlock);
 
+	/* Tree kept from an earlier evaluation of this deformed mesh. */
+	if (needs_refit) {
+		BLI_rw_mutex_lock(&cache_rwlock, THREAD_LOCK_WRITE);
+		bvhcache_refit_if_needed(mesh, type);
+		BLI_rw_mutex_unlock(&cache_rwlock);
+	}
+
 	if (data_cp.cached && data_cp.tree == NULL) {
 		memset(data, 0, sizeof(*data));
 		return data_cp.tree;
@@ -1301,12 +1443,6 @@ void free_bvhtree_from_mesh(struct BVHTreeFromMesh *data)
 /** \name BVHCache
  * \{ */
 
-typedef struct BVHCacheItem {
-	int type;
-	BVHTree *tree;
-
-} BVHCacheItem;
-
 /**
  * Queries a bvhcache for the cache bvhtree of the request type
  */
@@ -1323,12 +1459,16 @@ bool bvhcache_find(const BVHCache *cache, int type, BVHTree **r_tree)
 	return false;
 }
 
+/**
+ * Check the tree is still owned by the cache and up to date,
+ * trees waiting to be refit have to be queried again with #BKE_bvhtree_from_mesh_get.
+ */
 bool bvhcache_has_tree(const BVHCache *cache, const BVHTree *tree)
 {
 	while (cache) {
 		const BVHCacheItem *item = cache->link;
 		if (item->tree == tree) {
-			return true;
+			return !item->needs_refit;
 		}
 		cache = cache->next;
 	}
@@ -1352,6 +1492,7 @@ void bvhcache_insert(BVHCache **cache_p, BVHTree *tree, int type)
 
 	item->type = type;
 	item->tree = tree;
+	item->needs_refit = false;
 
 	BLI_linklist_prepend(cache_p, item);
 }
@@ -1374,4 +1515,54 @@ void bvhcache_free(BVHCache **cache_p)
 	*cache_p = NULL;
 }
 
+/**
+ * Number of leaves a tree of the given type has for \a mesh,
+ * -1 when the leaves depend on the topology and not just on the number of elements.
+ */
+static int bvhcache_mesh_leaf_len(const Mesh *mesh, const int type)
+{
+	switch (type) {
+		case BVHTREE_FROM_VERTS:
+			return mesh->totvert;
+		case BVHTREE_FROM_EDGES:
+			return mesh->totedge;
+		case BVHTREE_FROM_FACES:
+			return mesh->totface;
+		case BVHTREE_FROM_LOOPTRI:
+			return poly_to_tri_count(mesh->totpoly, mesh->totloop);
+		default:
+			return -1;
+	}
+}
+
+/**
+ * Prepare a cache built for an earlier evaluation of \a mesh, with the same topology
+ * but different vertex positions. Trees which still match the mesh elements are tagged
+ * to be refit on their next use by #BKE_bvhtree_from_mesh_get, the others are freed.
+ */
+void bvhcache_tag_deformed(BVHCache **cache_p, const Mesh *mesh)
+{
+	LinkNode *cache = *cache_p;
+	*cache_p = NULL;
+
+	while (cache) {
+		LinkNode *cache_next = cache->next;
+		BVHCacheItem *item = cache->link;
+		const int leaf_len = bvhcache_mesh_leaf_len(mesh, item->type);
+
+		if ((leaf_len != -1) &&
+		    (leaf_len == (item->tree ? BLI_bvhtree_get_len(item->tree) : 0)))
+		{
+			item->needs_refit = true;
+			cache->next = *cache_p;
+			*cache_p = cache;
+		}
+		else {
+			bvhcacheitem_free(item);
+			MEM_freeN(cache);
+		}
+		cache = cache_next;
+	}
+}
+
 /** \} */
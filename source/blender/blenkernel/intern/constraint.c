@@ -106,7 +106,7 @@ static CLG_LogRef LOG = {"bke.constraint"};
 static void damptrack_do_transform(float matrix[4][4], const float tarvec[3], int track_axis);
 
 static bConstraint *constraint_find_original(Object *ob, bPoseChannel *pchan, bConstraint *con, Object **r_orig_ob);
-static bConstraint *constraint_find_original_for_update(bConstraintOb *cob, bConstraint *con);
+static void constraint_sync_to_original(bConstraintOb *cob, bConstraint *con);
 
 /* -------------- Naming -------------- */
 
@@ -2820,13 +2820,7 @@ static void distlimit_evaluate(bConstraint *con, bConstraintOb *cob, ListBase *t
 			data->dist = dist;
 
 			/* Write the computed distance back to the master copy if in COW evaluation. */
-			bConstraint *orig_con = constraint_find_original_for_update(cob, con);
-
-			if (orig_con != NULL) {
-				bDistLimitConstraint *orig_data = orig_con->data;
-
-				orig_data->dist = data->dist;
-			}
+			constraint_sync_to_original(cob, con);
 		}
 
 		/* check if we're which way to clamp from, and calculate interpolation factor (if needed) */
@@ -2980,13 +2974,7 @@ static void stretchto_evaluate(bConstraint *con, bConstraintOb *cob, ListBase *t
 			data->orglength = dist;
 
 			/* Write the computed length back to the master copy if in COW evaluation. */
-			bConstraint *orig_con = constraint_find_original_for_update(cob, con);
-
-			if (orig_con != NULL) {
-				bStretchToConstraint *orig_data = orig_con->data;
-
-				orig_data->orglength = data->orglength;
-			}
+			constraint_sync_to_original(cob, con);
 		}
 
 		scale[1] = dist / data->orglength;
@@ -5142,21 +5130,49 @@ static bConstraint *constraint_find_original(Object *ob, bPoseChannel *pchan, bC
 	return NULL;
 }
 
-static bConstraint *constraint_find_original_for_update(bConstraintOb *cob, bConstraint *con)
-{
-	/* Write the computed distance back to the master copy if in COW evaluation. */
-	if (!DEG_is_active(cob->depsgraph)) {
-		return NULL;
-	}
+typedef struct ConstraintSyncToOriginal {
+	Object *ob;
+	bPoseChannel *pchan;
+	bConstraint *con;
+} ConstraintSyncToOriginal;
 
+static void constraint_sync_to_original_cb(struct Depsgraph *UNUSED(depsgraph), void *sync_v)
+{
+	const ConstraintSyncToOriginal *sync = sync_v;
+	bConstraint *con = sync->con;
 	Object *orig_ob = NULL;
-	bConstraint *orig_con = constraint_find_original(cob->ob, cob->pchan, con, &orig_ob);
+	bConstraint *orig_con = constraint_find_original(sync->ob, sync->pchan, con, &orig_ob);
 
-	if (orig_con != NULL) {
-		DEG_id_tag_update(&orig_ob->id, ID_RECALC_COPY_ON_WRITE | ID_RECALC_TRANSFORM);
+	if (orig_con == NULL) {
+		return;
 	}
 
-	return orig_con;
+	/* Values computed once during evaluation. */
+	switch (con->type) {
+		case CONSTRAINT_TYPE_DISTLIMIT:
+		{
+			bDistLimitConstraint *data = con->data, *orig_data = orig_con->data;
+			orig_data->dist = data->dist;
+			break;
+		}
+		case CONSTRAINT_TYPE_STRETCHTO:
+		{
+			bStretchToConstraint *data = con->data, *orig_data = orig_con->data;
+			orig_data->orglength = data->orglength;
+			break;
+		}
+		default:
+			BLI_assert(0);
+			break;
+	}
+
+	DEG_id_tag_update(&orig_ob->id, ID_RECALC_COPY_ON_WRITE | ID_RECALC_TRANSFORM);
+}
+
+static void constraint_sync_to_original(bConstraintOb *cob, bConstraint *con)
+{
+	ConstraintSyncToOriginal sync = {cob->ob, cob->pchan, con};
+	DEG_sync_to_original(cob->depsgraph, constraint_sync_to_original_cb, &sync, sizeof(sync));
 }
 
 /* -------- Constraints and Proxies ------- */
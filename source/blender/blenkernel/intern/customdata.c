@@ -36,6 +36,7 @@
 #include "BLI_string_utils.h"
 #include "BLI_math.h"
 #include "BLI_math_color_blend.h"
+#include "BLI_memory_utils.h"
 #include "BLI_mempool.h"
 
 #include "BLT_translation.h"
@@ -51,12 +52,18 @@
 
 #include "CLG_log.h"
 
+#include "atomic_ops.h"
+
 /* only for customdata_data_transfer_interp_normal_normals */
 #include "data_transfer_intern.h"
 
 /* number of layers to add when growing a CustomData object */
 #define CUSTOMDATA_GROW 5
 
+/* layers at least this large are advised to use huge pages,
+ * smaller ones would mostly waste the splitting of memory mappings */
+#define CUSTOMDATA_HUGE_PAGE_LAYER_SIZE (BLI_MEMORY_HUGE_PAGE_SIZE * 4)
+
 /* ensure typemap size is ok */
 BLI_STATIC_ASSERT(ARRAY_SIZE(((CustomData *)NULL)->typemap) == CD_NUMTYPES, "size mismatch");
 
@@ -1556,6 +1563,97 @@ static bool customdata_typemap_is_valid(const CustomData *data)
 }
 #endif
 
+/* -------------------------------------------------------------------- */
+/** \name Implicit Sharing
+ *
+ * Layers copied with #CD_SHARE use the data of their source layer, counting its users.
+ * All sharing layers are read-only, the data is copied by the first one being made writable
+ * and freed with the last user.
+ *
+ * Only layers of plain data are shared, so in-place changes of the data
+ * never affect memory owned by it.
+ * \{ */
+
+typedef struct CustomDataShared {
+	int users;
+} CustomDataShared;
+
+static bool customData_layer_can_share(const CustomDataLayer *layer)
+{
+	const LayerTypeInfo *typeInfo = layerType_getInfo(layer->type);
+
+	return ((layer->data != NULL) &&
+	        (layer->flag & CD_FLAG_NOFREE) == 0 &&
+	        (typeInfo->copy == NULL) &&
+	        (typeInfo->free == NULL));
+}
+
+/**
+ * Add a user to the data of \a layer, a source layer may be shared by concurrent copies.
+ */
+static CustomDataShared *customData_layer_share(CustomDataLayer *layer)
+{
+	CustomDataShared *shared = layer->shared;
+
+	if (shared == NULL) {
+		CustomDataShared *shared_new = MEM_mallocN(sizeof(*shared_new), __func__);
+		shared_new->users = 1;
+		shared = atomic_cas_ptr((void **)&layer->shared, NULL, shared_new);
+		if (shared == NULL) {
+			shared = shared_new;
+		}
+		else {
+			MEM_freeN(shared_new);
+		}
+	}
+
+	atomic_add_and_fetch_int32(&shared->users, 1);
+	return shared;
+}
+
+/**
+ * Remove a user, \return true when it was the last one, which owns the data now.
+ */
+static bool customData_shared_release(CustomDataShared *shared)
+{
+	if (atomic_sub_and_fetch_int32(&shared->users, 1) != 0) {
+		return false;
+	}
+	MEM_freeN(shared);
+	return true;
+}
+
+/**
+ * Make \a layer the only user of its data, so it can be modified.
+ *
+ * Other users might be released concurrently, the data is copied before this layer releases
+ * its user so it stays valid meanwhile. Nothing can add users here, since layers are only
+ * shared from data which is never written, so seeing a single user means there is no other.
+ */
+static void customData_layer_unshare(CustomDataLayer *layer, const int totelem)
+{
+	CustomDataShared *shared = layer->shared;
+	void *data_shared = layer->data;
+
+	if (shared == NULL) {
+		return;
+	}
+
+	if (shared->users > 1) {
+		const LayerTypeInfo *typeInfo = layerType_getInfo(layer->type);
+		layer->data = MEM_malloc_arrayN((size_t)totelem, typeInfo->size, layerType_getName(layer->type));
+		memcpy(layer->data, data_shared, (size_t)totelem * typeInfo->size);
+	}
+
+	if (customData_shared_release(shared) && (layer->data != data_shared)) {
+		/* Other users were freed meanwhile. */
+		MEM_freeN(data_shared);
+	}
+	layer->shared = NULL;
+}
+
+/** \} */
+
 bool CustomData_merge(
         const struct CustomData *source, struct CustomData *dest,
         CustomDataMask mask, eCDAllocType alloctype, int totelem)
@@ -1605,8 +1703,23 @@ bool CustomData_merge(
 		if ((alloctype == CD_ASSIGN) && (flag & CD_FLAG_NOFREE)) {
 			newlayer = customData_add_layer__internal(dest, type, CD_REFERENCE, data, totelem, layer->name);
 		}
+		else if (alloctype == CD_SHARE) {
+			if (customData_layer_can_share(layer)) {
+				newlayer = customData_add_layer__internal(dest, type, CD_ASSIGN, layer->data, totelem, layer->name);
+				if (newlayer && (newlayer->data == layer->data) && (newlayer->shared == NULL)) {
+					newlayer->shared = customData_layer_share((CustomDataLayer *)layer);
+				}
+			}
+			else {
+				newlayer = customData_add_layer__internal(dest, type, CD_DUPLICATE, layer->data, totelem, layer->name);
+			}
+		}
 		else {
 			newlayer = customData_add_layer__internal(dest, type, alloctype, data, totelem, layer->name);
+			if (newlayer && (alloctype == CD_ASSIGN)) {
+				/* Users of shared data move along with it. */
+				newlayer->shared = layer->shared;
+			}
 		}
 
 		if (newlayer) {
@@ -1636,6 +1749,9 @@ void CustomData_realloc(CustomData *data, int totelem)
 			continue;
 		}
 		typeInfo = layerType_getInfo(layer->type);
+		if (layer->shared) {
+			customData_layer_unshare(layer, (int)(MEM_allocN_len(layer->data) / (size_t)typeInfo->size));
+		}
 		layer->data = MEM_reallocN(layer->data, (size_t)totelem * typeInfo->size);
 	}
 }
@@ -1656,6 +1772,15 @@ static void customData_free_layer__internal(CustomDataLayer *layer, int totelem)
 {
 	const LayerTypeInfo *typeInfo;
 
+	if (layer->shared) {
+		CustomDataShared *shared = layer->shared;
+		layer->shared = NULL;
+		if (!customData_shared_release(shared)) {
+			/* Still used by other layers. */
+			return;
+		}
+	}
+
 	if (!(layer->flag & CD_FLAG_NOFREE) && layer->data) {
 		typeInfo = layerType_getInfo(layer->type);
 
@@ -1952,6 +2077,21 @@ static int customData_resize(CustomData *data, int amount)
 	return 1;
 }
 
+static void *customData_layer_alloc(
+        const LayerTypeInfo *typeInfo, int totelem, const bool clear, const char *name)
+{
+	void *layerdata = clear ?
+	        MEM_calloc_arrayN((size_t)totelem, typeInfo->size, name) :
+	        MEM_malloc_arrayN((size_t)totelem, typeInfo->size, name);
+
+	if (layerdata && (size_t)totelem * (size_t)typeInfo->size >= CUSTOMDATA_HUGE_PAGE_LAYER_SIZE) {
+		/* Pages of calloc'd memory are only mapped once written too. */
+		BLI_memory_advise_huge_pages(layerdata, (size_t)totelem * (size_t)typeInfo->size);
+	}
+
+	return layerdata;
+}
+
 static CustomDataLayer *customData_add_layer__internal(
         CustomData *data, int type, eCDAllocType alloctype, void *layerdata,
         int totelem, const char *name)
@@ -1974,12 +2114,10 @@ static CustomDataLayer *customData_add_layer__internal(
 		newlayerdata = layerdata;
 	}
 	else if (totelem > 0 && typeInfo->size > 0) {
-		if (alloctype == CD_DUPLICATE && layerdata) {
-			newlayerdata = MEM_malloc_arrayN((size_t)totelem, typeInfo->size, layerType_getName(type));
-		}
-		else {
-			newlayerdata = MEM_calloc_arrayN((size_t)totelem, typeInfo->size, layerType_getName(type));
-		}
+		/* Types owning memory are always cleared, so freeing a layer that isn't written yet is safe. */
+		const bool clear = !((alloctype == CD_DUPLICATE && layerdata) ||
+		                     (alloctype == CD_UNINITIALIZED && typeInfo->free == NULL));
+		newlayerdata = customData_layer_alloc(typeInfo, totelem, clear, layerType_getName(type));
 
 		if (!newlayerdata)
 			return NULL;
@@ -2015,6 +2153,7 @@ static CustomDataLayer *customData_add_layer__internal(
 	data->layers[index].type = type;
 	data->layers[index].flag = flag;
 	data->layers[index].data = newlayerdata;
+	data->layers[index].shared = NULL;
 
 	/* Set default name if none exists. Note we only call DATA_()  once
 	 * we know there is a default name, to avoid overhead of locale lookups
@@ -2199,6 +2338,9 @@ static void *customData_duplicate_referenced_layer_index(CustomData *data, const
 
 		layer->flag &= ~CD_FLAG_NOFREE;
 	}
+	else if (layer->shared) {
+		customData_layer_unshare(layer, totelem);
+	}
 
 	return layer->data;
 }
@@ -2233,6 +2375,19 @@ void *CustomData_duplicate_referenced_layer_named(CustomData *data, const int ty
 	return customData_duplicate_referenced_layer_index(data, layer_index, totelem);
 }
 
+void CustomData_duplicate_referenced_layers(CustomData *data, CustomDataMask mask, const int totelem)
+{
+	for (int i = 0; i < data->totlayer; i++) {
+		const CustomDataLayer *layer = &data->layers[i];
+
+		if ((mask & CD_TYPE_AS_MASK(layer->type)) &&
+		    ((layer->flag & CD_FLAG_NOFREE) || layer->shared))
+		{
+			customData_duplicate_referenced_layer_index(data, i, totelem);
+		}
+	}
+}
+
 bool CustomData_is_referenced_layer(struct CustomData *data, int type)
 {
 	CustomDataLayer *layer;
@@ -2245,7 +2400,7 @@ bool CustomData_is_referenced_layer(struct CustomData *data, int type)
 
 	layer = &data->layers[layer_index];
 
-	return (layer->flag & CD_FLAG_NOFREE) != 0;
+	return (layer->flag & CD_FLAG_NOFREE) != 0 || (layer->shared && layer->shared->users > 1);
 }
 
 void CustomData_free_temporary(CustomData *data, int totelem)
@@ -2626,6 +2781,17 @@ const char *CustomData_get_layer_name(const CustomData *data, int type, int n)
 	return (layer_index == -1) ? NULL : data->layers[layer_index].name;
 }
 
+static void customData_layer_set_data(CustomDataLayer *layer, void *ptr)
+{
+	/* Previous data can only be taken over by the caller when not shared,
+	 * see #CustomData_duplicate_referenced_layer. */
+	if (layer->shared) {
+		customData_shared_release(layer->shared);
+		layer->shared = NULL;
+	}
+	layer->data = ptr;
+}
+
 void *CustomData_set_layer(const CustomData *data, int type, void *ptr)
 {
 	/* get the layer index of the first layer of type */
@@ -2633,7 +2799,7 @@ void *CustomData_set_layer(const CustomData *data, int type, void *ptr)
 
 	if (layer_index == -1) return NULL;
 
-	data->layers[layer_index].data = ptr;
+	customData_layer_set_data(&data->layers[layer_index], ptr);
 
 	return ptr;
 }
@@ -2644,7 +2810,7 @@ void *CustomData_set_layer_n(const struct CustomData *data, int type, int n, voi
 	int layer_index = CustomData_get_layer_index_n(data, type, n);
 	if (layer_index == -1) return NULL;
 
-	data->layers[layer_index].data = ptr;
+	customData_layer_set_data(&data->layers[layer_index], ptr);
 
 	return ptr;
 }
@@ -3494,7 +3660,8 @@ void CustomData_file_write_prepare(
 				}
 				write_layers_size += chunk_size;
 			}
-			write_layers[j++] = *layer;
+			write_layers[j] = *layer;
+			write_layers[j++].shared = NULL;
 		}
 	}
 	BLI_assert(j == data->totlayer);
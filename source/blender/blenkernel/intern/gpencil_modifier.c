@@ -500,6 +500,17 @@ int BKE_gpencil_time_modifier(Depsgraph *depsgraph, Scene *scene, Object *ob,
 }
 /* *************************************************** */
 
+static void gpencil_sync_to_original(Depsgraph *depsgraph, void *gpd_v)
+{
+	bGPdata *gpd = *(bGPdata **)gpd_v;
+	bGPdata *gpd_orig = (bGPdata *)DEG_get_original_id(&gpd->id);
+	int ctime = (int)DEG_get_ctime(depsgraph);
+
+	for (bGPDlayer *gpl = gpd_orig->layers.first; gpl; gpl = gpl->next) {
+		gpl->actframe = BKE_gpencil_layer_getframe(gpl, ctime, GP_GETFRAME_USE_PREV);
+	}
+}
+
 void BKE_gpencil_eval_geometry(Depsgraph *depsgraph,
 	bGPdata *gpd)
 {
@@ -519,17 +530,11 @@ void BKE_gpencil_eval_geometry(Depsgraph *depsgraph,
 	 * later when there's more happening here. For now, let's just keep this in here to avoid
 	 * needing to have one more node slowing down evaluation...
 	 */
-	if (DEG_is_active(depsgraph)) {
-		bGPdata *gpd_orig = (bGPdata *)DEG_get_original_id(&gpd->id);
-
-		/* sync "actframe" changes back to main-db too,
-		 * so that editing tools work with copy-on-write
-		 * when the current frame changes
-		 */
-		for (bGPDlayer *gpl = gpd_orig->layers.first; gpl; gpl = gpl->next) {
-			gpl->actframe = BKE_gpencil_layer_getframe(gpl, ctime, GP_GETFRAME_USE_PREV);
-		}
-	}
+	/* sync "actframe" changes back to main-db too,
+	 * so that editing tools work with copy-on-write
+	 * when the current frame changes
+	 */
+	DEG_sync_to_original(depsgraph, gpencil_sync_to_original, &gpd, sizeof(gpd));
 }
 
 void BKE_gpencil_modifier_init(void)
@@ -446,6 +446,23 @@ void BKE_mesh_update_customdata_pointers(Mesh *me, const bool do_ensure_tess_cd)
 	me->mloopuv = CustomData_get_layer(&me->ldata, CD_MLOOPUV);
 }
 
+/**
+ * Make the layers of types in \a mask writable before editing them in place,
+ * they might be shared with evaluated copies (see #LIB_ID_COPY_CD_SHARE).
+ *
+ * \note Pointers to the previous data of these layers are invalid afterwards.
+ */
+void BKE_mesh_ensure_writable(Mesh *me, const CustomData_MeshMasks *mask)
+{
+	CustomData_duplicate_referenced_layers(&me->vdata, mask->vmask, me->totvert);
+	CustomData_duplicate_referenced_layers(&me->edata, mask->emask, me->totedge);
+	CustomData_duplicate_referenced_layers(&me->fdata, mask->fmask, me->totface);
+	CustomData_duplicate_referenced_layers(&me->pdata, mask->pmask, me->totpoly);
+	CustomData_duplicate_referenced_layers(&me->ldata, mask->lmask, me->totloop);
+
+	BKE_mesh_update_customdata_pointers(me, false);
+}
+
 bool BKE_mesh_has_custom_loop_normals(Mesh *me)
 {
 	if (me->edit_mesh) {
@@ -544,7 +561,9 @@ void BKE_mesh_copy_data(Main *bmain, Mesh *me_dst, const Mesh *me_src, const int
 
 	me_dst->mat = MEM_dupallocN(me_src->mat);
 
-	const eCDAllocType alloc_type = (flag & LIB_ID_COPY_CD_REFERENCE) ? CD_REFERENCE : CD_DUPLICATE;
+	const eCDAllocType alloc_type = (
+	        (flag & LIB_ID_COPY_CD_REFERENCE) ? CD_REFERENCE :
+	        (flag & LIB_ID_COPY_CD_SHARE) ? CD_SHARE : CD_DUPLICATE);
 	CustomData_copy(&me_src->vdata, &me_dst->vdata, mask.vmask, alloc_type, me_dst->totvert);
 	CustomData_copy(&me_src->edata, &me_dst->edata, mask.emask, alloc_type, me_dst->totedge);
 	CustomData_copy(&me_src->ldata, &me_dst->ldata, mask.lmask, alloc_type, me_dst->totloop);
@@ -629,7 +648,7 @@ static Mesh *mesh_new_nomain_from_template_ex(
         const Mesh *me_src,
         int verts_len, int edges_len, int tessface_len,
         int loops_len, int polys_len,
-        CustomData_MeshMasks mask)
+        CustomData_MeshMasks mask, eCDAllocType alloctype)
 {
 	/* Only do tessface if we are creating tessfaces or copying from mesh with only tessfaces. */
 	const bool do_tessface = (tessface_len ||
@@ -648,12 +667,12 @@ static Mesh *mesh_new_nomain_from_template_ex(
 
 	me_dst->cd_flag = me_src->cd_flag;
 
-	CustomData_copy(&me_src->vdata, &me_dst->vdata, mask.vmask, CD_CALLOC, verts_len);
-	CustomData_copy(&me_src->edata, &me_dst->edata, mask.emask, CD_CALLOC, edges_len);
-	CustomData_copy(&me_src->ldata, &me_dst->ldata, mask.lmask, CD_CALLOC, loops_len);
-	CustomData_copy(&me_src->pdata, &me_dst->pdata, mask.pmask, CD_CALLOC, polys_len);
+	CustomData_copy(&me_src->vdata, &me_dst->vdata, mask.vmask, alloctype, verts_len);
+	CustomData_copy(&me_src->edata, &me_dst->edata, mask.emask, alloctype, edges_len);
+	CustomData_copy(&me_src->ldata, &me_dst->ldata, mask.lmask, alloctype, loops_len);
+	CustomData_copy(&me_src->pdata, &me_dst->pdata, mask.pmask, alloctype, polys_len);
 	if (do_tessface) {
-		CustomData_copy(&me_src->fdata, &me_dst->fdata, mask.fmask, CD_CALLOC, tessface_len);
+		CustomData_copy(&me_src->fdata, &me_dst->fdata, mask.fmask, alloctype, tessface_len);
 	}
 	else {
 		mesh_tessface_clear_intern(me_dst, false);
@@ -677,7 +696,25 @@ Mesh *BKE_mesh_new_nomain_from_template(
 	        me_src,
 	        verts_len, edges_len, tessface_len,
 	        loops_len, polys_len,
-	        CD_MASK_EVERYTHING);
+	        CD_MASK_EVERYTHING, CD_CALLOC);
+}
+
+/**
+ * Same as #BKE_mesh_new_nomain_from_template,
+ * \param fully_written: The caller writes every element of the layers copied from \a me_src,
+ * so their memory doesn't need to be cleared first.
+ */
+Mesh *BKE_mesh_new_nomain_from_template_ex(
+        const Mesh *me_src,
+        int verts_len, int edges_len, int tessface_len,
+        int loops_len, int polys_len,
+        const bool fully_written)
+{
+	return mesh_new_nomain_from_template_ex(
+	        me_src,
+	        verts_len, edges_len, tessface_len,
+	        loops_len, polys_len,
+	        CD_MASK_EVERYTHING, fully_written ? CD_UNINITIALIZED : CD_CALLOC);
 }
 
 Mesh *BKE_mesh_copy_for_eval(struct Mesh *source, bool reference)
@@ -1295,8 +1332,14 @@ bool BKE_mesh_minmax(const Mesh *me, float r_min[3], float r_max[3])
 void BKE_mesh_transform(Mesh *me, float mat[4][4], bool do_keys)
 {
 	int i;
-	MVert *mvert = me->mvert;
-	float (*lnors)[3] = CustomData_get_layer(&me->ldata, CD_NORMAL);
+	MVert *mvert;
+	float (*lnors)[3];
+	const CustomData_MeshMasks mask = {.vmask = CD_MASK_MVERT, .lmask = CD_MASK_NORMAL};
+
+	/* Layers might be shared with evaluated copies. */
+	BKE_mesh_ensure_writable(me, &mask);
+	mvert = me->mvert;
+	lnors = CustomData_get_layer(&me->ldata, CD_NORMAL);
 
 	for (i = 0; i < me->totvert; i++, mvert++)
 		mul_m4_v3(mat, mvert->co);
@@ -1328,6 +1371,10 @@ void BKE_mesh_translate(Mesh *me, const float offset[3], const bool do_keys)
 {
 	int i = me->totvert;
 	MVert *mvert;
+	const CustomData_MeshMasks mask = {.vmask = CD_MASK_MVERT};
+
+	/* Vertices might be shared with evaluated copies. */
+	BKE_mesh_ensure_writable(me, &mask);
 	for (mvert = me->mvert; i--; mvert++) {
 		add_v3_v3(mvert->co, offset);
 	}
@@ -2955,147 +2955,207 @@ int BKE_mesh_recalc_tessellation(
 
 }
 
+/* Number of polygons tessellated before threading is used. */
+#define MESH_LOOPTRI_THREADED_LIMIT 1024
+
 /**
- * Calculate tessellation into #MLoopTri which exist only for this purpose.
+ * Tessellate a single polygon into \a mlt, which has room for `mp->totloop - 2` triangles.
+ *
+ * \param pf_arena_p: Arena used by n-gons, created on first use and cleared before returning.
  */
-void BKE_mesh_recalc_looptri(
-        const MLoop *mloop, const MPoly *mpoly,
-        const MVert *mvert,
-        int totloop, int totpoly,
-        MLoopTri *mlooptri)
+static void mesh_recalc_looptri_poly(
+        const MLoop *mloop, const MPoly *mp, const MVert *mvert,
+        const unsigned int poly_index, MLoopTri *mlt,
+        MemArena **pf_arena_p)
 {
 	/* use this to avoid locking pthread for _every_ polygon
 	 * and calling the fill function */
 
 #define USE_TESSFACE_SPEEDUP
 
-	const MPoly *mp;
+	const unsigned int mp_loopstart = (unsigned int)mp->loopstart;
+	const unsigned int mp_totloop = (unsigned int)mp->totloop;
 	const MLoop *ml;
-	MLoopTri *mlt;
-	MemArena *arena = NULL;
-	int poly_index, mlooptri_index;
 	unsigned int j;
 
-	mlooptri_index = 0;
-	mp = mpoly;
-	for (poly_index = 0; poly_index < totpoly; poly_index++, mp++) {
-		const unsigned int mp_loopstart = (unsigned int)mp->loopstart;
-		const unsigned int mp_totloop = (unsigned int)mp->totloop;
-		unsigned int l1, l2, l3;
-		if (mp_totloop < 3) {
-			/* do nothing */
-		}
+	if (mp_totloop < 3) {
+		/* do nothing */
+	}
 
 #ifdef USE_TESSFACE_SPEEDUP
 
-#define ML_TO_MLT(i1, i2, i3)  { \
-			mlt = &mlooptri[mlooptri_index]; \
-			l1 = mp_loopstart + i1; \
-			l2 = mp_loopstart + i2; \
-			l3 = mp_loopstart + i3; \
-			ARRAY_SET_ITEMS(mlt->tri, l1, l2, l3); \
-			mlt->poly = (unsigned int)poly_index; \
-		} ((void)0)
-
-		else if (mp_totloop == 3) {
-			ML_TO_MLT(0, 1, 2);
-			mlooptri_index++;
-		}
-		else if (mp_totloop == 4) {
-			ML_TO_MLT(0, 1, 2);
-			MLoopTri *mlt_a = mlt;
-			mlooptri_index++;
-			ML_TO_MLT(0, 2, 3);
-			MLoopTri *mlt_b = mlt;
-			mlooptri_index++;
-
-			if (UNLIKELY(is_quad_flip_v3_first_third_fast(
-			                     mvert[mloop[mlt_a->tri[0]].v].co,
-			                     mvert[mloop[mlt_a->tri[1]].v].co,
-			                     mvert[mloop[mlt_a->tri[2]].v].co,
-			                     mvert[mloop[mlt_b->tri[2]].v].co)))
-			{
-				/* flip out of degenerate 0-2 state. */
-				mlt_a->tri[2] = mlt_b->tri[2];
-				mlt_b->tri[0] = mlt_a->tri[1];
-			}
+#define ML_TO_MLT(mlt_, i1, i2, i3)  { \
+		ARRAY_SET_ITEMS((mlt_)->tri, mp_loopstart + i1, mp_loopstart + i2, mp_loopstart + i3); \
+		(mlt_)->poly = poly_index; \
+	} ((void)0)
+
+	else if (mp_totloop == 3) {
+		ML_TO_MLT(mlt, 0, 1, 2);
+	}
+	else if (mp_totloop == 4) {
+		MLoopTri *mlt_a = mlt;
+		MLoopTri *mlt_b = mlt + 1;
+		ML_TO_MLT(mlt_a, 0, 1, 2);
+		ML_TO_MLT(mlt_b, 0, 2, 3);
+
+		if (UNLIKELY(is_quad_flip_v3_first_third_fast(
+		                     mvert[mloop[mlt_a->tri[0]].v].co,
+		                     mvert[mloop[mlt_a->tri[1]].v].co,
+		                     mvert[mloop[mlt_a->tri[2]].v].co,
+		                     mvert[mloop[mlt_b->tri[2]].v].co)))
+		{
+			/* flip out of degenerate 0-2 state. */
+			mlt_a->tri[2] = mlt_b->tri[2];
+			mlt_b->tri[0] = mlt_a->tri[1];
 		}
+	}
 #endif /* USE_TESSFACE_SPEEDUP */
-		else {
-			const float *co_curr, *co_prev;
+	else {
+		const float *co_curr, *co_prev;
 
-			float normal[3];
+		float normal[3];
 
-			float axis_mat[3][3];
-			float (*projverts)[2];
-			unsigned int (*tris)[3];
+		float axis_mat[3][3];
+		float (*projverts)[2];
+		unsigned int (*tris)[3];
 
-			const unsigned int totfilltri = mp_totloop - 2;
+		const unsigned int totfilltri = mp_totloop - 2;
 
-			if (UNLIKELY(arena == NULL)) {
-				arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
-			}
+		if (UNLIKELY(*pf_arena_p == NULL)) {
+			*pf_arena_p = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
+		}
+		MemArena *pf_arena = *pf_arena_p;
 
-			tris = BLI_memarena_alloc(arena, sizeof(*tris) * (size_t)totfilltri);
-			projverts = BLI_memarena_alloc(arena, sizeof(*projverts) * (size_t)mp_totloop);
+		tris = BLI_memarena_alloc(pf_arena, sizeof(*tris) * (size_t)totfilltri);
+		projverts = BLI_memarena_alloc(pf_arena, sizeof(*projverts) * (size_t)mp_totloop);
 
-			zero_v3(normal);
+		zero_v3(normal);
 
-			/* calc normal, flipped: to get a positive 2d cross product */
-			ml = mloop + mp_loopstart;
-			co_prev = mvert[ml[mp_totloop - 1].v].co;
-			for (j = 0; j < mp_totloop; j++, ml++) {
-				co_curr = mvert[ml->v].co;
-				add_newell_cross_v3_v3v3(normal, co_prev, co_curr);
-				co_prev = co_curr;
-			}
-			if (UNLIKELY(normalize_v3(normal) == 0.0f)) {
-				normal[2] = 1.0f;
-			}
+		/* calc normal, flipped: to get a positive 2d cross product */
+		ml = mloop + mp_loopstart;
+		co_prev = mvert[ml[mp_totloop - 1].v].co;
+		for (j = 0; j < mp_totloop; j++, ml++) {
+			co_curr = mvert[ml->v].co;
+			add_newell_cross_v3_v3v3(normal, co_prev, co_curr);
+			co_prev = co_curr;
+		}
+		if (UNLIKELY(normalize_v3(normal) == 0.0f)) {
+			normal[2] = 1.0f;
+		}
 
-			/* project verts to 2d */
-			axis_dominant_v3_to_m3_negate(axis_mat, normal);
+		/* project verts to 2d */
+		axis_dominant_v3_to_m3_negate(axis_mat, normal);
 
-			ml = mloop + mp_loopstart;
-			for (j = 0; j < mp_totloop; j++, ml++) {
-				mul_v2_m3v3(projverts[j], axis_mat, mvert[ml->v].co);
-			}
+		ml = mloop + mp_loopstart;
+		for (j = 0; j < mp_totloop; j++, ml++) {
+			mul_v2_m3v3(projverts[j], axis_mat, mvert[ml->v].co);
+		}
 
-			BLI_polyfill_calc_arena(projverts, mp_totloop, 1, tris, arena);
+		BLI_polyfill_calc_arena(projverts, mp_totloop, 1, tris, pf_arena);
 
-			/* apply fill */
-			for (j = 0; j < totfilltri; j++) {
-				unsigned int *tri = tris[j];
+		/* apply fill */
+		for (j = 0; j < totfilltri; j++, mlt++) {
+			unsigned int *tri = tris[j];
 
-				mlt = &mlooptri[mlooptri_index];
+			/* set loop indices, transformed to vert indices later */
+			ARRAY_SET_ITEMS(mlt->tri, mp_loopstart + tri[0], mp_loopstart + tri[1], mp_loopstart + tri[2]);
+			mlt->poly = poly_index;
+		}
 
-				/* set loop indices, transformed to vert indices later */
-				l1 = mp_loopstart + tri[0];
-				l2 = mp_loopstart + tri[1];
-				l3 = mp_loopstart + tri[2];
+		BLI_memarena_clear(pf_arena);
+	}
+
+#undef USE_TESSFACE_SPEEDUP
+#undef ML_TO_MLT
+}
+
+typedef struct MeshRecalcLoopTriData {
+	const MLoop *mloop;
+	const MPoly *mpoly;
+	const MVert *mvert;
+	/* Index of the first triangle of each polygon. */
+	const unsigned int *looptri_offsets;
+	MLoopTri *mlooptri;
+} MeshRecalcLoopTriData;
 
-				ARRAY_SET_ITEMS(mlt->tri, l1, l2, l3);
-				mlt->poly = (unsigned int)poly_index;
+static void mesh_recalc_looptri_cb(
+        void *__restrict userdata,
+        const int poly_index,
+        const ParallelRangeTLS *__restrict tls)
+{
+	const MeshRecalcLoopTriData *data = userdata;
+	/* The arena is owned by the worker, only used for n-gons. */
+	MemArena *pf_arena = tls->arena;
 
-				mlooptri_index++;
+	mesh_recalc_looptri_poly(
+	        data->mloop, &data->mpoly[poly_index], data->mvert, (unsigned int)poly_index,
+	        &data->mlooptri[data->looptri_offsets[poly_index]], &pf_arena);
+}
+
+/**
+ * Calculate tessellation into #MLoopTri which exist only for this purpose.
+ *
+ * Large meshes are tessellated in parallel, the triangles of each polygon
+ * are written at offsets calculated from the number of loops beforehand.
+ */
+void BKE_mesh_recalc_looptri(
+        const MLoop *mloop, const MPoly *mpoly,
+        const MVert *mvert,
+        int totloop, int totpoly,
+        MLoopTri *mlooptri)
+{
+	const MPoly *mp;
+	unsigned int mlooptri_index = 0;
+	int poly_index;
+
+	if (totpoly <= MESH_LOOPTRI_THREADED_LIMIT) {
+		MemArena *pf_arena = NULL;
+
+		for (poly_index = 0, mp = mpoly; poly_index < totpoly; poly_index++, mp++) {
+			mesh_recalc_looptri_poly(
+			        mloop, mp, mvert, (unsigned int)poly_index, &mlooptri[mlooptri_index], &pf_arena);
+			if (mp->totloop >= 3) {
+				mlooptri_index += (unsigned int)mp->totloop - 2;
 			}
+		}
 
-			BLI_memarena_clear(arena);
+		if (pf_arena) {
+			BLI_memarena_free(pf_arena);
 		}
 	}
+	else {
+		unsigned int *looptri_offsets = MEM_malloc_arrayN(
+		        (size_t)totpoly, sizeof(*looptri_offsets), __func__);
+
+		/* Polygons with less than 3 loops don't have triangles. */
+		for (poly_index = 0, mp = mpoly; poly_index < totpoly; poly_index++, mp++) {
+			looptri_offsets[poly_index] = mlooptri_index;
+			if (mp->totloop >= 3) {
+				mlooptri_index += (unsigned int)mp->totloop - 2;
+			}
+		}
 
-	if (arena) {
-		BLI_memarena_free(arena);
-		arena = NULL;
+		MeshRecalcLoopTriData data = {
+		    .mloop = mloop, .mpoly = mpoly, .mvert = mvert,
+		    .looptri_offsets = looptri_offsets, .mlooptri = mlooptri,
+		};
+
+		ParallelRangeSettings settings;
+		BLI_parallel_range_settings_defaults(&settings);
+		/* Cost varies a lot between quads and large n-gons. */
+		settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+		settings.use_arena = true;
+		BLI_task_parallel_range(0, totpoly, &data, mesh_recalc_looptri_cb, &settings);
+
+		MEM_freeN(looptri_offsets);
 	}
 
-	BLI_assert(mlooptri_index == poly_to_tri_count(totpoly, totloop));
+	BLI_assert(mlooptri_index == (unsigned int)poly_to_tri_count(totpoly, totloop));
 	UNUSED_VARS_NDEBUG(totloop);
-
-#undef USE_TESSFACE_SPEEDUP
-#undef ML_TO_MLT
 }
 
+#undef MESH_LOOPTRI_THREADED_LIMIT
+
 static void bm_corners_to_loops_ex(
         ID *id, CustomData *fdata, CustomData *ldata,
         MFace *mface, int totloop, int findex, int loopstart, int numTex, int numCol)
@@ -213,6 +213,42 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
 	BKE_shrinkwrap_discard_boundary_data(mesh);
 }
 
+/**
+ * Take the BVH cache of a mesh which is about to be freed, so the next evaluation
+ * of the same object can reuse it, see #BKE_mesh_runtime_bvh_cache_reuse.
+ * Only meshes that are deformed from the original give up their cache.
+ */
+struct LinkNode *BKE_mesh_runtime_bvh_cache_take(Mesh *mesh)
+{
+	struct LinkNode *bvh_cache = NULL;
+	if (mesh->runtime.deformed_only) {
+		bvh_cache = mesh->runtime.bvh_cache;
+		mesh->runtime.bvh_cache = NULL;
+	}
+	return bvh_cache;
+}
+
+/**
+ * When \a mesh only has different vertex positions than the mesh \a bvh_cache_p was taken from,
+ * its trees are kept and refit on their next use instead of being built again.
+ * Otherwise the cache is freed.
+ */
+void BKE_mesh_runtime_bvh_cache_reuse(Mesh *mesh, struct LinkNode **bvh_cache_p)
+{
+	if (*bvh_cache_p == NULL) {
+		return;
+	}
+
+	if (mesh->runtime.deformed_only && (mesh->runtime.bvh_cache == NULL)) {
+		bvhcache_tag_deformed(bvh_cache_p, mesh);
+		mesh->runtime.bvh_cache = *bvh_cache_p;
+		*bvh_cache_p = NULL;
+	}
+	else {
+		bvhcache_free(bvh_cache_p);
+	}
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -222,6 +258,7 @@ void BKE_mesh_runtime_clear_geometry(Mesh *mesh)
 /* Draw Engine */
 void (*BKE_mesh_batch_cache_dirty_tag_cb)(Mesh *me, int mode) = NULL;
 void (*BKE_mesh_batch_cache_free_cb)(Mesh *me) = NULL;
+size_t (*BKE_mesh_batch_cache_memory_get_cb)(Mesh *me) = NULL;
 
 void BKE_mesh_batch_cache_dirty_tag(Mesh *me, int mode)
 {
@@ -235,6 +272,14 @@ void BKE_mesh_batch_cache_free(Mesh *me)
 		BKE_mesh_batch_cache_free_cb(me);
 	}
 }
+/* Memory of the GPU buffers drawing the mesh, in bytes. */
+size_t BKE_mesh_batch_cache_memory_get(Mesh *me)
+{
+	if (me->runtime.batch_cache) {
+		return BKE_mesh_batch_cache_memory_get_cb(me);
+	}
+	return 0;
+}
 
 /** \} */
 
@@ -1729,14 +1729,18 @@ static void movieclip_selection_synchronize(MovieClip *clip_dst, const MovieClip
 	}
 }
 
+static void movieclip_sync_to_original(struct Depsgraph *UNUSED(depsgraph), void *clip_v)
+{
+	MovieClip *clip = *(MovieClip **)clip_v;
+	MovieClip *clip_orig = (MovieClip *)DEG_get_original_id(&clip->id);
+	BKE_tracking_dopesheet_tag_update(&clip_orig->tracking);
+}
+
 void BKE_movieclip_eval_update(struct Depsgraph *depsgraph, MovieClip *clip)
 {
 	DEG_debug_print_eval(depsgraph, __func__, clip->id.name, clip);
 	BKE_tracking_dopesheet_tag_update(&clip->tracking);
-	if (DEG_is_active(depsgraph)) {
-		MovieClip *clip_orig = (MovieClip *)DEG_get_original_id(&clip->id);
-		BKE_tracking_dopesheet_tag_update(&clip_orig->tracking);
-	}
+	DEG_sync_to_original(depsgraph, movieclip_sync_to_original, &clip, sizeof(clip));
 }
 
 void BKE_movieclip_eval_selection_update(struct Depsgraph *depsgraph, MovieClip *clip)
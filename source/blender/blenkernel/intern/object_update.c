@@ -246,11 +246,9 @@ void BKE_object_handle_data_update(
 
 /* TODO(sergey): Ensure that bounding box is already calculated, and move this
  * into BKE_object_synchronize_to_original(). */
-void BKE_object_eval_boundbox(Depsgraph *depsgraph, Object *object)
+static void object_boundbox_sync_to_original(Depsgraph *UNUSED(depsgraph), void *object_v)
 {
-	if (!DEG_is_active(depsgraph)) {
-		return;
-	}
+	Object *object = *(Object **)object_v;
 	Object *ob_orig = DEG_get_original_object(object);
 	BoundBox *bb = BKE_object_boundbox_get(object);
 	if (bb != NULL) {
@@ -261,11 +259,14 @@ void BKE_object_eval_boundbox(Depsgraph *depsgraph, Object *object)
 	}
 }
 
-void BKE_object_synchronize_to_original(Depsgraph *depsgraph, Object *object)
+void BKE_object_eval_boundbox(Depsgraph *depsgraph, Object *object)
 {
-	if (!DEG_is_active(depsgraph)) {
-		return;
-	}
+	DEG_sync_to_original(depsgraph, object_boundbox_sync_to_original, &object, sizeof(object));
+}
+
+static void object_sync_to_original(Depsgraph *UNUSED(depsgraph), void *object_v)
+{
+	Object *object = *(Object **)object_v;
 	Object *object_orig = DEG_get_original_object(object);
 	/* Base flags. */
 	object_orig->base_flag = object->base_flag;
@@ -289,6 +290,11 @@ void BKE_object_synchronize_to_original(Depsgraph *depsgraph, Object *object)
 	}
 }
 
+void BKE_object_synchronize_to_original(Depsgraph *depsgraph, Object *object)
+{
+	DEG_sync_to_original(depsgraph, object_sync_to_original, &object, sizeof(object));
+}
+
 bool BKE_object_eval_proxy_copy(Depsgraph *depsgraph,
                                 Object *object)
 {
@@ -408,6 +414,15 @@ void BKE_object_data_select_update(Depsgraph *depsgraph, ID *object_data)
 	}
 }
 
+static void base_flags_sync_to_original(Depsgraph *UNUSED(depsgraph), void *base_v)
+{
+	Base *base = *(Base **)base_v;
+	Base *base_orig = base->base_orig;
+	BLI_assert(base_orig != NULL);
+	BLI_assert(base_orig->object != NULL);
+	base_orig->flag = base->flag;
+}
+
 void BKE_object_eval_eval_base_flags(Depsgraph *depsgraph,
                                      Scene *scene, const int view_layer_index,
                                      Object *object, int base_index,
@@ -457,10 +472,7 @@ void BKE_object_eval_eval_base_flags(Depsgraph *depsgraph,
 	}
 
 	/* Copy base flag back to the original view layer for editing. */
-	if (DEG_is_active(depsgraph) && (view_layer == DEG_get_evaluated_view_layer(depsgraph))) {
-		Base *base_orig = base->base_orig;
-		BLI_assert(base_orig != NULL);
-		BLI_assert(base_orig->object != NULL);
-		base_orig->flag = base->flag;
+	if (view_layer == DEG_get_evaluated_view_layer(depsgraph)) {
+		DEG_sync_to_original(depsgraph, base_flags_sync_to_original, &base, sizeof(base));
 	}
 }
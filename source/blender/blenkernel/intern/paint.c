@@ -1126,6 +1126,8 @@ void BKE_sculpt_update_mesh_elements(
 	PBVH *pbvh = BKE_sculpt_object_pbvh_ensure(depsgraph, ob);
 	BLI_assert(pbvh == ss->pbvh);
 	UNUSED_VARS_NDEBUG(pbvh);
+
+	BKE_sculpt_mesh_ensure_writable(ob);
 	MEM_SAFE_FREE(ss->pmap);
 	MEM_SAFE_FREE(ss->pmap_mem);
 	if (need_pmap && ob->type == OB_MESH) {
@@ -1374,6 +1376,30 @@ static PBVH *build_pbvh_from_ccg(Object *ob, SubdivCCG *subdiv_ccg)
 	return pbvh;
 }
 
+/**
+ * Sculpting edits vertices and masks of the original mesh in place, make them writable
+ * since they might be shared with evaluated copies (see #LIB_ID_COPY_CD_SHARE).
+ * Needed again after updates of the evaluated mesh, which can share the layers again.
+ */
+void BKE_sculpt_mesh_ensure_writable(Object *ob)
+{
+	SculptSession *ss = ob->sculpt;
+
+	if (ss == NULL || ss->bm != NULL || ss->multires != NULL || (ob->mode & OB_MODE_SCULPT) == 0) {
+		return;
+	}
+
+	Mesh *me = BKE_object_get_original_mesh(ob);
+	const CustomData_MeshMasks mask = {.vmask = CD_MASK_MVERT | CD_MASK_PAINT_MASK};
+	BKE_mesh_ensure_writable(me, &mask);
+
+	ss->mvert = me->mvert;
+	ss->vmask = CustomData_get_layer(&me->vdata, CD_PAINT_MASK);
+	if (ss->pbvh != NULL && BKE_pbvh_type(ss->pbvh) == PBVH_FACES) {
+		BKE_pbvh_mesh_verts_update(ss->pbvh, me->mvert);
+	}
+}
+
 PBVH *BKE_sculpt_object_pbvh_ensure(Depsgraph *depsgraph, Object *ob)
 {
 	if (ob == NULL || ob->sculpt == NULL) {
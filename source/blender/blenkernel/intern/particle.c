@@ -1951,9 +1951,23 @@ void psys_find_parents(ParticleSimulationData *sim, const bool use_render_params
 
 	BLI_kdtree_3d_balance(tree);
 
-	for (; p < totchild; p++, cpa++) {
-		psys_particle_on_emitter(sim->psmd, from, cpa->num, DMCACHE_ISCHILD, cpa->fuv, cpa->foffset, co, 0, 0, 0, orco);
-		cpa->parent = BLI_kdtree_3d_find_nearest(tree, orco, NULL);
+	if (p < totchild) {
+		/* Search all children at once, much faster than one at a time. */
+		const int orco_len = totchild - p;
+		float (*orco_child)[3] = MEM_mallocN(sizeof(*orco_child) * (size_t)orco_len, __func__);
+		int *parent = MEM_mallocN(sizeof(*parent) * (size_t)orco_len, __func__);
+		int i;
+
+		for (i = 0; i < orco_len; i++) {
+			psys_particle_on_emitter(sim->psmd, from, cpa[i].num, DMCACHE_ISCHILD, cpa[i].fuv, cpa[i].foffset, co, 0, 0, 0, orco_child[i]);
+		}
+		BLI_kdtree_3d_find_nearest_batch(tree, (const float (*)[3])orco_child, (uint)orco_len, parent, NULL);
+		for (i = 0; i < orco_len; i++) {
+			cpa[i].parent = parent[i];
+		}
+
+		MEM_freeN(orco_child);
+		MEM_freeN(parent);
 	}
 
 	BLI_kdtree_3d_free(tree);
@@ -2121,6 +2121,17 @@ void BKE_pbvh_grids_update(PBVH *bvh, CCGElem **grids, void **gridfaces,
 	}
 }
 
+/* Vertices of the mesh are re-allocated when made writable, see #BKE_sculpt_mesh_ensure_writable */
+void BKE_pbvh_mesh_verts_update(PBVH *bvh, MVert *verts)
+{
+	BLI_assert(bvh->type == PBVH_FACES);
+
+	/* Deformed PBVH own a copy of the vertices. */
+	if (!bvh->deformed) {
+		bvh->verts = verts;
+	}
+}
+
 /* Get the node's displacement layer, creating it if necessary */
 float *BKE_pbvh_node_layer_disp_get(PBVH *bvh, PBVHNode *node)
 {
@@ -1492,6 +1492,10 @@ void BKE_scene_graph_update_tagged(Depsgraph *depsgraph,
 	ViewLayer *view_layer = DEG_get_input_view_layer(depsgraph);
 
 	bool run_callbacks = DEG_id_type_any_updated(depsgraph);
+	/* Callbacks and evaluation change original data. */
+	if (run_callbacks || DEG_needs_eval(depsgraph)) {
+		DEG_lookahead_wait_all(bmain);
+	}
 	if (run_callbacks) {
 		BLI_callback_exec(bmain, &scene->id, BLI_CB_EVT_DEPSGRAPH_UPDATE_PRE);
 	}
@@ -1535,6 +1539,8 @@ void BKE_scene_graph_update_for_newframe(Depsgraph *depsgraph,
 	 * for example, clearing update tags from bmain.
 	 */
 	const float ctime = BKE_scene_frame_get(scene);
+	/* Callbacks and evaluation change original data. */
+	DEG_lookahead_wait_all(bmain);
 	/* Keep this first. */
 	BLI_callback_exec(bmain, &scene->id, BLI_CB_EVT_FRAME_CHANGE_PRE);
 	/* Update animated image textures for particles, modifiers, gpu, etc,
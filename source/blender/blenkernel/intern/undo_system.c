@@ -40,6 +40,8 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "PIL_time.h"
+
 #define undo_stack _wm_undo_stack_disallow  /* pass in as a variable always. */
 
 /** Odd requirement of Blender that we always keep a memfile undo in the stack. */
@@ -145,9 +147,13 @@ static void undosys_id_ref_resolve(void *user_data, UndoRefID *id_ref)
 static bool undosys_step_encode(bContext *C, Main *bmain, UndoStack *ustack, UndoStep *us)
 {
 	CLOG_INFO(&LOG, 2, "addr=%p, name='%s', type='%s'", us, us->name, us->type->name);
+	const double time_start = PIL_check_seconds_timer();
 	UNDO_NESTED_CHECK_BEGIN;
 	bool ok = us->type->step_encode(C, bmain, us);
 	UNDO_NESTED_CHECK_END;
+	us->stats.encode_time = PIL_check_seconds_timer() - time_start;
+	CLOG_INFO(&LOG, 1, "encode '%s': %.3f ms, %zu bytes",
+	          us->name, us->stats.encode_time * 1000.0, us->data_size);
 	if (ok) {
 		if (us->type->step_foreach_ID_ref != NULL) {
 			/* Don't use from context yet because sometimes context is fake and not all members are filled in. */
@@ -193,9 +199,14 @@ static void undosys_step_decode(bContext *C, Main *bmain, UndoStack *ustack, Und
 		us->type->step_foreach_ID_ref(us, undosys_id_ref_resolve, bmain);
 	}
 
+	const double time_start = PIL_check_seconds_timer();
 	UNDO_NESTED_CHECK_BEGIN;
 	us->type->step_decode(C, bmain, us, dir);
 	UNDO_NESTED_CHECK_END;
+	us->stats.decode_time = PIL_check_seconds_timer() - time_start;
+	CLOG_INFO(&LOG, 1, "decode '%s': %.3f ms, ID's read=%d, reused=%d",
+	          us->name, us->stats.decode_time * 1000.0,
+	          us->stats.decode_ids_len, us->stats.decode_ids_reused);
 
 #ifdef WITH_GLOBAL_UNDO_CORRECT_ORDER
 	if (us->type == BKE_UNDOSYS_TYPE_MEMFILE) {
@@ -998,14 +1009,20 @@ void BKE_undosys_print(UndoStack *ustack)
 	       BLI_listbase_count(&ustack->steps));
 	int index = 0;
 	for (UndoStep *us = ustack->steps.first; us; us = us->next) {
-		printf("[%c%c%c%c] %3d type='%s', name='%s'\n",
+		printf("[%c%c%c%c] %3d type='%s', name='%s', size=%zu, "
+		       "encode=%.3fms, decode=%.3fms (ID's read=%d, reused=%d)\n",
 		       (us == ustack->step_active) ? '*' : ' ',
 		       us->is_applied ? '#' : ' ',
 		       (us == ustack->step_active_memfile) ? 'M' : ' ',
 		       us->skip ? 'S' : ' ',
 		       index,
 		       us->type->name,
-		       us->name);
+		       us->name,
+		       us->data_size,
+		       us->stats.encode_time * 1000.0,
+		       us->stats.decode_time * 1000.0,
+		       us->stats.decode_ids_len,
+		       us->stats.decode_ids_reused);
 		index++;
 	}
 }
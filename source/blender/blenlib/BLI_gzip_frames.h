@@ -0,0 +1,62 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __BLI_GZIP_FRAMES_H__
+#define __BLI_GZIP_FRAMES_H__
+
+/** \file
+ * \ingroup bli
+ *
+ * Seekable gzip files, made of independently compressed frames.
+ *
+ * Each frame is a complete gzip member holding a fixed amount of uncompressed data,
+ * its compressed and uncompressed size are stored in an extra header field,
+ * so frames can be compressed in parallel and decompressed individually.
+ * Two empty members at the end of the file hold the frame index.
+ *
+ * Since concatenated gzip members are valid gzip, these files can still be read
+ * by any gzip reader (including older Blender versions) as one stream.
+ */
+
+#include "BLI_compiler_attrs.h"
+#include "BLI_sys_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct GzFramesWriter GzFramesWriter;
+typedef struct GzFramesReader GzFramesReader;
+
+/** Amount of uncompressed data in each frame (all but the last one). */
+#define GZ_FRAMES_FRAME_SIZE (1 << 20)
+
+GzFramesWriter *BLI_gzframes_writer_new(int file, int level) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+bool BLI_gzframes_writer_write(GzFramesWriter *gw, const void *data, size_t data_len) ATTR_NONNULL(1);
+bool BLI_gzframes_writer_free(GzFramesWriter *gw) ATTR_NONNULL();
+
+GzFramesReader *BLI_gzframes_reader_new(int file) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+int64_t BLI_gzframes_reader_read(GzFramesReader *gr, void *buffer, size_t size) ATTR_NONNULL();
+int64_t BLI_gzframes_reader_seek(GzFramesReader *gr, int64_t offset, int whence) ATTR_NONNULL();
+int64_t BLI_gzframes_reader_size(const GzFramesReader *gr) ATTR_NONNULL();
+int BLI_gzframes_reader_frames_len(const GzFramesReader *gr) ATTR_NONNULL();
+void BLI_gzframes_reader_free(GzFramesReader *gr) ATTR_NONNULL();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __BLI_GZIP_FRAMES_H__ */
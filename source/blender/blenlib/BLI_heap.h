@@ -22,6 +22,10 @@
  * \brief A min-heap / priority queue ADT
  */
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 struct Heap;
 struct HeapNode;
 typedef struct Heap Heap;
@@ -50,4 +54,8 @@ void           *BLI_heap_node_ptr(const HeapNode *heap) ATTR_WARN_UNUSED_RESULT
 /* only for gtest */
 bool            BLI_heap_is_valid(const Heap *heap);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif  /* __BLI_HEAP_H__ */
@@ -88,6 +88,22 @@ typedef struct BVHTreeRayHit {
 	float dist;
 } BVHTreeRayHit;
 
+/** Statistics about a tree, see #BLI_bvhtree_balance_ex. */
+typedef struct BVHTreeBuildStats {
+	/** Time to build the tree (in seconds). */
+	double time;
+	int totleaf;
+	int totbranch;
+	/** Depth of the deepest leaf. */
+	int depth_max;
+	/** Expected number of nodes visited by a query (SAH cost relative to the root area), lower is better. */
+	float sah_cost;
+} BVHTreeBuildStats;
+
+enum {
+	/* Build using the surface area heuristic, see #BLI_bvhtree_balance_ex */
+	BVH_BUILD_SAH               = (1 << 0),
+};
 enum {
 	/* Use a priority queue to process nodes in the optimal order (for slow callbacks) */
 	BVH_NEAREST_OPTIMAL_ORDER   = (1 << 0),
@@ -134,8 +150,10 @@ void BLI_bvhtree_free(BVHTree *tree);
 /* construct: first insert points, then call balance */
 void BLI_bvhtree_insert(BVHTree *tree, int index, const float co[3], int numpoints);
 void BLI_bvhtree_balance(BVHTree *tree);
+void BLI_bvhtree_balance_ex(BVHTree *tree, const int flag, BVHTreeBuildStats *r_stats);
 
-/* update: first update points/nodes, then call update_tree to refit the bounding volumes */
+/* update: first update points/nodes, then call update_tree to refit the bounding volumes,
+ * updating different nodes from multiple threads is supported, large trees are refit in parallel. */
 bool BLI_bvhtree_update_node(BVHTree *tree, int index, const float co[3], const float co_moving[3], int numpoints);
 void BLI_bvhtree_update_tree(BVHTree *tree);
 
@@ -170,6 +188,14 @@ int BLI_bvhtree_ray_cast(
         BVHTree *tree, const float co[3], const float dir[3], float radius, BVHTreeRayHit *hit,
         BVHTree_RayCastCallback callback, void *userdata);
 
+void BLI_bvhtree_ray_cast_packet_ex(
+        BVHTree *tree, const float (*co)[3], const float (*dir)[3], const int rays_len, float radius,
+        BVHTreeRayHit *hits, BVHTree_RayCastCallback callback, void *userdata,
+        int flag);
+void BLI_bvhtree_ray_cast_packet(
+        BVHTree *tree, const float (*co)[3], const float (*dir)[3], const int rays_len, float radius,
+        BVHTreeRayHit *hits, BVHTree_RayCastCallback callback, void *userdata);
+
 void BLI_bvhtree_ray_cast_all_ex(
         BVHTree *tree, const float co[3], const float dir[3], float radius, float hit_dist,
         BVHTree_RayCastCallback callback, void *userdata,
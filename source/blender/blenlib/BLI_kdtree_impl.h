@@ -44,6 +44,9 @@ void BLI_kdtree_nd_(insert)(
 int BLI_kdtree_nd_(find_nearest)(
         const KDTree *tree, const float co[KD_DIMS],
         KDTreeNearest *r_nearest) ATTR_NONNULL(1, 2);
+void BLI_kdtree_nd_(find_nearest_batch)(
+        const KDTree *tree, const float (*co)[KD_DIMS], const uint co_len,
+        int *r_index, KDTreeNearest *r_nearest) ATTR_NONNULL(1, 2);
 
 int BLI_kdtree_nd_(find_nearest_n)(
         const KDTree *tree, const float co[KD_DIMS],
@@ -27,4 +27,9 @@
 bool BLI_memory_is_zero(const void *arr, const size_t size);
 #endif
 
+/** Size of the huge pages #BLI_memory_advise_huge_pages deals with. */
+#define BLI_MEMORY_HUGE_PAGE_SIZE ((size_t)1 << 21)
+
+void BLI_memory_advise_huge_pages(void *arr, const size_t size);
+
 #endif  /* __BLI_MEMORY_UTILS_H__ */
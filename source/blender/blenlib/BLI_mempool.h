@@ -84,6 +84,11 @@ void *BLI_mempool_iterstep(BLI_mempool_iter *iter) ATTR_WARN_UNUSED_RESULT ATTR_
 BLI_mempool_iter *BLI_mempool_iter_threadsafe_create(BLI_mempool *pool, const size_t num_iter) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
 void  BLI_mempool_iter_threadsafe_free(BLI_mempool_iter *iter_arr) ATTR_NONNULL();
 
+struct BLI_mempool_chunk **BLI_mempool_chunks_array_create(
+        BLI_mempool *pool, unsigned int *r_chunks_len) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
+void  BLI_mempool_iternew_chunk(
+        BLI_mempool *pool, BLI_mempool_iter *iter, struct BLI_mempool_chunk *chunk) ATTR_NONNULL();
+
 #ifdef __cplusplus
 }
 #endif
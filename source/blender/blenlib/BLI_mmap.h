@@ -0,0 +1,61 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __BLI_MMAP_H__
+#define __BLI_MMAP_H__
+
+/** \file
+ * \ingroup bli
+ *
+ * Read-only memory mapped files.
+ *
+ * \note The mapping stays valid when the file is replaced by renaming another file
+ * over it (as Blender does when saving). When the file is truncated or its storage
+ * becomes unavailable while it's mapped, reads fail instead (see #BLI_mmap_read).
+ */
+
+#include "BLI_compiler_attrs.h"
+#include "BLI_sys_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct BLI_mmap_file BLI_mmap_file;
+
+/* Prepares an opened file for memory-mapped IO.
+ * May return NULL if the operation fails (e.g. empty files or address space limits).
+ * The file descriptor may be closed afterwards, the mapping stays valid. */
+BLI_mmap_file *BLI_mmap_open(int fd) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+
+/* Reads length bytes from file at the given offset into dest.
+ * Returns whether the operation was successful (may fail when reading beyond the file end,
+ * or when the file can't be read anymore, all further reads fail then). */
+bool BLI_mmap_read(BLI_mmap_file *file, void *dest, size_t offset, size_t length)
+        ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+
+/* Direct access to the mapped memory, IO errors aren't reported (the memory reads as zeroes then),
+ * use #BLI_mmap_read where they matter. */
+const void *BLI_mmap_get_pointer(const BLI_mmap_file *file) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
+size_t BLI_mmap_get_length(const BLI_mmap_file *file) ATTR_WARN_UNUSED_RESULT ATTR_NONNULL();
+
+void BLI_mmap_free(BLI_mmap_file *file) ATTR_NONNULL();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __BLI_MMAP_H__ */
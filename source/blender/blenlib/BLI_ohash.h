@@ -0,0 +1,193 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __BLI_OHASH_H__
+#define __BLI_OHASH_H__
+
+/** \file
+ * \ingroup bli
+ *
+ * OHash is an open-addressing hash-map (Robin Hood hashing with linear probing).
+ *
+ * Keys and values are stored inline in a single array, without per-entry
+ * allocations, so lookups don't have to chase a pointer for every entry
+ * of a bucket like #GHash does.
+ *
+ * \note The API matches BLI_ghash.h, but the implementation is different.
+ * Unlike GHash, pointers returned by #BLI_ohash_lookup_p & co. are only valid
+ * until the next insertion or removal.
+ */
+
+#include "BLI_sys_types.h" /* for bool */
+#include "BLI_compiler_attrs.h"
+#include "BLI_ghash.h"  /* for callback types */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct OHashEntry {
+	void *key;
+	void *val;
+} OHashEntry;
+
+typedef struct OHash {
+	GHashHashFP hashfp;
+	GHashCmpFP cmpfp;
+
+	/* Hash of the key stored in each slot, zero for empty slots. */
+	unsigned int *hashes;
+	OHashEntry *entries;
+
+	/* Number of slots is always (1 << capacity_exp). */
+	unsigned int capacity_exp;
+	unsigned int slot_mask;
+	unsigned int nentries;
+	unsigned int flag;
+} OHash;
+
+typedef struct OHashIterator {
+	OHash *oh;
+	unsigned int slot;
+} OHashIterator;
+
+/** \name OHash API
+ *
+ * Defined in ``ohash.c``
+ * \{ */
+
+OHash *BLI_ohash_new_ex(
+        GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info,
+        const unsigned int nentries_reserve) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+OHash *BLI_ohash_new(
+        GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+void   BLI_ohash_free(OHash *oh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp);
+void   BLI_ohash_reserve(OHash *oh, const unsigned int nentries_reserve);
+void   BLI_ohash_insert(OHash *oh, void *key, void *val);
+bool   BLI_ohash_reinsert(OHash *oh, void *key, void *val, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp);
+void  *BLI_ohash_lookup(OHash *oh, const void *key) ATTR_WARN_UNUSED_RESULT;
+void  *BLI_ohash_lookup_default(OHash *oh, const void *key, void *val_default) ATTR_WARN_UNUSED_RESULT;
+void **BLI_ohash_lookup_p(OHash *oh, const void *key) ATTR_WARN_UNUSED_RESULT;
+bool   BLI_ohash_ensure_p(OHash *oh, void *key, void ***r_val) ATTR_WARN_UNUSED_RESULT;
+bool   BLI_ohash_remove(OHash *oh, const void *key, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp);
+void  *BLI_ohash_popkey(OHash *oh, const void *key, GHashKeyFreeFP keyfreefp) ATTR_WARN_UNUSED_RESULT;
+bool   BLI_ohash_haskey(OHash *oh, const void *key) ATTR_WARN_UNUSED_RESULT;
+void   BLI_ohash_clear(OHash *oh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp);
+void   BLI_ohash_clear_ex(
+        OHash *oh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp,
+        const unsigned int nentries_reserve);
+unsigned int BLI_ohash_len(OHash *oh) ATTR_WARN_UNUSED_RESULT;
+void   BLI_ohash_flag_set(OHash *oh, unsigned int flag);
+void   BLI_ohash_flag_clear(OHash *oh, unsigned int flag);
+
+OHash *BLI_ohash_ptr_new_ex(
+        const char *info,
+        const unsigned int nentries_reserve) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+OHash *BLI_ohash_ptr_new(
+        const char *info) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+
+/* For testing, debugging only */
+double BLI_ohash_calc_quality_ex(OHash *oh, double *r_load, int *r_longest_probe);
+
+/** \} */
+
+/** \name OHash Iterator
+ *
+ * \note Removing items while iterating is not supported.
+ * \{ */
+
+void BLI_ohashIterator_init(OHashIterator *ohi, OHash *oh);
+void BLI_ohashIterator_step(OHashIterator *ohi);
+
+BLI_INLINE bool   BLI_ohashIterator_done(const OHashIterator *ohi)
+{ return ohi->slot > ohi->oh->slot_mask; }
+BLI_INLINE void  *BLI_ohashIterator_getKey(OHashIterator *ohi)
+{ return ohi->oh->entries[ohi->slot].key; }
+BLI_INLINE void  *BLI_ohashIterator_getValue(OHashIterator *ohi)
+{ return ohi->oh->entries[ohi->slot].val; }
+BLI_INLINE void **BLI_ohashIterator_getValue_p(OHashIterator *ohi)
+{ return &ohi->oh->entries[ohi->slot].val; }
+
+#define OHASH_ITER(oh_iter_, ohash_) \
+	for (BLI_ohashIterator_init(&oh_iter_, ohash_); \
+	     BLI_ohashIterator_done(&oh_iter_) == false; \
+	     BLI_ohashIterator_step(&oh_iter_))
+
+/** \} */
+
+/** \name OHash Pointer-Key Inline API
+ *
+ * Lookups for tables created with #BLI_ohash_ptr_new, hashing and comparison
+ * are inlined instead of going through the callbacks.
+ * \{ */
+
+/* Same as #BLI_ghashutil_ptrhash. */
+BLI_INLINE unsigned int BLI_ohashutil_ptrhash(const void *key)
+{
+	size_t y = (size_t)key;
+	return (unsigned int)(y >> 4) | ((unsigned int)y << (8 * sizeof(unsigned int) - 4));
+}
+
+/* Zero is reserved for empty slots. */
+BLI_INLINE unsigned int _ohash_hash_finalize(unsigned int hash)
+{
+	return hash | 0x80000000u;
+}
+
+/* Fibonacci hashing, spreads badly distributed hashes over all slots. */
+BLI_INLINE unsigned int _ohash_slot_home(const OHash *oh, unsigned int hash)
+{
+	return (hash * 2654435769u) >> (32 - oh->capacity_exp);
+}
+
+BLI_INLINE void **BLI_ohash_ptr_lookup_p(OHash *oh, const void *key)
+{
+	const unsigned int hash = _ohash_hash_finalize(BLI_ohashutil_ptrhash(key));
+	const unsigned int mask = oh->slot_mask;
+	unsigned int slot = _ohash_slot_home(oh, hash);
+	for (unsigned int dist = 0; ; dist++, slot = (slot + 1) & mask) {
+		const unsigned int slot_hash = oh->hashes[slot];
+		if (slot_hash == 0) {
+			return NULL;
+		}
+		if (slot_hash == hash && oh->entries[slot].key == key) {
+			return &oh->entries[slot].val;
+		}
+		/* Robin Hood invariant, key would have been stored here. */
+		if (((slot - _ohash_slot_home(oh, slot_hash)) & mask) < dist) {
+			return NULL;
+		}
+	}
+}
+
+BLI_INLINE void *BLI_ohash_ptr_lookup(OHash *oh, const void *key)
+{
+	void **val_p = BLI_ohash_ptr_lookup_p(oh, key);
+	return val_p ? *val_p : NULL;
+}
+
+BLI_INLINE bool BLI_ohash_ptr_haskey(OHash *oh, const void *key)
+{
+	return BLI_ohash_ptr_lookup_p(oh, key) != NULL;
+}
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLI_OHASH_H__ */
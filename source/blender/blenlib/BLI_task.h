@@ -34,12 +34,18 @@ extern "C" {
 #include "BLI_utildefines.h"
 
 struct BLI_mempool;
+struct MemArena;
 
 /* Task Scheduler
  *
  * Central scheduler that holds running threads ready to execute tasks. A single
  * queue holds the task from all pools.
  *
+ * Optionally every thread also gets its own lock-free deque: tasks pushed from
+ * within a running task go to the deque of that thread, which pops them in LIFO
+ * order, while idle threads steal the oldest ones in FIFO order. This avoids
+ * contention on the global queue with high number of threads.
+ *
  * Init/exit must be called before/after any task pools are created/freed, and
  * must be called from the main threads. All other scheduler and pool functions
  * are thread-safe. */
@@ -51,7 +57,13 @@ enum {
 	TASK_SCHEDULER_SINGLE_THREAD = 1,
 };
 
+typedef enum eTaskSchedulerFlag {
+	/* Use per-thread work-stealing deques. */
+	TASK_SCHEDULER_WORK_STEALING = (1 << 0),
+} eTaskSchedulerFlag;
+
 TaskScheduler *BLI_task_scheduler_create(int num_threads);
+TaskScheduler *BLI_task_scheduler_create_ex(int num_threads, const int flag);
 void BLI_task_scheduler_free(TaskScheduler *scheduler);
 
 int BLI_task_scheduler_num_threads(TaskScheduler *scheduler);
@@ -139,6 +151,12 @@ typedef struct ParallelRangeTLS {
 	 * worker threads. This is similar to OpenMP's firstprivate.
 	 */
 	void *userdata_chunk;
+	/* Scratch memory arena owned by this worker, only set when
+	 * ParallelRangeSettings.use_arena is enabled. Allocations from it are freed
+	 * all at once when the whole range has been processed (after func_finalize),
+	 * callbacks may also BLI_memarena_clear() it to reuse memory between iterations.
+	 */
+	struct MemArena *arena;
 } ParallelRangeTLS;
 
 typedef void (*TaskParallelRangeFunc)(void *__restrict userdata,
@@ -166,6 +184,10 @@ typedef struct ParallelRangeSettings {
 	 * processed.
 	 */
 	TaskParallelRangeFuncFinalize func_finalize;
+	/* Give each worker its own MemArena (see ParallelRangeTLS.arena), so callbacks
+	 * can allocate scratch buffers without going through the locked MEM_mallocN path.
+	 */
+	bool use_arena;
 	/* Minimum allowed number of range iterators to be handled by a single
 	 * thread. This allows to achieve following:
 	 * - Reduce amount of threading overhead.
@@ -206,6 +228,15 @@ void BLI_task_parallel_mempool(
         TaskParallelMempoolFunc func,
         const bool use_threading);
 
+typedef void (*TaskParallelMempoolFuncEx)(void *__restrict userdata,
+                                          MempoolIterData *iter,
+                                          const ParallelRangeTLS *__restrict tls);
+void BLI_task_parallel_mempool_ex(
+        struct BLI_mempool *mempool,
+        void *userdata,
+        TaskParallelMempoolFuncEx func,
+        const ParallelRangeSettings *settings);
+
 /* TODO(sergey): Think of a better place for this. */
 BLI_INLINE void BLI_parallel_range_settings_defaults(
         ParallelRangeSettings *settings)
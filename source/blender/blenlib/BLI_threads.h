@@ -66,6 +66,8 @@ void BLI_threaded_malloc_end(void);
 int     BLI_system_thread_count(void); /* gets the number of threads the system can make use of */
 void    BLI_system_num_threads_override_set(int num);
 int     BLI_system_num_threads_override_get(void);
+void    BLI_system_work_stealing_set(bool use);
+bool    BLI_system_work_stealing_get(void);
 
 /* Global Mutex Locks
  *
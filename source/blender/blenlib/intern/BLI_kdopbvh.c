@@ -40,6 +40,10 @@
 
 #include <assert.h>
 
+#ifdef __SSE2__
+#  include <xmmintrin.h>
+#endif
+
 #include "MEM_guardedalloc.h"
 
 #include "BLI_utildefines.h"
@@ -50,6 +54,10 @@
 #include "BLI_task.h"
 #include "BLI_heap_simple.h"
 
+#include "PIL_time.h"
+
+#include "atomic_ops.h"
+
 #include "BLI_strict_flags.h"
 
 /* used for iterative_raycast */
@@ -159,6 +167,31 @@ typedef struct BVHRayCastData {
 	BVHTreeRayHit hit;
 } BVHRayCastData;
 
+#define BVH_RAYCAST_PACKET_SIZE 4
+
+typedef struct BVHRayPacketData {
+	BVHTree_RayCastCallback callback;
+	void    *userdata;
+
+	BVHTreeRay ray[BVH_RAYCAST_PACKET_SIZE];
+	BVHTreeRayHit *hit[BVH_RAYCAST_PACKET_SIZE];
+	/* Bit-mask of the rays used (the last packet may not be full). */
+	uint ray_mask;
+
+#ifdef USE_KDOPBVH_WATERTIGHT
+	struct IsectRayPrecalc isect_precalc[BVH_RAYCAST_PACKET_SIZE];
+#endif
+
+	/* Per axis values for all rays, to test the rays against a node at once. */
+	float origin[3][BVH_RAYCAST_PACKET_SIZE];
+	float idot_axis[3][BVH_RAYCAST_PACKET_SIZE];
+	float hit_dist[BVH_RAYCAST_PACKET_SIZE];
+
+	/* Nodes to visit. */
+	BVHNode **stack;
+	int stack_len_capacity;
+} BVHRayPacketData;
+
 typedef struct BVHNearestProjectedData {
 	const BVHTree *tree;
 	struct DistProjectedAABBPrecalc precalc;
@@ -841,6 +874,533 @@ static void non_recursive_bvh_div_nodes(
 /** \} */
 
 
+/* -------------------------------------------------------------------- */
+/** \name SAH Build
+ *
+ * Top-down build choosing splits with the surface area heuristic (SAH),
+ * evaluated on bins of leaf centroids, see:
+ * "On fast Construction of SAH-based Bounding Volume Hierarchies", Ingo Wald, 2007.
+ *
+ * Binary splits are collapsed into nodes of up to tree_type children by splitting
+ * the child with the largest area until the node is full, or all children are leafs.
+ * Subtrees are built by their own tasks, branches are allocated in the order they're created,
+ * so (as for the implicit tree) children always have an index greater than their parent.
+ *
+ * Only the first 3 axes of the k-DOP are used to calculate areas.
+ * \{ */
+
+#define BVH_SAH_BINS 16
+
+/* Subtrees with fewer leafs are built by the task which created them. */
+#define BVH_SAH_TASK_LEAF_MIN 1024
+
+/* Use median splits below this depth, avoids deep trees for badly distributed leafs. */
+#define BVH_SAH_DEPTH_MAX 48
+
+/* Relative cost of visiting a branch and testing a leaf. */
+#define BVH_SAH_COST_BRANCH 1.0f
+#define BVH_SAH_COST_LEAF 1.0f
+
+typedef struct BVHSAHBounds {
+	float min[3], max[3];
+} BVHSAHBounds;
+
+typedef struct BVHSAHRange {
+	int begin, end;
+	/* Bounds of the leafs and of their centroids. */
+	BVHSAHBounds bounds, centroid_bounds;
+} BVHSAHRange;
+
+typedef struct BVHSAHBin {
+	BVHSAHBounds bounds, centroid_bounds;
+	int count;
+} BVHSAHBin;
+
+typedef struct BVHSAHBuildData {
+	BVHTree *tree;
+	TaskPool *pool;
+	/* Number of branches used, the root being the first one. */
+	int branches_len;
+	int branches_len_capacity;
+} BVHSAHBuildData;
+
+typedef struct BVHSAHBuildTask {
+	BVHNode *node;
+	BVHSAHRange range;
+	int depth;
+} BVHSAHBuildTask;
+
+static void bvh_sah_bounds_init(BVHSAHBounds *b)
+{
+	copy_v3_fl(b->min, FLT_MAX);
+	copy_v3_fl(b->max, -FLT_MAX);
+}
+
+static void bvh_sah_bounds_union(BVHSAHBounds *b, const BVHSAHBounds *b_other)
+{
+	minmax_v3v3_v3(b->min, b->max, b_other->min);
+	minmax_v3v3_v3(b->min, b->max, b_other->max);
+}
+
+static float bvh_sah_bounds_area(const BVHSAHBounds *b)
+{
+	float size[3];
+	if (b->min[0] > b->max[0]) {
+		return 0.0f;
+	}
+	sub_v3_v3v3(size, b->max, b->min);
+	/* Half the surface area, only relative values matter. */
+	return size[0] * size[1] + size[1] * size[2] + size[2] * size[0];
+}
+
+static void bvh_sah_node_bounds(const BVHTree *tree, const BVHNode *node, BVHSAHBounds *r_bounds, float r_centroid[3])
+{
+	for (int a = 0; a < 3; a++) {
+		const int axis = tree->start_axis + a;
+		r_bounds->min[a] = node->bv[2 * axis];
+		r_bounds->max[a] = node->bv[2 * axis + 1];
+		r_centroid[a] = (r_bounds->min[a] + r_bounds->max[a]) * 0.5f;
+	}
+}
+
+static void bvh_sah_range_bounds_calc(const BVHTree *tree, BVHSAHRange *range)
+{
+	bvh_sah_bounds_init(&range->bounds);
+	bvh_sah_bounds_init(&range->centroid_bounds);
+	for (int i = range->begin; i < range->end; i++) {
+		BVHSAHBounds bounds;
+		float centroid[3];
+		bvh_sah_node_bounds(tree, tree->nodes[i], &bounds, centroid);
+		bvh_sah_bounds_union(&range->bounds, &bounds);
+		minmax_v3v3_v3(range->centroid_bounds.min, range->centroid_bounds.max, centroid);
+	}
+}
+
+static int bvh_sah_bin_index(const float centroid, const float min, const float scale)
+{
+	const int bin = (int)((centroid - min) * scale);
+	return CLAMPIS(bin, 0, BVH_SAH_BINS - 1);
+}
+
+/**
+ * Split at the middle leaf, sorting along the largest centroid axis.
+ */
+static void bvh_sah_split_median(const BVHTree *tree, const BVHSAHRange *range, BVHSAHRange r_split[2], int *r_axis)
+{
+	const BVHSAHBounds *cb = &range->centroid_bounds;
+	const int mid = (range->begin + range->end) / 2;
+	float size[3];
+	sub_v3_v3v3(size, cb->max, cb->min);
+	const int axis = (int)max_axis_v3(size);
+
+	partition_nth_element(tree->nodes, range->begin, range->end, mid, 2 * (tree->start_axis + axis) + 1);
+
+	r_split[0].begin = range->begin;
+	r_split[0].end = mid;
+	r_split[1].begin = mid;
+	r_split[1].end = range->end;
+	bvh_sah_range_bounds_calc(tree, &r_split[0]);
+	bvh_sah_range_bounds_calc(tree, &r_split[1]);
+	*r_axis = axis;
+}
+
+/**
+ * Split a range of leafs in two, choosing the split with the lowest SAH cost.
+ */
+static void bvh_sah_split(const BVHTree *tree, const BVHSAHRange *range, const int depth, BVHSAHRange r_split[2], int *r_axis)
+{
+	BVHNode **leafs = tree->nodes;
+	const BVHSAHBounds *cb = &range->centroid_bounds;
+	BVHSAHBin bins[3][BVH_SAH_BINS];
+	float scale[3];
+	float cost_best = FLT_MAX;
+	int axis_best = -1, bin_best = -1;
+
+	if (depth >= BVH_SAH_DEPTH_MAX) {
+		bvh_sah_split_median(tree, range, r_split, r_axis);
+		return;
+	}
+
+	for (int a = 0; a < 3; a++) {
+		const float size = cb->max[a] - cb->min[a];
+		scale[a] = (size > 0.0f) ? (float)BVH_SAH_BINS / size : 0.0f;
+		for (int b = 0; b < BVH_SAH_BINS; b++) {
+			bvh_sah_bounds_init(&bins[a][b].bounds);
+			bvh_sah_bounds_init(&bins[a][b].centroid_bounds);
+			bins[a][b].count = 0;
+		}
+	}
+
+	for (int i = range->begin; i < range->end; i++) {
+		BVHSAHBounds bounds;
+		float centroid[3];
+		bvh_sah_node_bounds(tree, leafs[i], &bounds, centroid);
+		for (int a = 0; a < 3; a++) {
+			BVHSAHBin *bin = &bins[a][bvh_sah_bin_index(centroid[a], cb->min[a], scale[a])];
+			bvh_sah_bounds_union(&bin->bounds, &bounds);
+			minmax_v3v3_v3(bin->centroid_bounds.min, bin->centroid_bounds.max, centroid);
+			bin->count++;
+		}
+	}
+
+	for (int a = 0; a < 3; a++) {
+		float area_right[BVH_SAH_BINS];
+		int count_right[BVH_SAH_BINS];
+		BVHSAHBounds bounds;
+		int count;
+
+		if (scale[a] == 0.0f) {
+			continue;
+		}
+
+		/* Sweep from the right, storing the cost of the leafs right of each split. */
+		bvh_sah_bounds_init(&bounds);
+		count = 0;
+		for (int b = BVH_SAH_BINS - 1; b > 0; b--) {
+			bvh_sah_bounds_union(&bounds, &bins[a][b].bounds);
+			count += bins[a][b].count;
+			area_right[b] = bvh_sah_bounds_area(&bounds);
+			count_right[b] = count;
+		}
+
+		/* Sweep from the left, the split is between bin (b - 1) and b. */
+		bvh_sah_bounds_init(&bounds);
+		count = 0;
+		for (int b = 1; b < BVH_SAH_BINS; b++) {
+			bvh_sah_bounds_union(&bounds, &bins[a][b - 1].bounds);
+			count += bins[a][b - 1].count;
+			if (count != 0 && count_right[b] != 0) {
+				const float cost = bvh_sah_bounds_area(&bounds) * (float)count + area_right[b] * (float)count_right[b];
+				if (cost < cost_best) {
+					cost_best = cost;
+					axis_best = a;
+					bin_best = b;
+				}
+			}
+		}
+	}
+
+	if (axis_best == -1) {
+		/* All centroids are in the same bin. */
+		bvh_sah_split_median(tree, range, r_split, r_axis);
+		return;
+	}
+
+	/* Partition the leafs. */
+	{
+		int i = range->begin, j = range->end - 1;
+		while (i <= j) {
+			BVHSAHBounds bounds;
+			float centroid[3];
+			bvh_sah_node_bounds(tree, leafs[i], &bounds, centroid);
+			if (bvh_sah_bin_index(centroid[axis_best], cb->min[axis_best], scale[axis_best]) < bin_best) {
+				i++;
+			}
+			else {
+				SWAP(BVHNode *, leafs[i], leafs[j]);
+				j--;
+			}
+		}
+		r_split[0].begin = range->begin;
+		r_split[0].end = i;
+		r_split[1].begin = i;
+		r_split[1].end = range->end;
+	}
+
+	for (int side = 0; side < 2; side++) {
+		const int b_start = side ? bin_best : 0;
+		const int b_end = side ? BVH_SAH_BINS : bin_best;
+		bvh_sah_bounds_init(&r_split[side].bounds);
+		bvh_sah_bounds_init(&r_split[side].centroid_bounds);
+		for (int b = b_start; b < b_end; b++) {
+			bvh_sah_bounds_union(&r_split[side].bounds, &bins[axis_best][b].bounds);
+			bvh_sah_bounds_union(&r_split[side].centroid_bounds, &bins[axis_best][b].centroid_bounds);
+		}
+	}
+
+	*r_axis = axis_best;
+}
+
+static BVHNode *bvh_sah_branch_alloc(BVHSAHBuildData *data)
+{
+	const int index = atomic_fetch_and_add_int32(&data->branches_len, 1);
+	BLI_assert(index < data->branches_len_capacity);
+	return &data->tree->nodearray[data->tree->totleaf + index];
+}
+
+static void bvh_sah_build_task_cb(TaskPool *__restrict pool, void *taskdata, int thread_id);
+
+static void bvh_sah_build_node(
+        BVHSAHBuildData *data, BVHNode *node, const BVHSAHRange *range, const int depth, const int thread_id)
+{
+	const BVHTree *tree = data->tree;
+	BVHSAHRange children[MAX_TREETYPE];
+	int children_len = 1;
+
+	children[0] = *range;
+	node->main_axis = 0;
+
+	while (children_len < tree->tree_type) {
+		BVHSAHRange split[2];
+		float area_best = -1.0f;
+		int child_best = -1;
+		int axis;
+
+		/* Split the child with the largest area. */
+		for (int i = 0; i < children_len; i++) {
+			if (children[i].end - children[i].begin > 1) {
+				const float area = bvh_sah_bounds_area(&children[i].bounds);
+				if (area > area_best) {
+					area_best = area;
+					child_best = i;
+				}
+			}
+		}
+		if (child_best == -1) {
+			break;
+		}
+
+		bvh_sah_split(tree, &children[child_best], depth, split, &axis);
+		if (children_len == 1) {
+			node->main_axis = (char)axis;
+		}
+
+		memmove(&children[child_best + 2], &children[child_best + 1],
+		        sizeof(*children) * (size_t)(children_len - (child_best + 1)));
+		children[child_best] = split[0];
+		children[child_best + 1] = split[1];
+		children_len++;
+	}
+
+	node->totnode = (char)children_len;
+
+	for (int i = 0; i < children_len; i++) {
+		const int leafs_len = children[i].end - children[i].begin;
+		BVHNode *child;
+
+		if (leafs_len == 1) {
+			child = tree->nodes[children[i].begin];
+		}
+		else {
+			child = bvh_sah_branch_alloc(data);
+			if (data->pool && leafs_len >= BVH_SAH_TASK_LEAF_MIN) {
+				BVHSAHBuildTask *task = MEM_mallocN(sizeof(*task), __func__);
+				task->node = child;
+				task->range = children[i];
+				task->depth = depth + 1;
+				BLI_task_pool_push_from_thread(data->pool, bvh_sah_build_task_cb, task, true, TASK_PRIORITY_HIGH, thread_id);
+			}
+			else {
+				bvh_sah_build_node(data, child, &children[i], depth + 1, thread_id);
+			}
+		}
+
+		node->children[i] = child;
+		child->parent = node;
+	}
+}
+
+static void bvh_sah_build_task_cb(TaskPool *__restrict pool, void *taskdata, int thread_id)
+{
+	BVHSAHBuildData *data = BLI_task_pool_userdata(pool);
+	BVHSAHBuildTask *task = taskdata;
+	bvh_sah_build_node(data, task->node, &task->range, task->depth, thread_id);
+}
+
+/**
+ * The SAH build may need more branches than the implicit tree,
+ * the most it uses is when nodes which aren't full have 2 leafs, and all others are full.
+ */
+static int bvh_sah_needed_branches(int tree_type, int leafs)
+{
+	return max_ii(1, (tree_type * (leafs - 1) + tree_type - 2) / (2 * tree_type - 2));
+}
+
+static void bvhtree_ensure_branches(BVHTree *tree, int branches_num)
+{
+	const int numnodes_old = (int)(MEM_allocN_len(tree->nodes) / sizeof(*tree->nodes));
+	const int numnodes = tree->totleaf + branches_num + tree->tree_type;
+
+	if (numnodes <= numnodes_old) {
+		return;
+	}
+
+	tree->nodes = MEM_recallocN(tree->nodes, sizeof(BVHNode *) * (size_t)numnodes);
+	tree->nodebv = MEM_recallocN(tree->nodebv, sizeof(float) * (size_t)(tree->axis * numnodes));
+	tree->nodechild = MEM_recallocN(tree->nodechild, sizeof(BVHNode *) * (size_t)(tree->tree_type * numnodes));
+	tree->nodearray = MEM_recallocN(tree->nodearray, sizeof(BVHNode) * (size_t)numnodes);
+
+	/* Re-link the dynamic bv and child links, and the leafs. */
+	for (int i = 0; i < numnodes; i++) {
+		tree->nodearray[i].bv = &tree->nodebv[i * tree->axis];
+		tree->nodearray[i].children = &tree->nodechild[i * tree->tree_type];
+	}
+	for (int i = 0; i < tree->totleaf; i++) {
+		tree->nodes[i] = &tree->nodearray[i];
+	}
+}
+
+/**
+ * Build the tree using the SAH, returns the number of branches.
+ */
+static int bvh_sah_build(BVHTree *tree)
+{
+	BVHSAHBuildData data = {
+		.tree = tree,
+		.branches_len = 1,
+		.branches_len_capacity = bvh_sah_needed_branches(tree->tree_type, tree->totleaf),
+	};
+	BVHNode *root;
+	BVHSAHRange range = {.begin = 0, .end = tree->totleaf};
+
+	bvhtree_ensure_branches(tree, data.branches_len_capacity);
+
+	root = &tree->nodearray[tree->totleaf];
+	root->parent = NULL;
+
+	bvh_sah_range_bounds_calc(tree, &range);
+
+	if (tree->totleaf > KDOPBVH_THREAD_LEAF_THRESHOLD) {
+		BVHSAHBuildTask *task = MEM_mallocN(sizeof(*task), __func__);
+		task->node = root;
+		task->range = range;
+		task->depth = 0;
+
+		data.pool = BLI_task_pool_create(BLI_task_scheduler_get(), &data);
+		BLI_task_pool_push(data.pool, bvh_sah_build_task_cb, task, true, TASK_PRIORITY_HIGH);
+		BLI_task_pool_work_and_wait(data.pool);
+		BLI_task_pool_free(data.pool);
+	}
+	else {
+		bvh_sah_build_node(&data, root, &range, 0, 0);
+	}
+
+	/* Calculate the bounding volumes of all branches, children come after their parent. */
+	for (int i = data.branches_len - 1; i >= 0; i--) {
+		node_join(tree, &tree->nodearray[tree->totleaf + i]);
+	}
+
+	return data.branches_len;
+}
+
+/** \} */
+
+
+/* -------------------------------------------------------------------- */
+/** \name Build Statistics
+ * \{ */
+
+static float bvh_node_area(const BVHTree *tree, const BVHNode *node)
+{
+	BVHSAHBounds bounds;
+	float centroid[3];
+	bvh_sah_node_bounds(tree, node, &bounds, centroid);
+	return bvh_sah_bounds_area(&bounds);
+}
+
+static void bvhtree_stats_calc_recursive(
+        const BVHTree *tree, const BVHNode *node, const int depth, BVHTreeBuildStats *stats)
+{
+	const float area = bvh_node_area(tree, node);
+
+	stats->depth_max = max_ii(stats->depth_max, depth);
+
+	if (node->totnode == 0) {
+		stats->sah_cost += area * BVH_SAH_COST_LEAF;
+		return;
+	}
+
+	stats->sah_cost += area * BVH_SAH_COST_BRANCH;
+	for (int i = 0; i < node->totnode; i++) {
+		bvhtree_stats_calc_recursive(tree, node->children[i], depth + 1, stats);
+	}
+}
+
+static void bvhtree_stats_calc(const BVHTree *tree, BVHTreeBuildStats *stats)
+{
+	stats->totleaf = tree->totleaf;
+	stats->totbranch = tree->totbranch;
+	stats->depth_max = 0;
+	stats->sah_cost = 0.0f;
+
+	if (tree->totleaf != 0) {
+		const BVHNode *root = tree->nodes[tree->totleaf];
+		const float area = bvh_node_area(tree, root);
+		bvhtree_stats_calc_recursive(tree, root, 0, stats);
+		/* Relative to the root, so it's the expected cost of a query. */
+		stats->sah_cost = (area > 0.0f) ? stats->sah_cost / area : 0.0f;
+	}
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Parallel Refit
+ *
+ * Bottom-up update of the branch bounds, used by #BLI_bvhtree_update_tree.
+ * The top of the tree is split into independent subtrees which are refit in parallel,
+ * the few branches above them are joined afterwards.
+ * \{ */
+
+/* Number of subtrees to refit in parallel, more than threads to even out unbalanced trees. */
+#define KDOPBVH_REFIT_SUBTREES 128
+
+static void node_join_recursive(BVHTree *tree, BVHNode *node)
+{
+	for (int i = 0; i < node->totnode; i++) {
+		if (node->children[i]->totnode != 0) {
+			node_join_recursive(tree, node->children[i]);
+		}
+	}
+	node_join(tree, node);
+}
+
+static void bvhtree_refit_subtree_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BVHTree *tree = ((void **)userdata)[0];
+	BVHNode **subtrees = ((void **)userdata)[1];
+	node_join_recursive(tree, subtrees[i]);
+}
+
+static void bvhtree_refit_threaded(BVHTree *tree)
+{
+	/* Breadth first list of branches, parents always come before their children. */
+	BVHNode **queue = MEM_mallocN(sizeof(*queue) * (size_t)tree->totbranch, __func__);
+	int queue_len = 0, queue_head = 0;
+
+	queue[queue_len++] = tree->nodes[tree->totleaf];
+
+	/* Expand the top of the tree until there are enough subtrees,
+	 * branches in [0, queue_head) are above the subtrees in [queue_head, queue_len). */
+	while ((queue_head < queue_len) && (queue_len - queue_head < KDOPBVH_REFIT_SUBTREES)) {
+		BVHNode *node = queue[queue_head++];
+		for (int i = 0; i < node->totnode; i++) {
+			if (node->children[i]->totnode != 0) {
+				queue[queue_len++] = node->children[i];
+			}
+		}
+	}
+
+	if (queue_head < queue_len) {
+		void *userdata[2] = {tree, &queue[queue_head]};
+		ParallelRangeSettings settings;
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+		BLI_task_parallel_range(0, queue_len - queue_head, userdata, bvhtree_refit_subtree_cb, &settings);
+	}
+
+	for (int i = queue_head - 1; i >= 0; i--) {
+		node_join(tree, queue[i]);
+	}
+
+	MEM_freeN(queue);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree API
  * \{ */
@@ -939,19 +1499,36 @@ void BLI_bvhtree_free(BVHTree *tree)
 }
 
 void BLI_bvhtree_balance(BVHTree *tree)
+{
+	BLI_bvhtree_balance_ex(tree, 0, NULL);
+}
+
+/**
+ * \param flag: #BVH_BUILD_SAH to build using the surface area heuristic,
+ * slower to build than the default median split, but gives faster queries.
+ * Note that this may need to allocate more branches than the default build.
+ * \param r_stats: Optional, statistics about the resulting tree.
+ */
+void BLI_bvhtree_balance_ex(BVHTree *tree, const int flag, BVHTreeBuildStats *r_stats)
 {
 	BVHNode **leafs_array    = tree->nodes;
+	const double time_start = r_stats ? PIL_check_seconds_timer() : 0.0;
 
 	/* This function should only be called once
 	 * (some big bug goes here if its being called more than once per tree) */
 	BLI_assert(tree->totbranch == 0);
 
-	/* Build the implicit tree */
-	non_recursive_bvh_div_nodes(tree, tree->nodearray + (tree->totleaf - 1), leafs_array, tree->totleaf);
+	if ((flag & BVH_BUILD_SAH) && (tree->totleaf > 1)) {
+		tree->totbranch = bvh_sah_build(tree);
+	}
+	else {
+		/* Build the implicit tree */
+		non_recursive_bvh_div_nodes(tree, tree->nodearray + (tree->totleaf - 1), leafs_array, tree->totleaf);
+		tree->totbranch = implicit_needed_branches(tree->tree_type, tree->totleaf);
+	}
 
 	/* current code expects the branches to be linked to the nodes array
 	 * we perform that linkage here */
-	tree->totbranch = implicit_needed_branches(tree->tree_type, tree->totleaf);
 	for (int i = 0; i < tree->totbranch; i++) {
 		tree->nodes[tree->totleaf + i] = &tree->nodearray[tree->totleaf + i];
 	}
@@ -967,6 +1544,11 @@ void BLI_bvhtree_balance(BVHTree *tree)
 #ifdef USE_PRINT_TREE
 	bvhtree_info(tree);
 #endif
+
+	if (r_stats) {
+		r_stats->time = PIL_check_seconds_timer() - time_start;
+		bvhtree_stats_calc(tree, r_stats);
+	}
 }
 
 void BLI_bvhtree_insert(BVHTree *tree, int index, const float co[3], int numpoints)
@@ -1023,6 +1605,15 @@ bool BLI_bvhtree_update_node(BVHTree *tree, int index, const float co[3], const
 /* call BLI_bvhtree_update_node() first for every node/point/triangle */
 void BLI_bvhtree_update_tree(BVHTree *tree)
 {
+	if (tree->totbranch == 0) {
+		return;
+	}
+
+	if (tree->totleaf > KDOPBVH_THREAD_LEAF_THRESHOLD) {
+		bvhtree_refit_threaded(tree);
+		return;
+	}
+
 	/* Update bottom=>top
 	 * TRICKY: the way we build the tree all the childs have an index greater than the parent
 	 * This allows us todo a bottom up update by starting on the bigger numbered branch */
@@ -1757,6 +2348,219 @@ void BLI_bvhtree_ray_cast_all(
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name BLI_bvhtree_ray_cast_packet
+ *
+ * Cast #BVH_RAYCAST_PACKET_SIZE rays at once, testing each node against all rays of the packet,
+ * for coherent rays (similar origins and directions) most nodes are hit by all or none of them,
+ * so the tree is traversed once per packet instead of once per ray.
+ * \{ */
+
+/**
+ * \return a bit-mask of the rays which hit the bounding volume of \a node, closer than their current hit.
+ */
+#ifdef __SSE2__
+static uint bvh_ray_packet_node_test(const BVHRayPacketData *data, const BVHNode *node, float r_dist[BVH_RAYCAST_PACKET_SIZE])
+{
+	const float *bv = node->bv;
+	const __m128 hit_dist = _mm_loadu_ps(data->hit_dist);
+	__m128 t_near = _mm_setzero_ps();
+	__m128 t_far = hit_dist;
+
+	for (int i = 0; i < 3; i++) {
+		const __m128 origin = _mm_loadu_ps(data->origin[i]);
+		const __m128 idot_axis = _mm_loadu_ps(data->idot_axis[i]);
+		const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bv[2 * i]), origin), idot_axis);
+		const __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(bv[2 * i + 1]), origin), idot_axis);
+		/* Keep the accumulated value last, so NAN's (from a zero direction) are ignored. */
+		t_near = _mm_max_ps(_mm_min_ps(t1, t2), t_near);
+		t_far = _mm_min_ps(_mm_max_ps(t1, t2), t_far);
+	}
+
+	_mm_storeu_ps(r_dist, t_near);
+	return data->ray_mask &
+	       (uint)_mm_movemask_ps(_mm_and_ps(_mm_cmple_ps(t_near, t_far), _mm_cmplt_ps(t_near, hit_dist)));
+}
+#else
+static uint bvh_ray_packet_node_test(const BVHRayPacketData *data, const BVHNode *node, float r_dist[BVH_RAYCAST_PACKET_SIZE])
+{
+	const float *bv = node->bv;
+	uint mask = 0;
+
+	for (int l = 0; l < BVH_RAYCAST_PACKET_SIZE; l++) {
+		float t_near = 0.0f, t_far = data->hit_dist[l];
+		for (int i = 0; i < 3; i++) {
+			const float t1 = (bv[2 * i] - data->origin[i][l]) * data->idot_axis[i][l];
+			const float t2 = (bv[2 * i + 1] - data->origin[i][l]) * data->idot_axis[i][l];
+			t_near = max_ff(min_ff(t1, t2), t_near);
+			t_far = min_ff(max_ff(t1, t2), t_far);
+		}
+		r_dist[l] = t_near;
+		if ((t_near <= t_far) && (t_near < data->hit_dist[l])) {
+			mask |= (1u << l);
+		}
+	}
+	return data->ray_mask & mask;
+}
+#endif  /* __SSE2__ */
+
+static void bvh_ray_packet_init(
+        BVHRayPacketData *data, const float (*co)[3], const float (*dir)[3], const int rays_len,
+        BVHTreeRayHit *hits, int flag)
+{
+	data->ray_mask = (1u << rays_len) - 1;
+
+	for (int l = 0; l < BVH_RAYCAST_PACKET_SIZE; l++) {
+		if (l < rays_len) {
+			BVHTreeRay *ray = &data->ray[l];
+
+			BLI_ASSERT_UNIT_V3(dir[l]);
+
+			copy_v3_v3(ray->origin, co[l]);
+			copy_v3_v3(ray->direction, dir[l]);
+			ray->radius = 0.0f;
+#ifdef USE_KDOPBVH_WATERTIGHT
+			if (flag & BVH_RAYCAST_WATERTIGHT) {
+				isect_ray_tri_watertight_v3_precalc(&data->isect_precalc[l], ray->direction);
+				ray->isect_precalc = &data->isect_precalc[l];
+			}
+			else {
+				ray->isect_precalc = NULL;
+			}
+#else
+			UNUSED_VARS(flag);
+#endif
+
+			data->hit[l] = &hits[l];
+			data->hit_dist[l] = hits[l].dist;
+			for (int i = 0; i < 3; i++) {
+				data->origin[i][l] = ray->origin[i];
+				data->idot_axis[i][l] = 1.0f / ray->direction[i];
+			}
+		}
+		else {
+			/* Unused, masked out of all results. */
+			data->hit[l] = NULL;
+			data->hit_dist[l] = 0.0f;
+			for (int i = 0; i < 3; i++) {
+				data->origin[i][l] = 0.0f;
+				data->idot_axis[i][l] = 0.0f;
+			}
+		}
+	}
+}
+
+static void bvh_ray_packet_traverse(BVHRayPacketData *data, BVHNode *root)
+{
+	int stack_len = 0;
+
+	data->stack[stack_len++] = root;
+
+	while (stack_len) {
+		BVHNode *node = data->stack[--stack_len];
+		float dist[BVH_RAYCAST_PACKET_SIZE];
+		const uint mask = bvh_ray_packet_node_test(data, node, dist);
+
+		if (mask == 0) {
+			continue;
+		}
+
+		if (node->totnode == 0) {
+			for (int l = 0; l < BVH_RAYCAST_PACKET_SIZE; l++) {
+				if (mask & (1u << l)) {
+					BVHTreeRayHit *hit = data->hit[l];
+					if (data->callback) {
+						data->callback(data->userdata, node->index, &data->ray[l], hit);
+					}
+					else {
+						hit->index = node->index;
+						hit->dist  = dist[l];
+						madd_v3_v3v3fl(hit->co, data->ray[l].origin, data->ray[l].direction, dist[l]);
+					}
+					data->hit_dist[l] = hit->dist;
+				}
+			}
+		}
+		else {
+			/* Pick the order to visit children from the direction of most rays
+			 * (based on ray direction and split axis), the last pushed is visited first. */
+			int dir_sum = 0;
+			for (int l = 0; l < BVH_RAYCAST_PACKET_SIZE; l++) {
+				if (mask & (1u << l)) {
+					dir_sum += (data->ray[l].direction[node->main_axis] > 0.0f) ? 1 : -1;
+				}
+			}
+
+			if (UNLIKELY(stack_len + node->totnode > data->stack_len_capacity)) {
+				data->stack_len_capacity *= 2;
+				data->stack = MEM_reallocN(data->stack, sizeof(*data->stack) * (size_t)data->stack_len_capacity);
+			}
+
+			if (dir_sum > 0) {
+				for (int i = node->totnode - 1; i >= 0; i--) {
+					data->stack[stack_len++] = node->children[i];
+				}
+			}
+			else {
+				for (int i = 0; i != node->totnode; i++) {
+					data->stack[stack_len++] = node->children[i];
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Cast many rays, gives the same results as calling #BLI_bvhtree_ray_cast_ex for each ray,
+ * faster when consecutive rays are coherent (similar origins and directions),
+ * since they're traversed together, testing nodes against multiple rays at once (using SIMD).
+ *
+ * \param hits: Array of \a rays_len hits, initialized as for #BLI_bvhtree_ray_cast_ex.
+ * \param callback: Called for every ray which hits a leaf's bounding volume.
+ *
+ * \note Rays with a radius are cast one at a time.
+ */
+void BLI_bvhtree_ray_cast_packet_ex(
+        BVHTree *tree, const float (*co)[3], const float (*dir)[3], const int rays_len, float radius,
+        BVHTreeRayHit *hits, BVHTree_RayCastCallback callback, void *userdata,
+        int flag)
+{
+	BVHNode *root = tree->nodes[tree->totleaf];
+	BVHRayPacketData data;
+
+	if (radius != 0.0f) {
+		for (int i = 0; i < rays_len; i++) {
+			BLI_bvhtree_ray_cast_ex(tree, co[i], dir[i], radius, &hits[i], callback, userdata, flag);
+		}
+		return;
+	}
+
+	if (root == NULL) {
+		return;
+	}
+
+	data.callback = callback;
+	data.userdata = userdata;
+	data.stack_len_capacity = 256;
+	data.stack = MEM_mallocN(sizeof(*data.stack) * (size_t)data.stack_len_capacity, __func__);
+
+	for (int i = 0; i < rays_len; i += BVH_RAYCAST_PACKET_SIZE) {
+		bvh_ray_packet_init(&data, &co[i], &dir[i], min_ii(BVH_RAYCAST_PACKET_SIZE, rays_len - i), &hits[i], flag);
+		bvh_ray_packet_traverse(&data, root);
+	}
+
+	MEM_freeN(data.stack);
+}
+
+void BLI_bvhtree_ray_cast_packet(
+        BVHTree *tree, const float (*co)[3], const float (*dir)[3], const int rays_len, float radius,
+        BVHTreeRayHit *hits, BVHTree_RayCastCallback callback, void *userdata)
+{
+	BLI_bvhtree_ray_cast_packet_ex(tree, co, dir, rays_len, radius, hits, callback, userdata, BVH_RAYCAST_DEFAULT);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name BLI_bvhtree_range_query
  *
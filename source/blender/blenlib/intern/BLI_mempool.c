@@ -589,6 +589,59 @@ void  BLI_mempool_iter_threadsafe_free(BLI_mempool_iter *iter_arr)
 	MEM_freeN(iter_arr);
 }
 
+/**
+ * Create an array of all chunks of the pool, in iteration order.
+ *
+ * Allows threaded code to split iteration over whole chunks without having
+ * to walk the (single linked) list of chunks concurrently,
+ * see #BLI_mempool_iternew_chunk.
+ *
+ * \return The array (to be freed with #MEM_freeN), or NULL when the pool has no chunks.
+ */
+BLI_mempool_chunk **BLI_mempool_chunks_array_create(BLI_mempool *pool, uint *r_chunks_len)
+{
+	BLI_mempool_chunk *mpchunk;
+	uint chunks_len = 0;
+
+	for (mpchunk = pool->chunks; mpchunk; mpchunk = mpchunk->next) {
+		chunks_len++;
+	}
+
+	*r_chunks_len = chunks_len;
+	if (chunks_len == 0) {
+		return NULL;
+	}
+
+	BLI_mempool_chunk **chunks = MEM_mallocN(sizeof(*chunks) * chunks_len, __func__);
+	uint i = 0;
+	for (mpchunk = pool->chunks; mpchunk; mpchunk = mpchunk->next) {
+		chunks[i++] = mpchunk;
+	}
+
+	return chunks;
+}
+
+/**
+ * Initialize an iterator over the items of a single \a chunk of the pool,
+ * #BLI_MEMPOOL_ALLOW_ITER flag must be set.
+ *
+ * \note Unlike #BLI_mempool_iter_threadsafe_create there is no shared state,
+ * so iterators over different chunks can be used from different threads without any synchronization.
+ */
+void BLI_mempool_iternew_chunk(BLI_mempool *pool, BLI_mempool_iter *iter, BLI_mempool_chunk *chunk)
+{
+	/* Always NULL, iterators reading their 'next' chunk from there stop at the end of their current chunk. */
+	static BLI_mempool_chunk *chunk_none = NULL;
+
+	BLI_assert(pool->flag & BLI_MEMPOOL_ALLOW_ITER);
+
+	iter->pool = pool;
+	iter->curchunk = chunk;
+	iter->curindex = 0;
+
+	iter->curchunk_threaded_shared = &chunk_none;
+}
+
 #if 0
 /* unoptimized, more readable */
 
@@ -0,0 +1,224 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bli
+ */
+
+#include <string.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef WIN32
+#  include <windows.h>
+#  include <io.h>
+#else
+#  include <sys/mman.h>
+#  include <signal.h>
+#endif
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_fileops.h"
+#include "BLI_listbase.h"
+#include "BLI_mmap.h"
+#include "BLI_threads.h"
+
+#include "BLI_strict_flags.h"
+
+struct BLI_mmap_file {
+	/* The address to which the file was mapped. */
+	char *memory;
+
+	/* The length of the file (and therefore the mapped region). */
+	size_t length;
+
+	/* Set when reading the mapped memory failed (the file was truncated or its storage removed),
+	 * no further reads are attempted then. */
+	volatile bool io_error;
+
+#ifdef WIN32
+	HANDLE mapping;
+#endif
+};
+
+#ifndef WIN32
+/* Reading pages of a mapping which can't be read from the file anymore raises SIGBUS,
+ * the handler flags the mapped file the address belongs to and replaces its pages by zeroes,
+ * so the read finishes and its result can be discarded. */
+static struct {
+	ListBase open_mmaps;
+	bool configured;
+	void (*next_handler)(int, siginfo_t *, void *);
+} error_handler = {{NULL}};
+
+static ThreadMutex error_handler_lock = BLI_MUTEX_INITIALIZER;
+
+static void sigbus_handler(int sig, siginfo_t *siginfo, void *ptr)
+{
+	const char *error_addr = (const char *)siginfo->si_addr;
+
+	for (LinkData *link = error_handler.open_mmaps.first; link; link = link->next) {
+		BLI_mmap_file *file = link->data;
+		if (error_addr >= file->memory && error_addr < file->memory + file->length) {
+			file->io_error = true;
+			if (mmap(file->memory, file->length, PROT_READ,
+			         MAP_FIXED | MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) == MAP_FAILED)
+			{
+				abort();
+			}
+			return;
+		}
+	}
+
+	/* Not an error of a mapped file. */
+	if (error_handler.next_handler != NULL) {
+		error_handler.next_handler(sig, siginfo, ptr);
+	}
+	else {
+		abort();
+	}
+}
+
+static bool sigbus_handler_add(BLI_mmap_file *file)
+{
+	bool ok = true;
+
+	BLI_mutex_lock(&error_handler_lock);
+	if (!error_handler.configured) {
+		struct sigaction newact, oldact;
+		memset(&newact, 0, sizeof(newact));
+		newact.sa_sigaction = sigbus_handler;
+		newact.sa_flags = SA_SIGINFO;
+		if (sigaction(SIGBUS, &newact, &oldact) == 0) {
+			/* Errors which aren't caused by reading a mapped file are passed on. */
+			if (oldact.sa_flags & SA_SIGINFO) {
+				error_handler.next_handler = oldact.sa_sigaction;
+			}
+			error_handler.configured = true;
+		}
+		else {
+			ok = false;
+		}
+	}
+	if (ok) {
+		BLI_addtail(&error_handler.open_mmaps, BLI_genericNodeN(file));
+	}
+	BLI_mutex_unlock(&error_handler_lock);
+
+	return ok;
+}
+
+static void sigbus_handler_remove(BLI_mmap_file *file)
+{
+	BLI_mutex_lock(&error_handler_lock);
+	LinkData *link = BLI_findptr(&error_handler.open_mmaps, file, offsetof(LinkData, data));
+	BLI_freelinkN(&error_handler.open_mmaps, link);
+	BLI_mutex_unlock(&error_handler_lock);
+}
+#endif  /* WIN32 */
+
+BLI_mmap_file *BLI_mmap_open(int fd)
+{
+	const size_t length = BLI_file_descriptor_size(fd);
+	/* Mapping an empty file fails, so does an invalid descriptor (size of -1). */
+	if ((length == 0) || (length == (size_t)-1)) {
+		return NULL;
+	}
+
+#ifdef WIN32
+	HANDLE handle = (HANDLE)_get_osfhandle(fd);
+	if (handle == INVALID_HANDLE_VALUE) {
+		return NULL;
+	}
+	HANDLE mapping = CreateFileMapping(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) {
+		return NULL;
+	}
+	void *memory = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (memory == NULL) {
+		CloseHandle(mapping);
+		return NULL;
+	}
+#else
+	void *memory = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (memory == MAP_FAILED) {
+		return NULL;
+	}
+#endif
+
+	BLI_mmap_file *file = MEM_callocN(sizeof(*file), __func__);
+	file->memory = memory;
+	file->length = length;
+#ifdef WIN32
+	file->mapping = mapping;
+#else
+	/* Without the handler, an IO error while reading would crash. */
+	if (!sigbus_handler_add(file)) {
+		munmap(memory, length);
+		MEM_freeN(file);
+		return NULL;
+	}
+#endif
+	return file;
+}
+
+bool BLI_mmap_read(BLI_mmap_file *file, void *dest, size_t offset, size_t length)
+{
+	if (file->io_error || (offset > file->length) || (length > file->length - offset)) {
+		return false;
+	}
+
+#ifdef WIN32
+	__try {
+		memcpy(dest, file->memory + offset, length);
+	}
+	__except (GetExceptionCode() == EXCEPTION_IN_PAGE_ERROR ?
+	          EXCEPTION_EXECUTE_HANDLER : EXCEPTION_CONTINUE_SEARCH)
+	{
+		file->io_error = true;
+	}
+#else
+	/* Sets #BLI_mmap_file.io_error on failure, see #sigbus_handler. */
+	memcpy(dest, file->memory + offset, length);
+#endif
+
+	return !file->io_error;
+}
+
+const void *BLI_mmap_get_pointer(const BLI_mmap_file *file)
+{
+	return file->memory;
+}
+
+size_t BLI_mmap_get_length(const BLI_mmap_file *file)
+{
+	return file->length;
+}
+
+void BLI_mmap_free(BLI_mmap_file *file)
+{
+#ifdef WIN32
+	UnmapViewOfFile(file->memory);
+	CloseHandle(file->mapping);
+#else
+	sigbus_handler_remove(file);
+	munmap(file->memory, file->length);
+#endif
+	MEM_freeN(file);
+}
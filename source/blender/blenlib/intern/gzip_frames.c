@@ -0,0 +1,717 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bli
+ *
+ * Seekable gzip files, see BLI_gzip_frames.h.
+ *
+ * Layout, all numbers are little endian:
+ * <pre>
+ * frame:   gzip header, FLG=FEXTRA, XLEN=12
+ *          'B' 'F' LEN=8 <uint32 member size> <uint32 uncompressed size>
+ *          raw deflate data, CRC32, ISIZE
+ * ...
+ * index:   gzip header, FLG=FEXTRA, XLEN=8 + 4 * frames
+ *          'B' 'I' LEN=4 + 4 * frames <uint32 frame size> <uint32 member size> * frames
+ *          empty deflate data, CRC32, ISIZE
+ * end:     gzip header, FLG=FEXTRA, XLEN=12
+ *          'B' 'E' LEN=8 <uint64 offset of the index member>
+ *          empty deflate data, CRC32, ISIZE
+ * </pre>
+ *
+ * The end member has a fixed size, so the index can be found from the end of the file.
+ * The index is limited by the size of the extra field, files with more frames
+ * don't write it and readers find the frames by walking over the member headers instead.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+
+#include "zlib.h"
+
+#ifdef WIN32
+#  include <io.h>
+#  include "BLI_winstuff.h"
+#else
+#  include <unistd.h>
+#endif
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_gzip_frames.h"
+#include "BLI_math_base.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+
+#include "BLI_strict_flags.h"
+
+#define GZ_HEADER_LEN 10
+#define GZ_TRAILER_LEN 8
+#define GZ_FLAG_EXTRA 0x04
+
+/* Header, XLEN and the 'BF' sub-field. */
+#define GZ_FRAME_HEADER_LEN (GZ_HEADER_LEN + 2 + 4 + 8)
+/* The whole end member, see #gz_member_empty_write. */
+#define GZ_END_LEN (GZ_HEADER_LEN + 2 + 4 + 8 + 2 + GZ_TRAILER_LEN)
+/* Header and XLEN, followed by the sub-fields. */
+#define GZ_EXTRA_HEADER_LEN (GZ_HEADER_LEN + 2)
+/* Sanity check for reading, avoids huge allocations for corrupt files. */
+#define GZ_FRAME_SIZE_MAX (1 << 28)
+/* Limited by the 16 bit XLEN. */
+#define GZ_INDEX_FRAMES_MAX ((0xffff - 4 - 4) / 4)
+
+/* Deflate stream of zero bytes. */
+static const uchar gz_deflate_empty[2] = {0x03, 0x00};
+
+/* -------------------------------------------------------------------- */
+/** \name Utilities
+ * \{ */
+
+static void gz_put_u16(uchar *p, uint v)
+{
+	p[0] = (uchar)(v & 0xff);
+	p[1] = (uchar)((v >> 8) & 0xff);
+}
+
+static void gz_put_u32(uchar *p, uint32_t v)
+{
+	gz_put_u16(p, v & 0xffff);
+	gz_put_u16(p + 2, v >> 16);
+}
+
+static void gz_put_u64(uchar *p, uint64_t v)
+{
+	gz_put_u32(p, (uint32_t)(v & 0xffffffff));
+	gz_put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint gz_get_u16(const uchar *p)
+{
+	return (uint)p[0] | ((uint)p[1] << 8);
+}
+
+static uint32_t gz_get_u32(const uchar *p)
+{
+	return (uint32_t)gz_get_u16(p) | ((uint32_t)gz_get_u16(p + 2) << 16);
+}
+
+static uint64_t gz_get_u64(const uchar *p)
+{
+	return (uint64_t)gz_get_u32(p) | ((uint64_t)gz_get_u32(p + 4) << 32);
+}
+
+/**
+ * Write the gzip header with an extra field of \a xlen bytes,
+ * starting with a sub-field \a id of \a len bytes.
+ */
+static void gz_header_write(uchar *p, uint xlen, const char id[2], uint len)
+{
+	memset(p, 0, GZ_HEADER_LEN);
+	p[0] = 0x1f;
+	p[1] = 0x8b;
+	p[2] = Z_DEFLATED;
+	p[3] = GZ_FLAG_EXTRA;
+	/* Unknown OS. */
+	p[9] = 0xff;
+	gz_put_u16(&p[10], xlen);
+	p[12] = (uchar)id[0];
+	p[13] = (uchar)id[1];
+	gz_put_u16(&p[14], len);
+}
+
+/**
+ * \return The length of the extra field,
+ * when \a p is a gzip header with an extra field starting with sub-field \a id.
+ */
+static uint gz_header_check(const uchar *p, const char id[2])
+{
+	if ((p[0] == 0x1f) && (p[1] == 0x8b) && (p[2] == Z_DEFLATED) && (p[3] == GZ_FLAG_EXTRA) &&
+	    (p[12] == (uchar)id[0]) && (p[13] == (uchar)id[1]))
+	{
+		return gz_get_u16(&p[10]);
+	}
+	return 0;
+}
+
+/** Terminate an empty member after its header. */
+static void gz_member_empty_write(uchar *p)
+{
+	memcpy(p, gz_deflate_empty, sizeof(gz_deflate_empty));
+	memset(p + sizeof(gz_deflate_empty), 0, GZ_TRAILER_LEN);
+}
+
+static bool gz_write_all(int file, const uchar *data, size_t data_len)
+{
+	while (data_len != 0) {
+		const uint chunk = (uint)MIN2(data_len, (size_t)INT_MAX);
+		const int len = (int)write(file, data, chunk);
+		if (len <= 0) {
+			return false;
+		}
+		data += len;
+		data_len -= (size_t)len;
+	}
+	return true;
+}
+
+static bool gz_read_at(int file, uint64_t offset, uchar *data, size_t data_len)
+{
+	if (lseek(file, (int64_t)offset, SEEK_SET) == -1) {
+		return false;
+	}
+	while (data_len != 0) {
+		const uint chunk = (uint)MIN2(data_len, (size_t)INT_MAX);
+		const int len = (int)read(file, data, chunk);
+		if (len <= 0) {
+			return false;
+		}
+		data += len;
+		data_len -= (size_t)len;
+	}
+	return true;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Writing
+ * \{ */
+
+typedef struct GzFrame {
+	/* Uncompressed data, #GZ_FRAMES_FRAME_SIZE bytes. */
+	uchar *data;
+	size_t data_len;
+	/* Complete gzip member, #GzFramesWriter.member_len_max bytes, zero on error. */
+	uchar *member;
+	size_t member_len;
+} GzFrame;
+
+struct GzFramesWriter {
+	int file;
+	int level;
+
+	/**
+	 * Frames are compressed in batches, the frame after the first
+	 * #GzFramesWriter.frames_used ones is being filled.
+	 */
+	GzFrame *frames;
+	int frames_len;
+	int frames_used;
+	size_t member_len_max;
+
+	/* Member size of all written frames. */
+	uint32_t *index;
+	int index_len;
+	int index_alloc;
+	uint64_t file_offset;
+
+	bool error;
+};
+
+static void gz_frame_compress(GzFrame *frame, int level, size_t member_len_max)
+{
+	z_stream strm = {NULL};
+	frame->member_len = 0;
+
+	if (deflateInit2(&strm, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		return;
+	}
+	strm.next_in = frame->data;
+	strm.avail_in = (uInt)frame->data_len;
+	strm.next_out = frame->member + GZ_FRAME_HEADER_LEN;
+	strm.avail_out = (uInt)(member_len_max - GZ_FRAME_HEADER_LEN - GZ_TRAILER_LEN);
+	const int ret = deflate(&strm, Z_FINISH);
+	const size_t deflate_len = (size_t)strm.total_out;
+	deflateEnd(&strm);
+	if (ret != Z_STREAM_END) {
+		return;
+	}
+
+	const size_t member_len = GZ_FRAME_HEADER_LEN + deflate_len + GZ_TRAILER_LEN;
+	uchar *p = frame->member;
+	gz_header_write(p, 12, "BF", 8);
+	gz_put_u32(&p[16], (uint32_t)member_len);
+	gz_put_u32(&p[20], (uint32_t)frame->data_len);
+
+	p += GZ_FRAME_HEADER_LEN + deflate_len;
+	gz_put_u32(&p[0], (uint32_t)crc32(0, frame->data, (uInt)frame->data_len));
+	gz_put_u32(&p[4], (uint32_t)frame->data_len);
+
+	frame->member_len = member_len;
+}
+
+static void gz_frames_compress_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	GzFramesWriter *gw = userdata;
+	gz_frame_compress(&gw->frames[i], gw->level, gw->member_len_max);
+}
+
+/** Compress the full frames in parallel, then write them in order. */
+static void gz_frames_flush(GzFramesWriter *gw)
+{
+	if (gw->frames_used == 0) {
+		return;
+	}
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (gw->frames_used > 1);
+	BLI_task_parallel_range(0, gw->frames_used, gw, gz_frames_compress_cb, &settings);
+
+	for (int i = 0; i < gw->frames_used; i++) {
+		GzFrame *frame = &gw->frames[i];
+		if (gw->error == false) {
+			if ((frame->member_len == 0) || !gz_write_all(gw->file, frame->member, frame->member_len)) {
+				gw->error = true;
+			}
+			else {
+				if (gw->index_len == gw->index_alloc) {
+					gw->index_alloc *= 2;
+					gw->index = MEM_reallocN(gw->index, sizeof(*gw->index) * (size_t)gw->index_alloc);
+				}
+				gw->index[gw->index_len++] = (uint32_t)frame->member_len;
+				gw->file_offset += frame->member_len;
+			}
+		}
+		frame->data_len = 0;
+	}
+	gw->frames_used = 0;
+}
+
+static bool gz_frames_write_index(GzFramesWriter *gw)
+{
+	const uint xlen = 4 + 4 + 4 * (uint)gw->index_len;
+	const size_t index_len = GZ_EXTRA_HEADER_LEN + xlen + sizeof(gz_deflate_empty) + GZ_TRAILER_LEN;
+	uchar *buf = MEM_mallocN(index_len + GZ_END_LEN, __func__);
+
+	uchar *p = buf;
+	gz_header_write(p, xlen, "BI", xlen - 4);
+	gz_put_u32(&p[16], GZ_FRAMES_FRAME_SIZE);
+	for (int i = 0; i < gw->index_len; i++) {
+		gz_put_u32(&p[20 + 4 * i], gw->index[i]);
+	}
+	gz_member_empty_write(p + GZ_EXTRA_HEADER_LEN + xlen);
+
+	p = buf + index_len;
+	gz_header_write(p, 12, "BE", 8);
+	gz_put_u64(&p[16], gw->file_offset);
+	gz_member_empty_write(p + GZ_EXTRA_HEADER_LEN + 12);
+
+	const bool ok = gz_write_all(gw->file, buf, index_len + GZ_END_LEN);
+	MEM_freeN(buf);
+	return ok;
+}
+
+/**
+ * Start writing a framed gzip file to \a file (which is left open when done).
+ *
+ * \param level: zlib compression level.
+ */
+GzFramesWriter *BLI_gzframes_writer_new(int file, int level)
+{
+	GzFramesWriter *gw = MEM_callocN(sizeof(*gw), __func__);
+	gw->file = file;
+	gw->level = level;
+
+	/* Enough frames to keep all threads busy, without holding on to too much memory. */
+	gw->frames_len = max_ii(2, BLI_system_thread_count() * 2);
+	gw->frames = MEM_callocN(sizeof(*gw->frames) * (size_t)gw->frames_len, __func__);
+	gw->member_len_max = GZ_FRAME_HEADER_LEN + compressBound(GZ_FRAMES_FRAME_SIZE) + GZ_TRAILER_LEN;
+	for (int i = 0; i < gw->frames_len; i++) {
+		gw->frames[i].data = MEM_mallocN(GZ_FRAMES_FRAME_SIZE, __func__);
+		gw->frames[i].member = MEM_mallocN(gw->member_len_max, __func__);
+	}
+
+	gw->index_alloc = 64;
+	gw->index = MEM_mallocN(sizeof(*gw->index) * (size_t)gw->index_alloc, __func__);
+	return gw;
+}
+
+bool BLI_gzframes_writer_write(GzFramesWriter *gw, const void *data, size_t data_len)
+{
+	const uchar *src = data;
+	while ((data_len != 0) && (gw->error == false)) {
+		GzFrame *frame = &gw->frames[gw->frames_used];
+		const size_t len = MIN2(data_len, GZ_FRAMES_FRAME_SIZE - frame->data_len);
+		memcpy(frame->data + frame->data_len, src, len);
+		frame->data_len += len;
+		src += len;
+		data_len -= len;
+
+		if (frame->data_len == GZ_FRAMES_FRAME_SIZE) {
+			if (++gw->frames_used == gw->frames_len) {
+				gz_frames_flush(gw);
+			}
+		}
+	}
+	return !gw->error;
+}
+
+/**
+ * Write remaining data and the index, then free the writer.
+ *
+ * \return Success of all writes.
+ */
+bool BLI_gzframes_writer_free(GzFramesWriter *gw)
+{
+	/* Always write one frame, so the result is a valid gzip file. */
+	if ((gw->frames[gw->frames_used].data_len != 0) || (gw->index_len + gw->frames_used == 0)) {
+		gw->frames_used++;
+	}
+	gz_frames_flush(gw);
+
+	if ((gw->error == false) && (gw->index_len <= GZ_INDEX_FRAMES_MAX)) {
+		if (!gz_frames_write_index(gw)) {
+			gw->error = true;
+		}
+	}
+
+	const bool ok = !gw->error;
+	for (int i = 0; i < gw->frames_len; i++) {
+		MEM_freeN(gw->frames[i].data);
+		MEM_freeN(gw->frames[i].member);
+	}
+	MEM_freeN(gw->frames);
+	MEM_freeN(gw->index);
+	MEM_freeN(gw);
+	return ok;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Reading
+ * \{ */
+
+struct GzFramesReader {
+	int file;
+
+	/* Offset of each frame in the file, followed by the offset past the last frame. */
+	uint64_t *member_offsets;
+	int frames_len;
+	/* Uncompressed size of all frames but the last one. */
+	uint frame_size;
+
+	/* Uncompressed size and read position. */
+	int64_t size;
+	int64_t offset;
+
+	/* The last decompressed frame. */
+	int frame_loaded;
+	uchar *data;
+	size_t data_len;
+	uchar *member;
+	size_t member_alloc;
+
+	z_stream strm;
+};
+
+/**
+ * \return True when \a p is a frame header, \a r_member_len is checked to be at least
+ * as large as an empty member.
+ */
+static bool gz_frame_header_parse(const uchar *p, uint32_t *r_member_len, uint32_t *r_data_len)
+{
+	if ((gz_header_check(p, "BF") != 12) || (gz_get_u16(&p[14]) != 8)) {
+		return false;
+	}
+	*r_member_len = gz_get_u32(&p[16]);
+	*r_data_len = gz_get_u32(&p[20]);
+	return (*r_member_len >= GZ_FRAME_HEADER_LEN + sizeof(gz_deflate_empty) + GZ_TRAILER_LEN);
+}
+
+/** Read the index written at the end of the file. */
+static bool gz_frames_index_read(GzFramesReader *gr, uint64_t file_len)
+{
+	uchar end[GZ_END_LEN];
+	if ((file_len < GZ_FRAME_HEADER_LEN + GZ_END_LEN) ||
+	    !gz_read_at(gr->file, file_len - GZ_END_LEN, end, sizeof(end)) ||
+	    (gz_header_check(end, "BE") != 12) || (gz_get_u16(&end[14]) != 8))
+	{
+		return false;
+	}
+
+	const uint64_t index_offset = gz_get_u64(&end[16]);
+	if (index_offset + GZ_EXTRA_HEADER_LEN + 4 + 4 > file_len - GZ_END_LEN) {
+		return false;
+	}
+
+	uchar header[GZ_EXTRA_HEADER_LEN + 4 + 4];
+	if (!gz_read_at(gr->file, index_offset, header, sizeof(header))) {
+		return false;
+	}
+	const uint xlen = gz_header_check(header, "BI");
+	const uint frames_len = (xlen - 8) / 4;
+	if ((xlen < 8 + 4) || (gz_get_u16(&header[14]) != xlen - 4) || ((xlen - 8) % 4 != 0) ||
+	    (index_offset + GZ_EXTRA_HEADER_LEN + xlen + sizeof(gz_deflate_empty) + GZ_TRAILER_LEN !=
+	     file_len - GZ_END_LEN))
+	{
+		return false;
+	}
+	gr->frame_size = gz_get_u32(&header[16]);
+	if (gr->frame_size > GZ_FRAME_SIZE_MAX) {
+		return false;
+	}
+
+	uchar *sizes = MEM_mallocN(4 * frames_len, __func__);
+	bool ok = gz_read_at(gr->file, index_offset + sizeof(header), sizes, 4 * frames_len);
+	if (ok) {
+		gr->frames_len = (int)frames_len;
+		gr->member_offsets = MEM_mallocN(sizeof(*gr->member_offsets) * (frames_len + 1), __func__);
+		gr->member_offsets[0] = 0;
+		for (uint i = 0; i < frames_len; i++) {
+			gr->member_offsets[i + 1] = gr->member_offsets[i] + gz_get_u32(&sizes[4 * i]);
+		}
+		ok = (gr->member_offsets[frames_len] == index_offset);
+	}
+	MEM_freeN(sizes);
+
+	/* Size of the last frame. */
+	uchar frame_header[GZ_FRAME_HEADER_LEN];
+	uint32_t member_len, data_len;
+	if (ok &&
+	    gz_read_at(gr->file, gr->member_offsets[frames_len - 1], frame_header, sizeof(frame_header)) &&
+	    gz_frame_header_parse(frame_header, &member_len, &data_len) &&
+	    (member_len == index_offset - gr->member_offsets[frames_len - 1]) &&
+	    (data_len <= gr->frame_size) && ((gr->frame_size != 0) || (frames_len == 1)))
+	{
+		gr->size = (int64_t)gr->frame_size * (frames_len - 1) + data_len;
+		return true;
+	}
+	MEM_SAFE_FREE(gr->member_offsets);
+	return false;
+}
+
+/** Find the frames by walking over the member headers, for files without an index. */
+static bool gz_frames_index_scan(GzFramesReader *gr, uint64_t file_len)
+{
+	int frames_alloc = 64;
+	gr->member_offsets = MEM_mallocN(sizeof(*gr->member_offsets) * (size_t)frames_alloc, __func__);
+	gr->member_offsets[0] = 0;
+	gr->frames_len = 0;
+	gr->size = 0;
+
+	uint64_t offset = 0;
+	uint32_t data_len_prev = 0;
+	while (offset < file_len) {
+		uchar header[GZ_FRAME_HEADER_LEN];
+		uint32_t member_len, data_len;
+		if ((file_len - offset < sizeof(header)) ||
+		    !gz_read_at(gr->file, offset, header, sizeof(header)) ||
+		    !gz_frame_header_parse(header, &member_len, &data_len))
+		{
+			break;
+		}
+		/* Only the last frame may be smaller. */
+		if ((gr->frames_len != 0) && (data_len_prev != gr->frame_size)) {
+			break;
+		}
+		if (gr->frames_len == 0) {
+			if (data_len > GZ_FRAME_SIZE_MAX) {
+				break;
+			}
+			gr->frame_size = data_len;
+		}
+		else if (data_len > gr->frame_size) {
+			break;
+		}
+
+		offset += member_len;
+		gr->frames_len++;
+		gr->size += data_len;
+		data_len_prev = data_len;
+		if (gr->frames_len + 1 == frames_alloc) {
+			frames_alloc *= 2;
+			gr->member_offsets = MEM_reallocN(
+			        gr->member_offsets, sizeof(*gr->member_offsets) * (size_t)frames_alloc);
+		}
+		gr->member_offsets[gr->frames_len] = offset;
+	}
+
+	/* Anything but frames, the index and the end member isn't supported. */
+	if ((gr->frames_len == 0) || (offset > file_len) ||
+	    ((gr->frame_size == 0) && (gr->frames_len != 1)))
+	{
+		MEM_SAFE_FREE(gr->member_offsets);
+		return false;
+	}
+	if (offset != file_len) {
+		uchar header[GZ_EXTRA_HEADER_LEN + 4];
+		if ((file_len - offset < sizeof(header)) ||
+		    !gz_read_at(gr->file, offset, header, sizeof(header)) ||
+		    (!gz_header_check(header, "BI") && !gz_header_check(header, "BE")))
+		{
+			MEM_SAFE_FREE(gr->member_offsets);
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Open a framed gzip file for reading.
+ *
+ * \return NULL when \a file isn't a framed gzip file (it may still be a regular gzip file).
+ */
+GzFramesReader *BLI_gzframes_reader_new(int file)
+{
+	uchar header[GZ_FRAME_HEADER_LEN];
+	uint32_t member_len, data_len;
+	if (!gz_read_at(file, 0, header, sizeof(header)) ||
+	    !gz_frame_header_parse(header, &member_len, &data_len))
+	{
+		return NULL;
+	}
+
+	const int64_t file_len = (int64_t)lseek(file, 0, SEEK_END);
+	if (file_len == -1) {
+		return NULL;
+	}
+
+	GzFramesReader *gr = MEM_callocN(sizeof(*gr), __func__);
+	gr->file = file;
+	gr->frame_loaded = -1;
+
+	if (!gz_frames_index_read(gr, (uint64_t)file_len) &&
+	    !gz_frames_index_scan(gr, (uint64_t)file_len))
+	{
+		MEM_freeN(gr);
+		return NULL;
+	}
+
+	if (inflateInit2(&gr->strm, -MAX_WBITS) != Z_OK) {
+		MEM_freeN(gr->member_offsets);
+		MEM_freeN(gr);
+		return NULL;
+	}
+	gr->data = MEM_mallocN(MAX2(gr->frame_size, 1u), __func__);
+	return gr;
+}
+
+static bool gz_frame_load(GzFramesReader *gr, int frame)
+{
+	const size_t member_len = (size_t)(gr->member_offsets[frame + 1] - gr->member_offsets[frame]);
+	if (member_len > gr->member_alloc) {
+		MEM_SAFE_FREE(gr->member);
+		gr->member = MEM_mallocN(member_len, __func__);
+		gr->member_alloc = member_len;
+	}
+
+	gr->frame_loaded = -1;
+	uint32_t header_member_len, data_len;
+	if (!gz_read_at(gr->file, gr->member_offsets[frame], gr->member, member_len) ||
+	    !gz_frame_header_parse(gr->member, &header_member_len, &data_len) ||
+	    (header_member_len != member_len) || (data_len > gr->frame_size))
+	{
+		return false;
+	}
+
+	inflateReset(&gr->strm);
+	gr->strm.next_in = gr->member + GZ_FRAME_HEADER_LEN;
+	gr->strm.avail_in = (uInt)(member_len - GZ_FRAME_HEADER_LEN - GZ_TRAILER_LEN);
+	gr->strm.next_out = gr->data;
+	gr->strm.avail_out = (uInt)data_len;
+	if ((inflate(&gr->strm, Z_FINISH) != Z_STREAM_END) || (gr->strm.total_out != data_len)) {
+		return false;
+	}
+
+	const uchar *trailer = gr->member + member_len - GZ_TRAILER_LEN;
+	if ((gz_get_u32(&trailer[0]) != (uint32_t)crc32(0, gr->data, (uInt)data_len)) ||
+	    (gz_get_u32(&trailer[4]) != data_len))
+	{
+		return false;
+	}
+
+	gr->data_len = data_len;
+	gr->frame_loaded = frame;
+	return true;
+}
+
+/**
+ * Read uncompressed data from the current position, frames are decompressed on demand.
+ *
+ * \return The number of bytes read (less than \a size at the end of the file), -1 on error.
+ */
+int64_t BLI_gzframes_reader_read(GzFramesReader *gr, void *buffer, size_t size)
+{
+	uchar *dst = buffer;
+	int64_t read_len = 0;
+	while ((size != 0) && (gr->offset < gr->size)) {
+		const int frame = min_ii((int)(gr->offset / MAX2(gr->frame_size, 1u)), gr->frames_len - 1);
+		if ((frame != gr->frame_loaded) && !gz_frame_load(gr, frame)) {
+			return -1;
+		}
+		const size_t frame_offset = (size_t)(gr->offset - (int64_t)frame * gr->frame_size);
+		const size_t len = MIN2(size, gr->data_len - frame_offset);
+		memcpy(dst, gr->data + frame_offset, len);
+		dst += len;
+		size -= len;
+		read_len += (int64_t)len;
+		gr->offset += (int64_t)len;
+	}
+	return read_len;
+}
+
+/**
+ * Seek in the uncompressed data, works like lseek.
+ *
+ * \return The new position, -1 when it is outside of the file.
+ */
+int64_t BLI_gzframes_reader_seek(GzFramesReader *gr, int64_t offset, int whence)
+{
+	switch (whence) {
+		case SEEK_CUR:
+			offset += gr->offset;
+			break;
+		case SEEK_END:
+			offset += gr->size;
+			break;
+	}
+	if ((offset < 0) || (offset > gr->size)) {
+		return -1;
+	}
+	gr->offset = offset;
+	return offset;
+}
+
+/** Size of the uncompressed data. */
+int64_t BLI_gzframes_reader_size(const GzFramesReader *gr)
+{
+	return gr->size;
+}
+
+int BLI_gzframes_reader_frames_len(const GzFramesReader *gr)
+{
+	return gr->frames_len;
+}
+
+/** Free the reader, \a file is left open. */
+void BLI_gzframes_reader_free(GzFramesReader *gr)
+{
+	inflateEnd(&gr->strm);
+	MEM_SAFE_FREE(gr->member);
+	MEM_freeN(gr->data);
+	MEM_freeN(gr->member_offsets);
+	MEM_freeN(gr);
+}
+
+/** \} */
@@ -18,10 +18,16 @@
  * \ingroup bli
  */
 
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "MEM_guardedalloc.h"
 
 #include "BLI_math.h"
+#include "BLI_math_bits.h"
 #include "BLI_kdtree_impl.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 #include "BLI_strict_flags.h"
 
@@ -324,6 +330,429 @@ int BLI_kdtree_nd_(find_nearest)(
 }
 
 
+/* -------------------------------------------------------------------- */
+/** \name Batched Nearest Search
+ *
+ * Queries are sorted along a Morton curve so neighboring queries walk mostly the same nodes,
+ * then searched in packets of #KD_PACKET_SIZE points, comparing each node against
+ * all points of the packet at once.
+ * \{ */
+
+#define KD_PACKET_SIZE 4
+#define KD_PACKET_MASK ((1u << KD_PACKET_SIZE) - 1)
+
+/* Bits per axis of the Morton code used to sort queries, the code fits in 30 bits. */
+#define KD_MORTON_BITS (30 / KD_DIMS)
+
+/* Number of queries below which a batch is searched without threading. */
+#define KD_BATCH_THREADED_LIMIT 1024
+
+#ifdef __SSE2__
+
+typedef __m128 KDPacket;
+
+BLI_INLINE KDPacket kd_packet_set1(const float f)
+{
+	return _mm_set1_ps(f);
+}
+BLI_INLINE KDPacket kd_packet_load(const float f[KD_PACKET_SIZE])
+{
+	return _mm_loadu_ps(f);
+}
+BLI_INLINE void kd_packet_store(float r_f[KD_PACKET_SIZE], const KDPacket a)
+{
+	_mm_storeu_ps(r_f, a);
+}
+BLI_INLINE KDPacket kd_packet_sub(const KDPacket a, const KDPacket b)
+{
+	return _mm_sub_ps(a, b);
+}
+BLI_INLINE KDPacket kd_packet_mul(const KDPacket a, const KDPacket b)
+{
+	return _mm_mul_ps(a, b);
+}
+BLI_INLINE KDPacket kd_packet_madd(const KDPacket a, const KDPacket b, const KDPacket c)
+{
+	return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+BLI_INLINE KDPacket kd_packet_min(const KDPacket a, const KDPacket b)
+{
+	return _mm_min_ps(a, b);
+}
+/* Bit-mask of lanes where (a < b). */
+BLI_INLINE uint kd_packet_lt_mask(const KDPacket a, const KDPacket b)
+{
+	return (uint)_mm_movemask_ps(_mm_cmplt_ps(a, b));
+}
+/* Bit-mask of lanes where (a <= b). */
+BLI_INLINE uint kd_packet_le_mask(const KDPacket a, const KDPacket b)
+{
+	return (uint)_mm_movemask_ps(_mm_cmple_ps(a, b));
+}
+
+#else  /* __SSE2__ */
+
+typedef struct KDPacket {
+	float v[KD_PACKET_SIZE];
+} KDPacket;
+
+BLI_INLINE KDPacket kd_packet_set1(const float f)
+{
+	KDPacket r;
+	for (uint l = 0; l < KD_PACKET_SIZE; l++) {
+		r.v[l] = f;
+	}
+	return r;
+}
+BLI_INLINE KDPacket kd_packet_load(const float f[KD_PACKET_SIZE])
+{
+	KDPacket r;
+	for (uint l = 0; l < KD_PACKET_SIZE; l++) {
+		r.v[l] = f[l];
+	}
+	return r;
+}
+BLI_INLINE void kd_packet_store(float r_f[KD_PACKET_SIZE], const KDPacket a)
+{
+	for (uint l = 0; l < KD_PACKET_SIZE; l++) {
+		r_f[l] = a.v[l];
+	}
+}
+BLI_INLINE KDPacket kd_packet_sub(const KDPacket a, const KDPacket b)
+{
+	KDPacket r;
+	for (uint l = 0; l < KD_PACKET_SIZE; l++) {
+		r.v[l] = a.v[l] - b.v[l];
+	}
+	return r;
+}
+BLI_INLINE KDPacket kd_packet_mul(const KDPacket a, const KDPacket b)
+{
+	KDPacket r;
+	for (uint l = 0; l < KD_PACKET_SIZE; l++) {
+		r.v[l] = a.v[l] * b.v[l];
+	}
+	return r;
+}
+BLI_INLINE KDPacket kd_packet_madd(const KDPacket a, const KDPacket b, const KDPacket c)
+{
+	KDPacket r;
+	for (uint l = 0; l < KD_PACKET_SIZE; l++) {
+		r.v[l] = a.v[l] * b.v[l] + c.v[l];
+	}
+	return r;
+}
+BLI_INLINE KDPacket kd_packet_min(const KDPacket a, const KDPacket b)
+{
+	KDPacket r;
+	for (uint l = 0; l < KD_PACKET_SIZE; l++) {
+		r.v[l] = min_ff(a.v[l], b.v[l]);
+	}
+	return r;
+}
+BLI_INLINE uint kd_packet_lt_mask(const KDPacket a, const KDPacket b)
+{
+	uint mask = 0;
+	for (uint l = 0; l < KD_PACKET_SIZE; l++) {
+		if (a.v[l] < b.v[l]) {
+			mask |= (1u << l);
+		}
+	}
+	return mask;
+}
+BLI_INLINE uint kd_packet_le_mask(const KDPacket a, const KDPacket b)
+{
+	uint mask = 0;
+	for (uint l = 0; l < KD_PACKET_SIZE; l++) {
+		if (a.v[l] <= b.v[l]) {
+			mask |= (1u << l);
+		}
+	}
+	return mask;
+}
+
+#endif  /* __SSE2__ */
+
+typedef struct KDTreeQuery {
+	uint code;
+	uint index;
+} KDTreeQuery;
+
+static uint kdtree_morton_code(const float co[KD_DIMS], const float min[KD_DIMS], const float scale[KD_DIMS])
+{
+	const float co_max = (float)((1u << KD_MORTON_BITS) - 1);
+	uint co_quant[KD_DIMS];
+	uint code = 0;
+
+	for (uint j = 0; j < KD_DIMS; j++) {
+		const float f = (co[j] - min[j]) * scale[j];
+		/* Written so NAN maps to zero. */
+		co_quant[j] = (f > 0.0f) ? (uint)min_ff(f, co_max) : 0;
+	}
+	for (uint b = 0; b < KD_MORTON_BITS; b++) {
+		for (uint j = 0; j < KD_DIMS; j++) {
+			code |= ((co_quant[j] >> b) & 1u) << (b * KD_DIMS + j);
+		}
+	}
+	return code;
+}
+
+/**
+ * Sort queries by their Morton code (LSD radix sort, 3 passes of 10 bits).
+ *
+ * \return the buffer holding the sorted queries, either \a queries or \a queries_tmp.
+ */
+static KDTreeQuery *kdtree_query_sort(KDTreeQuery *queries, KDTreeQuery *queries_tmp, const uint queries_len)
+{
+	for (uint shift = 0; shift < 30; shift += 10) {
+		uint offsets[1024] = {0};
+		uint ofs = 0;
+
+		for (uint i = 0; i < queries_len; i++) {
+			offsets[(queries[i].code >> shift) & 1023u]++;
+		}
+		for (uint i = 0; i < ARRAY_SIZE(offsets); i++) {
+			const uint count = offsets[i];
+			offsets[i] = ofs;
+			ofs += count;
+		}
+		for (uint i = 0; i < queries_len; i++) {
+			queries_tmp[offsets[(queries[i].code >> shift) & 1023u]++] = queries[i];
+		}
+		SWAP(KDTreeQuery *, queries, queries_tmp);
+	}
+	return queries;
+}
+
+/**
+ * Find the nearest node for up to #KD_PACKET_SIZE queries at once.
+ *
+ * \param r_min_node: Nodes used to initialize the search (any valid node works,
+ * the closer to the query the more of the tree is skipped), returns the nearest nodes.
+ */
+static void kdtree_find_nearest_packet(
+        const KDTree *tree, const float (*co)[KD_DIMS], const KDTreeQuery *queries, const uint queries_len,
+        uint r_min_node[KD_PACKET_SIZE], float r_min_dist[KD_PACKET_SIZE])
+{
+	const KDTreeNode *nodes = tree->nodes;
+	KDPacket co_packet[KD_DIMS], min_dist;
+	uint *stack, stack_default[KD_STACK_INIT];
+	uint stack_len_capacity, cur = 0;
+
+	{
+		float co_lanes[KD_DIMS][KD_PACKET_SIZE];
+		for (uint l = 0; l < KD_PACKET_SIZE; l++) {
+			/* Unused lanes repeat the last query, their result is ignored. */
+			const float *co_lane = co[queries[MIN2(l, queries_len - 1)].index];
+			for (uint j = 0; j < KD_DIMS; j++) {
+				co_lanes[j][l] = co_lane[j];
+			}
+			r_min_dist[l] = len_squared_vnvn(nodes[r_min_node[l]].co, co_lane);
+		}
+		for (uint j = 0; j < KD_DIMS; j++) {
+			co_packet[j] = kd_packet_load(co_lanes[j]);
+		}
+		min_dist = kd_packet_load(r_min_dist);
+	}
+
+	stack = stack_default;
+	stack_len_capacity = KD_STACK_INIT;
+
+	stack[cur++] = tree->root;
+
+	while (cur--) {
+		const uint node_index = stack[cur];
+		const KDTreeNode *node = &nodes[node_index];
+		const KDPacket plane_dist = kd_packet_sub(co_packet[node->d], kd_packet_set1(node->co[node->d]));
+		/* Lanes for which the splitting plane is closer than the nearest node found so far,
+		 * only those can find a nearer node on the far side. */
+		const uint plane_mask = kd_packet_lt_mask(kd_packet_mul(plane_dist, plane_dist), min_dist);
+		/* Lanes on the left side of the splitting plane. */
+		const uint left_mask = kd_packet_le_mask(plane_dist, kd_packet_set1(0.0f));
+		const bool use_left = (node->left != KD_NODE_UNSET) && (left_mask | plane_mask);
+		const bool use_right = (node->right != KD_NODE_UNSET) && ((~left_mask & KD_PACKET_MASK) | plane_mask);
+
+		if (plane_mask) {
+			KDPacket cur_dist = kd_packet_set1(0.0f);
+			for (uint j = 0; j < KD_DIMS; j++) {
+				const KDPacket d = kd_packet_sub(co_packet[j], kd_packet_set1(node->co[j]));
+				cur_dist = kd_packet_madd(d, d, cur_dist);
+			}
+			const uint nearer_mask = kd_packet_lt_mask(cur_dist, min_dist);
+			if (nearer_mask) {
+				min_dist = kd_packet_min(cur_dist, min_dist);
+				for (uint l = 0; l < KD_PACKET_SIZE; l++) {
+					if (nearer_mask & (1u << l)) {
+						r_min_node[l] = node_index;
+					}
+				}
+			}
+		}
+
+		/* Push the side most lanes are on last, so it's searched first. */
+		if (count_bits_i(left_mask) >= KD_PACKET_SIZE / 2) {
+			if (use_right) {
+				stack[cur++] = node->right;
+			}
+			if (use_left) {
+				stack[cur++] = node->left;
+			}
+		}
+		else {
+			if (use_left) {
+				stack[cur++] = node->left;
+			}
+			if (use_right) {
+				stack[cur++] = node->right;
+			}
+		}
+		if (UNLIKELY(cur + KD_DIMS > stack_len_capacity)) {
+			stack = realloc_nodes(stack, &stack_len_capacity, stack_default != stack);
+		}
+	}
+
+	kd_packet_store(r_min_dist, min_dist);
+
+	if (stack != stack_default) {
+		MEM_freeN(stack);
+	}
+}
+
+typedef struct KDTreeBatchData {
+	const KDTree *tree;
+	const float (*co)[KD_DIMS];
+	const KDTreeQuery *queries;
+	uint queries_len;
+	int *r_index;
+	KDTreeNearest *r_nearest;
+} KDTreeBatchData;
+
+typedef struct KDTreeBatchChunk {
+	/* Result of the previous packet, a close starting point for the next one. */
+	uint min_node[KD_PACKET_SIZE];
+} KDTreeBatchChunk;
+
+static void kdtree_find_nearest_batch_cb(
+        void *__restrict userdata,
+        const int iter,
+        const ParallelRangeTLS *__restrict tls)
+{
+	const KDTreeBatchData *data = userdata;
+	KDTreeBatchChunk *chunk = tls->userdata_chunk;
+	const uint ofs = (uint)iter * KD_PACKET_SIZE;
+	const KDTreeQuery *queries = &data->queries[ofs];
+	const uint queries_len = MIN2((uint)KD_PACKET_SIZE, data->queries_len - ofs);
+	float min_dist[KD_PACKET_SIZE];
+
+	kdtree_find_nearest_packet(data->tree, data->co, queries, queries_len, chunk->min_node, min_dist);
+
+	for (uint l = 0; l < queries_len; l++) {
+		const KDTreeNode *min_node = &data->tree->nodes[chunk->min_node[l]];
+		const uint i = queries[l].index;
+		if (data->r_index) {
+			data->r_index[i] = min_node->index;
+		}
+		if (data->r_nearest) {
+			KDTreeNearest *nearest = &data->r_nearest[i];
+			nearest->index = min_node->index;
+			nearest->dist = sqrtf(min_dist[l]);
+			copy_vn_vn(nearest->co, min_node->co);
+		}
+	}
+}
+
+/**
+ * Find the nearest node for many points at once,
+ * gives the same results as calling #BLI_kdtree_3d_find_nearest for each point
+ * (when multiple nodes are at the same distance, either may be returned).
+ *
+ * Use this when searching for many points, since the searches are sorted
+ * to improve memory access, done in packets (using SIMD) and multi-threaded.
+ *
+ * \param r_index: Optional, the nearest index for each point, -1 when the tree is empty.
+ * \param r_nearest: Optional, the nearest node for each point.
+ */
+void BLI_kdtree_nd_(find_nearest_batch)(
+        const KDTree *tree, const float (*co)[KD_DIMS], const uint co_len,
+        int *r_index, KDTreeNearest *r_nearest)
+{
+	KDTreeQuery *queries, *queries_buf[2];
+	float min[KD_DIMS], max[KD_DIMS], scale[KD_DIMS];
+
+#ifdef DEBUG
+	BLI_assert(tree->is_balanced == true);
+#endif
+
+	if (co_len == 0) {
+		return;
+	}
+
+	if (UNLIKELY(tree->root == KD_NODE_UNSET)) {
+		for (uint i = 0; i < co_len; i++) {
+			if (r_index) {
+				r_index[i] = -1;
+			}
+			if (r_nearest) {
+				r_nearest[i].index = -1;
+				r_nearest[i].dist = FLT_MAX;
+				copy_vn_fl(r_nearest[i].co, KD_DIMS, 0.0f);
+			}
+		}
+		return;
+	}
+
+	copy_vn_vn(min, co[0]);
+	copy_vn_vn(max, co[0]);
+	for (uint i = 1; i < co_len; i++) {
+		for (uint j = 0; j < KD_DIMS; j++) {
+			min[j] = min_ff(min[j], co[i][j]);
+			max[j] = max_ff(max[j], co[i][j]);
+		}
+	}
+	for (uint j = 0; j < KD_DIMS; j++) {
+		const float size = max[j] - min[j];
+		scale[j] = (size > 0.0f) ? (float)((1u << KD_MORTON_BITS) - 1) / size : 0.0f;
+	}
+
+	queries_buf[0] = MEM_mallocN(sizeof(*queries) * co_len, __func__);
+	queries_buf[1] = MEM_mallocN(sizeof(*queries) * co_len, __func__);
+	for (uint i = 0; i < co_len; i++) {
+		queries_buf[0][i].code = kdtree_morton_code(co[i], min, scale);
+		queries_buf[0][i].index = i;
+	}
+	queries = kdtree_query_sort(queries_buf[0], queries_buf[1], co_len);
+
+	KDTreeBatchData data = {
+		.tree = tree,
+		.co = co,
+		.queries = queries,
+		.queries_len = co_len,
+		.r_index = r_index,
+		.r_nearest = r_nearest,
+	};
+	KDTreeBatchChunk chunk;
+	for (uint l = 0; l < KD_PACKET_SIZE; l++) {
+		chunk.min_node[l] = tree->root;
+	}
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (co_len >= KD_BATCH_THREADED_LIMIT);
+	/* Each thread handles a contiguous range of sorted queries. */
+	settings.scheduling_mode = TASK_SCHEDULING_STATIC;
+	settings.userdata_chunk = &chunk;
+	settings.userdata_chunk_size = sizeof(chunk);
+	BLI_task_parallel_range(
+	        0, (int)((co_len + KD_PACKET_SIZE - 1) / KD_PACKET_SIZE),
+	        &data, kdtree_find_nearest_batch_cb, &settings);
+
+	MEM_freeN(queries_buf[0]);
+	MEM_freeN(queries_buf[1]);
+}
+
+/** \} */
+
+
 /**
  * A version of #BLI_kdtree_3d_find_nearest which runs a callback
  * to filter out values.
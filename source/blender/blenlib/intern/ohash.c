@@ -0,0 +1,577 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/** \file
+ * \ingroup bli
+ *
+ * A general (pointer -> pointer) open-addressing hash table.
+ *
+ * Uses Robin Hood hashing: on insertion, an entry which is further away from
+ * its home slot takes the place of an entry which is closer to its own,
+ * keeping probe sequences short and allowing lookups of missing keys to stop
+ * early. Removal shifts following entries back instead of leaving tombstones.
+ *
+ * The hash of every key is stored next to the slots, so most mismatching
+ * entries are skipped without calling the comparison callback.
+ *
+ * \note The API matches BLI_ghash.c, but the implementation is different.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_sys_types.h"  /* for intptr_t support */
+#include "BLI_utildefines.h"
+#include "BLI_ohash.h"  /* own include */
+
+/* keep last */
+#include "BLI_strict_flags.h"
+
+/* -------------------------------------------------------------------- */
+/** \name Structs & Constants
+ * \{ */
+
+#define OHASH_CAPACITY_EXP_MIN 3
+#define OHASH_CAPACITY_EXP_MAX 31
+
+#define OHASH_CAPACITY(oh) (1u << (oh)->capacity_exp)
+
+/**
+ * Max load is higher than GHash's one, Robin Hood hashing keeps the variance
+ * of probe lengths low even for quite full tables.
+ * Min load is a quarter of max load, to avoid resizing too often.
+ */
+#define OHASH_LIMIT_GROW(_nslots)   (((_nslots) * 7) /  8)
+#define OHASH_LIMIT_SHRINK(_nslots) (((_nslots) * 7) / 32)
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Internal Utility API
+ * \{ */
+
+BLI_INLINE uint ohash_keyhash(const OHash *oh, const void *key)
+{
+	return _ohash_hash_finalize(oh->hashfp(key));
+}
+
+BLI_INLINE uint ohash_probe_distance(const OHash *oh, const uint slot, const uint slot_hash)
+{
+	return (slot - _ohash_slot_home(oh, slot_hash)) & oh->slot_mask;
+}
+
+static uint ohash_capacity_exp_for_entries(uint nentries)
+{
+	uint capacity_exp = OHASH_CAPACITY_EXP_MIN;
+	while (capacity_exp < OHASH_CAPACITY_EXP_MAX &&
+	       OHASH_LIMIT_GROW(1u << capacity_exp) < nentries)
+	{
+		capacity_exp++;
+	}
+	return capacity_exp;
+}
+
+static void ohash_slots_alloc(OHash *oh, const uint capacity_exp)
+{
+	const uint capacity = 1u << capacity_exp;
+	oh->capacity_exp = capacity_exp;
+	oh->slot_mask = capacity - 1;
+	oh->hashes = MEM_calloc_arrayN(capacity, sizeof(*oh->hashes), "OHash hashes");
+	oh->entries = MEM_malloc_arrayN(capacity, sizeof(*oh->entries), "OHash entries");
+}
+
+/**
+ * Place an entry known not to be in the table yet.
+ * \return the slot where the entry was stored.
+ */
+static uint ohash_insert_ex(OHash *oh, uint hash, void *key, void *val)
+{
+	const uint mask = oh->slot_mask;
+	uint slot = _ohash_slot_home(oh, hash);
+	uint dist = 0;
+	uint slot_result = UINT_MAX;
+
+	for (;; slot = (slot + 1) & mask, dist++) {
+		const uint slot_hash = oh->hashes[slot];
+		if (slot_hash == 0) {
+			oh->hashes[slot] = hash;
+			oh->entries[slot].key = key;
+			oh->entries[slot].val = val;
+			return (slot_result != UINT_MAX) ? slot_result : slot;
+		}
+		const uint slot_dist = ohash_probe_distance(oh, slot, slot_hash);
+		if (slot_dist < dist) {
+			/* Steal the slot from the richer entry, continue inserting it instead. */
+			OHashEntry entry_tmp = oh->entries[slot];
+			oh->hashes[slot] = hash;
+			oh->entries[slot].key = key;
+			oh->entries[slot].val = val;
+			if (slot_result == UINT_MAX) {
+				slot_result = slot;
+			}
+			hash = slot_hash;
+			key = entry_tmp.key;
+			val = entry_tmp.val;
+			dist = slot_dist;
+		}
+	}
+}
+
+static void ohash_resize(OHash *oh, const uint capacity_exp)
+{
+	uint *hashes_old = oh->hashes;
+	OHashEntry *entries_old = oh->entries;
+	const uint capacity_old = OHASH_CAPACITY(oh);
+
+	ohash_slots_alloc(oh, capacity_exp);
+
+	for (uint i = 0; i < capacity_old; i++) {
+		if (hashes_old[i] != 0) {
+			ohash_insert_ex(oh, hashes_old[i], entries_old[i].key, entries_old[i].val);
+		}
+	}
+
+	MEM_freeN(hashes_old);
+	MEM_freeN(entries_old);
+}
+
+/**
+ * Ensure there is room for \a nentries, grow only.
+ */
+BLI_INLINE void ohash_expand(OHash *oh, const uint nentries)
+{
+	if (UNLIKELY(nentries > OHASH_LIMIT_GROW(OHASH_CAPACITY(oh)))) {
+		ohash_resize(oh, ohash_capacity_exp_for_entries(nentries));
+	}
+}
+
+BLI_INLINE void ohash_contract(OHash *oh, const uint nentries, const bool force_shrink)
+{
+	if (!(force_shrink || (oh->flag & GHASH_FLAG_ALLOW_SHRINK))) {
+		return;
+	}
+	if (oh->capacity_exp > OHASH_CAPACITY_EXP_MIN &&
+	    nentries < OHASH_LIMIT_SHRINK(OHASH_CAPACITY(oh)))
+	{
+		const uint capacity_exp = ohash_capacity_exp_for_entries(nentries);
+		if (capacity_exp < oh->capacity_exp) {
+			ohash_resize(oh, capacity_exp);
+		}
+	}
+}
+
+/**
+ * \return the slot of \a key or UINT_MAX when not found.
+ */
+BLI_INLINE uint ohash_lookup_slot(const OHash *oh, const void *key, const uint hash)
+{
+	const uint mask = oh->slot_mask;
+	uint slot = _ohash_slot_home(oh, hash);
+
+	for (uint dist = 0; ; slot = (slot + 1) & mask, dist++) {
+		const uint slot_hash = oh->hashes[slot];
+		if (slot_hash == 0) {
+			return UINT_MAX;
+		}
+		if (slot_hash == hash && !oh->cmpfp(key, oh->entries[slot].key)) {
+			return slot;
+		}
+		if (ohash_probe_distance(oh, slot, slot_hash) < dist) {
+			return UINT_MAX;
+		}
+	}
+}
+
+/**
+ * Backward shift deletion, keeps probe sequences intact without tombstones.
+ */
+static void ohash_remove_slot(OHash *oh, uint slot)
+{
+	const uint mask = oh->slot_mask;
+	uint slot_next = (slot + 1) & mask;
+
+	while (oh->hashes[slot_next] != 0 &&
+	       ohash_probe_distance(oh, slot_next, oh->hashes[slot_next]) != 0)
+	{
+		oh->hashes[slot] = oh->hashes[slot_next];
+		oh->entries[slot] = oh->entries[slot_next];
+		slot = slot_next;
+		slot_next = (slot_next + 1) & mask;
+	}
+	oh->hashes[slot] = 0;
+	oh->nentries--;
+}
+
+static void ohash_free_cb(OHash *oh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	const uint capacity = OHASH_CAPACITY(oh);
+	for (uint i = 0; i < capacity; i++) {
+		if (oh->hashes[i] != 0) {
+			if (keyfreefp) {
+				keyfreefp(oh->entries[i].key);
+			}
+			if (valfreefp) {
+				valfreefp(oh->entries[i].val);
+			}
+		}
+	}
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Public API
+ * \{ */
+
+/**
+ * Creates a new, empty OHash.
+ *
+ * \param hashfp: Hash callback.
+ * \param cmpfp: Comparison callback.
+ * \param info: Identifier string for the OHash.
+ * \param nentries_reserve: Optionally reserve the number of members that the hash will hold.
+ * \return  An empty OHash.
+ */
+OHash *BLI_ohash_new_ex(
+        GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info,
+        const uint nentries_reserve)
+{
+	OHash *oh = MEM_mallocN(sizeof(*oh), info);
+
+	oh->hashfp = hashfp;
+	oh->cmpfp = cmpfp;
+	oh->nentries = 0;
+	oh->flag = 0;
+
+	ohash_slots_alloc(oh, ohash_capacity_exp_for_entries(nentries_reserve));
+
+	return oh;
+}
+
+/**
+ * Wraps #BLI_ohash_new_ex with zero entries reserved.
+ */
+OHash *BLI_ohash_new(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info)
+{
+	return BLI_ohash_new_ex(hashfp, cmpfp, info, 0);
+}
+
+/**
+ * Frees the OHash and its members.
+ */
+void BLI_ohash_free(OHash *oh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	if (keyfreefp || valfreefp) {
+		ohash_free_cb(oh, keyfreefp, valfreefp);
+	}
+	MEM_freeN(oh->hashes);
+	MEM_freeN(oh->entries);
+	MEM_freeN(oh);
+}
+
+/**
+ * Reserve given amount of entries (resize \a oh accordingly if needed).
+ */
+void BLI_ohash_reserve(OHash *oh, const uint nentries_reserve)
+{
+	ohash_expand(oh, nentries_reserve);
+	ohash_contract(oh, MAX2(nentries_reserve, oh->nentries), true);
+}
+
+/**
+ * \return size of the OHash.
+ */
+uint BLI_ohash_len(OHash *oh)
+{
+	return oh->nentries;
+}
+
+/**
+ * Insert a key/value pair into the \a oh.
+ *
+ * \note Duplicates are not checked,
+ * the caller is expected to ensure elements are unique unless
+ * GHASH_FLAG_ALLOW_DUPES flag is set.
+ */
+void BLI_ohash_insert(OHash *oh, void *key, void *val)
+{
+	BLI_assert((oh->flag & GHASH_FLAG_ALLOW_DUPES) || !BLI_ohash_haskey(oh, key));
+	ohash_expand(oh, ++oh->nentries);
+	ohash_insert_ex(oh, ohash_keyhash(oh, key), key, val);
+}
+
+/**
+ * Inserts a new value to a key that may already be in ohash.
+ *
+ * \returns true if a new key has been added.
+ */
+bool BLI_ohash_reinsert(OHash *oh, void *key, void *val, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	const uint hash = ohash_keyhash(oh, key);
+	const uint slot = ohash_lookup_slot(oh, key, hash);
+	if (slot != UINT_MAX) {
+		OHashEntry *e = &oh->entries[slot];
+		if (keyfreefp) {
+			keyfreefp(e->key);
+		}
+		if (valfreefp) {
+			valfreefp(e->val);
+		}
+		e->key = key;
+		e->val = val;
+		return false;
+	}
+	ohash_expand(oh, ++oh->nentries);
+	ohash_insert_ex(oh, hash, key, val);
+	return true;
+}
+
+/**
+ * Lookup the value of \a key in \a oh.
+ *
+ * \note When NULL is a valid value, use #BLI_ohash_lookup_p to differentiate a missing key
+ * from a key with a NULL value. (Avoids calling #BLI_ohash_haskey before #BLI_ohash_lookup)
+ */
+void *BLI_ohash_lookup(OHash *oh, const void *key)
+{
+	const uint slot = ohash_lookup_slot(oh, key, ohash_keyhash(oh, key));
+	return (slot != UINT_MAX) ? oh->entries[slot].val : NULL;
+}
+
+/**
+ * A version of #BLI_ohash_lookup which accepts a fallback argument.
+ */
+void *BLI_ohash_lookup_default(OHash *oh, const void *key, void *val_default)
+{
+	const uint slot = ohash_lookup_slot(oh, key, ohash_keyhash(oh, key));
+	return (slot != UINT_MAX) ? oh->entries[slot].val : val_default;
+}
+
+/**
+ * Lookup a pointer to the value of \a key in \a oh.
+ *
+ * \returns the pointer to value for \a key or NULL.
+ *
+ * \note The pointer is only valid until the next modification of \a oh.
+ */
+void **BLI_ohash_lookup_p(OHash *oh, const void *key)
+{
+	const uint slot = ohash_lookup_slot(oh, key, ohash_keyhash(oh, key));
+	return (slot != UINT_MAX) ? &oh->entries[slot].val : NULL;
+}
+
+/**
+ * Ensure \a key is exists in \a oh.
+ *
+ * \param r_val: The address of the value pointer,
+ * only valid until the next modification of \a oh.
+ * \returns true when the value didn't need to be added.
+ */
+bool BLI_ohash_ensure_p(OHash *oh, void *key, void ***r_val)
+{
+	const uint hash = ohash_keyhash(oh, key);
+	uint slot = ohash_lookup_slot(oh, key, hash);
+	const bool haskey = (slot != UINT_MAX);
+	if (!haskey) {
+		ohash_expand(oh, ++oh->nentries);
+		slot = ohash_insert_ex(oh, hash, key, NULL);
+	}
+	*r_val = &oh->entries[slot].val;
+	return haskey;
+}
+
+/**
+ * Remove \a key from \a oh, or return false if the key wasn't found.
+ */
+bool BLI_ohash_remove(OHash *oh, const void *key, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	const uint slot = ohash_lookup_slot(oh, key, ohash_keyhash(oh, key));
+	if (slot == UINT_MAX) {
+		return false;
+	}
+	if (keyfreefp) {
+		keyfreefp(oh->entries[slot].key);
+	}
+	if (valfreefp) {
+		valfreefp(oh->entries[slot].val);
+	}
+	ohash_remove_slot(oh, slot);
+	ohash_contract(oh, oh->nentries, false);
+	return true;
+}
+
+/**
+ * Remove \a key from \a oh, returning the value or NULL if the key wasn't found.
+ */
+void *BLI_ohash_popkey(OHash *oh, const void *key, GHashKeyFreeFP keyfreefp)
+{
+	const uint slot = ohash_lookup_slot(oh, key, ohash_keyhash(oh, key));
+	if (slot == UINT_MAX) {
+		return NULL;
+	}
+	void *val = oh->entries[slot].val;
+	if (keyfreefp) {
+		keyfreefp(oh->entries[slot].key);
+	}
+	ohash_remove_slot(oh, slot);
+	ohash_contract(oh, oh->nentries, false);
+	return val;
+}
+
+/**
+ * \return true if the \a key is in \a oh.
+ */
+bool BLI_ohash_haskey(OHash *oh, const void *key)
+{
+	return ohash_lookup_slot(oh, key, ohash_keyhash(oh, key)) != UINT_MAX;
+}
+
+/**
+ * Reset \a oh clearing all entries.
+ *
+ * \param nentries_reserve: Optionally reserve the number of members that the hash will hold.
+ */
+void BLI_ohash_clear_ex(
+        OHash *oh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp,
+        const uint nentries_reserve)
+{
+	if (keyfreefp || valfreefp) {
+		ohash_free_cb(oh, keyfreefp, valfreefp);
+	}
+	const uint capacity_exp = ohash_capacity_exp_for_entries(nentries_reserve);
+	if (capacity_exp != oh->capacity_exp) {
+		MEM_freeN(oh->hashes);
+		MEM_freeN(oh->entries);
+		ohash_slots_alloc(oh, capacity_exp);
+	}
+	else {
+		memset(oh->hashes, 0, sizeof(*oh->hashes) * OHASH_CAPACITY(oh));
+	}
+	oh->nentries = 0;
+}
+
+/**
+ * Wraps #BLI_ohash_clear_ex with zero entries reserved.
+ */
+void BLI_ohash_clear(OHash *oh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	BLI_ohash_clear_ex(oh, keyfreefp, valfreefp, 0);
+}
+
+/**
+ * Sets a OHash flag.
+ */
+void BLI_ohash_flag_set(OHash *oh, uint flag)
+{
+	oh->flag |= flag;
+}
+
+/**
+ * Clear a OHash flag.
+ */
+void BLI_ohash_flag_clear(OHash *oh, uint flag)
+{
+	oh->flag &= ~flag;
+}
+
+/**
+ * Pointer-keyed table, allows to use the inlined ``BLI_ohash_ptr_`` lookups.
+ */
+OHash *BLI_ohash_ptr_new_ex(const char *info, const uint nentries_reserve)
+{
+	return BLI_ohash_new_ex(BLI_ghashutil_ptrhash, BLI_ghashutil_ptrcmp, info, nentries_reserve);
+}
+OHash *BLI_ohash_ptr_new(const char *info)
+{
+	return BLI_ohash_ptr_new_ex(info, 0);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Iterator API
+ * \{ */
+
+BLI_INLINE void ohash_iterator_skip_empty(OHashIterator *ohi)
+{
+	const OHash *oh = ohi->oh;
+	while (ohi->slot <= oh->slot_mask && oh->hashes[ohi->slot] == 0) {
+		ohi->slot++;
+	}
+}
+
+/**
+ * Init an already allocated OHashIterator. The hash table must not
+ * be mutated while the iterator is in use, and the iterator will
+ * step exactly BLI_ohash_len(oh) times before becoming done.
+ */
+void BLI_ohashIterator_init(OHashIterator *ohi, OHash *oh)
+{
+	ohi->oh = oh;
+	ohi->slot = 0;
+	ohash_iterator_skip_empty(ohi);
+}
+
+/**
+ * Steps the iterator to the next index.
+ */
+void BLI_ohashIterator_step(OHashIterator *ohi)
+{
+	ohi->slot++;
+	ohash_iterator_skip_empty(ohi);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Debugging & Introspection
+ * \{ */
+
+/**
+ * Measure how well the hash function performs (1.0 is approx as good as random distribution).
+ *
+ * \param r_load: The load factor of the table.
+ * \param r_longest_probe: The longest probe sequence needed to reach an entry.
+ * \return the average probe length (number of visited slots) of a successful lookup.
+ */
+double BLI_ohash_calc_quality_ex(OHash *oh, double *r_load, int *r_longest_probe)
+{
+	const uint capacity = OHASH_CAPACITY(oh);
+	uint64_t sum = 0;
+	uint longest = 0;
+
+	for (uint i = 0; i < capacity; i++) {
+		if (oh->hashes[i] != 0) {
+			const uint dist = ohash_probe_distance(oh, i, oh->hashes[i]);
+			sum += dist + 1;
+			longest = MAX2(longest, dist + 1);
+		}
+	}
+
+	if (r_load) {
+		*r_load = (double)oh->nentries / (double)capacity;
+	}
+	if (r_longest_probe) {
+		*r_longest_probe = (int)longest;
+	}
+
+	return oh->nentries ? (double)sum / (double)oh->nentries : 0.0;
+}
+
+/** \} */
@@ -599,6 +599,39 @@ static void pf_triangulate(PolyFill *pf)
 	}
 }
 
+#ifdef USE_CONVEX_SKIP
+/**
+ * Fast-path for polygons where all corners are convex (circles, CAD caps... etc).
+ * Any corner is a valid ear, so the checks and sign updates of #pf_triangulate are skipped,
+ * clipping ears in the same order gives the same triangles.
+ */
+static void pf_triangulate_convex(PolyFill *pf)
+{
+	PolyIndex *pi_ear = pf->indices;
+
+	BLI_assert(pf->coords_tot_concave == 0);
+
+	while (pf->coords_tot > 3) {
+		PolyIndex *pi_next = pi_ear->next;
+		pf_ear_tip_cut(pf, pi_ear);
+#ifdef USE_CLIP_EVEN
+		pi_ear = pi_next->next;
+#else
+		UNUSED_VARS(pi_next);
+		pi_ear = pf->indices;
+#endif
+	}
+
+	if (pf->coords_tot == 3) {
+		uint *tri = pf_tri_add(pf);
+		pi_ear = pf->indices;
+		tri[0] = pi_ear->index; pi_ear = pi_ear->next;
+		tri[1] = pi_ear->index; pi_ear = pi_ear->next;
+		tri[2] = pi_ear->index;
+	}
+}
+#endif
+
 /**
  * \return CONCAVE, TANGENTIAL or CONVEX
  */
@@ -859,6 +892,13 @@ static void polyfill_prepare(
 static void polyfill_calc(
         PolyFill *pf)
 {
+#ifdef USE_CONVEX_SKIP
+	if (pf->coords_tot_concave == 0) {
+		pf_triangulate_convex(pf);
+		return;
+	}
+#endif
+
 #ifdef USE_KDTREE
 #ifdef USE_CONVEX_SKIP
 	if (pf->coords_tot_concave)
@@ -28,6 +28,7 @@
 
 #include "BLI_listbase.h"
 #include "BLI_math.h"
+#include "BLI_memarena.h"
 #include "BLI_mempool.h"
 #include "BLI_task.h"
 #include "BLI_threads.h"
@@ -58,6 +59,14 @@
  */
 #define DELAYED_QUEUE_SIZE 4096
 
+/* Number of tasks which fit into per-thread work-stealing deque.
+ *
+ * Must be power of two. When deque is full tasks are pushed to the scheduler's
+ * global queue instead.
+ */
+#define DEQUE_SIZE 1024
+#define DEQUE_MASK (DEQUE_SIZE - 1)
+
 #ifndef NDEBUG
 #  define ASSERT_THREAD_ID(scheduler, thread_id)                              \
 	do {                                                                      \
@@ -157,6 +166,34 @@ typedef struct TaskThreadLocalStorage {
 	Task *delayed_queue[DELAYED_QUEUE_SIZE];
 } TaskThreadLocalStorage;
 
+/* Single slot of a work-stealing deque.
+ *
+ * Pool is duplicated here so thieves can filter tasks by pool without
+ * dereferencing task which might have been already handled and freed by
+ * another thread.
+ */
+typedef struct TaskDequeSlot {
+	Task *task;
+	TaskPool *pool;
+} TaskDequeSlot;
+
+/* Per-thread work-stealing deque (Chase-Lev).
+ *
+ * Owner thread pushes and pops tasks at the bottom (LIFO, good cache locality
+ * for tasks spawned from the running task), all other threads steal from the
+ * top (FIFO, oldest and usually biggest chunks of work).
+ *
+ * Only owner thread modifies bottom, top is only advanced with CAS.
+ */
+typedef struct TaskDeque {
+	volatile int64_t top;
+	/* Keep indices on different cache lines, they are modified by different
+	 * threads. */
+	char pad[64 - sizeof(int64_t)];
+	volatile int64_t bottom;
+	TaskDequeSlot slots[DEQUE_SIZE];
+} TaskDeque;
+
 struct TaskPool {
 	TaskScheduler *scheduler;
 
@@ -207,6 +244,16 @@ struct TaskScheduler {
 	int num_threads;
 	bool background_thread_only;
 
+	/* Every thread (including main one) has its own deque, tasks pushed from
+	 * within a running task go there instead of the global queue. See
+	 * TASK_SCHEDULER_WORK_STEALING.
+	 */
+	bool use_work_stealing;
+	/* Number of worker threads which are waiting on queue_cond. Used to avoid
+	 * taking queue_mutex on every deque push when all threads are busy.
+	 */
+	volatile uint32_t num_sleeping_threads;
+
 	ListBase queue;
 	ThreadMutex queue_mutex;
 	ThreadCondition queue_cond;
@@ -221,6 +268,10 @@ typedef struct TaskThread {
 	TaskScheduler *scheduler;
 	int id;
 	TaskThreadLocalStorage tls;
+	/* Only allocated when scheduler uses work stealing. */
+	TaskDeque *deque;
+	/* State of pseudo-random generator used to pick victim to steal from. */
+	uint32_t steal_seed;
 } TaskThread;
 
 /* Helper */
@@ -325,31 +376,163 @@ static void task_free(TaskPool *pool, Task *task, const int thread_id)
 
 /* Task Scheduler */
 
+/* NOTE: Counter itself is modified atomically, since tasks pushed to
+ * work-stealing deques are accounted without any locks. Mutex is only used to
+ * ensure waiters do not miss notification. */
 static void task_pool_num_decrease(TaskPool *pool, size_t done)
 {
-	BLI_mutex_lock(&pool->num_mutex);
-
 	BLI_assert(pool->num >= done);
 
-	pool->num -= done;
-
-	if (pool->num == 0) {
+	if (atomic_sub_and_fetch_z((size_t *)&pool->num, done) == 0) {
+		BLI_mutex_lock(&pool->num_mutex);
 		BLI_condition_notify_all(&pool->num_cond);
+		BLI_mutex_unlock(&pool->num_mutex);
 	}
-
-	BLI_mutex_unlock(&pool->num_mutex);
 }
 
 static void task_pool_num_increase(TaskPool *pool, size_t new)
 {
-	BLI_mutex_lock(&pool->num_mutex);
+	atomic_add_and_fetch_z((size_t *)&pool->num, new);
 
-	pool->num += new;
+	BLI_mutex_lock(&pool->num_mutex);
 	BLI_condition_notify_all(&pool->num_cond);
-
 	BLI_mutex_unlock(&pool->num_mutex);
 }
 
+/* Work-stealing deque */
+
+BLI_INLINE TaskDeque *task_deque_get(TaskPool *pool, const int thread_id)
+{
+	TaskScheduler *scheduler = pool->scheduler;
+	if (!scheduler->use_work_stealing || thread_id == -1) {
+		return NULL;
+	}
+	if (thread_id == 0 && (pool->use_local_tls || !BLI_thread_is_main())) {
+		/* Threads which are not managed by the scheduler do not have deque. */
+		return NULL;
+	}
+	return scheduler->task_threads[thread_id].deque;
+}
+
+BLI_INLINE bool task_deque_is_owned_by_current_thread(TaskScheduler *scheduler,
+                                                      const int thread_id)
+{
+	if (thread_id == 0) {
+		return BLI_thread_is_main();
+	}
+	return pthread_getspecific(scheduler->tls_id_key) == &scheduler->task_threads[thread_id];
+}
+
+BLI_INLINE bool task_deque_is_empty(const TaskDeque *deque)
+{
+	return deque->top >= deque->bottom;
+}
+
+/* Only to be called from the deque owner thread. */
+static bool task_deque_push(TaskDeque *deque, Task *task)
+{
+	const int64_t bottom = deque->bottom;
+	const int64_t top = deque->top;
+	if (bottom - top >= DEQUE_SIZE) {
+		return false;
+	}
+	TaskDequeSlot *slot = &deque->slots[bottom & DEQUE_MASK];
+	slot->task = task;
+	slot->pool = task->pool;
+	/* Full barrier, makes slot visible to thieves before bottom. */
+	atomic_add_and_fetch_int64((int64_t *)&deque->bottom, 1);
+	return true;
+}
+
+/* Only to be called from the deque owner thread. */
+static Task *task_deque_pop(TaskDeque *deque)
+{
+	/* Full barrier, bottom must be published before reading top. */
+	const int64_t bottom = atomic_sub_and_fetch_int64((int64_t *)&deque->bottom, 1);
+	int64_t top = deque->top;
+	if (top > bottom) {
+		/* Deque was empty. */
+		deque->bottom = bottom + 1;
+		return NULL;
+	}
+	Task *task = deque->slots[bottom & DEQUE_MASK].task;
+	if (top == bottom) {
+		/* Last task in the deque, race against thieves for it. */
+		if (atomic_cas_int64((int64_t *)&deque->top, top, top + 1) != top) {
+			task = NULL;
+		}
+		deque->bottom = bottom + 1;
+	}
+	return task;
+}
+
+/* Can be called from any thread. If pool is not NULL only the task from that
+ * pool is stolen. */
+static Task *task_deque_steal(TaskDeque *deque, TaskPool *pool)
+{
+	const int64_t top = deque->top;
+	/* Full barrier, top must be read before bottom. */
+	const int64_t bottom = atomic_fetch_and_add_int64((int64_t *)&deque->bottom, 0);
+	if (top >= bottom) {
+		return NULL;
+	}
+	const TaskDequeSlot *slot = &deque->slots[top & DEQUE_MASK];
+	Task *task = slot->task;
+	if (pool != NULL && slot->pool != pool) {
+		return NULL;
+	}
+	if (atomic_cas_int64((int64_t *)&deque->top, top, top + 1) != top) {
+		/* Lost the race against owner or another thief. */
+		return NULL;
+	}
+	return task;
+}
+
+/* Steal a task from any of the threads, starting at a random one to avoid
+ * all thieves hammering the same victim. */
+static Task *task_scheduler_steal(TaskScheduler *scheduler,
+                                  TaskThread *thief,
+                                  TaskPool *pool)
+{
+	const int num_deques = scheduler->num_threads + 1;
+	uint32_t seed = thief->steal_seed;
+	seed ^= seed << 13;
+	seed ^= seed >> 17;
+	seed ^= seed << 5;
+	thief->steal_seed = seed;
+	const int offset = (int)(seed % (uint32_t)num_deques);
+	for (int i = 0; i < num_deques; i++) {
+		TaskThread *victim = &scheduler->task_threads[(offset + i) % num_deques];
+		Task *task = task_deque_steal(victim->deque, pool);
+		if (task != NULL) {
+			return task;
+		}
+	}
+	return NULL;
+}
+
+static bool task_scheduler_has_stealable_tasks(TaskScheduler *scheduler)
+{
+	for (int i = 0; i < scheduler->num_threads + 1; i++) {
+		if (!task_deque_is_empty(scheduler->task_threads[i].deque)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Wake up one sleeping worker, if any, after task was pushed to a deque. */
+static void task_scheduler_wakeup_thief(TaskScheduler *scheduler)
+{
+	/* NOTE: Deque push is a full barrier, so either we see the sleeping thread
+	 * here, or it sees our task when checking deques before going to sleep. */
+	if (atomic_fetch_and_add_uint32((uint32_t *)&scheduler->num_sleeping_threads, 0) != 0) {
+		BLI_mutex_lock(&scheduler->queue_mutex);
+		BLI_condition_notify_one(&scheduler->queue_cond);
+		BLI_mutex_unlock(&scheduler->queue_mutex);
+	}
+}
+
 static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler, Task **task)
 {
 	bool found_task = false;
@@ -423,6 +606,73 @@ BLI_INLINE void handle_local_queue(TaskThreadLocalStorage *tls,
 	BLI_assert(!tls->do_delayed_push);
 }
 
+/* Non-blocking pop of any task from the global queue. */
+static Task *task_scheduler_try_pop(TaskScheduler *scheduler)
+{
+	Task *task;
+	/* Cheap check to avoid lock contention when global queue is not used. */
+	if (scheduler->queue.first == NULL) {
+		return NULL;
+	}
+	BLI_mutex_lock(&scheduler->queue_mutex);
+	task = scheduler->queue.first;
+	if (task != NULL) {
+		BLI_remlink(&scheduler->queue, task);
+	}
+	BLI_mutex_unlock(&scheduler->queue_mutex);
+	return task;
+}
+
+/* Work-stealing version of task_scheduler_thread_wait_pop().
+ *
+ * Order of task lookup is: own deque, global queue, other threads' deques.
+ * Only when nothing is found anywhere the thread goes to sleep. */
+static bool task_scheduler_thread_wait_pop_stealing(TaskThread *thread, Task **task)
+{
+	TaskScheduler *scheduler = thread->scheduler;
+
+	while (!scheduler->do_exit) {
+		if ((*task = task_deque_pop(thread->deque)) != NULL ||
+		    (*task = task_scheduler_try_pop(scheduler)) != NULL ||
+		    (*task = task_scheduler_steal(scheduler, thread, NULL)) != NULL)
+		{
+			return true;
+		}
+
+		BLI_mutex_lock(&scheduler->queue_mutex);
+		atomic_add_and_fetch_uint32((uint32_t *)&scheduler->num_sleeping_threads, 1);
+		/* Check again after announcing ourselves as sleeping, so concurrent
+		 * deque push either sees us or we see its task. */
+		if (!scheduler->do_exit &&
+		    scheduler->queue.first == NULL &&
+		    !task_scheduler_has_stealable_tasks(scheduler))
+		{
+			BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+		}
+		atomic_sub_and_fetch_uint32((uint32_t *)&scheduler->num_sleeping_threads, 1);
+		BLI_mutex_unlock(&scheduler->queue_mutex);
+	}
+
+	return false;
+}
+
+static void *task_scheduler_thread_run_stealing(TaskThread *thread)
+{
+	int thread_id = thread->id;
+	Task *task;
+
+	while (task_scheduler_thread_wait_pop_stealing(thread, &task)) {
+		TaskPool *pool = task->pool;
+
+		task->run(pool, task->taskdata, thread_id);
+		task_free(pool, task, thread_id);
+
+		task_pool_num_decrease(pool, 1);
+	}
+
+	return NULL;
+}
+
 static void *task_scheduler_thread_run(void *thread_p)
 {
 	TaskThread *thread = (TaskThread *) thread_p;
@@ -433,6 +683,10 @@ static void *task_scheduler_thread_run(void *thread_p)
 
 	pthread_setspecific(scheduler->tls_id_key, thread);
 
+	if (scheduler->use_work_stealing) {
+		return task_scheduler_thread_run_stealing(thread);
+	}
+
 	/* keep popping off tasks */
 	while (task_scheduler_thread_wait_pop(scheduler, &task)) {
 		TaskPool *pool = task->pool;
@@ -456,6 +710,14 @@ static void *task_scheduler_thread_run(void *thread_p)
 }
 
 TaskScheduler *BLI_task_scheduler_create(int num_threads)
+{
+	return BLI_task_scheduler_create_ex(num_threads, 0);
+}
+
+/**
+ * Create scheduler with non-default behavior, see #eTaskSchedulerFlag.
+ */
+TaskScheduler *BLI_task_scheduler_create_ex(int num_threads, const int flag)
 {
 	TaskScheduler *scheduler = MEM_callocN(sizeof(TaskScheduler), "TaskScheduler");
 
@@ -481,12 +743,27 @@ TaskScheduler *BLI_task_scheduler_create(int num_threads)
 		num_threads = 1;
 	}
 
-	scheduler->task_threads = MEM_mallocN(sizeof(TaskThread) * (num_threads + 1),
+	/* Work stealing is pointless with the background-only thread, which is
+	 * not allowed to pick up tasks from regular pools anyway. */
+	scheduler->use_work_stealing = (flag & TASK_SCHEDULER_WORK_STEALING) &&
+	                               !scheduler->background_thread_only;
+
+	scheduler->task_threads = MEM_callocN(sizeof(TaskThread) * (num_threads + 1),
 	                                      "TaskScheduler task threads");
 
 	/* Initialize TLS for main thread. */
+	scheduler->task_threads[0].scheduler = scheduler;
 	initialize_task_tls(&scheduler->task_threads[0].tls);
 
+	if (scheduler->use_work_stealing) {
+		for (int i = 0; i < num_threads + 1; i++) {
+			TaskThread *thread = &scheduler->task_threads[i];
+			thread->deque = MEM_callocN(sizeof(TaskDeque), "TaskScheduler deque");
+			/* Any non-zero seed will do. */
+			thread->steal_seed = 2463534242u + (uint32_t)i * 2654435761u;
+		}
+	}
+
 	pthread_key_create(&scheduler->tls_id_key, NULL);
 
 	/* launch threads that will be waiting for work */
@@ -541,6 +818,16 @@ void BLI_task_scheduler_free(TaskScheduler *scheduler)
 		for (int i = 0; i < scheduler->num_threads + 1; ++i) {
 			TaskThreadLocalStorage *tls = &scheduler->task_threads[i].tls;
 			free_task_tls(tls);
+			if (scheduler->task_threads[i].deque != NULL) {
+				/* delete leftover tasks */
+				TaskDeque *deque = scheduler->task_threads[i].deque;
+				for (int64_t j = deque->top; j < deque->bottom; j++) {
+					task = deque->slots[j & DEQUE_MASK].task;
+					task_data_free(task, 0);
+					MEM_freeN(task);
+				}
+				MEM_freeN(deque);
+			}
 		}
 
 		MEM_freeN(scheduler->task_threads);
@@ -564,11 +851,9 @@ int BLI_task_scheduler_num_threads(TaskScheduler *scheduler)
 	return scheduler->num_threads + 1;
 }
 
-static void task_scheduler_push(TaskScheduler *scheduler, Task *task, TaskPriority priority)
+/* Add task to the global queue, it must already be accounted in pool's num. */
+static void task_scheduler_queue_add(TaskScheduler *scheduler, Task *task, TaskPriority priority)
 {
-	task_pool_num_increase(task->pool, 1);
-
-	/* add task to queue */
 	BLI_mutex_lock(&scheduler->queue_mutex);
 
 	if (priority == TASK_PRIORITY_HIGH) {
@@ -582,6 +867,14 @@ static void task_scheduler_push(TaskScheduler *scheduler, Task *task, TaskPriori
 	BLI_mutex_unlock(&scheduler->queue_mutex);
 }
 
+static void task_scheduler_push(TaskScheduler *scheduler, Task *task, TaskPriority priority)
+{
+	task_pool_num_increase(task->pool, 1);
+
+	/* add task to queue */
+	task_scheduler_queue_add(scheduler, task, priority);
+}
+
 static void task_scheduler_push_all(TaskScheduler *scheduler,
                                     TaskPool *pool,
                                     Task **tasks,
@@ -803,6 +1096,20 @@ static void task_pool_push(
 	/* Populate to any local queue first, this is cheapest push ever. */
 	if (task_can_use_local_queues(pool, thread_id)) {
 		ASSERT_THREAD_ID(pool->scheduler, thread_id);
+		/* With work stealing own deque replaces local and delayed queues, tasks
+		 * in there are still available for idle threads.
+		 */
+		TaskDeque *deque = task_deque_get(pool, thread_id);
+		if (deque != NULL) {
+			/* Account the task before it becomes visible to thieves. */
+			atomic_add_and_fetch_z((size_t *)&pool->num, 1);
+			if (!task_deque_push(deque, task)) {
+				task_scheduler_queue_add(pool->scheduler, task, priority);
+				return;
+			}
+			task_scheduler_wakeup_thief(pool->scheduler);
+			return;
+		}
 		TaskThreadLocalStorage *tls = get_task_tls(pool, thread_id);
 		/* Try to push to a local execution queue.
 		 * These tasks will be picked up next.
@@ -847,6 +1154,80 @@ void BLI_task_pool_push_from_thread(TaskPool *pool, TaskRunFunction run,
 	task_pool_push(pool, run, taskdata, free_taskdata, NULL, priority, thread_id);
 }
 
+/* Pop task of the given pool from own deque. Tasks of other pools on top of
+ * it are moved to the global queue, running them here could deadlock. */
+static Task *task_deque_pop_for_pool(TaskScheduler *scheduler, TaskDeque *deque, TaskPool *pool)
+{
+	Task *task;
+	while ((task = task_deque_pop(deque)) != NULL) {
+		if (task->pool == pool) {
+			return task;
+		}
+		task_scheduler_queue_add(scheduler, task, TASK_PRIORITY_HIGH);
+	}
+	return NULL;
+}
+
+static Task *task_scheduler_pop_for_pool(TaskScheduler *scheduler, TaskPool *pool)
+{
+	Task *task;
+
+	BLI_mutex_lock(&scheduler->queue_mutex);
+
+	for (task = scheduler->queue.first; task; task = task->next) {
+		if (task->pool == pool) {
+			BLI_remlink(&scheduler->queue, task);
+			break;
+		}
+	}
+
+	BLI_mutex_unlock(&scheduler->queue_mutex);
+
+	return task;
+}
+
+static void task_pool_work_and_wait_stealing(TaskPool *pool)
+{
+	TaskScheduler *scheduler = pool->scheduler;
+	TaskDeque *deque = task_deque_get(pool, pool->thread_id);
+	TaskThread *thread = &scheduler->task_threads[pool->thread_id];
+
+	BLI_mutex_lock(&pool->num_mutex);
+
+	while (pool->num != 0) {
+		Task *task = NULL;
+
+		BLI_mutex_unlock(&pool->num_mutex);
+
+		if (deque != NULL) {
+			task = task_deque_pop_for_pool(scheduler, deque, pool);
+		}
+		if (task == NULL) {
+			task = task_scheduler_pop_for_pool(scheduler, pool);
+		}
+		if (task == NULL && !pool->use_local_tls) {
+			task = task_scheduler_steal(scheduler, thread, pool);
+		}
+
+		if (task != NULL) {
+			task->run(pool, task->taskdata, pool->thread_id);
+			task_free(pool, task, pool->thread_id);
+			task_pool_num_decrease(pool, 1);
+		}
+
+		BLI_mutex_lock(&pool->num_mutex);
+		if (pool->num == 0) {
+			break;
+		}
+
+		if (task == NULL) {
+			BLI_condition_wait(&pool->num_cond, &pool->num_mutex);
+		}
+	}
+
+	BLI_mutex_unlock(&pool->num_mutex);
+}
+
 void BLI_task_pool_work_and_wait(TaskPool *pool)
 {
 	TaskThreadLocalStorage *tls = get_task_tls(pool, pool->thread_id);
@@ -872,6 +1253,12 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 
 	handle_local_queue(tls, pool->thread_id);
 
+	if (scheduler->use_work_stealing) {
+		task_pool_work_and_wait_stealing(pool);
+		BLI_assert(tls->num_local_queue == 0);
+		return;
+	}
+
 	BLI_mutex_lock(&pool->num_mutex);
 
 	while (pool->num != 0) {
@@ -942,6 +1329,17 @@ void BLI_task_pool_cancel(TaskPool *pool)
 
 	task_scheduler_clear(pool->scheduler, pool);
 
+	/* Tasks in own deque are not reachable by anyone else while we wait here
+	 * if they are below tasks of other pools, so handle them right away. */
+	TaskDeque *deque = task_deque_get(pool, pool->thread_id);
+	if (deque != NULL && task_deque_is_owned_by_current_thread(pool->scheduler, pool->thread_id)) {
+		Task *task;
+		while ((task = task_deque_pop_for_pool(pool->scheduler, deque, pool)) != NULL) {
+			task_free(pool, task, pool->thread_id);
+			task_pool_num_decrease(pool, 1);
+		}
+	}
+
 	/* wait until all entries are cleared */
 	BLI_mutex_lock(&pool->num_mutex);
 	while (pool->num) {
@@ -998,17 +1396,62 @@ void BLI_task_pool_delayed_push_end(TaskPool *pool, int thread_id)
  * Main functions:
  * - #BLI_task_parallel_range
  * - #BLI_task_parallel_listbase (#ListBase - double linked list)
+ * - #BLI_task_parallel_mempool (#BLI_mempool - iterate over mempools)
  *
  * TODO:
  * - #BLI_task_parallel_foreach_link (#Link - single linked list)
  * - #BLI_task_parallel_foreach_ghash/gset (#GHash/#GSet - hash & set)
- * - #BLI_task_parallel_foreach_mempool (#BLI_mempool - iterate over mempools)
  */
 
 /* Allows to avoid using malloc for userdata_chunk in tasks, when small enough. */
 #define MALLOCA(_size) ((_size) <= 8192) ? alloca((_size)) : MEM_mallocN((_size), __func__)
 #define MALLOCA_FREE(_mem, _size) if (((_mem) != NULL) && ((_size) > 8192)) MEM_freeN((_mem))
 
+/**
+ * Initialize the per-task data of a parallel loop: a copy of the user chunk
+ * (stored in \a userdata_chunk_array, when used) and a scratch arena for each task.
+ */
+static void parallel_tls_init(
+        const ParallelRangeSettings *settings,
+        ParallelRangeTLS *tls_array, void *userdata_chunk_array, const int num_tasks)
+{
+	const size_t userdata_chunk_size = settings->userdata_chunk_size;
+
+	for (int i = 0; i < num_tasks; i++) {
+		ParallelRangeTLS *tls = &tls_array[i];
+		tls->thread_id = 0;
+		tls->userdata_chunk = NULL;
+		tls->arena = NULL;
+
+		if (userdata_chunk_array != NULL) {
+			tls->userdata_chunk = (char *)userdata_chunk_array + (userdata_chunk_size * i);
+			memcpy(tls->userdata_chunk, settings->userdata_chunk, userdata_chunk_size);
+		}
+		if (settings->use_arena) {
+			/* Buffers are only allocated on first use. */
+			tls->arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, "parallel loop arena");
+		}
+	}
+}
+
+/**
+ * Call the finalize callback for each task, then free their arenas
+ * (after finalize, so reductions can still read data allocated in them).
+ */
+static void parallel_tls_finalize(
+        void *userdata, const ParallelRangeSettings *settings,
+        ParallelRangeTLS *tls_array, const int num_tasks, const bool do_finalize)
+{
+	for (int i = 0; i < num_tasks; i++) {
+		if (do_finalize && settings->func_finalize != NULL) {
+			settings->func_finalize(userdata, tls_array[i].userdata_chunk);
+		}
+		if (tls_array[i].arena != NULL) {
+			BLI_memarena_free(tls_array[i].arena);
+		}
+	}
+}
+
 typedef struct ParallelRangeState {
 	int start, stop;
 	void *userdata;
@@ -1033,14 +1476,12 @@ BLI_INLINE bool parallel_range_next_iter_get(
 
 static void parallel_range_func(
         TaskPool * __restrict pool,
-        void *userdata_chunk,
+        void *taskdata,
         int thread_id)
 {
 	ParallelRangeState * __restrict state = BLI_task_pool_userdata(pool);
-	ParallelRangeTLS tls = {
-		.thread_id = thread_id,
-		.userdata_chunk = userdata_chunk,
-	};
+	ParallelRangeTLS tls = *(ParallelRangeTLS *)taskdata;
+	tls.thread_id = thread_id;
 	int iter, count;
 	while (parallel_range_next_iter_get(state, &iter, &count)) {
 		for (int i = 0; i < count; ++i) {
@@ -1060,18 +1501,13 @@ static void parallel_range_single_thread(const int start, int const stop,
 	const bool use_userdata_chunk = (userdata_chunk_size != 0) && (userdata_chunk != NULL);
 	if (use_userdata_chunk) {
 		userdata_chunk_local = MALLOCA(userdata_chunk_size);
-		memcpy(userdata_chunk_local, userdata_chunk, userdata_chunk_size);
 	}
-	ParallelRangeTLS tls = {
-		.thread_id = 0,
-		.userdata_chunk = userdata_chunk_local,
-	};
+	ParallelRangeTLS tls;
+	parallel_tls_init(settings, &tls, userdata_chunk_local, 1);
 	for (int i = start; i < stop; ++i) {
 		func(userdata, i, &tls);
 	}
-	if (settings->func_finalize != NULL) {
-		settings->func_finalize(userdata, userdata_chunk_local);
-	}
+	parallel_tls_finalize(userdata, settings, &tls, 1, true);
 	MALLOCA_FREE(userdata_chunk_local, userdata_chunk_size);
 }
 
@@ -1092,8 +1528,8 @@ void BLI_task_parallel_range(const int start, const int stop,
 
 	void *userdata_chunk = settings->userdata_chunk;
 	const size_t userdata_chunk_size = settings->userdata_chunk_size;
-	void *userdata_chunk_local = NULL;
 	void *userdata_chunk_array = NULL;
+	ParallelRangeTLS *tls_array;
 	const bool use_userdata_chunk = (userdata_chunk_size != 0) && (userdata_chunk != NULL);
 
 	if (start == stop) {
@@ -1162,16 +1598,14 @@ void BLI_task_parallel_range(const int start, const int stop,
 	if (use_userdata_chunk) {
 		userdata_chunk_array = MALLOCA(userdata_chunk_size * num_tasks);
 	}
+	tls_array = MALLOCA(sizeof(*tls_array) * (size_t)num_tasks);
+	parallel_tls_init(settings, tls_array, userdata_chunk_array, num_tasks);
 
 	for (i = 0; i < num_tasks; i++) {
-		if (use_userdata_chunk) {
-			userdata_chunk_local = (char *)userdata_chunk_array + (userdata_chunk_size * i);
-			memcpy(userdata_chunk_local, userdata_chunk, userdata_chunk_size);
-		}
 		/* Use this pool's pre-allocated tasks. */
 		BLI_task_pool_push_from_thread(task_pool,
 		                               parallel_range_func,
-		                               userdata_chunk_local, false,
+		                               &tls_array[i], false,
 		                               TASK_PRIORITY_HIGH,
 		                               task_pool->thread_id);
 	}
@@ -1179,20 +1613,11 @@ void BLI_task_parallel_range(const int start, const int stop,
 	BLI_task_pool_work_and_wait(task_pool);
 	BLI_task_pool_free(task_pool);
 
-	if (use_userdata_chunk) {
-		if (settings->func_finalize != NULL) {
-			for (i = 0; i < num_tasks; i++) {
-				userdata_chunk_local = (char *)userdata_chunk_array + (userdata_chunk_size * i);
-				settings->func_finalize(userdata, userdata_chunk_local);
-			}
-		}
-		MALLOCA_FREE(userdata_chunk_array, userdata_chunk_size * num_tasks);
-	}
+	parallel_tls_finalize(userdata, settings, tls_array, num_tasks, use_userdata_chunk);
+	MALLOCA_FREE(tls_array, sizeof(*tls_array) * (size_t)num_tasks);
+	MALLOCA_FREE(userdata_chunk_array, userdata_chunk_size * num_tasks);
 }
 
-#undef MALLOCA
-#undef MALLOCA_FREE
-
 typedef struct ParallelListbaseState {
 	void *userdata;
 	TaskParallelListbaseFunc func;
@@ -1330,22 +1755,178 @@ void BLI_task_parallel_listbase(
 
 
 typedef struct ParallelMempoolState {
+	BLI_mempool *mempool;
 	void *userdata;
 	TaskParallelMempoolFunc func;
+	TaskParallelMempoolFuncEx func_ex;
+
+	/* All chunks of the mempool, claimed by tasks in groups of chunk_step ones. */
+	struct BLI_mempool_chunk **chunks;
+	uint chunks_len;
+	uint chunk_step;
+	uint chunk_next;
 } ParallelMempoolState;
 
+BLI_INLINE bool parallel_mempool_next_chunks_get(
+        ParallelMempoolState * __restrict state,
+        uint * __restrict r_chunk_start, uint * __restrict r_chunk_end)
+{
+	const uint chunk_start = atomic_fetch_and_add_uint32(&state->chunk_next, state->chunk_step);
+
+	*r_chunk_start = chunk_start;
+	*r_chunk_end = MIN2(chunk_start + state->chunk_step, state->chunks_len);
+
+	return (chunk_start < state->chunks_len);
+}
+
 static void parallel_mempool_func(
         TaskPool * __restrict pool,
         void *taskdata,
-        int UNUSED(threadid))
+        int thread_id)
 {
 	ParallelMempoolState * __restrict state = BLI_task_pool_userdata(pool);
-	BLI_mempool_iter *iter = taskdata;
+	ParallelRangeTLS tls = *(ParallelRangeTLS *)taskdata;
+	tls.thread_id = thread_id;
+	BLI_mempool_iter iter;
 	MempoolIterData *item;
+	uint chunk_start, chunk_end;
+
+	/* Only claiming whole groups of chunks is synchronized between tasks,
+	 * items are then iterated without any atomic operation. */
+	while (parallel_mempool_next_chunks_get(state, &chunk_start, &chunk_end)) {
+		for (uint i = chunk_start; i < chunk_end; i++) {
+			BLI_mempool_iternew_chunk(state->mempool, &iter, state->chunks[i]);
+			if (state->func_ex != NULL) {
+				while ((item = BLI_mempool_iterstep(&iter)) != NULL) {
+					state->func_ex(state->userdata, item, &tls);
+				}
+			}
+			else {
+				while ((item = BLI_mempool_iterstep(&iter)) != NULL) {
+					state->func(state->userdata, item);
+				}
+			}
+		}
+	}
+}
+
+static void parallel_mempool_single_thread(
+        BLI_mempool *mempool,
+        void *userdata,
+        TaskParallelMempoolFuncEx func,
+        const ParallelRangeSettings *settings)
+{
+	void *userdata_chunk = settings->userdata_chunk;
+	const size_t userdata_chunk_size = settings->userdata_chunk_size;
+	void *userdata_chunk_local = NULL;
+	const bool use_userdata_chunk = (userdata_chunk_size != 0) && (userdata_chunk != NULL);
+	if (use_userdata_chunk) {
+		userdata_chunk_local = MALLOCA(userdata_chunk_size);
+	}
+	ParallelRangeTLS tls;
+	parallel_tls_init(settings, &tls, userdata_chunk_local, 1);
+	BLI_mempool_iter iter;
+	BLI_mempool_iternew(mempool, &iter);
+
+	for (void *item = BLI_mempool_iterstep(&iter); item != NULL; item = BLI_mempool_iterstep(&iter)) {
+		func(userdata, item, &tls);
+	}
+	parallel_tls_finalize(userdata, settings, &tls, 1, true);
+	MALLOCA_FREE(userdata_chunk_local, userdata_chunk_size);
+}
+
+static void task_parallel_mempool_ex(
+        BLI_mempool *mempool,
+        void *userdata,
+        TaskParallelMempoolFunc func,
+        TaskParallelMempoolFuncEx func_ex,
+        const ParallelRangeSettings *settings)
+{
+	TaskScheduler *task_scheduler;
+	TaskPool *task_pool;
+	ParallelMempoolState state;
+	int i, num_threads, num_tasks;
+
+	void *userdata_chunk = settings->userdata_chunk;
+	const size_t userdata_chunk_size = settings->userdata_chunk_size;
+	void *userdata_chunk_array = NULL;
+	ParallelRangeTLS *tls_array;
+	const bool use_userdata_chunk = (userdata_chunk_size != 0) && (userdata_chunk != NULL);
+
+	task_scheduler = BLI_task_scheduler_get();
+	num_threads = BLI_task_scheduler_num_threads(task_scheduler);
+
+	state.mempool = mempool;
+	state.userdata = userdata;
+	state.func = func;
+	state.func_ex = func_ex;
+	state.chunks = BLI_mempool_chunks_array_create(mempool, &state.chunks_len);
+	state.chunk_next = 0;
 
-	while ((item = BLI_mempool_iterstep(iter)) != NULL) {
-		state->func(state->userdata, item);
+	/* The idea here is to prevent creating task for each of the loop iterations
+	 * and instead have tasks which are evenly distributed across CPU cores and
+	 * claim whole chunks of the mempool to be crunched.
+	 */
+	num_tasks = num_threads + 2;
+	if (settings->min_iter_per_thread > 1) {
+		num_tasks = min_ii(num_tasks, max_ii(1, BLI_mempool_len(mempool) / settings->min_iter_per_thread));
+	}
+	num_tasks = min_ii(num_tasks, (int)state.chunks_len);
+
+	switch (settings->scheduling_mode) {
+		case TASK_SCHEDULING_STATIC:
+			state.chunk_step = MAX2(1u, state.chunks_len / (uint)num_tasks);
+			break;
+		case TASK_SCHEDULING_DYNAMIC:
+			state.chunk_step = 1;
+			break;
+	}
+
+	if (num_tasks <= 1) {
+		MEM_SAFE_FREE(state.chunks);
+		if (func_ex != NULL) {
+			parallel_mempool_single_thread(mempool, userdata, func_ex, settings);
+		}
+		else {
+			BLI_mempool_iter iter;
+			BLI_mempool_iternew(mempool, &iter);
+
+			for (void *item = BLI_mempool_iterstep(&iter); item != NULL; item = BLI_mempool_iterstep(&iter)) {
+				func(userdata, item);
+			}
+		}
+		return;
+	}
+
+	task_pool = BLI_task_pool_create_suspended(task_scheduler, &state);
+
+	/* NOTE: This way we are adding a memory barrier and ensure all worker
+	 * threads can read and modify the value, without any locks. */
+	atomic_fetch_and_add_uint32(&state.chunk_next, 0);
+
+	if (use_userdata_chunk) {
+		userdata_chunk_array = MALLOCA(userdata_chunk_size * num_tasks);
+	}
+	tls_array = MALLOCA(sizeof(*tls_array) * (size_t)num_tasks);
+	parallel_tls_init(settings, tls_array, userdata_chunk_array, num_tasks);
+
+	for (i = 0; i < num_tasks; i++) {
+		/* Use this pool's pre-allocated tasks. */
+		BLI_task_pool_push_from_thread(task_pool,
+		                               parallel_mempool_func,
+		                               &tls_array[i], false,
+		                               TASK_PRIORITY_HIGH,
+		                               task_pool->thread_id);
 	}
+
+	BLI_task_pool_work_and_wait(task_pool);
+	BLI_task_pool_free(task_pool);
+
+	MEM_freeN(state.chunks);
+
+	parallel_tls_finalize(userdata, settings, tls_array, num_tasks, use_userdata_chunk);
+	MALLOCA_FREE(tls_array, sizeof(*tls_array) * (size_t)num_tasks);
+	MALLOCA_FREE(userdata_chunk_array, userdata_chunk_size * num_tasks);
 }
 
 /**
@@ -1357,7 +1938,7 @@ static void parallel_mempool_func(
  * \param use_threading: If \a true, actually split-execute loop in threads, else just do a sequential for loop
  * (allows caller to use any kind of test to switch on parallelization or not).
  *
- * \note There is no static scheduling here.
+ * \note Work is split over whole chunks of the mempool, see #BLI_task_parallel_mempool_ex.
  */
 void BLI_task_parallel_mempool(
         BLI_mempool *mempool,
@@ -1365,11 +1946,6 @@ void BLI_task_parallel_mempool(
         TaskParallelMempoolFunc func,
         const bool use_threading)
 {
-	TaskScheduler *task_scheduler;
-	TaskPool *task_pool;
-	ParallelMempoolState state;
-	int i, num_threads, num_tasks;
-
 	if (BLI_mempool_len(mempool) == 0) {
 		return;
 	}
@@ -1384,32 +1960,40 @@ void BLI_task_parallel_mempool(
 		return;
 	}
 
-	task_scheduler = BLI_task_scheduler_get();
-	task_pool = BLI_task_pool_create_suspended(task_scheduler, &state);
-	num_threads = BLI_task_scheduler_num_threads(task_scheduler);
-
-	/* The idea here is to prevent creating task for each of the loop iterations
-	 * and instead have tasks which are evenly distributed across CPU cores and
-	 * pull next item to be crunched using the threaded-aware BLI_mempool_iter.
-	 */
-	num_tasks = num_threads + 2;
-
-	state.userdata = userdata;
-	state.func = func;
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	task_parallel_mempool_ex(mempool, userdata, func, NULL, &settings);
+}
 
-	BLI_mempool_iter *mempool_iterators = BLI_mempool_iter_threadsafe_create(mempool, (size_t)num_tasks);
+/**
+ * Same as #BLI_task_parallel_mempool, with per-thread data and a finalize (reduction) callback.
+ *
+ * Each task claims whole chunks of the mempool (a group of them with #TASK_SCHEDULING_STATIC,
+ * a single one with #TASK_SCHEDULING_DYNAMIC), so there is no atomic operation per item.
+ * \a settings are the same as for #BLI_task_parallel_range, with \a min_iter_per_thread
+ * limiting the number of tasks based on the number of items in the mempool.
+ */
+void BLI_task_parallel_mempool_ex(
+        BLI_mempool *mempool,
+        void *userdata,
+        TaskParallelMempoolFuncEx func,
+        const ParallelRangeSettings *settings)
+{
+	if (settings->userdata_chunk_size != 0) {
+		BLI_assert(settings->userdata_chunk != NULL);
+	}
 
-	for (i = 0; i < num_tasks; i++) {
-		/* Use this pool's pre-allocated tasks. */
-		BLI_task_pool_push_from_thread(task_pool,
-		                               parallel_mempool_func,
-		                               &mempool_iterators[i], false,
-		                               TASK_PRIORITY_HIGH,
-		                               task_pool->thread_id);
+	if (BLI_mempool_len(mempool) == 0) {
+		return;
 	}
 
-	BLI_task_pool_work_and_wait(task_pool);
-	BLI_task_pool_free(task_pool);
+	if (!settings->use_threading) {
+		parallel_mempool_single_thread(mempool, userdata, func, settings);
+		return;
+	}
 
-	BLI_mempool_iter_threadsafe_free(mempool_iterators);
+	task_parallel_mempool_ex(mempool, userdata, NULL, func, settings);
 }
+
+#undef MALLOCA
+#undef MALLOCA_FREE
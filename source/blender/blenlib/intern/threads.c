@@ -124,6 +124,7 @@ static pthread_t mainid;
 static bool is_numa_available = false;
 static unsigned int thread_levels = 0;  /* threads can be invoked inside threads */
 static int num_threads_override = 0;
+static bool use_work_stealing = false;
 
 /* just a max for security reasons */
 #define RE_MAX_THREAD BLENDER_MAX_THREADS
@@ -160,6 +161,7 @@ void BLI_threadapi_exit(void)
 {
 	if (task_scheduler) {
 		BLI_task_scheduler_free(task_scheduler);
+		task_scheduler = NULL;
 	}
 	BLI_spin_end(&_malloc_lock);
 }
@@ -172,7 +174,8 @@ TaskScheduler *BLI_task_scheduler_get(void)
 		/* Do a lazy initialization, so it happens after
 		 * command line arguments parsing
 		 */
-		task_scheduler = BLI_task_scheduler_create(tot_thread);
+		task_scheduler = BLI_task_scheduler_create_ex(
+		        tot_thread, use_work_stealing ? TASK_SCHEDULER_WORK_STEALING : 0);
 	}
 
 	return task_scheduler;
@@ -390,6 +393,18 @@ int BLI_system_num_threads_override_get(void)
 	return num_threads_override;
 }
 
+/* Must be set before the global task scheduler is created. */
+void BLI_system_work_stealing_set(bool use)
+{
+	BLI_assert(task_scheduler == NULL);
+	use_work_stealing = use;
+}
+
+bool BLI_system_work_stealing_get(void)
+{
+	return use_work_stealing;
+}
+
 /* Global Mutex Locks */
 
 static ThreadMutex *global_mutex_from_type(const int type)
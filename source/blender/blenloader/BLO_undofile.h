@@ -25,6 +25,7 @@
  * \ingroup blenloader
  */
 
+struct GSet;
 struct Scene;
 
 typedef struct {
@@ -34,11 +35,30 @@ typedef struct {
 	unsigned int size;
 	/** When true, this chunk doesn't own the memory, it's shared with a previous #MemFileChunk */
 	bool is_identical;
+	/**
+	 * Address of the ID this chunk holds data for, NULL for data which isn't part of an ID.
+	 * Only used as a key, the ID may have been freed since this chunk was written.
+	 */
+	const void *id_key;
 } MemFileChunk;
 
 typedef struct MemFile {
 	ListBase chunks;
 	size_t size;
+	/**
+	 * Keys of the ID's written unchanged, all their chunks are shared with the memfile
+	 * this one was compared to when writing (see #BLO_write_file_mem). NULL when there was none.
+	 */
+	struct GSet *ids_unchanged;
+	/**
+	 * Set by the caller before reading, keys of the ID's which are the same in the current state,
+	 * they're reused instead of being read again (see #BLO_memfile_ids_create).
+	 */
+	struct GSet *read_ids_unchanged;
+	/** Statistics of the last time this memfile has been read, see #BLO_read_from_memfile. */
+	int read_ids_len;
+	/** Number of ID's reused from the previous state instead of being read. */
+	int read_ids_reused;
 } MemFile;
 
 typedef struct MemFileUndoData {
@@ -50,7 +70,8 @@ typedef struct MemFileUndoData {
 /* actually only used writefile.c */
 extern void memfile_chunk_add(
         MemFile *memfile, const char *buf, unsigned int size,
-        MemFileChunk **compchunk_step);
+        MemFileChunk **compchunk_step, const void *id_key);
+extern void memfile_chunk_add_shared(MemFile *memfile, const MemFileChunk *compchunk);
 
 /* exports */
 extern void BLO_memfile_free(MemFile *memfile);
@@ -58,6 +79,12 @@ extern void BLO_memfile_merge(MemFile *first, MemFile *second);
 
 /* utilities */
 extern struct Main *BLO_memfile_main_get(struct MemFile *memfile, struct Main *bmain, struct Scene **r_scene);
+extern void BLO_memfile_snapshot(const MemFile *memfile, MemFile *r_snapshot);
 extern bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename);
+extern bool BLO_memfile_write_file_ex(
+        struct MemFile *memfile, const char *filename, const bool use_compress,
+        const short *stop, float *progress);
+extern struct GSet *BLO_memfile_ids_create(const struct MemFile *memfile);
+extern void BLO_memfile_ids_unchanged_filter(struct GSet *ids, const struct MemFile *memfile);
 
 #endif  /* __BLO_UNDOFILE_H__ */
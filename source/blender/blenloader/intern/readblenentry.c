@@ -78,6 +78,25 @@ BlendHandle *BLO_blendhandle_from_file(const char *filepath, ReportList *reports
 	return bh;
 }
 
+/**
+ * Open a blendhandle from a file path, to list its data-blocks and their previews.
+ *
+ * Uses the index at the end of the file when it has one, so only the index is read
+ * instead of all blocks of the file. The handle can't be used for linking.
+ *
+ * \param filepath: The file path to open.
+ * \param reports: Report errors in opening the file (can be NULL).
+ * \return A handle on success, or NULL on failure.
+ */
+BlendHandle *BLO_blendhandle_from_file_index(const char *filepath, ReportList *reports)
+{
+	BlendHandle *bh;
+
+	bh = (BlendHandle *)blo_filedata_from_file_index(filepath, reports);
+
+	return bh;
+}
+
 /**
  * Open a blendhandle from memory.
  *
@@ -99,6 +118,8 @@ void BLO_blendhandle_print_sizes(BlendHandle *bh, void *fp)
 	FileData *fd = (FileData *)bh;
 	BHead *bhead;
 
+	BLI_assert(fd->filesdna != NULL);
+
 	fprintf(fp, "[\n");
 	for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
 		if (bhead->code == ENDB)
@@ -139,6 +160,19 @@ LinkNode *BLO_blendhandle_get_datablock_names(BlendHandle *bh, int ofblocktype,
 	BHead *bhead;
 	int tot = 0;
 
+	if (fd->index_entries != NULL) {
+		for (int i = 0; i < fd->index_entries_len; i++) {
+			const BlendIndexEntry *entry = &fd->index_entries[i];
+			if (entry->code == ofblocktype) {
+				BLI_linklist_prepend(&names, strdup(entry->name + 2));
+				tot++;
+			}
+		}
+
+		*tot_names = tot;
+		return names;
+	}
+
 	for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
 		if (bhead->code == ofblocktype) {
 			const char *idname = blo_bhead_id_name(fd, bhead);
@@ -154,6 +188,66 @@ LinkNode *BLO_blendhandle_get_datablock_names(BlendHandle *bh, int ofblocktype,
 	return names;
 }
 
+static bool blendhandle_has_previews(int ofblocktype)
+{
+	switch (ofblocktype) {
+		case ID_MA: /* fall through */
+		case ID_TE: /* fall through */
+		case ID_IM: /* fall through */
+		case ID_WO: /* fall through */
+		case ID_LA: /* fall through */
+		case ID_OB: /* fall through */
+		case ID_GR: /* fall through */
+		case ID_SCE: /* fall through */
+			return true;
+		default:
+			return false;
+	}
+}
+
+/**
+ * Same as #BLO_blendhandle_get_previews, reading only the preview pixels, using the offsets stored in the index.
+ */
+static LinkNode *blendhandle_get_previews_from_index(FileData *fd, int ofblocktype, int *tot_prev)
+{
+	LinkNode *previews = NULL;
+	int tot = 0;
+
+	if (blendhandle_has_previews(ofblocktype)) {
+		for (int i = 0; i < fd->index_entries_len; i++) {
+			const BlendIndexEntry *entry = &fd->index_entries[i];
+			if (entry->code != ofblocktype) {
+				continue;
+			}
+
+			PreviewImage *new_prv = MEM_callocN(sizeof(PreviewImage), "newpreview");
+			BLI_linklist_prepend(&previews, new_prv);
+			tot++;
+
+			for (int j = 0; j < 2; j++) {
+				new_prv->flag[j] = entry->preview_flag[j];
+				/* Offsets of previews which aren't in the file are cleared when reading the index. */
+				if (entry->preview_rect_offset[j] == 0) {
+					continue;
+				}
+				const int rect_len = (int)(entry->preview_w[j] * entry->preview_h[j] * sizeof(uint));
+				uint *rect = MEM_mallocN((size_t)rect_len, "PreviewImage Rect");
+				if (blo_filedata_read_at(fd, entry->preview_rect_offset[j], rect, rect_len)) {
+					new_prv->w[j] = entry->preview_w[j];
+					new_prv->h[j] = entry->preview_h[j];
+					new_prv->rect[j] = rect;
+				}
+				else {
+					MEM_freeN(rect);
+				}
+			}
+		}
+	}
+
+	*tot_prev = tot;
+	return previews;
+}
+
 /**
  * Gets the previews of all the datablocks in a file of a certain type (e.g. all the scene previews in a file).
  *
@@ -172,25 +266,18 @@ LinkNode *BLO_blendhandle_get_previews(BlendHandle *bh, int ofblocktype, int *to
 	PreviewImage *new_prv = NULL;
 	int tot = 0;
 
+	if (fd->index_entries != NULL) {
+		return blendhandle_get_previews_from_index(fd, ofblocktype, tot_prev);
+	}
+
 	for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
 		if (bhead->code == ofblocktype) {
 			const char *idname = blo_bhead_id_name(fd, bhead);
-			switch (GS(idname)) {
-				case ID_MA: /* fall through */
-				case ID_TE: /* fall through */
-				case ID_IM: /* fall through */
-				case ID_WO: /* fall through */
-				case ID_LA: /* fall through */
-				case ID_OB: /* fall through */
-				case ID_GR: /* fall through */
-				case ID_SCE: /* fall through */
-					new_prv = MEM_callocN(sizeof(PreviewImage), "newpreview");
-					BLI_linklist_prepend(&previews, new_prv);
-					tot++;
-					looking = 1;
-					break;
-				default:
-					break;
+			if (blendhandle_has_previews(GS(idname))) {
+				new_prv = MEM_callocN(sizeof(PreviewImage), "newpreview");
+				BLI_linklist_prepend(&previews, new_prv);
+				tot++;
+				looking = 1;
 			}
 		}
 		else if (bhead->code == DATA) {
@@ -257,11 +344,27 @@ LinkNode *BLO_blendhandle_get_linkable_groups(BlendHandle *bh)
 	LinkNode *names = NULL;
 	BHead *bhead;
 
+	if (fd->index_entries != NULL) {
+		for (int i = 0; i < fd->index_entries_len; i++) {
+			const int code = fd->index_entries[i].code;
+			if (BKE_idcode_is_valid(code) && BKE_idcode_is_linkable(code)) {
+				const char *str = BKE_idcode_to_name(code);
+
+				if (BLI_gset_add(gathered, (void *)str)) {
+					BLI_linklist_prepend(&names, strdup(str));
+				}
+			}
+		}
+
+		BLI_gset_free(gathered, NULL);
+		return names;
+	}
+
 	for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
 		if (bhead->code == ENDB) {
 			break;
 		}
-		else if (BKE_idcode_is_valid(bhead->code)) {
+		else if (BHEAD_CODE_IS_ID(bhead->code) && BKE_idcode_is_valid(bhead->code)) {
 			if (BKE_idcode_is_linkable(bhead->code)) {
 				const char *str = BKE_idcode_to_name(bhead->code);
 
@@ -367,6 +470,11 @@ BlendFileData *BLO_read_from_memfile(
 		fd->skip_flags = skip_flags;
 		BLI_strncpy(fd->relabase, filename, sizeof(fd->relabase));
 
+		/* find data-blocks which didn't change since this step, they are reused instead of read */
+		memfile->read_ids_len = 0;
+		memfile->read_ids_reused = 0;
+		blo_make_undo_id_maps(fd, oldmain);
+
 		/* clear ob->proxy_from pointers in old main */
 		blo_clear_proxy_pointers_from_lib(oldmain);
 
@@ -105,13 +105,19 @@
 
 #include "BLI_endian_switch.h"
 #include "BLI_blenlib.h"
+#include "BLI_gzip_frames.h"
 #include "BLI_math.h"
+#include "BLI_mmap.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 #include "BLI_mempool.h"
 #include "BLI_ghash.h"
+#include "BLI_linklist.h"
 
 #include "BLT_translation.h"
 
+#include "PIL_time.h"
+
 #include "BKE_action.h"
 #include "BKE_armature.h"
 #include "BKE_brush.h"
@@ -226,8 +232,10 @@
  * Delay reading blocks we might not use (especially applies to library linking).
  * which keeps large arrays in memory from data-blocks we may not even use.
  *
- * \note This is disabled when using compression,
+ * \note This is disabled for regular gzip compressed files,
  * while zlib supports seek ist's unusably slow, see: T61880.
+ * Files written by Blender are split into independently compressed frames
+ * (see BLI_gzip_frames.h), these support seeking by decompressing only the frame needed.
  */
 #define USE_BHEAD_READ_ON_DEMAND
 
@@ -614,7 +622,8 @@ static void read_file_bhead_idname_map_create(FileData *fd)
 	for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
 		if (code_prev != bhead->code) {
 			code_prev = bhead->code;
-			is_link = BKE_idcode_is_valid(code_prev) ? BKE_idcode_is_linkable(code_prev) : false;
+			is_link = (BHEAD_CODE_IS_ID(code_prev) && BKE_idcode_is_valid(code_prev)) ?
+			          BKE_idcode_is_linkable(code_prev) : false;
 		}
 
 		if (is_link) {
@@ -629,7 +638,8 @@ static void read_file_bhead_idname_map_create(FileData *fd)
 	for (bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
 		if (code_prev != bhead->code) {
 			code_prev = bhead->code;
-			is_link = BKE_idcode_is_valid(code_prev) ? BKE_idcode_is_linkable(code_prev) : false;
+			is_link = (BHEAD_CODE_IS_ID(code_prev) && BKE_idcode_is_valid(code_prev)) ?
+			          BKE_idcode_is_linkable(code_prev) : false;
 		}
 
 		if (is_link) {
@@ -881,6 +891,10 @@ static BHeadN *get_bhead(FileData *fd)
 	 */
 	if (new_bhead) {
 		BLI_addtail(&fd->bhead_list, new_bhead);
+		/* Nothing after ENDB is a block. */
+		if (new_bhead->bhead.code == ENDB) {
+			fd->is_eof = true;
+		}
 	}
 
 	return new_bhead;
@@ -940,18 +954,24 @@ BHead *blo_bhead_next(FileData *fd, BHead *thisblock)
 	return bhead;
 }
 
-#ifdef USE_BHEAD_READ_ON_DEMAND
-static bool blo_bhead_read_data(FileData *fd, BHead *thisblock, void *buf)
+/**
+ * Read \a len bytes at \a offset of the file, without changing the read position.
+ * Only for files that support seeking.
+ */
+bool blo_filedata_read_at(FileData *fd, off64_t offset, void *buf, int len)
 {
 	bool success = true;
-	BHeadN *new_bhead = BHEADN_FROM_BHEAD(thisblock);
-	BLI_assert(new_bhead->has_data == false && new_bhead->file_offset != 0);
+	BLI_assert(fd->seek != NULL);
+	if (fd->mmap_file != NULL) {
+		/* No need to move the read position. */
+		return BLI_mmap_read(fd->mmap_file, buf, (size_t)offset, (size_t)len);
+	}
 	off64_t offset_backup = fd->file_offset;
-	if (UNLIKELY(fd->seek(fd, new_bhead->file_offset, SEEK_SET) == -1)) {
+	if (UNLIKELY(fd->seek(fd, offset, SEEK_SET) == -1)) {
 		success = false;
 	}
 	else {
-		if (fd->read(fd, buf, new_bhead->bhead.len) != new_bhead->bhead.len) {
+		if (fd->read(fd, buf, (uint)len) != len) {
 			success = false;
 		}
 	}
@@ -961,6 +981,14 @@ static bool blo_bhead_read_data(FileData *fd, BHead *thisblock, void *buf)
 	return success;
 }
 
+#ifdef USE_BHEAD_READ_ON_DEMAND
+static bool blo_bhead_read_data(FileData *fd, BHead *thisblock, void *buf)
+{
+	BHeadN *new_bhead = BHEADN_FROM_BHEAD(thisblock);
+	BLI_assert(new_bhead->has_data == false && new_bhead->file_offset != 0);
+	return blo_filedata_read_at(fd, new_bhead->file_offset, buf, new_bhead->bhead.len);
+}
+
 static BHead *blo_bhead_read_full(FileData *fd, BHead *thisblock)
 {
 	BHeadN *new_bhead = BHEADN_FROM_BHEAD(thisblock);
@@ -1056,6 +1084,7 @@ static bool read_file_dna(FileData *fd, const char **r_error_message)
 			if (fd->filesdna) {
 				blo_do_versions_dna(fd->filesdna, fd->fileversion, subversion);
 				fd->compflags = DNA_struct_get_compareflags(fd->filesdna, fd->memsdna);
+				fd->reconstruct_info = DNA_reconstruct_info_create(fd->filesdna, fd->memsdna, fd->compflags);
 				/* used to retrieve ID names from (bhead+1) */
 				fd->id_name_offs = DNA_elem_offset(fd->filesdna, "ID", "char", "name[]");
 
@@ -1074,6 +1103,84 @@ static bool read_file_dna(FileData *fd, const char **r_error_message)
 	return false;
 }
 
+/**
+ * Read the data-block index from the last block before #ENDB, see #BlendIndexEntry.
+ *
+ * \return Success, false when the file has no index or it can't be used.
+ */
+static bool read_file_index(FileData *fd)
+{
+	if ((fd->seek == NULL) || (fd->flags & (FD_FLAGS_SWITCH_ENDIAN | FD_FLAGS_POINTSIZE_DIFFERS))) {
+		return false;
+	}
+
+	const off64_t offset_backup = fd->file_offset;
+	const off64_t file_len = fd->seek(fd, 0, SEEK_END);
+	/* The file ends with the index block data and ENDB, written by the same Blender as the index. */
+	const off64_t endb_offset = file_len - (off64_t)sizeof(BHead);
+	const off64_t footer_offset = endb_offset - (off64_t)sizeof(BlendIndexFooter);
+	BHead endb, bhead_index;
+	BlendIndexFooter footer;
+	bool success = false;
+
+	if ((footer_offset >= SIZEOFBLENDERHEADER + (off64_t)sizeof(BHead)) &&
+	    blo_filedata_read_at(fd, endb_offset, &endb, sizeof(endb)) &&
+	    (endb.code == ENDB) && (endb.len == 0) &&
+	    blo_filedata_read_at(fd, footer_offset, &footer, sizeof(footer)) &&
+	    (memcmp(footer.magic, BLEND_INDEX_MAGIC, sizeof(footer.magic)) == 0) &&
+	    (footer.entry_size == sizeof(BlendIndexEntry)) &&
+	    (footer.entries_len >= 0) &&
+	    (footer.offset >= SIZEOFBLENDERHEADER + (off64_t)sizeof(BHead)) &&
+	    (footer.offset + (off64_t)footer.entries_len * footer.entry_size == footer_offset) &&
+	    blo_filedata_read_at(fd, footer.offset - (off64_t)sizeof(BHead), &bhead_index, sizeof(bhead_index)) &&
+	    (bhead_index.code == TEST) &&
+	    (bhead_index.len == (int)(footer_offset + (off64_t)sizeof(footer) - footer.offset)))
+	{
+		/* Data-blocks and previews are before the index block. */
+		const off64_t blocks_end = footer.offset - (off64_t)sizeof(BHead);
+
+		BlendIndexEntry *entries = MEM_malloc_arrayN(
+		        (size_t)max_ii(footer.entries_len, 1), sizeof(*entries), __func__);
+
+		if (blo_filedata_read_at(fd, footer.offset, entries, footer.entries_len * footer.entry_size)) {
+			success = true;
+			for (int i = 0; i < footer.entries_len; i++) {
+				BlendIndexEntry *entry = &entries[i];
+				if (entry->offset < SIZEOFBLENDERHEADER || entry->offset >= blocks_end) {
+					success = false;
+					break;
+				}
+				entry->name[sizeof(entry->name) - 1] = '\0';
+
+				/* Previews must be in the file, don't read them otherwise. */
+				for (int j = 0; j < 2; j++) {
+					const uint64_t rect_len = (uint64_t)entry->preview_w[j] * entry->preview_h[j] * sizeof(uint);
+					if ((entry->preview_rect_offset[j] < SIZEOFBLENDERHEADER) ||
+					    (rect_len == 0) || (rect_len > INT_MAX) ||
+					    ((uint64_t)entry->preview_rect_offset[j] + rect_len > (uint64_t)blocks_end))
+					{
+						entry->preview_rect_offset[j] = 0;
+					}
+				}
+			}
+		}
+
+		if (success) {
+			fd->index_entries = entries;
+			fd->index_entries_len = footer.entries_len;
+		}
+		else {
+			MEM_freeN(entries);
+		}
+	}
+
+	if (fd->seek(fd, offset_backup, SEEK_SET) == -1) {
+		success = false;
+	}
+
+	return success;
+}
+
 static int *read_file_thumbnail(FileData *fd)
 {
 	BHead *bhead;
@@ -1142,6 +1249,63 @@ static off64_t fd_seek_data_from_file(FileData *filedata, off64_t offset, int wh
 	return filedata->file_offset;
 }
 
+/* Memory mapped file reading, avoids a system call for every block. */
+
+static int fd_read_from_mmap(FileData *filedata, void *buffer, uint size)
+{
+	/* Don't read beyond the end of the file. */
+	const size_t length = BLI_mmap_get_length(filedata->mmap_file);
+	const size_t offset = (size_t)filedata->file_offset;
+	const size_t readsize = (offset < length) ? MIN2(size, length - offset) : 0;
+
+	if (!BLI_mmap_read(filedata->mmap_file, buffer, offset, readsize)) {
+		return 0;
+	}
+	filedata->file_offset += readsize;
+
+	return (int)readsize;
+}
+
+static off64_t fd_seek_from_mmap(FileData *filedata, off64_t offset, int whence)
+{
+	const off64_t length = (off64_t)BLI_mmap_get_length(filedata->mmap_file);
+	switch (whence) {
+		case SEEK_CUR:
+			offset += filedata->file_offset;
+			break;
+		case SEEK_END:
+			offset += length;
+			break;
+	}
+	if (offset < 0 || offset > length) {
+		return -1;
+	}
+	filedata->file_offset = offset;
+	return filedata->file_offset;
+}
+
+/* GZip file reading, seekable frames (see BLI_gzip_frames.h). */
+
+static int fd_read_gzip_frames_from_file(FileData *filedata, void *buffer, uint size)
+{
+	int readsize = (int)BLI_gzframes_reader_read(filedata->gzframes, buffer, size);
+
+	if (readsize < 0) {
+		readsize = EOF;
+	}
+	else {
+		filedata->file_offset += readsize;
+	}
+
+	return (readsize);
+}
+
+static off64_t fd_seek_gzip_frames_from_file(FileData *filedata, off64_t offset, int whence)
+{
+	filedata->file_offset = BLI_gzframes_reader_seek(filedata->gzframes, offset, whence);
+	return filedata->file_offset;
+}
+
 /* GZip file reading. */
 
 static int fd_read_gzip_from_file(FileData *filedata, void *buffer, uint size)
@@ -1250,10 +1414,8 @@ static FileData *filedata_new(void)
 	return fd;
 }
 
-static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
+static FileData *blo_check_and_read_dna(FileData *fd, ReportList *reports)
 {
-	decode_blender_header(fd);
-
 	if (fd->flags & FD_FLAGS_FILE_OK) {
 		const char *error_message = NULL;
 		if (read_file_dna(fd, &error_message) == false) {
@@ -1273,12 +1435,21 @@ static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
 	return fd;
 }
 
+static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
+{
+	decode_blender_header(fd);
+
+	return blo_check_and_read_dna(fd, reports);
+}
+
 static FileData *blo_filedata_from_file_descriptor(const char *filepath, ReportList *reports, int file)
 {
 	FileDataReadFn *read_fn = NULL;
 	FileDataSeekFn *seek_fn = NULL;  /* Optional. */
 
 	gzFile gzfile = (gzFile)Z_NULL;
+	GzFramesReader *gzframes = NULL;
+	BLI_mmap_file *mmap_file = NULL;
 
 	char header[7];
 
@@ -1295,8 +1466,17 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath, ReportL
 
 	/* Regular file. */
 	if (memcmp(header, "BLENDER", sizeof(header)) == 0) {
-		read_fn = fd_read_data_from_file;
-		seek_fn = fd_seek_data_from_file;
+		/* Blocks are served from the mapping, falls back to regular reads
+		 * when the file can't be mapped (e.g. address space limits). */
+		mmap_file = BLI_mmap_open(file);
+		if (mmap_file != NULL) {
+			read_fn = fd_read_from_mmap;
+			seek_fn = fd_seek_from_mmap;
+		}
+		else {
+			read_fn = fd_read_data_from_file;
+			seek_fn = fd_seek_data_from_file;
+		}
 	}
 
 	/* Gzip file. */
@@ -1304,6 +1484,17 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath, ReportL
 	if ((read_fn == NULL) &&
 	    /* Check header magic. */
 	    (header[0] == 0x1f && header[1] == 0x8b))
+	{
+		gzframes = BLI_gzframes_reader_new(file);
+		if (gzframes != NULL) {
+			read_fn = fd_read_gzip_frames_from_file;
+			seek_fn = fd_seek_gzip_frames_from_file;
+		}
+	}
+
+	/* Gzip file, not written as seekable frames. */
+	if ((read_fn == NULL) &&
+	    (header[0] == 0x1f && header[1] == 0x8b))
 	{
 		gzfile = BLI_gzopen(filepath, "rb");
 		if (gzfile == (gzFile)Z_NULL) {
@@ -1328,6 +1519,8 @@ static FileData *blo_filedata_from_file_descriptor(const char *filepath, ReportL
 
 	fd->filedes = file;
 	fd->gzfiledes = gzfile;
+	fd->gzframes = gzframes;
+	fd->mmap_file = mmap_file;
 
 	fd->read = read_fn;
 	fd->seek = seek_fn;
@@ -1365,6 +1558,29 @@ FileData *blo_filedata_from_file(const char *filepath, ReportList *reports)
 	return NULL;
 }
 
+/**
+ * Same as blo_filedata_from_file(), but only reads the data-block index at the end of the file
+ * (see #BlendIndexEntry), when the file has one. Use it to list the data-blocks of a file and their previews,
+ * without reading all of its blocks.
+ *
+ * Falls back to reading the DNA when there is no index.
+ * When the index is used the DNA isn't read, so the result can't be used for linking.
+ */
+FileData *blo_filedata_from_file_index(const char *filepath, ReportList *reports)
+{
+	FileData *fd = blo_filedata_from_file_open(filepath, reports);
+	if (fd != NULL) {
+		BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
+
+		decode_blender_header(fd);
+		if ((fd->flags & FD_FLAGS_FILE_OK) && read_file_index(fd)) {
+			return fd;
+		}
+		return blo_check_and_read_dna(fd, reports);
+	}
+	return NULL;
+}
+
 /**
  * Same as blo_filedata_from_file(), but does not reads DNA data, only header. Use it for light access
  * (e.g. thumbnail reading).
@@ -1389,17 +1605,23 @@ static int fd_read_gzip_from_memory(FileData *filedata, void *buffer, uint size)
 	filedata->strm.next_out = (Bytef *)buffer;
 	filedata->strm.avail_out = size;
 
-	// Inflate another chunk.
-	err = inflate(&filedata->strm, Z_SYNC_FLUSH);
+	while (filedata->strm.avail_out != 0) {
+		// Inflate another chunk.
+		err = inflate(&filedata->strm, Z_SYNC_FLUSH);
 
-	if (err == Z_STREAM_END) {
-		return 0;
-	}
-	else if (err != Z_OK) {
-		printf("fd_read_gzip_from_memory: zlib error\n");
-		return 0;
+		if (err == Z_STREAM_END) {
+			/* Files may consist of multiple gzip members, see BLI_gzip_frames.h. */
+			if (filedata->strm.avail_in == 0 || inflateReset(&filedata->strm) != Z_OK) {
+				break;
+			}
+		}
+		else if (err != Z_OK) {
+			printf("fd_read_gzip_from_memory: zlib error\n");
+			return 0;
+		}
 	}
 
+	size -= filedata->strm.avail_out;
 	filedata->file_offset += size;
 
 	return (size);
@@ -1472,6 +1694,14 @@ FileData *blo_filedata_from_memfile(MemFile *memfile, ReportList *reports)
 void blo_filedata_free(FileData *fd)
 {
 	if (fd) {
+		if (fd->gzframes != NULL) {
+			BLI_gzframes_reader_free(fd->gzframes);
+		}
+
+		if (fd->mmap_file != NULL) {
+			BLI_mmap_free(fd->mmap_file);
+		}
+
 		if (fd->filedes != -1) {
 			close(fd->filedes);
 		}
@@ -1508,6 +1738,16 @@ void blo_filedata_free(FileData *fd)
 			DNA_sdna_free(fd->filesdna);
 		if (fd->compflags)
 			MEM_freeN((void *)fd->compflags);
+		if (fd->reconstruct_info)
+			DNA_reconstruct_info_free(fd->reconstruct_info);
+		if (fd->undo_old_ids)
+			BLI_gset_free(fd->undo_old_ids, NULL);
+		if (fd->undo_restore_ids)
+			BLI_linklist_free(fd->undo_restore_ids, MEM_freeN);
+		if (fd->undo_reused_ids)
+			BLI_linklist_free(fd->undo_reused_ids, NULL);
+		if (fd->index_entries)
+			MEM_freeN(fd->index_entries);
 
 		if (fd->datamap)
 			oldnewmap_free(fd->datamap);
@@ -2106,6 +2346,27 @@ void blo_add_library_pointer_map(ListBase *old_mainlist, FileData *fd)
 	fd->old_mainlist = old_mainlist;
 }
 
+/**
+ * Lookups of the local data-blocks of the old main, used to reuse them when reading an undo step.
+ * Must be called before splitting the old main.
+ */
+void blo_make_undo_id_maps(FileData *fd, Main *oldmain)
+{
+	ListBase *lbarray[MAX_LIBARRAY];
+
+	fd->undo_unchanged_ids = fd->memfile->read_ids_unchanged;
+	fd->undo_old_ids = BLI_gset_ptr_new(__func__);
+
+	int i = set_listbasepointers(oldmain, lbarray);
+	while (i--) {
+		for (ID *id = lbarray[i]->first; id; id = id->next) {
+			if (id->lib == NULL) {
+				BLI_gset_insert(fd->undo_old_ids, id);
+			}
+		}
+	}
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -2153,16 +2414,20 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 
 		if (fd->compflags[bh->SDNAnr] != SDNA_CMP_REMOVED) {
 			if (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL) {
+				const void *data = (bh + 1);
 #ifdef USE_BHEAD_READ_ON_DEMAND
+				/* Not reconstructed from the memory mapped file directly,
+				 * blocks are only 4 byte aligned in the file and reading can fail. */
 				if (BHEADN_FROM_BHEAD(bh)->has_data == false) {
 					bh = blo_bhead_read_full(fd, bh);
 					if (UNLIKELY(bh == NULL)) {
 						fd->flags &= ~FD_FLAGS_FILE_OK;
 						return NULL;
 					}
+					data = (bh + 1);
 				}
 #endif
-				temp = DNA_struct_reconstruct(fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, (bh + 1));
+				temp = DNA_struct_reconstruct(fd->reconstruct_info, bh->SDNAnr, bh->nr, data);
 			}
 			else {
 				/* SDNA_CMP_EQUAL */
@@ -5040,6 +5305,7 @@ static void direct_link_customdata(FileData *fd, CustomData *data, int count)
 			layer->flag &= ~CD_FLAG_IN_MEMORY;
 
 		layer->flag &= ~CD_FLAG_NOFREE;
+		layer->shared = NULL;
 
 		if (CustomData_verify_versions(data, i)) {
 			layer->data = newdataadr(fd, layer->data);
@@ -8901,6 +9167,129 @@ static const char *dataname(short id_code)
 
 }
 
+/**
+ * Link the direct data of the ID type, after #direct_link_id.
+ *
+ * \return True when the data-block is invalid and must be freed.
+ */
+static bool direct_link_libblock(FileData *fd, Main *main, ID *id)
+{
+	bool wrong_id = false;
+
+	switch (GS(id->name)) {
+		case ID_WM:
+			direct_link_windowmanager(fd, (wmWindowManager *)id);
+			break;
+		case ID_SCR:
+			wrong_id = direct_link_screen(fd, (bScreen *)id);
+			break;
+		case ID_SCE:
+			direct_link_scene(fd, (Scene *)id);
+			break;
+		case ID_OB:
+			direct_link_object(fd, (Object *)id);
+			break;
+		case ID_ME:
+			direct_link_mesh(fd, (Mesh *)id);
+			break;
+		case ID_CU:
+			direct_link_curve(fd, (Curve *)id);
+			break;
+		case ID_MB:
+			direct_link_mball(fd, (MetaBall *)id);
+			break;
+		case ID_MA:
+			direct_link_material(fd, (Material *)id);
+			break;
+		case ID_TE:
+			direct_link_texture(fd, (Tex *)id);
+			break;
+		case ID_IM:
+			direct_link_image(fd, (Image *)id);
+			break;
+		case ID_LA:
+			direct_link_light(fd, (Light *)id);
+			break;
+		case ID_VF:
+			direct_link_vfont(fd, (VFont *)id);
+			break;
+		case ID_TXT:
+			direct_link_text(fd, (Text *)id);
+			break;
+		case ID_IP:
+			direct_link_ipo(fd, (Ipo *)id);
+			break;
+		case ID_KE:
+			direct_link_key(fd, (Key *)id);
+			break;
+		case ID_LT:
+			direct_link_latt(fd, (Lattice *)id);
+			break;
+		case ID_WO:
+			direct_link_world(fd, (World *)id);
+			break;
+		case ID_LI:
+			direct_link_library(fd, (Library *)id, main);
+			break;
+		case ID_CA:
+			direct_link_camera(fd, (Camera *)id);
+			break;
+		case ID_SPK:
+			direct_link_speaker(fd, (Speaker *)id);
+			break;
+		case ID_SO:
+			direct_link_sound(fd, (bSound *)id);
+			break;
+		case ID_LP:
+			direct_link_lightprobe(fd, (LightProbe *)id);
+			break;
+		case ID_GR:
+			direct_link_collection(fd, (Collection *)id);
+			break;
+		case ID_AR:
+			direct_link_armature(fd, (bArmature *)id);
+			break;
+		case ID_AC:
+			direct_link_action(fd, (bAction *)id);
+			break;
+		case ID_NT:
+			direct_link_nodetree(fd, (bNodeTree *)id);
+			break;
+		case ID_BR:
+			direct_link_brush(fd, (Brush *)id);
+			break;
+		case ID_PA:
+			direct_link_particlesettings(fd, (ParticleSettings *)id);
+			break;
+		case ID_GD:
+			direct_link_gpencil(fd, (bGPdata *)id);
+			break;
+		case ID_MC:
+			direct_link_movieclip(fd, (MovieClip *)id);
+			break;
+		case ID_MSK:
+			direct_link_mask(fd, (Mask *)id);
+			break;
+		case ID_LS:
+			direct_link_linestyle(fd, (FreestyleLineStyle *)id);
+			break;
+		case ID_PAL:
+			direct_link_palette(fd, (Palette *)id);
+			break;
+		case ID_PC:
+			direct_link_paint_curve(fd, (PaintCurve *)id);
+			break;
+		case ID_CF:
+			direct_link_cachefile(fd, (CacheFile *)id);
+			break;
+		case ID_WS:
+			direct_link_workspace(fd, (WorkSpace *)id, main);
+			break;
+	}
+
+	return wrong_id;
+}
+
 static BHead *read_data_into_oldnewmap(FileData *fd, BHead *bhead, const char *allocname)
 {
 	bhead = blo_bhead_next(fd, bhead);
@@ -8928,7 +9317,350 @@ static BHead *read_data_into_oldnewmap(FileData *fd, BHead *bhead, const char *a
 	return bhead;
 }
 
-static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const int tag, ID **r_id)
+/* Deferred direct linking:
+ *
+ * Data-blocks don't depend on each other's direct data, so reconstructing the data
+ * and direct linking can run in parallel once all blocks of the file have been read.
+ * Each data-block gets its own #FileData.datamap, which is only accessed by one thread.
+ *
+ * Only used for types that don't touch global state while direct linking,
+ * everything else is linked in order while reading. */
+
+typedef struct ReadDeferredID {
+	ID *id;
+	/* First DATA block of the ID, NULL when there are none. */
+	BHead *bhead_data;
+	int bhead_data_len;
+	int tag;
+	bool failed;
+} ReadDeferredID;
+
+typedef struct ReadDeferredTimings {
+	double reconstruct;
+	double direct_link;
+} ReadDeferredTimings;
+
+static bool read_libblock_can_defer(const FileData *fd, const ID *id)
+{
+	if (fd->deferred_ids_alloc == 0) {
+		return false;
+	}
+	/* Blocks must be readable from multiple threads:
+	 * from the memory mapped file, or already read (no seeking). */
+	if ((fd->mmap_file == NULL) && (fd->seek != NULL)) {
+		return false;
+	}
+	return ELEM(GS(id->name), ID_ME, ID_CU, ID_LT, ID_KE, ID_MB, ID_AC);
+}
+
+/** Skip the DATA blocks of \a id, they are read later by #read_libblocks_defer_end. */
+static BHead *read_libblock_defer(FileData *fd, BHead *bhead, ID *id, const int tag)
+{
+	if (fd->deferred_ids_len == fd->deferred_ids_alloc) {
+		fd->deferred_ids_alloc *= 2;
+		fd->deferred_ids = MEM_reallocN(fd->deferred_ids, sizeof(*fd->deferred_ids) * fd->deferred_ids_alloc);
+	}
+	ReadDeferredID *deferred = &fd->deferred_ids[fd->deferred_ids_len++];
+	deferred->id = id;
+	deferred->bhead_data = NULL;
+	deferred->bhead_data_len = 0;
+	deferred->tag = tag;
+	deferred->failed = false;
+
+	bhead = blo_bhead_next(fd, bhead);
+	if (bhead && bhead->code == DATA) {
+		deferred->bhead_data = bhead;
+	}
+	while (bhead && bhead->code == DATA) {
+		deferred->bhead_data_len++;
+		bhead = blo_bhead_next(fd, bhead);
+	}
+	return bhead;
+}
+
+static void read_libblock_deferred_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict tls)
+{
+	FileData *fd = userdata;
+	ReadDeferredID *deferred = &fd->deferred_ids[i];
+	ReadDeferredTimings *timings = tls->userdata_chunk;
+	ID *id = deferred->id;
+	const double time_start = timings ? PIL_check_seconds_timer() : 0.0;
+
+	/* Shallow copy, so direct linking uses the data-map of this ID. */
+	FileData fd_local = *fd;
+	fd_local.datamap = oldnewmap_new();
+
+	const char *allocname = dataname(GS(id->name));
+	BHead *bhead = deferred->bhead_data;
+	for (int j = 0; j < deferred->bhead_data_len; j++) {
+		void *data = read_struct(&fd_local, bhead, allocname);
+		if (data) {
+			oldnewmap_insert(fd_local.datamap, bhead->old, data, 0);
+		}
+		/* All blocks are in the list already, don't use #blo_bhead_next which may read more. */
+		if (j + 1 < deferred->bhead_data_len) {
+			bhead = &BHEADN_FROM_BHEAD(bhead)->next->bhead;
+		}
+	}
+	const double time_read = timings ? PIL_check_seconds_timer() : 0.0;
+
+	direct_link_id(&fd_local, id);
+	id->tag = deferred->tag | LIB_TAG_NEED_LINK | LIB_TAG_NEW;
+	const bool wrong_id = direct_link_libblock(&fd_local, NULL, id);
+	BLI_assert(wrong_id == false);
+	UNUSED_VARS_NDEBUG(wrong_id);
+
+	oldnewmap_free_unused(fd_local.datamap);
+	oldnewmap_free(fd_local.datamap);
+
+	if ((fd_local.flags & FD_FLAGS_FILE_OK) == 0) {
+		deferred->failed = true;
+	}
+	if (timings) {
+		timings->reconstruct += time_read - time_start;
+		timings->direct_link += PIL_check_seconds_timer() - time_read;
+	}
+}
+
+static void read_libblock_deferred_finalize(
+        void *__restrict userdata,
+        void *__restrict userdata_chunk)
+{
+	FileData *fd = userdata;
+	ReadDeferredTimings *timings = userdata_chunk;
+	fd->timings->deferred_reconstruct += timings->reconstruct;
+	fd->timings->deferred_direct_link += timings->direct_link;
+}
+
+static void read_libblocks_defer_begin(FileData *fd)
+{
+	BLI_assert(fd->deferred_ids == NULL);
+	fd->deferred_ids_alloc = 64;
+	fd->deferred_ids = MEM_malloc_arrayN(fd->deferred_ids_alloc, sizeof(*fd->deferred_ids), __func__);
+	fd->deferred_ids_len = 0;
+}
+
+/** Reconstruct and direct link all data-blocks skipped by #read_libblock_defer. */
+static void read_libblocks_defer_end(FileData *fd)
+{
+	const double time_start = fd->timings ? PIL_check_seconds_timer() : 0.0;
+	ReadDeferredTimings timings = {0.0};
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (fd->deferred_ids_len > 1);
+	/* Sizes of data-blocks vary a lot. */
+	settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+	if (fd->timings) {
+		settings.userdata_chunk = &timings;
+		settings.userdata_chunk_size = sizeof(timings);
+		settings.func_finalize = read_libblock_deferred_finalize;
+	}
+	BLI_task_parallel_range(0, fd->deferred_ids_len, fd, read_libblock_deferred_cb, &settings);
+
+	for (int i = 0; i < fd->deferred_ids_len; i++) {
+		if (fd->deferred_ids[i].failed) {
+			fd->flags &= ~FD_FLAGS_FILE_OK;
+		}
+	}
+
+	if (fd->timings) {
+		fd->timings->deferred_len += fd->deferred_ids_len;
+		fd->timings->deferred += PIL_check_seconds_timer() - time_start;
+	}
+
+	MEM_freeN(fd->deferred_ids);
+	fd->deferred_ids = NULL;
+	fd->deferred_ids_len = fd->deferred_ids_alloc = 0;
+}
+
+/* Undo reusing unchanged data-blocks:
+ *
+ * When reading an undo step, data-blocks which are the same in the current state (found from the
+ * data-blocks written unchanged by the undo steps in between, see #MemFile.read_ids_unchanged)
+ * are moved from the old main instead of being read again, keeping their data and runtime caches.
+ * Only their ID pointers are re-linked afterwards.
+ * Reuse is only done for types which don't reference data of other data-blocks besides ID pointers.
+ *
+ * Since the comparison is done on the written memory, including pointers, data-blocks which are
+ * read again are moved to their previous address, otherwise ID pointers to them would differ
+ * on the next undo step. */
+
+static bool read_libblock_undo_can_reuse(FileData *fd, Main *main, BHead *bhead)
+{
+	if ((fd->undo_unchanged_ids == NULL) ||
+	    (main->curlib != NULL) ||
+	    !BLI_gset_haskey(fd->undo_unchanged_ids, bhead->old) ||
+	    !BLI_gset_haskey(fd->undo_old_ids, bhead->old))
+	{
+		return false;
+	}
+
+	/* The ID is still in the old main, at the same address it's been written from,
+	 * and wasn't edited since the current state was written or read. */
+	ID *id = (ID *)bhead->old;
+	if ((bhead->code != GS(id->name)) || (id->lib != NULL) || (id->override_static != NULL) ||
+	    (id->tag & LIB_TAG_UNDO_CHANGED))
+	{
+		return false;
+	}
+
+	/* Edit-mode data isn't part of the undo step. */
+	switch (GS(id->name)) {
+		case ID_ME:
+			return ((Mesh *)id)->edit_mesh == NULL;
+		case ID_CU:
+			return (((Curve *)id)->editnurb == NULL) && (((Curve *)id)->editfont == NULL);
+		case ID_LT:
+			return ((Lattice *)id)->editlatt == NULL;
+		case ID_MB:
+			return ((MetaBall *)id)->editelems == NULL;
+		case ID_KE:
+		case ID_AC:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static BHead *read_libblock_undo_reuse(FileData *fd, Main *main, BHead *bhead, const int tag, ID **r_id)
+{
+	Main *old_main = fd->old_mainlist->first;
+	ID *id = (ID *)bhead->old;
+	const short idcode = GS(id->name);
+
+	BLI_remlink(which_libbase(old_main, idcode), id);
+	BLI_addtail(which_libbase(main, idcode), id);
+	oldnewmap_insert(fd->libmap, bhead->old, id, bhead->code);
+
+	/* Same as reading, users are counted again when linking. */
+	id->us = ID_FAKE_USERS(id);
+	id->newid = NULL;
+	id->orig_id = NULL;
+	id->recalc = 0;
+	id->tag = tag | LIB_TAG_NEW;
+
+	BLI_linklist_prepend(&fd->undo_reused_ids, id);
+	fd->memfile->read_ids_reused++;
+
+	if (r_id) {
+		*r_id = id;
+	}
+
+	/* Skip the data of the data-block. */
+	bhead = blo_bhead_next(fd, bhead);
+	while (bhead && bhead->code == DATA) {
+		bhead = blo_bhead_next(fd, bhead);
+	}
+	return bhead;
+}
+
+static int read_libblock_undo_relink_cb(void *user_data, ID *UNUSED(id_self), ID **id_pointer, int cb_flag)
+{
+	FileData *fd = user_data;
+
+	if (*id_pointer != NULL) {
+		/* Matches the user counting of the lib_link functions. */
+		if (cb_flag & IDWALK_CB_USER) {
+			*id_pointer = newlibadr_us(fd, NULL, *id_pointer);
+		}
+		else if (cb_flag & IDWALK_CB_USER_ONE) {
+			*id_pointer = newlibadr_real_us(fd, NULL, *id_pointer);
+		}
+		else {
+			*id_pointer = newlibadr(fd, NULL, *id_pointer);
+		}
+	}
+	return IDWALK_RET_NOP;
+}
+
+typedef struct ReadUndoRestoreID {
+	ID *id;
+	ID *id_old;
+} ReadUndoRestoreID;
+
+/**
+ * Data-blocks which are read again keep the address they have in the old main,
+ * so ID pointers to them (from reused data-blocks, and in later undo steps) don't change.
+ */
+static bool read_libblock_undo_can_restore_address(FileData *fd, Main *main, BHead *bhead)
+{
+	if ((fd->undo_old_ids == NULL) ||
+	    (main->curlib != NULL) ||
+	    !BLI_gset_haskey(fd->undo_old_ids, bhead->old))
+	{
+		return false;
+	}
+
+	/* UI data-blocks are handled separately when reading undo steps. */
+	const ID *id_old = bhead->old;
+	return (bhead->code == GS(id_old->name)) && !ELEM(bhead->code, ID_LI, ID_WM, ID_SCR, ID_WS);
+}
+
+static void read_libblock_undo_restore_address_add(FileData *fd, ID *id, const void *id_old)
+{
+	ReadUndoRestoreID *restore = MEM_mallocN(sizeof(*restore), __func__);
+	restore->id = id;
+	restore->id_old = (ID *)id_old;
+	BLI_linklist_prepend(&fd->undo_restore_ids, restore);
+}
+
+/**
+ * Swap the data-blocks read from the undo step with the ones of the old main they replace,
+ * the old data then gets freed with the old main. Must run after direct linking,
+ * but before any pointers to the data-blocks are stored (lib-linking).
+ */
+static void read_libblocks_undo_restore_addresses(FileData *fd, Main *main)
+{
+	Main *old_main = fd->old_mainlist->first;
+	void *id_tmp = NULL;
+	size_t id_tmp_size = 0;
+
+	for (LinkNode *link = fd->undo_restore_ids; link; link = link->next) {
+		ReadUndoRestoreID *restore = link->link;
+		ID *id = restore->id;
+		ID *id_old = restore->id_old;
+		const short idcode = GS(id->name);
+		const size_t size = BKE_libblock_get_alloc_info(idcode, NULL) - sizeof(Link);
+
+		/* Swap list positions, then everything but the list links. */
+		BLI_listbases_swaplinks(which_libbase(main, idcode), which_libbase(old_main, idcode), id, id_old);
+		if (size > id_tmp_size) {
+			MEM_SAFE_FREE(id_tmp);
+			id_tmp = MEM_mallocN(size, __func__);
+			id_tmp_size = size;
+		}
+		memcpy(id_tmp, (char *)id + sizeof(Link), size);
+		memcpy((char *)id + sizeof(Link), (char *)id_old + sizeof(Link), size);
+		memcpy((char *)id_old + sizeof(Link), id_tmp, size);
+
+		/* The file address of the data-block is the address of the old one. */
+		OldNew *entry = oldnewmap_lookup_entry(fd->libmap, id_old);
+		BLI_assert(entry && entry->newp == id);
+		entry->newp = id_old;
+	}
+	MEM_SAFE_FREE(id_tmp);
+	BLI_linklist_free(fd->undo_restore_ids, MEM_freeN);
+	fd->undo_restore_ids = NULL;
+}
+
+/**
+ * Re-link the ID pointers of reused data-blocks,
+ * which point to data-blocks of the old main when they've been read again.
+ */
+static void read_libblocks_undo_reused_relink(FileData *fd, Main *main)
+{
+	for (LinkNode *link = fd->undo_reused_ids; link; link = link->next) {
+		BKE_library_foreach_ID_link(main, link->link, read_libblock_undo_relink_cb, fd, IDWALK_NOP);
+	}
+	BLI_linklist_free(fd->undo_reused_ids, NULL);
+	fd->undo_reused_ids = NULL;
+}
+
+static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, int tag, ID **r_id)
 {
 	/* this routine reads a libblock and its direct data. Use link functions to connect it all
 	 */
@@ -8937,6 +9669,12 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const int ta
 	const char *allocname;
 	bool wrong_id = false;
 
+	/* Data-blocks read from a file (when appending for example) can be at the address of data-blocks
+	 * written in the last undo step, so they must be written again. */
+	if (fd->memfile == NULL) {
+		tag |= LIB_TAG_UNDO_CHANGED;
+	}
+
 	/* In undo case, most libs and linked data should be kept as is from previous state (see BLO_read_from_memfile).
 	 * However, some needed by the snapshot being read may have been removed in previous one, and would go missing.
 	 * This leads e.g. to desappearing objects in some undo/redo case, see T34446.
@@ -8990,6 +9728,17 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const int ta
 		}
 	}
 
+	const void *undo_id_old = NULL;
+	if (fd->memfile) {
+		if (read_libblock_undo_can_reuse(fd, main, bhead)) {
+			return read_libblock_undo_reuse(fd, main, bhead, tag, r_id);
+		}
+		if (read_libblock_undo_can_restore_address(fd, main, bhead)) {
+			undo_id_old = bhead->old;
+		}
+		fd->memfile->read_ids_len++;
+	}
+
 	/* read libblock */
 	id = read_struct(fd, bhead, "lib block");
 
@@ -9032,8 +9781,17 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const int ta
 	/* need a name for the mallocN, just for debugging and sane prints on leaks */
 	allocname = dataname(GS(id->name));
 
+	if (read_libblock_can_defer(fd, id)) {
+		if (undo_id_old) {
+			read_libblock_undo_restore_address_add(fd, id, undo_id_old);
+		}
+		return read_libblock_defer(fd, bhead, id, tag);
+	}
+
 	/* read all data into fd->datamap */
+	const double time_start = fd->timings ? PIL_check_seconds_timer() : 0.0;
 	bhead = read_data_into_oldnewmap(fd, bhead, allocname);
+	const double time_read = fd->timings ? PIL_check_seconds_timer() : 0.0;
 
 	/* init pointers direct data */
 	direct_link_id(fd, id);
@@ -9042,123 +9800,23 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const int ta
 	/* Note: doing this after driect_link_id(), which resets that field. */
 	id->tag = tag | LIB_TAG_NEED_LINK | LIB_TAG_NEW;
 
-	switch (GS(id->name)) {
-		case ID_WM:
-			direct_link_windowmanager(fd, (wmWindowManager *)id);
-			break;
-		case ID_SCR:
-			wrong_id = direct_link_screen(fd, (bScreen *)id);
-			break;
-		case ID_SCE:
-			direct_link_scene(fd, (Scene *)id);
-			break;
-		case ID_OB:
-			direct_link_object(fd, (Object *)id);
-			break;
-		case ID_ME:
-			direct_link_mesh(fd, (Mesh *)id);
-			break;
-		case ID_CU:
-			direct_link_curve(fd, (Curve *)id);
-			break;
-		case ID_MB:
-			direct_link_mball(fd, (MetaBall *)id);
-			break;
-		case ID_MA:
-			direct_link_material(fd, (Material *)id);
-			break;
-		case ID_TE:
-			direct_link_texture(fd, (Tex *)id);
-			break;
-		case ID_IM:
-			direct_link_image(fd, (Image *)id);
-			break;
-		case ID_LA:
-			direct_link_light(fd, (Light *)id);
-			break;
-		case ID_VF:
-			direct_link_vfont(fd, (VFont *)id);
-			break;
-		case ID_TXT:
-			direct_link_text(fd, (Text *)id);
-			break;
-		case ID_IP:
-			direct_link_ipo(fd, (Ipo *)id);
-			break;
-		case ID_KE:
-			direct_link_key(fd, (Key *)id);
-			break;
-		case ID_LT:
-			direct_link_latt(fd, (Lattice *)id);
-			break;
-		case ID_WO:
-			direct_link_world(fd, (World *)id);
-			break;
-		case ID_LI:
-			direct_link_library(fd, (Library *)id, main);
-			break;
-		case ID_CA:
-			direct_link_camera(fd, (Camera *)id);
-			break;
-		case ID_SPK:
-			direct_link_speaker(fd, (Speaker *)id);
-			break;
-		case ID_SO:
-			direct_link_sound(fd, (bSound *)id);
-			break;
-		case ID_LP:
-			direct_link_lightprobe(fd, (LightProbe *)id);
-			break;
-		case ID_GR:
-			direct_link_collection(fd, (Collection *)id);
-			break;
-		case ID_AR:
-			direct_link_armature(fd, (bArmature *)id);
-			break;
-		case ID_AC:
-			direct_link_action(fd, (bAction *)id);
-			break;
-		case ID_NT:
-			direct_link_nodetree(fd, (bNodeTree *)id);
-			break;
-		case ID_BR:
-			direct_link_brush(fd, (Brush *)id);
-			break;
-		case ID_PA:
-			direct_link_particlesettings(fd, (ParticleSettings *)id);
-			break;
-		case ID_GD:
-			direct_link_gpencil(fd, (bGPdata *)id);
-			break;
-		case ID_MC:
-			direct_link_movieclip(fd, (MovieClip *)id);
-			break;
-		case ID_MSK:
-			direct_link_mask(fd, (Mask *)id);
-			break;
-		case ID_LS:
-			direct_link_linestyle(fd, (FreestyleLineStyle *)id);
-			break;
-		case ID_PAL:
-			direct_link_palette(fd, (Palette *)id);
-			break;
-		case ID_PC:
-			direct_link_paint_curve(fd, (PaintCurve *)id);
-			break;
-		case ID_CF:
-			direct_link_cachefile(fd, (CacheFile *)id);
-			break;
-		case ID_WS:
-			direct_link_workspace(fd, (WorkSpace *)id, main);
-			break;
-	}
+	wrong_id = direct_link_libblock(fd, main, id);
 
 	oldnewmap_free_unused(fd->datamap);
 	oldnewmap_clear(fd->datamap);
 
+	if (fd->timings) {
+		fd->timings->read_direct_link += PIL_check_seconds_timer() - time_read;
+		/* Also includes reading the block headers. */
+		fd->timings->read_reconstruct += time_read - time_start;
+	}
+
 	if (wrong_id) {
 		BKE_id_free(main, id);
 	}
+	else if (undo_id_old) {
+		read_libblock_undo_restore_address_add(fd, id, undo_id_old);
+	}
 
 	return (bhead);
 }
@@ -9470,12 +10128,43 @@ static BHead *read_userdef(BlendFileData *bfd, FileData *fd, BHead *bhead)
 /** \name Read File (Internal)
  * \{ */
 
+static void read_timings_print(const FileDataTimings *timings, const char *filepath, double time_total)
+{
+	printf("Read blend: '%s' in %.4fs\n", filepath, time_total);
+	printf("  read:        %.4fs (reconstruct %.4fs, direct link %.4fs)\n",
+	       timings->read, timings->read_reconstruct, timings->read_direct_link);
+	printf("  parallel:    %.4fs (%d data-blocks, reconstruct %.4fs, direct link %.4fs in all threads)\n",
+	       timings->deferred, timings->deferred_len,
+	       timings->deferred_reconstruct, timings->deferred_direct_link);
+	printf("  libraries:   %.4fs\n", timings->libraries);
+	printf("  lib link:    %.4fs\n", timings->lib_link);
+	printf("  versioning:  %.4fs\n", timings->versioning);
+}
+
+/* Add the time since \a *r_time_prev to \a r_time. */
+static void read_timings_step(FileData *fd, double *r_time, double *r_time_prev)
+{
+	if (fd->timings) {
+		const double time = PIL_check_seconds_timer();
+		*r_time += time - *r_time_prev;
+		*r_time_prev = time;
+	}
+}
+
 BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 {
 	BHead *bhead = blo_bhead_first(fd);
 	BlendFileData *bfd;
 	ListBase mainlist = {NULL, NULL};
 
+	/* Undo steps are read too often to print them. */
+	FileDataTimings timings = {0};
+	double time_start = 0.0, time_prev = 0.0;
+	if ((G.debug & G_DEBUG) && (fd->memfile == NULL)) {
+		fd->timings = &timings;
+		time_start = time_prev = PIL_check_seconds_timer();
+	}
+
 	bfd = MEM_callocN(sizeof(BlendFileData), "blendfiledata");
 	bfd->main = BKE_main_new();
 	BLI_addtail(&mainlist, bfd->main);
@@ -9508,6 +10197,8 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 		}
 	}
 
+	read_libblocks_defer_begin(fd);
+
 	while (bhead) {
 		switch (bhead->code) {
 			case DATA:
@@ -9559,17 +10250,36 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 		}
 	}
 
+	read_timings_step(fd, &timings.read, &time_prev);
+
+	read_libblocks_defer_end(fd);
+
+	if (fd->undo_restore_ids) {
+		read_libblocks_undo_restore_addresses(fd, bfd->main);
+	}
+
+	if (fd->timings) {
+		/* Only the time of the parallel pass itself. */
+		time_prev = PIL_check_seconds_timer();
+	}
+
 	/* do before read_libraries, but skip undo case */
 	if (fd->memfile == NULL) {
 		do_versions(fd, NULL, bfd->main);
 		do_versions_userdef(fd, bfd);
 	}
+	read_timings_step(fd, &timings.versioning, &time_prev);
 
 	read_libraries(fd, &mainlist);
+	read_timings_step(fd, &timings.libraries, &time_prev);
 
 	blo_join_main(&mainlist);
 
 	lib_link_all(fd, bfd->main);
+	if (fd->undo_reused_ids) {
+		read_libblocks_undo_reused_relink(fd, bfd->main);
+	}
+	read_timings_step(fd, &timings.lib_link, &time_prev);
 
 	/* Skip in undo case. */
 	if (fd->memfile == NULL) {
@@ -9581,6 +10291,7 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 		}
 		blo_join_main(&mainlist);
 	}
+	read_timings_step(fd, &timings.versioning, &time_prev);
 
 	BKE_main_id_tag_all(bfd->main, LIB_TAG_NEW, false);
 
@@ -9601,6 +10312,11 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 
 	fd->mainlist = NULL;  /* Safety, this is local variable, shall not be used afterward. */
 
+	if (fd->timings) {
+		read_timings_print(&timings, filepath, PIL_check_seconds_timer() - time_start);
+		fd->timings = NULL;
+	}
+
 	return bfd;
 }
 
@@ -11041,7 +11757,8 @@ int BLO_library_link_copypaste(Main *mainl, BlendHandle *bh, const unsigned int
 		if (bhead->code == ENDB)
 			break;
 
-		if (BKE_idcode_is_valid(bhead->code) && BKE_idcode_is_linkable(bhead->code) &&
+		if (BHEAD_CODE_IS_ID(bhead->code) &&
+		    BKE_idcode_is_valid(bhead->code) && BKE_idcode_is_linkable(bhead->code) &&
 		    (id_types_mask == 0 || (BKE_idcode_to_idfilter((short)bhead->code) & id_types_mask) != 0))
 		{
 			read_libblock(fd, mainl, bhead, LIB_TAG_NEED_EXPAND | LIB_TAG_INDIRECT, &id);
@@ -11126,6 +11843,9 @@ static Main *library_link_begin(Main *mainvar, FileData **fd, const char *filepa
 {
 	Main *mainl;
 
+	/* Handles opened from the index don't have the DNA (see #blo_filedata_from_file_index). */
+	BLI_assert((*fd)->filesdna != NULL);
+
 	(*fd)->mainlist = MEM_callocN(sizeof(ListBase), "FileData.mainlist");
 
 	/* clear for objects and collections instantiating tag */
@@ -30,10 +30,16 @@
 #include "DNA_space_types.h"
 #include "DNA_windowmanager_types.h"  /* for ReportType */
 
+struct BLI_mmap_file;
+struct DNA_ReconstructInfo;
+struct GSet;
+struct GzFramesReader;
 struct Key;
+struct LinkNode;
 struct MemFile;
 struct Object;
 struct OldNewMap;
+struct ReadDeferredID;
 struct PartEff;
 struct ReportList;
 struct View3D;
@@ -60,6 +66,63 @@ typedef int64_t off64_t;
 typedef int (FileDataReadFn)(struct FileData *filedata, void *buffer, unsigned int size);
 typedef off64_t (FileDataSeekFn)(struct FileData *filedata, off64_t offset, int whence);
 
+/** Time spent in each phase of reading a file, only measured when running with `--debug`. */
+typedef struct FileDataTimings {
+	/** Reading all blocks, including the data-blocks reconstructed and linked while reading. */
+	double read;
+	double read_reconstruct;
+	double read_direct_link;
+	/** Data-blocks reconstructed and linked in parallel after reading, see #read_libblock_defer. */
+	int deferred_len;
+	double deferred;
+	double deferred_reconstruct;
+	double deferred_direct_link;
+
+	double libraries;
+	double lib_link;
+	double versioning;
+} FileDataTimings;
+
+/**
+ * Index of the data-blocks of a file, written in the last block before #ENDB.
+ * The block uses the #TEST code, which reading the file skips (older versions included).
+ *
+ * Lists the data-blocks and their previews, so files can be browsed without reading all of their blocks
+ * (see #BLO_blendhandle_from_file_index). The index is written with the byte-order of the file,
+ * it's only used when that matches the byte-order and pointer size of the reader.
+ *
+ * Layout of the block data: #BlendIndexFooter.entries_len entries, followed by the #BlendIndexFooter,
+ * so it can be found from the end of the file.
+ */
+typedef struct BlendIndexEntry {
+	/** #BHead.code of the data-block. */
+	int code;
+	int _pad;
+	/** File offset of the data-block #BHead. */
+	int64_t offset;
+	/** The #PreviewImage of the data-block, zero sizes when there is none. */
+	unsigned int preview_w[2], preview_h[2];
+	short preview_flag[2];
+	short _pad1[2];
+	/** File offset of the preview pixels (not their #BHead), zero when not written. */
+	int64_t preview_rect_offset[2];
+	/** #ID.name, including the ID code. */
+	char name[66];
+	char _pad2[6];
+} BlendIndexEntry;
+
+typedef struct BlendIndexFooter {
+	/** File offset of the first #BlendIndexEntry, the data of the index block. */
+	int64_t offset;
+	int entries_len;
+	/** Size of #BlendIndexEntry, so entries can be extended. */
+	int entry_size;
+	/** #BLEND_INDEX_MAGIC. */
+	char magic[8];
+} BlendIndexFooter;
+
+#define BLEND_INDEX_MAGIC "BLENDIDX"
+
 typedef struct FileData {
 	/** Linked list of BHeadN's. */
 	ListBase bhead_list;
@@ -81,6 +144,10 @@ typedef struct FileData {
 
 	/** Variables needed for reading from file. */
 	gzFile gzfiledes;
+	/** Seekable gzip file, uses #FileData.filedes. */
+	struct GzFramesReader *gzframes;
+	/** Memory mapped file, blocks that aren't modified are read from it by reference. */
+	struct BLI_mmap_file *mmap_file;
 	/** Gzip stream for memory decompression. */
 	z_stream strm;
 
@@ -93,6 +160,8 @@ typedef struct FileData {
 	const struct SDNA *memsdna;
 	/** Array of #eSDNA_StructCompare. */
 	const char *compflags;
+	/** How the structs of #filesdna are converted to #memsdna, see #DNA_struct_reconstruct. */
+	struct DNA_ReconstructInfo *reconstruct_info;
 
 	int fileversion;
 	/** Used to retrieve ID names from (bhead+1). */
@@ -121,12 +190,38 @@ typedef struct FileData {
 	ListBase *mainlist;
 	/** Used for undo. */
 	ListBase *old_mainlist;
+	/** Undo: ID's of the old main which can be reused as-is, see #MemFile.read_ids_unchanged. */
+	struct GSet *undo_unchanged_ids;
+	/** Undo: ID's moved from the old main, which still need their ID pointers to be re-linked. */
+	struct LinkNode *undo_reused_ids;
+	/** Undo: local ID's of the old main, their memory is reused for ID's read again. */
+	struct GSet *undo_old_ids;
+	/** Undo: ID's read again, to be moved to the address of their old ID (#ReadUndoRestoreID). */
+	struct LinkNode *undo_restore_ids;
 
 	struct ReportList *reports;
+
+	/** Data-blocks to reconstruct and link after reading, see #read_libblock_defer. */
+	struct ReadDeferredID *deferred_ids;
+	int deferred_ids_len;
+	int deferred_ids_alloc;
+
+	/** Only set when measuring the time of reading. */
+	FileDataTimings *timings;
+
+	/** Read from the last block before #ENDB, see #blo_filedata_from_file_index. */
+	BlendIndexEntry *index_entries;
+	int index_entries_len;
 } FileData;
 
 #define SIZEOFBLENDERHEADER 12
 
+/* Blocks of data-blocks use the two character ID code,
+ * other codes use four characters and must not be passed to the ID code functions
+ * (#TEST would be read as #ID_TE). */
+#define BHEAD_CODE_IS_ID(code) \
+	((code) <= 0xFFFF)
+
 /***/
 struct Main;
 void blo_join_main(ListBase *mainlist);
@@ -135,6 +230,7 @@ void blo_split_main(ListBase *mainlist, struct Main *main);
 BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath);
 
 FileData *blo_filedata_from_file(const char *filepath, struct ReportList *reports);
+FileData *blo_filedata_from_file_index(const char *filepath, struct ReportList *reports);
 FileData *blo_filedata_from_memory(const void *buffer, int buffersize, struct ReportList *reports);
 FileData *blo_filedata_from_memfile(struct MemFile *memfile, struct ReportList *reports);
 
@@ -150,8 +246,10 @@ void blo_end_sound_pointer_map(FileData *fd, struct Main *oldmain);
 void blo_make_packed_pointer_map(FileData *fd, struct Main *oldmain);
 void blo_end_packed_pointer_map(FileData *fd, struct Main *oldmain);
 void blo_add_library_pointer_map(ListBase *old_mainlist, FileData *fd);
+void blo_make_undo_id_maps(FileData *fd, struct Main *oldmain);
 
 void blo_filedata_free(FileData *fd);
+bool blo_filedata_read_at(FileData *fd, off64_t offset, void *buf, int len);
 
 BHead *blo_bhead_first(FileData *fd);
 BHead *blo_bhead_next(FileData *fd, BHead *thisblock);
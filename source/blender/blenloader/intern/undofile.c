@@ -41,6 +41,9 @@
 #include "DNA_listBase.h"
 
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
+#include "BLI_gzip_frames.h"
+#include "BLI_linklist.h"
 
 #include "BLO_undofile.h"
 #include "BLO_readfile.h"
@@ -64,25 +67,46 @@ void BLO_memfile_free(MemFile *memfile)
 		MEM_freeN(chunk);
 	}
 	memfile->size = 0;
+
+	if (memfile->ids_unchanged) {
+		BLI_gset_free(memfile->ids_unchanged, NULL);
+		memfile->ids_unchanged = NULL;
+	}
 }
 
 /* to keep list of memfiles consistent, 'first' is always first in list */
 /* result is that 'first' is being freed */
 void BLO_memfile_merge(MemFile *first, MemFile *second)
 {
-	MemFileChunk *fc, *sc;
+	/* Chunks are compared per ID, so shared chunks aren't necessarily at the same position,
+	 * find the chunks of 'first' owning the data by address. */
+	GHash *buf_owner_map = BLI_ghash_ptr_new(__func__);
+	for (MemFileChunk *fc = first->chunks.first; fc; fc = fc->next) {
+		if (fc->is_identical == false) {
+			BLI_ghash_insert(buf_owner_map, (void *)fc->buf, fc);
+		}
+	}
 
-	fc = first->chunks.first;
-	sc = second->chunks.first;
-	while (fc || sc) {
-		if (fc && sc) {
-			if (sc->is_identical) {
+	for (MemFileChunk *sc = second->chunks.first; sc; sc = sc->next) {
+		if (sc->is_identical) {
+			MemFileChunk *fc = BLI_ghash_popkey(buf_owner_map, sc->buf, NULL);
+			if (fc != NULL) {
 				sc->is_identical = false;
 				fc->is_identical = true;
 			}
 		}
-		if (fc) fc = fc->next;
-		if (sc) sc = sc->next;
+	}
+	BLI_ghash_free(buf_owner_map, NULL, NULL);
+
+	/* 'second' is compared to the memfile 'first' was compared to from now on. */
+	if (second->ids_unchanged) {
+		if (first->ids_unchanged) {
+			BLO_memfile_ids_unchanged_filter(second->ids_unchanged, first);
+		}
+		else {
+			BLI_gset_free(second->ids_unchanged, NULL);
+			second->ids_unchanged = NULL;
+		}
 	}
 
 	BLO_memfile_free(first);
@@ -90,18 +114,21 @@ void BLO_memfile_merge(MemFile *first, MemFile *second)
 
 void memfile_chunk_add(
         MemFile *memfile, const char *buf, uint size,
-        MemFileChunk **compchunk_step)
+        MemFileChunk **compchunk_step, const void *id_key)
 {
 	MemFileChunk *curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
 	curchunk->size = size;
 	curchunk->buf = NULL;
 	curchunk->is_identical = false;
+	curchunk->id_key = id_key;
 	BLI_addtail(&memfile->chunks, curchunk);
 
 	/* we compare compchunk with buf */
 	if (*compchunk_step != NULL) {
 		MemFileChunk *compchunk = *compchunk_step;
-		if (compchunk->size == curchunk->size) {
+		/* Only share data between chunks of the same ID,
+		 * so identical chunks can be used to detect unchanged ID's. */
+		if ((compchunk->size == curchunk->size) && (compchunk->id_key == curchunk->id_key)) {
 			if (memcmp(compchunk->buf, buf, size) == 0) {
 				curchunk->buf = compchunk->buf;
 				curchunk->is_identical = true;
@@ -119,6 +146,19 @@ void memfile_chunk_add(
 	}
 }
 
+/**
+ * Add a chunk sharing the data of \a compchunk, for data known to be unchanged without writing it again.
+ */
+void memfile_chunk_add_shared(MemFile *memfile, const MemFileChunk *compchunk)
+{
+	MemFileChunk *curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
+	curchunk->size = compchunk->size;
+	curchunk->buf = compchunk->buf;
+	curchunk->is_identical = true;
+	curchunk->id_key = compchunk->id_key;
+	BLI_addtail(&memfile->chunks, curchunk);
+}
+
 struct Main *BLO_memfile_main_get(struct MemFile *memfile, struct Main *oldmain, struct Scene **r_scene)
 {
 	struct Main *bmain_undo = NULL;
@@ -137,15 +177,104 @@ struct Main *BLO_memfile_main_get(struct MemFile *memfile, struct Main *oldmain,
 }
 
 
+/**
+ * Keys of all ID's written in \a memfile.
+ *
+ * Reading an undo step directly after the step the current state was written or read from,
+ * the ID's of the current state which are the same in the step are found by removing the ID's
+ * changed by each step in between (see #BLO_memfile_ids_unchanged_filter).
+ *
+ * \return A set of ID keys, to be freed by the caller.
+ */
+GSet *BLO_memfile_ids_create(const MemFile *memfile)
+{
+	GSet *ids = BLI_gset_ptr_new(__func__);
+	for (const MemFileChunk *chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
+		if (chunk->id_key != NULL) {
+			BLI_gset_add(ids, (void *)chunk->id_key);
+		}
+	}
+	return ids;
+}
+
+/**
+ * Remove the ID's from \a ids which weren't written unchanged in \a memfile.
+ */
+void BLO_memfile_ids_unchanged_filter(GSet *ids, const MemFile *memfile)
+{
+	if (memfile->ids_unchanged == NULL) {
+		BLI_gset_clear(ids, NULL);
+		return;
+	}
+
+	GSetIterator gs_iter;
+	LinkNode *ids_changed = NULL;
+	GSET_ITER (gs_iter, ids) {
+		void *id_key = BLI_gsetIterator_getKey(&gs_iter);
+		if (!BLI_gset_haskey(memfile->ids_unchanged, id_key)) {
+			BLI_linklist_prepend(&ids_changed, id_key);
+		}
+	}
+	for (LinkNode *link = ids_changed; link; link = link->next) {
+		BLI_gset_remove(ids, link->link, NULL);
+	}
+	BLI_linklist_free(ids_changed, NULL);
+}
+
+/**
+ * Copy the data of \a memfile into \a r_snapshot, sharing nothing with it.
+ *
+ * Chunks of undo steps share their data, which is freed with the steps.
+ * The snapshot can be written from another thread while the undo stack changes.
+ */
+void BLO_memfile_snapshot(const MemFile *memfile, MemFile *r_snapshot)
+{
+	size_t size = 0;
+	for (const MemFileChunk *chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
+		size += chunk->size;
+	}
+
+	memset(r_snapshot, 0, sizeof(*r_snapshot));
+	if (size == 0) {
+		return;
+	}
+
+	/* Single allocation, owned by the first chunk. */
+	char *buf = MEM_mallocN(size, __func__);
+	for (const MemFileChunk *chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
+		MemFileChunk *chunk_copy = MEM_mallocN(sizeof(*chunk_copy), "MemFileChunk");
+		memcpy(buf, chunk->buf, chunk->size);
+		chunk_copy->buf = buf;
+		chunk_copy->size = chunk->size;
+		chunk_copy->is_identical = (r_snapshot->chunks.first != NULL);
+		chunk_copy->id_key = chunk->id_key;
+		BLI_addtail(&r_snapshot->chunks, chunk_copy);
+		buf += chunk->size;
+	}
+	r_snapshot->size = size;
+}
+
 /**
  * Saves .blend using undo buffer.
  *
+ * The file is written next to \a filename and renamed when complete,
+ * so an existing file is never left partially written.
+ *
+ * \param use_compress: Write a compressed file.
+ * \param stop: Optional, cancels writing when set (from another thread).
+ * \param progress: Optional, set to the written fraction of the file.
  * \return success.
  */
-bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename)
+bool BLO_memfile_write_file_ex(
+        struct MemFile *memfile, const char *filename, const bool use_compress,
+        const short *stop, float *progress)
 {
 	MemFileChunk *chunk;
+	char tempname[FILE_MAX + 1];
+	GzFramesWriter *gw = NULL;
 	int file, oflags;
+	size_t size_total = 0, size_written = 0;
+	bool ok = true, cancel = false;
 
 	/* note: This is currently used for autosave and 'quit.blend', where _not_ following symlinks is OK,
 	 * however if this is ever executed explicitly by the user, we may want to allow writing to symlinks.
@@ -161,26 +290,65 @@ bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename)
 #    warning "Symbolic links will be followed on undo save, possibly causing CVE-2008-1103"
 #  endif
 #endif
-	file = BLI_open(filename,  oflags, 0666);
+	BLI_snprintf(tempname, sizeof(tempname), "%s@", filename);
+	file = BLI_open(tempname, oflags, 0666);
 
 	if (file == -1) {
 		fprintf(stderr, "Unable to save '%s': %s\n",
-		        filename, errno ? strerror(errno) : "Unknown error opening file");
+		        tempname, errno ? strerror(errno) : "Unknown error opening file");
 		return false;
 	}
 
+	if (use_compress) {
+		gw = BLI_gzframes_writer_new(file, 1);
+	}
+
 	for (chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
-		if ((size_t)write(file, chunk->buf, chunk->size) != chunk->size) {
+		size_total += chunk->size;
+	}
+
+	for (chunk = memfile->chunks.first; chunk && ok; chunk = chunk->next) {
+		if (stop && *stop) {
+			cancel = true;
 			break;
 		}
+		if (gw) {
+			ok = BLI_gzframes_writer_write(gw, chunk->buf, chunk->size);
+		}
+		else {
+			ok = ((size_t)write(file, chunk->buf, chunk->size) == chunk->size);
+		}
+		size_written += chunk->size;
+		if (progress) {
+			*progress = (float)((double)size_written / (double)size_total);
+		}
+	}
+
+	if (gw && !BLI_gzframes_writer_free(gw)) {
+		ok = false;
+	}
+	if (close(file) == -1) {
+		ok = false;
 	}
 
-	close(file);
+	if (!ok || cancel) {
+		if (!cancel) {
+			fprintf(stderr, "Unable to save '%s': %s\n",
+			        tempname, errno ? strerror(errno) : "Unknown error writing file");
+		}
+		BLI_delete(tempname, false, false);
+		return false;
+	}
 
-	if (chunk) {
+	if (BLI_rename(tempname, filename) != 0) {
 		fprintf(stderr, "Unable to save '%s': %s\n",
-		        filename, errno ? strerror(errno) : "Unknown error writing file");
+		        filename, errno ? strerror(errno) : "Unknown error renaming file");
 		return false;
 	}
 	return true;
 }
+
+bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename)
+{
+	return BLO_memfile_write_file_ex(memfile, filename, false, NULL, NULL);
+}
@@ -98,6 +98,7 @@ void BLO_update_defaults_userpref_blend(void)
 	/* Only enable tooltips translation by default, without actually enabling translation itself, for now. */
 	U.transopts = USER_TR_TOOLTIPS;
 	U.memcachelimit = 4096;
+	U.playback_lookahead_memory = 1024;
 
 	/* Auto perspective. */
 	U.uiflag |= USER_AUTOPERSP;
@@ -485,6 +485,10 @@ void BLO_version_defaults_userpref_blend(Main *bmain, UserDef *userdef)
 		userdef->move_threshold = 2;
 	}
 
+	if (!USER_VERSION_ATLEAST(280, 52)) {
+		userdef->playback_lookahead_memory = 1024;
+	}
+
 	/**
 	 * Include next version bump.
 	 */
@@ -148,7 +148,12 @@
 #include "MEM_guardedalloc.h" // MEM_freeN
 #include "BLI_bitmap.h"
 #include "BLI_blenlib.h"
+#include "BLI_ghash.h"
+#include "BLI_gzip_frames.h"
+#include "BLI_math_base.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_action.h"
 #include "BKE_blender_version.h"
@@ -207,6 +212,8 @@
 typedef enum {
 	WW_WRAP_NONE = 1,
 	WW_WRAP_ZLIB,
+	/** Growing memory buffer, used to write data-blocks in parallel (see #write_file_ids_parallel). */
+	WW_WRAP_MEM,
 } eWriteWrapType;
 
 typedef struct WriteWrap WriteWrap;
@@ -222,7 +229,15 @@ struct WriteWrap {
 	/* internal */
 	union {
 		int file_handle;
-		gzFile gz_handle;
+		struct {
+			int file_handle;
+			GzFramesWriter *writer;
+		} gz_frames;
+		struct {
+			char *data;
+			size_t data_len;
+			size_t data_alloc;
+		} mem;
 	} _user_data;
 };
 
@@ -254,18 +269,21 @@ static size_t ww_write_none(WriteWrap *ww, const char *buf, size_t buf_len)
 }
 #undef FILE_HANDLE
 
-/* zlib */
+/* zlib, written as independently compressed frames so reading can seek (see BLI_gzip_frames.h). */
 #define FILE_HANDLE(ww) \
-	(ww)->_user_data.gz_handle
+	(ww)->_user_data.gz_frames.file_handle
+#define FRAMES_WRITER(ww) \
+	(ww)->_user_data.gz_frames.writer
 
 static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
 {
-	gzFile file;
+	int file;
 
-	file = BLI_gzopen(filepath, "wb1");
+	file = BLI_open(filepath, O_BINARY + O_WRONLY + O_CREAT + O_TRUNC, 0666);
 
-	if (file != Z_NULL) {
+	if (file != -1) {
 		FILE_HANDLE(ww) = file;
+		FRAMES_WRITER(ww) = BLI_gzframes_writer_new(file, 1);
 		return true;
 	}
 	else {
@@ -274,13 +292,42 @@ static bool ww_open_zlib(WriteWrap *ww, const char *filepath)
 }
 static bool ww_close_zlib(WriteWrap *ww)
 {
-	return (gzclose(FILE_HANDLE(ww)) == Z_OK);
+	const bool ok = BLI_gzframes_writer_free(FRAMES_WRITER(ww));
+	return (close(FILE_HANDLE(ww)) != -1) && ok;
 }
 static size_t ww_write_zlib(WriteWrap *ww, const char *buf, size_t buf_len)
 {
-	return gzwrite(FILE_HANDLE(ww), buf, buf_len);
+	return BLI_gzframes_writer_write(FRAMES_WRITER(ww), buf, buf_len) ? buf_len : 0;
 }
 #undef FILE_HANDLE
+#undef FRAMES_WRITER
+
+/* memory */
+#define MEM_BUFFER(ww) \
+	(ww)->_user_data.mem
+
+static bool ww_open_mem(WriteWrap *ww, const char *UNUSED(filepath))
+{
+	memset(&MEM_BUFFER(ww), 0, sizeof(MEM_BUFFER(ww)));
+	return true;
+}
+static bool ww_close_mem(WriteWrap *ww)
+{
+	MEM_SAFE_FREE(MEM_BUFFER(ww).data);
+	return true;
+}
+static size_t ww_write_mem(WriteWrap *ww, const char *buf, size_t buf_len)
+{
+	if (MEM_BUFFER(ww).data_len + buf_len > MEM_BUFFER(ww).data_alloc) {
+		MEM_BUFFER(ww).data_alloc = MAX3(
+		        MEM_BUFFER(ww).data_alloc * 2, MEM_BUFFER(ww).data_len + buf_len, (size_t)MYWRITE_MAX_CHUNK);
+		MEM_BUFFER(ww).data = MEM_reallocN(MEM_BUFFER(ww).data, MEM_BUFFER(ww).data_alloc);
+	}
+	memcpy(MEM_BUFFER(ww).data + MEM_BUFFER(ww).data_len, buf, buf_len);
+	MEM_BUFFER(ww).data_len += buf_len;
+	return buf_len;
+}
+#undef MEM_BUFFER
 
 /* --- end compression types --- */
 
@@ -297,6 +344,14 @@ static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
 			r_ww->use_buf = false;
 			break;
 		}
+		case WW_WRAP_MEM:
+		{
+			r_ww->open  = ww_open_mem;
+			r_ww->close = ww_close_mem;
+			r_ww->write = ww_write_mem;
+			r_ww->use_buf = false;
+			break;
+		}
 		default:
 		{
 			r_ww->open  = ww_open_none;
@@ -336,10 +391,27 @@ typedef struct {
 		MemFile      *compare;
 		/** Use to de-duplicate chunks when writing. */
 		MemFileChunk *compare_chunk;
+		/** Maps ID's to their first chunk in #compare. */
+		GHash *compare_id_chunk_map;
+		/** ID currently being written, see #mywrite_id_begin. */
+		const void *id_key;
+		/** All chunks of the ID currently being written are shared with #compare so far. */
+		bool id_is_identical;
 	} mem;
 	/** When true, write to #WriteData.current, could also call 'is_undo'. */
 	bool use_memfile;
 
+	/** Index of the data-blocks, written before #ENDB (not for undo), see #BlendIndexEntry. */
+	struct {
+		/** Number of bytes written, the file offset of the next block. */
+		int64_t offset;
+		BlendIndexEntry *entries;
+		int entries_len;
+		int entries_alloc;
+		/** Entry of the ID being written, for its preview (-1 when none). */
+		int entry_active;
+	} index;
+
 	/**
 	 * Wrap writing, so we can use zlib or
 	 * other compression types later, see: G_FILE_COMPRESS
@@ -375,7 +447,10 @@ static void writedata_do_write(WriteData *wd, const void *mem, int memlen)
 
 	/* memory based save */
 	if (wd->use_memfile) {
-		memfile_chunk_add(wd->mem.current, mem, memlen, &wd->mem.compare_chunk);
+		memfile_chunk_add(wd->mem.current, mem, memlen, &wd->mem.compare_chunk, wd->mem.id_key);
+		if (((MemFileChunk *)wd->mem.current->chunks.last)->is_identical == false) {
+			wd->mem.id_is_identical = false;
+		}
 	}
 	else {
 		if (wd->ww->write(wd->ww, mem, memlen) != memlen) {
@@ -389,6 +464,9 @@ static void writedata_free(WriteData *wd)
 	if (wd->buf) {
 		MEM_freeN(wd->buf);
 	}
+	if (wd->index.entries) {
+		MEM_freeN(wd->index.entries);
+	}
 	MEM_freeN(wd);
 }
 
@@ -429,6 +507,7 @@ static void mywrite(WriteData *wd, const void *adr, int len)
 #ifdef USE_WRITE_DATA_LEN
 	wd->write_len += len;
 #endif
+	wd->index.offset += len;
 
 	if (wd->buf == NULL) {
 		writedata_do_write(wd, adr, len);
@@ -475,11 +554,24 @@ static WriteData *mywrite_begin(WriteWrap *ww, MemFile *compare, MemFile *curren
 {
 	WriteData *wd = writedata_new(ww);
 
+	wd->index.entry_active = -1;
+
 	if (current != NULL) {
 		wd->mem.current = current;
 		wd->mem.compare = compare;
 		wd->mem.compare_chunk = compare ? compare->chunks.first : NULL;
 		wd->use_memfile = true;
+
+		if (compare != NULL) {
+			current->ids_unchanged = BLI_gset_ptr_new(__func__);
+			wd->mem.compare_id_chunk_map = BLI_ghash_ptr_new(__func__);
+			/* Backwards, so the first chunk of each ID is kept. */
+			for (MemFileChunk *chunk = compare->chunks.last; chunk; chunk = chunk->prev) {
+				if (chunk->id_key != NULL) {
+					BLI_ghash_reinsert(wd->mem.compare_id_chunk_map, (void *)chunk->id_key, chunk, NULL, NULL);
+				}
+			}
+		}
 	}
 
 	return wd;
@@ -499,11 +591,167 @@ static bool mywrite_end(WriteData *wd)
 	}
 
 	const bool err = wd->error;
+	if (wd->mem.compare_id_chunk_map) {
+		BLI_ghash_free(wd->mem.compare_id_chunk_map, NULL, NULL);
+	}
 	writedata_free(wd);
 
 	return err;
 }
 
+/**
+ * Start writing the data of an ID.
+ *
+ * For undo, the data of each ID is written in its own chunks,
+ * only compared against the chunks of the same ID in the previous memfile.
+ * So adding or removing ID's doesn't cause the following data to be duplicated,
+ * and ID's written unchanged are known from their chunks (see #MemFile.ids_unchanged).
+ */
+static void mywrite_id_begin(WriteData *wd, const ID *id)
+{
+	if (wd->use_memfile) {
+		mywrite_flush(wd);
+		wd->mem.id_key = id;
+		if (wd->mem.compare_id_chunk_map != NULL) {
+			wd->mem.compare_chunk = BLI_ghash_lookup(wd->mem.compare_id_chunk_map, id);
+		}
+		wd->mem.id_is_identical = (wd->mem.compare_chunk != NULL);
+	}
+}
+
+/**
+ * For undo, take the chunks of an ID from the previous memfile instead of writing it,
+ * when it wasn't changed since (see #LIB_TAG_UNDO_CHANGED).
+ *
+ * Only done for the types of data which is tagged for an update when it's edited,
+ * the same types undo reuses unchanged data-blocks of, see #read_libblock_undo_can_reuse.
+ *
+ * \return true when the chunks have been reused, the ID must not be written then.
+ */
+static bool mywrite_id_reuse(WriteData *wd, const ID *id)
+{
+	if (!wd->use_memfile ||
+	    (wd->mem.compare_chunk == NULL) ||
+	    (id->tag & LIB_TAG_UNDO_CHANGED) ||
+	    !ELEM(GS(id->name), ID_ME, ID_CU, ID_LT, ID_MB, ID_KE, ID_AC))
+	{
+		return false;
+	}
+
+	MemFileChunk *chunk = wd->mem.compare_chunk;
+	for (; chunk && (chunk->id_key == id); chunk = chunk->next) {
+		memfile_chunk_add_shared(wd->mem.current, chunk);
+	}
+	wd->mem.compare_chunk = chunk;
+	return true;
+}
+
+/**
+ * End writing the data of an ID, see #mywrite_id_begin.
+ */
+static void mywrite_id_end(WriteData *wd, const ID *id)
+{
+	if (wd->use_memfile) {
+		mywrite_flush(wd);
+		wd->mem.id_key = NULL;
+
+		/* Unchanged when written in the same number of chunks, all shared with the previous memfile. */
+		if ((wd->mem.current->ids_unchanged != NULL) &&
+		    wd->mem.id_is_identical &&
+		    ((wd->mem.compare_chunk == NULL) || (wd->mem.compare_chunk->id_key != id)))
+		{
+			BLI_gset_add(wd->mem.current->ids_unchanged, (void *)id);
+		}
+	}
+	wd->index.entry_active = -1;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Data-Block Index
+ *
+ * Written in a #TEST block before #ENDB, so files can be browsed without reading all their blocks,
+ * see #blo_filedata_from_file_index.
+ * \{ */
+
+static BlendIndexEntry *mywrite_index_entry_new(WriteData *wd)
+{
+	if (wd->index.entries_len == wd->index.entries_alloc) {
+		wd->index.entries_alloc = MAX2(wd->index.entries_alloc * 2, 256);
+		wd->index.entries = MEM_recallocN(wd->index.entries, sizeof(*wd->index.entries) * wd->index.entries_alloc);
+	}
+	return &wd->index.entries[wd->index.entries_len++];
+}
+
+static void mywrite_index_add(WriteData *wd, int filecode, const ID *id)
+{
+	BLI_STATIC_ASSERT(sizeof(((BlendIndexEntry *)NULL)->name) == MAX_ID_NAME, "Size mismatch: name");
+
+	BlendIndexEntry *entry = mywrite_index_entry_new(wd);
+	entry->code = filecode;
+	/* The ID's #BHead hasn't been written yet. */
+	entry->offset = wd->index.offset;
+	STRNCPY(entry->name, id->name);
+
+	wd->index.entry_active = wd->index.entries_len - 1;
+}
+
+/**
+ * Store the preview of the ID being written in its index entry,
+ * must be called before writing the preview.
+ */
+static void mywrite_index_preview_set(WriteData *wd, const PreviewImage *prv)
+{
+	if (wd->index.entry_active == -1) {
+		return;
+	}
+
+	BlendIndexEntry *entry = &wd->index.entries[wd->index.entry_active];
+	for (int i = 0; i < 2; i++) {
+		entry->preview_w[i] = prv->w[i];
+		entry->preview_h[i] = prv->h[i];
+		entry->preview_flag[i] = prv->flag[i];
+	}
+}
+
+/**
+ * Store the file offset of preview pixels, must be called before writing them.
+ */
+static void mywrite_index_preview_rect_set(WriteData *wd, const int size)
+{
+	if (wd->index.entry_active == -1) {
+		return;
+	}
+
+	BlendIndexEntry *entry = &wd->index.entries[wd->index.entry_active];
+	entry->preview_rect_offset[size] = wd->index.offset + (int64_t)sizeof(BHead);
+}
+
+/**
+ * Uses #TEST like the thumbnail, other block codes are read as data-blocks by older Blender versions.
+ */
+static void mywrite_index(WriteData *wd)
+{
+	const int entries_size = (int)sizeof(BlendIndexEntry) * wd->index.entries_len;
+
+	BHead bh = {0};
+	bh.code = TEST;
+	bh.len = entries_size + (int)sizeof(BlendIndexFooter);
+
+	BlendIndexFooter footer = {0};
+	footer.offset = wd->index.offset + (int64_t)sizeof(bh);
+	footer.entries_len = wd->index.entries_len;
+	footer.entry_size = sizeof(BlendIndexEntry);
+	memcpy(footer.magic, BLEND_INDEX_MAGIC, sizeof(footer.magic));
+
+	mywrite(wd, &bh, sizeof(bh));
+	if (entries_size != 0) {
+		mywrite(wd, wd->index.entries, entries_size);
+	}
+	mywrite(wd, &footer, sizeof(footer));
+}
+
 /** \} */
 
 /* -------------------------------------------------------------------- */
@@ -537,6 +785,10 @@ static void writestruct_at_address_nr(
 		return;
 	}
 
+	if (!wd->use_memfile && (BKE_idcode_is_valid(filecode) || filecode == ID_LINK_PLACEHOLDER)) {
+		mywrite_index_add(wd, filecode, data);
+	}
+
 	mywrite(wd, &bh, sizeof(BHead));
 	mywrite(wd, data, bh.len);
 }
@@ -758,11 +1010,14 @@ static void write_previews(WriteData *wd, const PreviewImage *prv_orig)
 			prv.h[1] = 0;
 			prv.rect[1] = NULL;
 		}
+		mywrite_index_preview_set(wd, &prv);
 		writestruct_at_address(wd, DATA, PreviewImage, 1, prv_orig, &prv);
 		if (prv.rect[0]) {
+			mywrite_index_preview_rect_set(wd, 0);
 			writedata(wd, DATA, prv.w[0] * prv.h[0] * sizeof(uint), prv.rect[0]);
 		}
 		if (prv.rect[1]) {
+			mywrite_index_preview_rect_set(wd, 1);
 			writedata(wd, DATA, prv.w[1] * prv.h[1] * sizeof(uint), prv.rect[1]);
 		}
 	}
@@ -3837,6 +4092,342 @@ static void write_thumb(WriteData *wd, const BlendThumbnail *thumb)
 
 /** \} */
 
+/* -------------------------------------------------------------------- */
+/** \name Data-Block Writing
+ * \{ */
+
+static void write_id(WriteData *wd, ID *id)
+{
+	switch ((ID_Type)GS(id->name)) {
+		case ID_WM:
+			write_windowmanager(wd, (wmWindowManager *)id);
+			break;
+		case ID_WS:
+			write_workspace(wd, (WorkSpace *)id);
+			break;
+		case ID_SCR:
+			write_screen(wd, (bScreen *)id);
+			break;
+		case ID_MC:
+			write_movieclip(wd, (MovieClip *)id);
+			break;
+		case ID_MSK:
+			write_mask(wd, (Mask *)id);
+			break;
+		case ID_SCE:
+			write_scene(wd, (Scene *)id);
+			break;
+		case ID_CU:
+			write_curve(wd, (Curve *)id);
+			break;
+		case ID_MB:
+			write_mball(wd, (MetaBall *)id);
+			break;
+		case ID_IM:
+			write_image(wd, (Image *)id);
+			break;
+		case ID_CA:
+			write_camera(wd, (Camera *)id);
+			break;
+		case ID_LA:
+			write_light(wd, (Light *)id);
+			break;
+		case ID_LT:
+			write_lattice(wd, (Lattice *)id);
+			break;
+		case ID_VF:
+			write_vfont(wd, (VFont *)id);
+			break;
+		case ID_KE:
+			write_key(wd, (Key *)id);
+			break;
+		case ID_WO:
+			write_world(wd, (World *)id);
+			break;
+		case ID_TXT:
+			write_text(wd, (Text *)id);
+			break;
+		case ID_SPK:
+			write_speaker(wd, (Speaker *)id);
+			break;
+		case ID_LP:
+			write_probe(wd, (LightProbe *)id);
+			break;
+		case ID_SO:
+			write_sound(wd, (bSound *)id);
+			break;
+		case ID_GR:
+			write_collection(wd, (Collection *)id);
+			break;
+		case ID_AR:
+			write_armature(wd, (bArmature *)id);
+			break;
+		case ID_AC:
+			write_action(wd, (bAction *)id);
+			break;
+		case ID_OB:
+			write_object(wd, (Object *)id);
+			break;
+		case ID_MA:
+			write_material(wd, (Material *)id);
+			break;
+		case ID_TE:
+			write_texture(wd, (Tex *)id);
+			break;
+		case ID_ME:
+			write_mesh(wd, (Mesh *)id);
+			break;
+		case ID_PA:
+			write_particlesettings(wd, (ParticleSettings *)id);
+			break;
+		case ID_NT:
+			write_nodetree(wd, (bNodeTree *)id);
+			break;
+		case ID_BR:
+			write_brush(wd, (Brush *)id);
+			break;
+		case ID_PAL:
+			write_palette(wd, (Palette *)id);
+			break;
+		case ID_PC:
+			write_paintcurve(wd, (PaintCurve *)id);
+			break;
+		case ID_GD:
+			write_gpencil(wd, (bGPdata *)id);
+			break;
+		case ID_LS:
+			write_linestyle(wd, (FreestyleLineStyle *)id);
+			break;
+		case ID_CF:
+			write_cachefile(wd, (CacheFile *)id);
+			break;
+		case ID_LI:
+			/* Do nothing, handled below - and should never be reached. */
+			BLI_assert(0);
+			break;
+		case ID_IP:
+			/* Do nothing, deprecated. */
+			break;
+		default:
+			/* Should never be reached. */
+			BLI_assert(0);
+			break;
+	}
+}
+
+/**
+ * Write an ID for undo without its runtime data, which isn't read back (see #direct_link_id),
+ * so accessing it from Python or tagging it for an update doesn't make it differ from the previous step.
+ */
+static void write_id_undo(WriteData *wd, ID *id)
+{
+	const int tag = id->tag;
+	const int recalc = id->recalc;
+	void *py_instance = id->py_instance;
+
+	id->tag = 0;
+	id->recalc = 0;
+	id->py_instance = NULL;
+
+	write_id(wd, id);
+
+	id->tag = tag;
+	id->recalc = recalc;
+	id->py_instance = py_instance;
+}
+
+/* Parallel writing:
+ *
+ * When saving files with #G_FILE_SAVE_PARALLEL, data-blocks are serialized in parallel into memory buffers,
+ * while the buffers of the data-blocks before them are written to the file in order.
+ * So the file is the same as when writing sequentially, and serializing overlaps with compression and disk I/O.
+ *
+ * Writing a data-block only modifies its own data (temporarily, for forward compatibility),
+ * other data-blocks are only read, so any type can be written in parallel.
+ * Static overrides are the exception, storing them modifies the data-block and the override storage,
+ * files using them are written sequentially. */
+
+/** Number of consecutive data-blocks serialized by one task, into one buffer. */
+#define WRITE_PARALLEL_TASK_IDS 16
+/** Number of tasks serialized while the data-blocks before them are written to the file. */
+#define WRITE_PARALLEL_BATCH_SIZE 64
+/** Memory buffers are reused by the next batches, unless they're larger than this. */
+#define WRITE_PARALLEL_BUFFER_KEEP_SIZE (1 << 20)
+
+typedef struct WriteIDTaskData {
+	ID **ids;
+	int ids_len;
+	/**
+	 * Memory buffers of the tasks being serialized and written,
+	 * two batches, task `i` uses `i % (WRITE_PARALLEL_BATCH_SIZE * 2)`.
+	 */
+	WriteWrap task_wws[WRITE_PARALLEL_BATCH_SIZE * 2];
+	WriteData *task_wds[WRITE_PARALLEL_BATCH_SIZE * 2];
+} WriteIDTaskData;
+
+static void write_id_task(TaskPool *__restrict pool, void *taskdata, int UNUSED(threadid))
+{
+	WriteIDTaskData *data = BLI_task_pool_userdata(pool);
+	const int task = POINTER_AS_INT(taskdata);
+	const int slot = task % (int)ARRAY_SIZE(data->task_wws);
+
+	WriteData *wd = mywrite_begin(&data->task_wws[slot], NULL, NULL);
+	const int ids_end = min_ii((task + 1) * WRITE_PARALLEL_TASK_IDS, data->ids_len);
+	for (int i = task * WRITE_PARALLEL_TASK_IDS; i < ids_end; i++) {
+		write_id(wd, data->ids[i]);
+		mywrite_id_end(wd, data->ids[i]);
+	}
+	data->task_wds[slot] = wd;
+}
+
+/**
+ * Write the data of the data-blocks written to memory by #write_id_task.
+ */
+static void mywrite_task_buffer(WriteData *wd, WriteWrap *task_ww, WriteData *task_wd)
+{
+	/* File offsets of the index are relative to the start of the buffer. */
+	for (int i = 0; i < task_wd->index.entries_len; i++) {
+		BlendIndexEntry *entry = mywrite_index_entry_new(wd);
+		*entry = task_wd->index.entries[i];
+		entry->offset += wd->index.offset;
+		for (int j = 0; j < 2; j++) {
+			if (entry->preview_rect_offset[j] != 0) {
+				entry->preview_rect_offset[j] += wd->index.offset;
+			}
+		}
+	}
+
+	if (task_wd->error) {
+		wd->error = true;
+	}
+
+	const char *data = task_ww->_user_data.mem.data;
+	size_t data_len = task_ww->_user_data.mem.data_len;
+	if (data_len == 0) {
+		/* Nothing written, e.g. data-blocks without users. */
+	}
+	else if (data_len <= MYWRITE_MAX_CHUNK) {
+		/* Small data-blocks are combined. */
+		mywrite(wd, data, (int)data_len);
+	}
+	else {
+		/* Write large data-blocks directly, instead of copying them into the buffer. */
+		mywrite_flush(wd);
+		while (data_len != 0) {
+			const int len = (int)MIN2(data_len, (size_t)INT_MAX);
+			writedata_do_write(wd, data, len);
+#ifdef USE_WRITE_DATA_LEN
+			wd->write_len += len;
+#endif
+			wd->index.offset += len;
+			data += len;
+			data_len -= (size_t)len;
+		}
+	}
+
+	mywrite_end(task_wd);
+
+	/* Reuse the buffer for the next batches. */
+	if (task_ww->_user_data.mem.data_alloc > WRITE_PARALLEL_BUFFER_KEEP_SIZE) {
+		task_ww->close(task_ww);
+		task_ww->open(task_ww, NULL);
+	}
+	task_ww->_user_data.mem.data_len = 0;
+}
+
+static bool write_file_use_parallel(const WriteData *wd, Main *mainvar, int write_flags)
+{
+	/* Only when requested, the number of threads can also be set to 1 to save sequentially. */
+	if (wd->use_memfile || !(write_flags & G_FILE_SAVE_PARALLEL) || (BLI_system_thread_count() < 2)) {
+		return false;
+	}
+
+	ID *id;
+	FOREACH_MAIN_ID_BEGIN(mainvar, id) {
+		if (id->override_static != NULL) {
+			return false;
+		}
+	}
+	FOREACH_MAIN_ID_END;
+
+	return true;
+}
+
+/**
+ * Same as writing all data-blocks of \a mainvar in order, except libraries, see "Parallel writing" above.
+ */
+static void write_file_ids_parallel(WriteData *wd, Main *mainvar)
+{
+	ListBase *lbarray[MAX_LIBARRAY];
+	int ids_len = 0;
+	int a = set_listbasepointers(mainvar, lbarray);
+	while (a--) {
+		ID *id = lbarray[a]->first;
+		if (id && GS(id->name) == ID_LI) {
+			continue;  /* Libraries are handled separately. */
+		}
+		ids_len += BLI_listbase_count(lbarray[a]);
+	}
+
+	WriteIDTaskData *data = MEM_callocN(sizeof(*data), __func__);
+	data->ids = MEM_malloc_arrayN((size_t)max_ii(ids_len, 1), sizeof(*data->ids), __func__);
+	for (int slot = 0; slot < ARRAY_SIZE(data->task_wws); slot++) {
+		ww_handle_init(WW_WRAP_MEM, &data->task_wws[slot]);
+		data->task_wws[slot].open(&data->task_wws[slot], NULL);
+	}
+
+	a = set_listbasepointers(mainvar, lbarray);
+	while (a--) {
+		ID *id = lbarray[a]->first;
+		if (id && GS(id->name) == ID_LI) {
+			continue;
+		}
+		for (; id; id = id->next) {
+			/* We should never attempt to write non-regular IDs (i.e. all kind of temp/runtime ones). */
+			BLI_assert((id->tag & (LIB_TAG_NO_MAIN | LIB_TAG_NO_USER_REFCOUNT | LIB_TAG_NOT_ALLOCATED)) == 0);
+			data->ids[data->ids_len++] = id;
+		}
+	}
+
+	/* Serialize the next batch while writing the previous one. */
+	const int tasks_len = (ids_len + WRITE_PARALLEL_TASK_IDS - 1) / WRITE_PARALLEL_TASK_IDS;
+	TaskScheduler *scheduler = BLI_task_scheduler_get();
+	TaskPool *pool_prev = NULL;
+	int batch_prev = 0;
+	for (int batch = 0; (batch < tasks_len) || (pool_prev != NULL); batch += WRITE_PARALLEL_BATCH_SIZE) {
+		TaskPool *pool = NULL;
+		if (batch < tasks_len) {
+			pool = BLI_task_pool_create(scheduler, data);
+			const int batch_end = min_ii(batch + WRITE_PARALLEL_BATCH_SIZE, tasks_len);
+			for (int task = batch; task < batch_end; task++) {
+				BLI_task_pool_push(pool, write_id_task, POINTER_FROM_INT(task), false, TASK_PRIORITY_HIGH);
+			}
+		}
+
+		if (pool_prev != NULL) {
+			BLI_task_pool_work_and_wait(pool_prev);
+			BLI_task_pool_free(pool_prev);
+
+			const int batch_prev_end = min_ii(batch_prev + WRITE_PARALLEL_BATCH_SIZE, tasks_len);
+			for (int task = batch_prev; task < batch_prev_end; task++) {
+				const int slot = task % (int)ARRAY_SIZE(data->task_wws);
+				mywrite_task_buffer(wd, &data->task_wws[slot], data->task_wds[slot]);
+			}
+		}
+
+		pool_prev = pool;
+		batch_prev = batch;
+	}
+
+	for (int slot = 0; slot < ARRAY_SIZE(data->task_wws); slot++) {
+		data->task_wws[slot].close(&data->task_wws[slot]);
+	}
+	MEM_freeN(data->ids);
+	MEM_freeN(data);
+}
+
+/** \} */
+
 /* -------------------------------------------------------------------- */
 /** \name File Writing (Private)
  * \{ */
@@ -3880,159 +4471,62 @@ static bool write_file_handle(
 	 * avoid thumbnail detecting changes because of this. */
 	mywrite_flush(wd);
 
-	OverrideStaticStorage *override_storage = wd->use_memfile ? NULL : BKE_override_static_operations_store_initialize();
+	if (write_file_use_parallel(wd, mainvar, write_flags)) {
+		write_file_ids_parallel(wd, mainvar);
+	}
+	else {
+		OverrideStaticStorage *override_storage = wd->use_memfile ? NULL : BKE_override_static_operations_store_initialize();
+
+		/* This outer loop allows to save first datablocks from real mainvar, then the temp ones from override process,
+		 * if needed, without duplicating whole code. */
+		Main *bmain = mainvar;
+		do {
+			ListBase *lbarray[MAX_LIBARRAY];
+			int a = set_listbasepointers(bmain, lbarray);
+			while (a--) {
+				ID *id = lbarray[a]->first;
 
-	/* This outer loop allows to save first datablocks from real mainvar, then the temp ones from override process,
-	 * if needed, without duplicating whole code. */
-	Main *bmain = mainvar;
-	do {
-		ListBase *lbarray[MAX_LIBARRAY];
-		int a = set_listbasepointers(bmain, lbarray);
-		while (a--) {
-			ID *id = lbarray[a]->first;
+				if (id && GS(id->name) == ID_LI) {
+					continue;  /* Libraries are handled separately below. */
+				}
 
-			if (id && GS(id->name) == ID_LI) {
-				continue;  /* Libraries are handled separately below. */
-			}
+				for (; id; id = id->next) {
+					/* We should never attempt to write non-regular IDs (i.e. all kind of temp/runtime ones). */
+					BLI_assert((id->tag & (LIB_TAG_NO_MAIN | LIB_TAG_NO_USER_REFCOUNT | LIB_TAG_NOT_ALLOCATED)) == 0);
 
-			for (; id; id = id->next) {
-				/* We should never attempt to write non-regular IDs (i.e. all kind of temp/runtime ones). */
-				BLI_assert((id->tag & (LIB_TAG_NO_MAIN | LIB_TAG_NO_USER_REFCOUNT | LIB_TAG_NOT_ALLOCATED)) == 0);
+					const bool do_override = !ELEM(override_storage, NULL, bmain) && id->override_static;
 
-				const bool do_override = !ELEM(override_storage, NULL, bmain) && id->override_static;
+					if (do_override) {
+						BKE_override_static_operations_store_start(bmain, override_storage, id);
+					}
 
-				if (do_override) {
-					BKE_override_static_operations_store_start(bmain, override_storage, id);
-				}
+					mywrite_id_begin(wd, id);
 
-				switch ((ID_Type)GS(id->name)) {
-					case ID_WM:
-						write_windowmanager(wd, (wmWindowManager *)id);
-						break;
-					case ID_WS:
-						write_workspace(wd, (WorkSpace *)id);
-						break;
-					case ID_SCR:
-						write_screen(wd, (bScreen *)id);
-						break;
-					case ID_MC:
-						write_movieclip(wd, (MovieClip *)id);
-						break;
-					case ID_MSK:
-						write_mask(wd, (Mask *)id);
-						break;
-					case ID_SCE:
-						write_scene(wd, (Scene *)id);
-						break;
-					case ID_CU:
-						write_curve(wd, (Curve *)id);
-						break;
-					case ID_MB:
-						write_mball(wd, (MetaBall *)id);
-						break;
-					case ID_IM:
-						write_image(wd, (Image *)id);
-						break;
-					case ID_CA:
-						write_camera(wd, (Camera *)id);
-						break;
-					case ID_LA:
-						write_light(wd, (Light *)id);
-						break;
-					case ID_LT:
-						write_lattice(wd, (Lattice *)id);
-						break;
-					case ID_VF:
-						write_vfont(wd, (VFont *)id);
-						break;
-					case ID_KE:
-						write_key(wd, (Key *)id);
-						break;
-					case ID_WO:
-						write_world(wd, (World *)id);
-						break;
-					case ID_TXT:
-						write_text(wd, (Text *)id);
-						break;
-					case ID_SPK:
-						write_speaker(wd, (Speaker *)id);
-						break;
-					case ID_LP:
-						write_probe(wd, (LightProbe *)id);
-						break;
-					case ID_SO:
-						write_sound(wd, (bSound *)id);
-						break;
-					case ID_GR:
-						write_collection(wd, (Collection *)id);
-						break;
-					case ID_AR:
-						write_armature(wd, (bArmature *)id);
-						break;
-					case ID_AC:
-						write_action(wd, (bAction *)id);
-						break;
-					case ID_OB:
-						write_object(wd, (Object *)id);
-						break;
-					case ID_MA:
-						write_material(wd, (Material *)id);
-						break;
-					case ID_TE:
-						write_texture(wd, (Tex *)id);
-						break;
-					case ID_ME:
-						write_mesh(wd, (Mesh *)id);
-						break;
-					case ID_PA:
-						write_particlesettings(wd, (ParticleSettings *)id);
-						break;
-					case ID_NT:
-						write_nodetree(wd, (bNodeTree *)id);
-						break;
-					case ID_BR:
-						write_brush(wd, (Brush *)id);
-						break;
-					case ID_PAL:
-						write_palette(wd, (Palette *)id);
-						break;
-					case ID_PC:
-						write_paintcurve(wd, (PaintCurve *)id);
-						break;
-					case ID_GD:
-						write_gpencil(wd, (bGPdata *)id);
-						break;
-					case ID_LS:
-						write_linestyle(wd, (FreestyleLineStyle *)id);
-						break;
-					case ID_CF:
-						write_cachefile(wd, (CacheFile *)id);
-						break;
-					case ID_LI:
-						/* Do nothing, handled below - and should never be reached. */
-						BLI_assert(0);
-						break;
-					case ID_IP:
-						/* Do nothing, deprecated. */
-						break;
-					default:
-						/* Should never be reached. */
-						BLI_assert(0);
-						break;
-				}
+					if (mywrite_id_reuse(wd, id)) {
+						/* pass */
+					}
+					else if (wd->use_memfile) {
+						write_id_undo(wd, id);
+					}
+					else {
+						write_id(wd, id);
+					}
+
+					mywrite_id_end(wd, id);
 
-				if (do_override) {
-					BKE_override_static_operations_store_end(override_storage, id);
+					if (do_override) {
+						BKE_override_static_operations_store_end(override_storage, id);
+					}
 				}
+
+				mywrite_flush(wd);
 			}
+		} while ((bmain != override_storage) && (bmain = override_storage));
 
-			mywrite_flush(wd);
+		if (override_storage) {
+			BKE_override_static_operations_store_finalize(override_storage);
+			override_storage = NULL;
 		}
-	} while ((bmain != override_storage) && (bmain = override_storage));
-
-	if (override_storage) {
-		BKE_override_static_operations_store_finalize(override_storage);
-		override_storage = NULL;
 	}
 
 	/* Special handling, operating over split Mains... */
@@ -4062,6 +4556,11 @@ static bool write_file_handle(
 	}
 #endif
 
+	/* Not needed for undo, only used to browse files. */
+	if (!wd->use_memfile) {
+		mywrite_index(wd);
+	}
+
 	/* end of file */
 	memset(&bhead, 0, sizeof(BHead));
 	bhead.code = ENDB;
@@ -4194,9 +4693,12 @@ bool BLO_write_file(
 	}
 
 	/* actual file writing */
-	const bool err = write_file_handle(mainvar, &ww, NULL, NULL, write_flags, thumb);
+	bool err = write_file_handle(mainvar, &ww, NULL, NULL, write_flags, thumb);
 
-	ww.close(&ww);
+	/* Compressed files write their remaining frames on close. */
+	if (ww.close(&ww) == false) {
+		err = true;
+	}
 
 	if (UNLIKELY(path_list_backup)) {
 		BKE_bpath_list_restore(mainvar, path_list_flag, path_list_backup);
@@ -207,6 +207,32 @@ BLI_INLINE void BM_iter_parallel(
 	}
 }
 
+/**
+ * Same as #BM_iter_parallel, with per-thread data and finalize callback, see #BLI_task_parallel_mempool_ex.
+ */
+ATTR_NONNULL(1, 5)
+BLI_INLINE void BM_iter_parallel_ex(
+        BMesh *bm, const char itype, TaskParallelMempoolFuncEx func, void *userdata,
+        const ParallelRangeSettings *settings)
+{
+	/* inlining optimizes out this switch when called with the defined type */
+	switch ((BMIterType)itype) {
+		case BM_VERTS_OF_MESH:
+			BLI_task_parallel_mempool_ex(bm->vpool, userdata, func, settings);
+			break;
+		case BM_EDGES_OF_MESH:
+			BLI_task_parallel_mempool_ex(bm->epool, userdata, func, settings);
+			break;
+		case BM_FACES_OF_MESH:
+			BLI_task_parallel_mempool_ex(bm->fpool, userdata, func, settings);
+			break;
+		default:
+			/* should never happen */
+			BLI_assert(0);
+			break;
+	}
+}
+
 #endif  /* __BLI_TASK_H__ */
 
 #endif /* __BMESH_ITERATORS_INLINE_H__ */
@@ -33,6 +33,7 @@
 
 #include "BLI_math.h"
 #include "BLI_listbase.h"
+#include "BLI_task.h"
 
 #include "bmesh.h"
 #include "bmesh_structure.h"
@@ -40,32 +41,46 @@
 /* For '_FLAG_OVERLAP'. */
 #include "bmesh_private.h"
 
-static void recount_totsels(BMesh *bm)
+/* Reduction of the number of selected elements counted by each thread. */
+static void bm_select_count_finalize(void *__restrict userdata, void *__restrict userdata_chunk)
 {
-	const char iter_types[3] = {BM_VERTS_OF_MESH,
-	                            BM_EDGES_OF_MESH,
-	                            BM_FACES_OF_MESH};
-	int *tots[3];
-	int i;
+	*(int *)userdata += *(const int *)userdata_chunk;
+}
 
-	/* recount (tot * sel) variables */
-	bm->totvertsel = bm->totedgesel = bm->totfacesel = 0;
-	tots[0] = &bm->totvertsel;
-	tots[1] = &bm->totedgesel;
-	tots[2] = &bm->totfacesel;
+static void bm_select_count_cb(
+        void *__restrict UNUSED(userdata), MempoolIterData *mp_ele, const ParallelRangeTLS *__restrict tls)
+{
+	if (BM_elem_flag_test((BMElem *)mp_ele, BM_ELEM_SELECT)) {
+		*(int *)tls->userdata_chunk += 1;
+	}
+}
 
-	for (i = 0; i < 3; i++) {
-		BMIter iter;
-		BMElem *ele;
-		int count = 0;
+/**
+ * Run \a func over all elements of \a itype, \a func counts selected elements in its per-thread data.
+ */
+static int bm_mesh_select_count_iter(
+        BMesh *bm, const char itype, const int tot, TaskParallelMempoolFuncEx func)
+{
+	int count = 0, count_chunk = 0;
 
-		BM_ITER_MESH (ele, &iter, bm, iter_types[i]) {
-			if (BM_elem_flag_test(ele, BM_ELEM_SELECT)) {
-				count += 1;
-			}
-		}
-		*tots[i] = count;
-	}
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (tot >= BM_OMP_LIMIT);
+	settings.userdata_chunk = &count_chunk;
+	settings.userdata_chunk_size = sizeof(count_chunk);
+	settings.func_finalize = bm_select_count_finalize;
+
+	BM_iter_parallel_ex(bm, itype, func, &count, &settings);
+
+	return count;
+}
+
+static void recount_totsels(BMesh *bm)
+{
+	/* recount (tot * sel) variables */
+	bm->totvertsel = bm_mesh_select_count_iter(bm, BM_VERTS_OF_MESH, bm->totvert, bm_select_count_cb);
+	bm->totedgesel = bm_mesh_select_count_iter(bm, BM_EDGES_OF_MESH, bm->totedge, bm_select_count_cb);
+	bm->totfacesel = bm_mesh_select_count_iter(bm, BM_FACES_OF_MESH, bm->totface, bm_select_count_cb);
 }
 
 /** \name BMesh helper functions for selection & hide flushing.
@@ -232,6 +247,74 @@ void BM_mesh_select_mode_clean(BMesh *bm)
 	BM_mesh_select_mode_clean_ex(bm, bm->selectmode);
 }
 
+/* Callbacks for #BM_mesh_select_mode_flush_ex,
+ * each one only sets flags of its own element and counts the selected ones. */
+
+static void bm_select_flush_edge_from_verts_cb(
+        void *__restrict UNUSED(userdata), MempoolIterData *mp_e, const ParallelRangeTLS *__restrict tls)
+{
+	BMEdge *e = (BMEdge *)mp_e;
+
+	if (BM_elem_flag_test(e->v1, BM_ELEM_SELECT) &&
+	    BM_elem_flag_test(e->v2, BM_ELEM_SELECT) &&
+	    !BM_elem_flag_test(e, BM_ELEM_HIDDEN))
+	{
+		BM_elem_flag_enable(e, BM_ELEM_SELECT);
+		*(int *)tls->userdata_chunk += 1;
+	}
+	else {
+		BM_elem_flag_disable(e, BM_ELEM_SELECT);
+	}
+}
+
+static void bm_select_flush_face_from_verts_cb(
+        void *__restrict UNUSED(userdata), MempoolIterData *mp_f, const ParallelRangeTLS *__restrict tls)
+{
+	BMFace *f = (BMFace *)mp_f;
+	bool ok = true;
+
+	if (!BM_elem_flag_test(f, BM_ELEM_HIDDEN)) {
+		BMLoop *l_iter, *l_first;
+		l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+		do {
+			if (!BM_elem_flag_test(l_iter->v, BM_ELEM_SELECT)) {
+				ok = false;
+				break;
+			}
+		} while ((l_iter = l_iter->next) != l_first);
+	}
+	else {
+		ok = false;
+	}
+
+	BM_elem_flag_set(f, BM_ELEM_SELECT, ok);
+	*(int *)tls->userdata_chunk += ok;
+}
+
+static void bm_select_flush_face_from_edges_cb(
+        void *__restrict UNUSED(userdata), MempoolIterData *mp_f, const ParallelRangeTLS *__restrict tls)
+{
+	BMFace *f = (BMFace *)mp_f;
+	bool ok = true;
+
+	if (!BM_elem_flag_test(f, BM_ELEM_HIDDEN)) {
+		BMLoop *l_iter, *l_first;
+		l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+		do {
+			if (!BM_elem_flag_test(l_iter->e, BM_ELEM_SELECT)) {
+				ok = false;
+				break;
+			}
+		} while ((l_iter = l_iter->next) != l_first);
+	}
+	else {
+		ok = false;
+	}
+
+	BM_elem_flag_set(f, BM_ELEM_SELECT, ok);
+	*(int *)tls->userdata_chunk += ok;
+}
+
 /**
  * \brief Select Mode Flush
  *
@@ -241,69 +324,28 @@ void BM_mesh_select_mode_clean(BMesh *bm)
  */
 void BM_mesh_select_mode_flush_ex(BMesh *bm, const short selectmode)
 {
-	BMEdge *e;
-	BMLoop *l_iter;
-	BMLoop *l_first;
-	BMFace *f;
-
-	BMIter eiter;
-	BMIter fiter;
+	/* Flushing and counting of selected elements is done in the same (threaded) loops. */
+	bm->totvertsel = bm_mesh_select_count_iter(bm, BM_VERTS_OF_MESH, bm->totvert, bm_select_count_cb);
 
 	if (selectmode & SCE_SELECT_VERTEX) {
 		/* both loops only set edge/face flags and read off verts */
-		BM_ITER_MESH (e, &eiter, bm, BM_EDGES_OF_MESH) {
-			if (BM_elem_flag_test(e->v1, BM_ELEM_SELECT) &&
-			    BM_elem_flag_test(e->v2, BM_ELEM_SELECT) &&
-			    !BM_elem_flag_test(e, BM_ELEM_HIDDEN))
-			{
-				BM_elem_flag_enable(e, BM_ELEM_SELECT);
-			}
-			else {
-				BM_elem_flag_disable(e, BM_ELEM_SELECT);
-			}
-		}
-		BM_ITER_MESH (f, &fiter, bm, BM_FACES_OF_MESH) {
-			bool ok = true;
-			if (!BM_elem_flag_test(f, BM_ELEM_HIDDEN)) {
-				l_iter = l_first = BM_FACE_FIRST_LOOP(f);
-				do {
-					if (!BM_elem_flag_test(l_iter->v, BM_ELEM_SELECT)) {
-						ok = false;
-						break;
-					}
-				} while ((l_iter = l_iter->next) != l_first);
-			}
-			else {
-				ok = false;
-			}
-
-			BM_elem_flag_set(f, BM_ELEM_SELECT, ok);
-		}
+		bm->totedgesel = bm_mesh_select_count_iter(
+		        bm, BM_EDGES_OF_MESH, bm->totedge, bm_select_flush_edge_from_verts_cb);
+		bm->totfacesel = bm_mesh_select_count_iter(
+		        bm, BM_FACES_OF_MESH, bm->totface, bm_select_flush_face_from_verts_cb);
 	}
 	else if (selectmode & SCE_SELECT_EDGE) {
-		BM_ITER_MESH (f, &fiter, bm, BM_FACES_OF_MESH) {
-			bool ok = true;
-			if (!BM_elem_flag_test(f, BM_ELEM_HIDDEN)) {
-				l_iter = l_first = BM_FACE_FIRST_LOOP(f);
-				do {
-					if (!BM_elem_flag_test(l_iter->e, BM_ELEM_SELECT)) {
-						ok = false;
-						break;
-					}
-				} while ((l_iter = l_iter->next) != l_first);
-			}
-			else {
-				ok = false;
-			}
-
-			BM_elem_flag_set(f, BM_ELEM_SELECT, ok);
-		}
+		bm->totedgesel = bm_mesh_select_count_iter(bm, BM_EDGES_OF_MESH, bm->totedge, bm_select_count_cb);
+		bm->totfacesel = bm_mesh_select_count_iter(
+		        bm, BM_FACES_OF_MESH, bm->totface, bm_select_flush_face_from_edges_cb);
+	}
+	else {
+		bm->totedgesel = bm_mesh_select_count_iter(bm, BM_EDGES_OF_MESH, bm->totedge, bm_select_count_cb);
+		bm->totfacesel = bm_mesh_select_count_iter(bm, BM_FACES_OF_MESH, bm->totface, bm_select_count_cb);
 	}
 
 	/* Remove any deselected elements from the BMEditSelection */
 	BM_select_history_validate(bm);
-
-	recount_totsels(bm);
 }
 
 void BM_mesh_select_mode_flush(BMesh *bm)
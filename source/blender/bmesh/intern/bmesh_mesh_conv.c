@@ -614,6 +614,8 @@ void BM_mesh_bm_to_me(
 
 	/* don't free this yet */
 	if (oldverts) {
+		/* The verts are freed below, they must not be shared with evaluated copies. */
+		oldverts = CustomData_duplicate_referenced_layer(&me->vdata, CD_MVERT, me->totvert);
 		CustomData_set_layer(&me->vdata, CD_MVERT, NULL);
 	}
 
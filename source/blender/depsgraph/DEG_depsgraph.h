@@ -46,6 +46,8 @@
 #ifndef __DEG_DEPSGRAPH_H__
 #define __DEG_DEPSGRAPH_H__
 
+#include <stddef.h>
+
 #include "DNA_ID.h"
 
 /* Dependency Graph */
@@ -165,6 +167,28 @@ void DEG_evaluate_on_refresh(Depsgraph *graph);
 
 bool DEG_needs_eval(Depsgraph *graph);
 
+/* Playback Lookahead  --------------------------- */
+
+/* Evaluate following frames on copies of the graph in a background thread,
+ * so DEG_evaluate_on_framechange() can use them instead of evaluating the
+ * frame. Copies are discarded on any change to the data, and new frames are
+ * predicted when the frame does not follow the previous one.
+ * < num_frames: number of frames to evaluate ahead
+ * < memory_limit: approximate limit of memory used by all copies, in bytes
+ */
+void DEG_lookahead_enable(struct Main *bmain,
+                          Depsgraph *graph,
+                          int num_frames,
+                          size_t memory_limit);
+void DEG_lookahead_disable(Depsgraph *graph);
+/* Disable lookahead of all dependency graphs, needed before original data
+ * is freed or replaced without tagging (file load, undo). */
+void DEG_lookahead_disable_all(struct Main *bmain);
+/* Copies are built in the background from original data. Wait until they
+ * are built before original data is changed outside of the evaluation of
+ * copies, by operators, scripts or the evaluation of an active graph. */
+void DEG_lookahead_wait_all(struct Main *bmain);
+
 /* Editors Integration  -------------------------- */
 
 /* Mechanism to allow editors to be informed of depsgraph updates,
@@ -194,6 +218,21 @@ bool DEG_is_active(const struct Depsgraph *depsgraph);
 void DEG_make_active(struct Depsgraph *depsgraph);
 void DEG_make_inactive(struct Depsgraph *depsgraph);
 
+/* Copy evaluated data used by the interface to the original datablocks.
+ *
+ * The function is called with a copy of the data: right away by an active
+ * graph, once the evaluated data is used for the current frame by a graph
+ * evaluating frames ahead, and never by other graphs. Pointers in the data
+ * are to evaluated data, which stays valid until then.
+ *
+ * Simulations, which read their state back from the original data, check
+ * DEG_is_active() instead, frames are not evaluated ahead for them. */
+typedef void (*DEG_SyncToOriginalFn)(struct Depsgraph *depsgraph, void *data);
+void DEG_sync_to_original(struct Depsgraph *depsgraph,
+                          DEG_SyncToOriginalFn func,
+                          const void *data,
+                          size_t data_size);
+
 /* Evaluation Debug ------------------------------ */
 
 bool DEG_debug_is_evaluating(struct Depsgraph *depsgraph);
@@ -63,6 +63,12 @@ void DEG_graph_build_from_view_layer(struct Depsgraph *graph,
 /* Tag relations from the given graph for update. */
 void DEG_graph_tag_relations_update(struct Depsgraph *graph);
 
+/* Tag relations of a single ID in the given graph for update. Only nodes of
+ * this ID and relations around them are rebuilt, unless the whole graph is
+ * tagged for update as well. */
+void DEG_graph_id_tag_relations_update(struct Depsgraph *graph,
+                                       struct ID *id);
+
 /* Create or update relations in the specified graph. */
 void DEG_graph_relations_update(struct Depsgraph *graph,
                                 struct Main *bmain,
@@ -72,6 +78,11 @@ void DEG_graph_relations_update(struct Depsgraph *graph,
 /* Tag all relations in the database for update.*/
 void DEG_relations_tag_update(struct Main *bmain);
 
+/* Tag relations of the given ID for update in all dependency graphs. Use when
+ * the change does not affect other datablocks, such as adding a modifier or
+ * a constraint. */
+void DEG_id_tag_relations_update(struct Main *bmain, struct ID *id);
+
 /* Add Dependencies  ----------------------------- */
 
 /* Handle for components to define their dependencies from callbacks.
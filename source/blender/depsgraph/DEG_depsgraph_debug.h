@@ -65,6 +65,20 @@ void DEG_debug_stats_gnuplot(const struct Depsgraph *graph,
                              const char *label,
                              const char *output_filename);
 
+/* ************************************************ */
+/* Evaluation Timeline */
+
+/* Start recording evaluation of all dependency graphs: which thread evaluated
+ * which operation, when, and how long it waited for a thread. Previously
+ * recorded events are discarded, only the most recent ones are kept. */
+void DEG_debug_trace_begin(void);
+void DEG_debug_trace_end(void);
+
+/* Write recorded events in the Chrome trace event format (JSON). */
+bool DEG_debug_trace_write(const char *filepath);
+/* Write recorded events to the file when Blender exits. */
+void DEG_debug_trace_write_on_exit(const char *filepath);
+
 /* ************************************************ */
 
 /* Compare two dependency graphs. */
@@ -42,6 +42,8 @@ extern "C" {
 #include "intern/depsgraph_tag.h"
 #include "intern/depsgraph_type.h"
 #include "intern/eval/deg_eval_copy_on_write.h"
+#include "intern/eval/deg_eval_critical_path.h"
+#include "intern/eval/deg_eval_plan.h"
 #include "intern/node/deg_node.h"
 #include "intern/node/deg_node_id.h"
 #include "intern/node/deg_node_component.h"
@@ -192,6 +194,11 @@ void deg_graph_build_finalize(Main *bmain, Depsgraph *graph)
 {
 	/* Make sure dependencies of visible ID datablocks are visible. */
 	deg_graph_build_flush_visibility(graph);
+	/* Evaluate long chains of operations first. */
+	deg_eval_critical_path_update_priorities(graph);
+	/* Prepare compact storage used for evaluation. */
+	deg_eval_plan_clear(graph);
+	deg_eval_plan_ensure(graph);
 	/* Re-tag IDs for update if it was tagged before the relations
 	 * update tag. */
 	for (IDNode *id_node : graph->id_nodes) {
@@ -320,42 +320,56 @@ ID *DepsgraphNodeBuilder::ensure_cow_id(ID *id_orig)
 
 /* **** Build functions for entity nodes **** */
 
+DepsgraphNodeBuilder::IDInfo *DepsgraphNodeBuilder::save_id_info(
+        IDNode *id_node)
+{
+	IDInfo *id_info = (IDInfo *)MEM_mallocN(
+	        sizeof(IDInfo), "depsgraph id info");
+	if (deg_copy_on_write_is_expanded(id_node->id_cow) &&
+	    id_node->id_orig != id_node->id_cow)
+	{
+		id_info->id_cow = id_node->id_cow;
+	}
+	else {
+		id_info->id_cow = NULL;
+	}
+	id_info->previously_visible_components_mask =
+	        id_node->visible_components_mask;
+	id_info->previous_eval_flags = id_node->eval_flags;
+	id_info->previous_customdata_masks = id_node->customdata_masks;
+	id_info->linked_state = id_node->linked_state;
+	id_info->is_directly_visible = id_node->is_directly_visible;
+	BLI_ghash_insert(id_info_hash_, id_node->id_orig, id_info);
+	id_node->id_cow = NULL;
+	return id_info;
+}
+
+void DepsgraphNodeBuilder::save_entry_tag(OperationNode *op_node)
+{
+	ComponentNode *comp_node = op_node->owner;
+	IDNode *id_node = comp_node->owner;
+
+	SavedEntryTag entry_tag;
+	entry_tag.id_orig = id_node->id_orig;
+	entry_tag.component_type = comp_node->type;
+	entry_tag.opcode = op_node->opcode;
+	entry_tag.name = op_node->name;
+	entry_tag.name_tag = op_node->name_tag;
+	saved_entry_tags_.push_back(entry_tag);
+}
+
 void DepsgraphNodeBuilder::begin_build()
 {
 	/* Store existing copy-on-write versions of datablock, so we can re-use
 	 * them for new ID nodes. */
 	id_info_hash_ = BLI_ghash_ptr_new("Depsgraph id hash");
 	for (IDNode *id_node : graph_->id_nodes) {
-		IDInfo *id_info = (IDInfo *)MEM_mallocN(
-		        sizeof(IDInfo), "depsgraph id info");
-		if (deg_copy_on_write_is_expanded(id_node->id_cow) &&
-		    id_node->id_orig != id_node->id_cow)
-		{
-			id_info->id_cow = id_node->id_cow;
-		}
-		else {
-			id_info->id_cow = NULL;
-		}
-		id_info->previously_visible_components_mask =
-		        id_node->visible_components_mask;
-		id_info->previous_eval_flags = id_node->eval_flags;
-		id_info->previous_customdata_masks = id_node->customdata_masks;
-		BLI_ghash_insert(id_info_hash_, id_node->id_orig, id_info);
-		id_node->id_cow = NULL;
+		save_id_info(id_node);
 	}
 
 	GSET_FOREACH_BEGIN(OperationNode *, op_node, graph_->entry_tags)
 	{
-		ComponentNode *comp_node = op_node->owner;
-		IDNode *id_node = comp_node->owner;
-
-		SavedEntryTag entry_tag;
-		entry_tag.id_orig = id_node->id_orig;
-		entry_tag.component_type = comp_node->type;
-		entry_tag.opcode = op_node->opcode;
-		entry_tag.name = op_node->name;
-		entry_tag.name_tag = op_node->name_tag;
-		saved_entry_tags_.push_back(entry_tag);
+		save_entry_tag(op_node);
 	};
 	GSET_FOREACH_END();
 
@@ -365,6 +379,37 @@ void DepsgraphNodeBuilder::begin_build()
 	BLI_gset_clear(graph_->entry_tags, NULL);
 }
 
+void DepsgraphNodeBuilder::begin_build_partial(const vector<ID *> &ids)
+{
+	/* Same as above, but only for the IDs which are being rebuilt. */
+	id_info_hash_ = BLI_ghash_ptr_new("Depsgraph id hash");
+	for (ID *id : ids) {
+		save_id_info(find_id_node(id));
+	}
+
+	GSET_FOREACH_BEGIN(OperationNode *, op_node, graph_->entry_tags)
+	{
+		if (BLI_ghash_haskey(id_info_hash_, op_node->owner->owner->id_orig)) {
+			save_entry_tag(op_node);
+		}
+	};
+	GSET_FOREACH_END();
+
+	for (ID *id : ids) {
+		graph_->remove_id_node(find_id_node(id));
+	}
+
+	/* Kept nodes are not visited again, and only changes caused by the
+	 * rebuilt IDs are to be re-evaluated. */
+	for (IDNode *id_node : graph_->id_nodes) {
+		built_map_.tagBuild(id_node->id_orig);
+		id_node->previously_visible_components_mask =
+		        id_node->visible_components_mask;
+		id_node->previous_eval_flags = id_node->eval_flags;
+		id_node->previous_customdata_masks = id_node->customdata_masks;
+	}
+}
+
 void DepsgraphNodeBuilder::end_build()
 {
 	for (const SavedEntryTag& entry_tag : saved_entry_tags_) {
@@ -100,6 +100,13 @@ public:
 	void begin_build();
 	void end_build();
 
+	/* Partial rebuild: nodes of the given IDs are removed from the graph and
+	 * built again, all other ID nodes are kept as they are. */
+	void begin_build_partial(const vector<ID *> &ids);
+	void build_view_layer_partial(Scene *scene,
+	                              ViewLayer *view_layer,
+	                              const vector<ID *> &ids);
+
 	IDNode *add_id_node(ID *id);
 	IDNode *find_id_node(ID *id);
 	TimeSourceNode *add_time_source();
@@ -231,6 +238,9 @@ public:
 		uint32_t previous_eval_flags;
 		/* Mesh CustomData mask from the previous depsgraph. */
 		DEGCustomDataMeshMasks previous_customdata_masks;
+		/* How the ID was pulled into the previous depsgraph. */
+		eDepsNode_LinkedState_Type linked_state;
+		bool is_directly_visible;
 	};
 
 protected:
@@ -246,6 +256,9 @@ protected:
 	};
 	vector<SavedEntryTag> saved_entry_tags_;
 
+	IDInfo *save_id_info(IDNode *id_node);
+	void save_entry_tag(OperationNode *op_node);
+
 	struct BuilderWalkUserData {
 		DepsgraphNodeBuilder *builder;
 		/* Denotes whether object the walk is invoked from is visible. */
@@ -171,4 +171,38 @@ void DepsgraphNodeBuilder::build_view_layer(
 	}
 }
 
+void DepsgraphNodeBuilder::build_view_layer_partial(
+        Scene *scene,
+        ViewLayer *view_layer,
+        const vector<ID *> &ids)
+{
+	/* Setup the same context as build_view_layer() does. */
+	view_layer_index_ = 0;
+	scene_ = scene;
+	view_layer_ = view_layer;
+	for (ID *id : ids) {
+		BLI_assert(GS(id->name) == ID_OB);
+		Object *object = (Object *)id;
+		const IDInfo *id_info = (IDInfo *)BLI_ghash_lookup(id_info_hash_, id);
+		/* Object operations are bound to the index of its base among the
+		 * bases which are pulled into the graph. */
+		int base_index = -1;
+		int index = 0;
+		LISTBASE_FOREACH (Base *, base, &view_layer->object_bases) {
+			if (!need_pull_base_into_graph(base)) {
+				continue;
+			}
+			if (base->object == object) {
+				base_index = index;
+				break;
+			}
+			++index;
+		}
+		build_object(base_index,
+		             object,
+		             id_info->linked_state,
+		             id_info->is_directly_visible);
+	}
+}
+
 }  // namespace DEG
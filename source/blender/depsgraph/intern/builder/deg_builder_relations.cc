@@ -214,6 +214,7 @@ DepsgraphRelationBuilder::DepsgraphRelationBuilder(Main *bmain,
                                                    Depsgraph *graph)
     : DepsgraphBuilder(bmain, graph),
       scene_(NULL),
+      is_partial_build_(false),
       rna_node_query_(graph)
 {
 }
@@ -325,6 +326,9 @@ Relation *DepsgraphRelationBuilder::add_time_relation(
         int flags)
 {
 	if (timesrc && node_to) {
+		if (is_partial_build_) {
+			flags |= RELATION_CHECK_BEFORE_ADD;
+		}
 		return graph_->add_new_relation(
 		        timesrc, node_to, description, flags);
 	}
@@ -345,6 +349,9 @@ Relation *DepsgraphRelationBuilder::add_operation_relation(
         int flags)
 {
 	if (node_from && node_to) {
+		if (is_partial_build_) {
+			flags |= RELATION_CHECK_BEFORE_ADD;
+		}
 		return graph_->add_new_relation(node_from,
 		                                node_to,
 		                                description,
@@ -453,6 +460,15 @@ void DepsgraphRelationBuilder::begin_build()
 {
 }
 
+void DepsgraphRelationBuilder::begin_build_partial(
+        const vector<ID *> &built_ids)
+{
+	for (ID *id : built_ids) {
+		built_map_.tagBuild(id);
+	}
+	is_partial_build_ = true;
+}
+
 void DepsgraphRelationBuilder::build_id(ID *id)
 {
 	if (id == NULL) {
@@ -181,6 +181,14 @@ public:
 
 	void begin_build();
 
+	/* Partial rebuild: relations of the given IDs are already in the graph
+	 * and are not built again. Relations which are built are only added if
+	 * they are not in the graph yet. */
+	void begin_build_partial(const vector<ID *> &built_ids);
+	void build_view_layer_partial(Scene *scene,
+	                              ViewLayer *view_layer,
+	                              const vector<ID *> &ids);
+
 	template <typename KeyFrom, typename KeyTo>
 	Relation *add_relation(const KeyFrom& key_from,
 	                       const KeyTo& key_to,
@@ -365,6 +373,8 @@ private:
 
 	/* State which demotes currently built entities. */
 	Scene *scene_;
+	/* Relations are being added to a graph which already has most of them. */
+	bool is_partial_build_;
 
 	BuilderMap built_map_;
 	RNANodeQuery rna_node_query_;
@@ -135,4 +135,54 @@ void DepsgraphRelationBuilder::build_view_layer(Scene *scene, ViewLayer *view_la
 	}
 }
 
+void DepsgraphRelationBuilder::build_view_layer_partial(
+        Scene *scene,
+        ViewLayer *view_layer,
+        const vector<ID *> &ids)
+{
+	/* Setup currently building context. */
+	scene_ = scene;
+	for (ID *id : ids) {
+		switch (GS(id->name)) {
+			case ID_SCE:
+			{
+				/* Relations between scene and objects are built by the objects
+				 * themselves. Going through the whole view layer again is what
+				 * the partial build is to avoid. Scene's own data might still
+				 * point to the rebuilt IDs, so that is built again. */
+				Scene *id_scene = (Scene *)id;
+				if (id_scene->camera != NULL) {
+					build_object(NULL, id_scene->camera);
+				}
+				if (id_scene->rigidbody_world != NULL) {
+					build_rigidbody(id_scene);
+				}
+				if (id_scene->adt != NULL) {
+					build_animdata(&id_scene->id);
+				}
+				if (id_scene->world != NULL) {
+					build_world(id_scene->world);
+				}
+				if (id_scene->nodetree != NULL) {
+					build_compositor(id_scene);
+				}
+				break;
+			}
+			case ID_OB:
+			{
+				Object *object = (Object *)id;
+				Base *base = BKE_view_layer_base_find(view_layer, object);
+				if (base != NULL && !need_pull_base_into_graph(base)) {
+					base = NULL;
+				}
+				build_object(base, object);
+				break;
+			}
+			default:
+				build_id(id);
+				break;
+		}
+	}
+}
+
 }  // namespace DEG
@@ -46,6 +46,8 @@ extern "C" {
 #include "intern/depsgraph_update.h"
 
 #include "intern/eval/deg_eval_copy_on_write.h"
+#include "intern/eval/deg_eval_lookahead.h"
+#include "intern/eval/deg_eval_plan.h"
 
 #include "intern/node/deg_node.h"
 #include "intern/node/deg_node_component.h"
@@ -71,17 +73,21 @@ Depsgraph::Depsgraph(Scene *scene,
                      eEvaluationMode mode)
   : time_source(NULL),
     need_update(true),
+    execution_plan(NULL),
     scene(scene),
     view_layer(view_layer),
     mode(mode),
     ctime(BKE_scene_frame_get(scene)),
     scene_cow(NULL),
     is_active(false),
-    debug_is_evaluating(false)
+    is_lookahead(false),
+    debug_is_evaluating(false),
+    lookahead(NULL)
 {
 	BLI_spin_init(&lock);
 	id_hash = BLI_ghash_ptr_new("Depsgraph id hash");
 	entry_tags = BLI_gset_ptr_new("Depsgraph entry_tags");
+	relations_update_ids = BLI_gset_ptr_new("Depsgraph relations_update_ids");
 	debug_flags = G.debug;
 	memset(id_type_updated, 0, sizeof(id_type_updated));
 	memset(physics_relations, 0, sizeof(physics_relations));
@@ -89,9 +95,15 @@ Depsgraph::Depsgraph(Scene *scene,
 
 Depsgraph::~Depsgraph()
 {
+	if (lookahead != NULL) {
+		deg_lookahead_free(this);
+	}
+	sync_to_original_clear();
+	deg_eval_plan_clear(this);
 	clear_id_nodes();
 	BLI_ghash_free(id_hash, NULL, NULL);
 	BLI_gset_free(entry_tags, NULL);
+	BLI_gset_free(relations_update_ids, NULL);
 	if (time_source != NULL) {
 		OBJECT_GUARDED_DELETE(time_source, TimeSourceNode);
 	}
@@ -173,6 +185,54 @@ void Depsgraph::clear_id_nodes()
 	clear_physics_relations(this);
 }
 
+static bool node_belongs_to_id(const Node *node, const IDNode *id_node)
+{
+	if (node->type != NodeType::OPERATION) {
+		return false;
+	}
+	const OperationNode *op_node = static_cast<const OperationNode *>(node);
+	return op_node->owner->owner == id_node;
+}
+
+void Depsgraph::remove_id_node(IDNode *id_node)
+{
+	/* Evaluation plan points to the operations which are about to be freed. */
+	deg_eval_plan_clear(this);
+	GHASH_FOREACH_BEGIN(ComponentNode *, comp_node, id_node->components)
+	{
+		BLI_assert(comp_node->operations_map == NULL);
+		for (OperationNode *op_node : comp_node->operations) {
+			/* Relations between operations of this ID are freed along with
+			 * the nodes, the rest needs to be unlinked from the other side. */
+			const Node::Relations outlinks = op_node->outlinks;
+			for (Relation *rel : outlinks) {
+				if (!node_belongs_to_id(rel->to, id_node)) {
+					rel->unlink();
+					OBJECT_GUARDED_DELETE(rel, Relation);
+				}
+			}
+			const Node::Relations inlinks = op_node->inlinks;
+			for (Relation *rel : inlinks) {
+				if (!node_belongs_to_id(rel->from, id_node)) {
+					rel->unlink();
+					OBJECT_GUARDED_DELETE(rel, Relation);
+				}
+			}
+			BLI_gset_remove(entry_tags, op_node, NULL);
+		}
+	}
+	GHASH_FOREACH_END();
+	operations.erase(std::remove_if(operations.begin(),
+	                                operations.end(),
+	                                [id_node](OperationNode *op_node) {
+	                                    return op_node->owner->owner == id_node;
+	                                }),
+	                 operations.end());
+	BLI_ghash_remove(id_hash, id_node->id_orig, NULL, NULL);
+	remove_from_vector(&id_nodes, id_node);
+	OBJECT_GUARDED_DELETE(id_node, IDNode);
+}
+
 /* Add new relation between two nodes */
 Relation *Depsgraph::add_new_relation(Node *from, Node *to,
                                       const char *description,
@@ -279,6 +339,7 @@ void Depsgraph::add_entry_tag(OperationNode *node)
 
 void Depsgraph::clear_all_nodes()
 {
+	deg_eval_plan_clear(this);
 	clear_id_nodes();
 	if (time_source != NULL) {
 		OBJECT_GUARDED_DELETE(time_source, TimeSourceNode);
@@ -286,6 +347,41 @@ void Depsgraph::clear_all_nodes()
 	}
 }
 
+void Depsgraph::swap_nodes(Depsgraph *other)
+{
+	BLI_assert(scene == other->scene);
+	BLI_assert(view_layer == other->view_layer);
+	BLI_assert(mode == other->mode);
+	std::swap(id_hash, other->id_hash);
+	std::swap(id_nodes, other->id_nodes);
+	std::swap(time_source, other->time_source);
+	std::swap(need_update, other->need_update);
+	std::swap(relations_update_ids, other->relations_update_ids);
+	std::swap(id_type_updated, other->id_type_updated);
+	std::swap(entry_tags, other->entry_tags);
+	std::swap(operations, other->operations);
+	std::swap(execution_plan, other->execution_plan);
+	std::swap(ctime, other->ctime);
+	std::swap(scene_cow, other->scene_cow);
+	std::swap(physics_relations, other->physics_relations);
+}
+
+void Depsgraph::sync_to_original_flush(Depsgraph *graph)
+{
+	for (const SyncToOriginal &sync : sync_to_original) {
+		sync.func(reinterpret_cast<::Depsgraph *>(graph), sync.data);
+	}
+	sync_to_original_clear();
+}
+
+void Depsgraph::sync_to_original_clear()
+{
+	for (const SyncToOriginal &sync : sync_to_original) {
+		MEM_freeN(sync.data);
+	}
+	sync_to_original.clear();
+}
+
 ID *Depsgraph::get_cow_id(const ID *id_orig) const
 {
 	IDNode *id_node = find_id_node(id_orig);
@@ -351,6 +447,30 @@ bool DEG_is_active(const struct Depsgraph *depsgraph)
 	return deg_graph->is_active;
 }
 
+void DEG_sync_to_original(struct Depsgraph *depsgraph,
+                          DEG_SyncToOriginalFn func,
+                          const void *data,
+                          size_t data_size)
+{
+	if (depsgraph == NULL) {
+		return;
+	}
+	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(depsgraph);
+	if (deg_graph->is_active) {
+		func(depsgraph, const_cast<void *>(data));
+	}
+	else if (deg_graph->is_lookahead) {
+		/* Called from evaluation threads. */
+		DEG::SyncToOriginal sync;
+		sync.func = func;
+		sync.data = MEM_mallocN(data_size, __func__);
+		memcpy(sync.data, data, data_size);
+		BLI_spin_lock(&deg_graph->lock);
+		deg_graph->sync_to_original.push_back(sync);
+		BLI_spin_unlock(&deg_graph->lock);
+	}
+}
+
 void DEG_make_active(struct Depsgraph *depsgraph)
 {
 	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(depsgraph);
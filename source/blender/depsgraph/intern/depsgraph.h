@@ -52,11 +52,20 @@ struct ViewLayer;
 namespace DEG {
 
 struct ComponentNode;
+struct ExecutionPlan;
 struct IDNode;
+struct Lookahead;
 struct Node;
 struct OperationNode;
 struct TimeSourceNode;
 
+/* Copy of evaluated data to the original datablocks, kept by graphs
+ * evaluating frames ahead, see DEG_sync_to_original(). */
+struct SyncToOriginal {
+	DEG_SyncToOriginalFn func;
+	void *data;
+};
+
 /* *************************** */
 /* Relationships Between Nodes */
 
@@ -113,6 +122,9 @@ struct Depsgraph {
 	IDNode *find_id_node(const ID *id) const;
 	IDNode *add_id_node(ID *id, ID *id_cow_hint = NULL);
 	void clear_id_nodes();
+	/* Remove node of a single ID along with all relations to and from its
+	 * operations, keeping the rest of the graph intact. */
+	void remove_id_node(IDNode *id_node);
 	void clear_id_nodes_conditional(const std::function <bool (ID_Type id_type)>& filter);
 
 	/* Add new relationship between two nodes. */
@@ -134,6 +146,16 @@ struct Depsgraph {
 	/* Clear storage used by all nodes. */
 	void clear_all_nodes();
 
+	/* Exchange nodes and evaluated datablocks with another graph built for
+	 * the same scene and view layer. Pointers to the graphs, activity and
+	 * debug settings are not changed. */
+	void swap_nodes(Depsgraph *other);
+
+	/* Call functions kept by DEG_sync_to_original() on the given graph, which
+	 * uses the evaluated data of this one now. */
+	void sync_to_original_flush(Depsgraph *graph);
+	void sync_to_original_clear();
+
 	/* Copy-on-Write Functionality ........ */
 
 	/* For given original ID get ID which is created by CoW system. */
@@ -156,6 +178,11 @@ struct Depsgraph {
 	/* Indicates whether relations needs to be updated. */
 	bool need_update;
 
+	/* Original IDs which were tagged for relations update on their own. Only
+	 * nodes of those IDs and relations around them are to be rebuilt. Empty
+	 * when the whole graph is to be rebuilt. */
+	GSet *relations_update_ids;
+
 	/* Indicates which ID types were updated. */
 	char id_type_updated[MAX_LIBARRAY];
 
@@ -170,6 +197,10 @@ struct Depsgraph {
 	/* All operation nodes, sorted in order of single-thread traversal order. */
 	OperationNodes operations;
 
+	/* Compact copy of operations and their relations used for evaluation,
+	 * built once relations are updated. */
+	ExecutionPlan *execution_plan;
+
 	/* Spin lock for threading-critical operations.
 	 * Mainly used by graph evaluation. */
 	SpinLock lock;
@@ -195,12 +226,21 @@ struct Depsgraph {
 	 * to read stuff from. */
 	bool is_active;
 
+	/* Graph evaluating a frame ahead of time, keeping copies of evaluated data
+	 * to the original datablocks until its evaluated data is used. */
+	bool is_lookahead;
+	vector<SyncToOriginal> sync_to_original;
+
 	/* NOTE: Corresponds to G_DEBUG_DEPSGRAPH_* flags. */
 	int debug_flags;
 	string debug_name;
 
 	bool debug_is_evaluating;
 
+	/* Copies of this graph evaluated ahead of time during playback, NULL when
+	 * lookahead is disabled. */
+	Lookahead *lookahead;
+
 	/* Cached list of colliders/effectors for collections and the scene
 	 * created along with relations, for fast lookup during evaluation. */
 	GHash *physics_relations[DEG_PHYSICS_RELATIONS_NUM];
@@ -34,9 +34,12 @@
 
 extern "C" {
 #include "DNA_cachefile_types.h"
+#include "DNA_modifier_types.h"
+#include "DNA_object_force_types.h"
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
 
+#include "BKE_library_query.h"
 #include "BKE_main.h"
 #include "BKE_scene.h"
 } /* extern "C" */
@@ -52,12 +55,14 @@ extern "C" {
 #include "builder/deg_builder_transitive.h"
 
 #include "intern/debug/deg_debug.h"
+#include "intern/eval/deg_eval_lookahead.h"
 
 #include "intern/node/deg_node.h"
 #include "intern/node/deg_node_component.h"
 #include "intern/node/deg_node_id.h"
 #include "intern/node/deg_node_operation.h"
 
+#include "intern/depsgraph_physics.h"
 #include "intern/depsgraph_type.h"
 
 /* ****************** */
@@ -287,6 +292,7 @@ void DEG_graph_build_from_view_layer(Depsgraph *graph,
 #endif
 	/* Relations are up to date. */
 	deg_graph->need_update = false;
+	BLI_gset_clear(deg_graph->relations_update_ids, NULL);
 	/* Finish statistics. */
 	if (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) {
 		printf("Depsgraph built in %f seconds.\n",
@@ -294,12 +300,278 @@ void DEG_graph_build_from_view_layer(Depsgraph *graph,
 	}
 }
 
+namespace {
+
+/* Check whether nodes of the ID can be rebuilt on their own. */
+bool deg_graph_partial_build_supports_id(const DEG::IDNode *id_node)
+{
+	if (GS(id_node->id_orig->name) != ID_OB) {
+		return false;
+	}
+	if (id_node->linked_state == DEG::DEG_ID_LINKED_VIA_SET) {
+		return false;
+	}
+	/* Colliders, effectors and rigid bodies are found by other objects via
+	 * collections, so the objects which are to depend on this one can not be
+	 * found from the graph. */
+	Object *object = (Object *)id_node->id_orig;
+	if (object->rigidbody_object != NULL ||
+	    object->rigidbody_constraint != NULL ||
+	    object->particlesystem.first != NULL ||
+	    (object->pd != NULL && object->pd->forcefield != PFIELD_NULL))
+	{
+		return false;
+	}
+	LISTBASE_FOREACH (ModifierData *, md, &object->modifiers) {
+		if (ELEM(md->type,
+		         eModifierType_Collision,
+		         eModifierType_Smoke,
+		         eModifierType_DynamicPaint))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/* Check whether relations of the ID can be rebuilt on their own. */
+bool deg_graph_partial_build_supports_relations(const ID *id)
+{
+	switch (GS(id->name)) {
+		case ID_AC:
+		case ID_AR:
+		case ID_CA:
+		case ID_GR:
+		case ID_OB:
+		case ID_KE:
+		case ID_LA:
+		case ID_LP:
+		case ID_NT:
+		case ID_MA:
+		case ID_TE:
+		case ID_IM:
+		case ID_WO:
+		case ID_MSK:
+		case ID_MC:
+		case ID_ME:
+		case ID_CU:
+		case ID_MB:
+		case ID_LT:
+		case ID_SPK:
+		case ID_CF:
+		case ID_SCE:
+			return true;
+		default:
+			return false;
+	}
+}
+
+bool deg_graph_has_cyclic_relations(const DEG::Depsgraph *graph)
+{
+	for (const DEG::OperationNode *op_node : graph->operations) {
+		for (const DEG::Relation *rel : op_node->outlinks) {
+			if (rel->flag & DEG::RELATION_FLAG_CYCLIC) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+struct NeighbourIDsData {
+	GSet *rebuild_ids;
+	GSet *neighbour_ids;
+	ID *id;
+};
+
+int deg_graph_partial_build_neighbour_cb(void *user_data,
+                                         ID * /*id_self*/,
+                                         ID **id_pointer,
+                                         int /*cb_flag*/)
+{
+	NeighbourIDsData *data = (NeighbourIDsData *)user_data;
+	if (*id_pointer != NULL && BLI_gset_haskey(data->rebuild_ids, *id_pointer)) {
+		BLI_gset_add(data->neighbour_ids, data->id);
+	}
+	return IDWALK_RET_NOP;
+}
+
+void deg_graph_partial_build_add_neighbour(const DEG::Node *node,
+                                           NeighbourIDsData *data)
+{
+	if (node->type != DEG::NodeType::OPERATION) {
+		return;
+	}
+	const DEG::OperationNode *op_node =
+	        static_cast<const DEG::OperationNode *>(node);
+	ID *id = op_node->owner->owner->id_orig;
+	if (!BLI_gset_haskey(data->rebuild_ids, id)) {
+		BLI_gset_add(data->neighbour_ids, id);
+	}
+}
+
+/* Gather IDs which relations need to be built again along with the rebuilt
+ * IDs: the ones connected to them by relations, which are removed with the
+ * nodes, and the ones pointing to them, which might now need relations to
+ * nodes which did not exist before. */
+void deg_graph_partial_build_neighbours(DEG::Depsgraph *graph,
+                                        GSet *rebuild_ids,
+                                        GSet *neighbour_ids)
+{
+	NeighbourIDsData data;
+	data.rebuild_ids = rebuild_ids;
+	data.neighbour_ids = neighbour_ids;
+	data.id = NULL;
+	GSET_FOREACH_BEGIN(ID *, id, rebuild_ids)
+	{
+		DEG::IDNode *id_node = graph->find_id_node(id);
+		GHASH_FOREACH_BEGIN(DEG::ComponentNode *, comp_node, id_node->components)
+		{
+			for (DEG::OperationNode *op_node : comp_node->operations) {
+				for (DEG::Relation *rel : op_node->inlinks) {
+					deg_graph_partial_build_add_neighbour(rel->from, &data);
+				}
+				for (DEG::Relation *rel : op_node->outlinks) {
+					deg_graph_partial_build_add_neighbour(rel->to, &data);
+				}
+			}
+		}
+		GHASH_FOREACH_END();
+	}
+	GSET_FOREACH_END();
+	for (DEG::IDNode *id_node : graph->id_nodes) {
+		if (BLI_gset_haskey(rebuild_ids, id_node->id_orig)) {
+			continue;
+		}
+		data.id = id_node->id_orig;
+		BKE_library_foreach_ID_link(NULL,
+		                            id_node->id_orig,
+		                            deg_graph_partial_build_neighbour_cb,
+		                            &data,
+		                            IDWALK_READONLY);
+	}
+}
+
+/* Rebuild nodes of the IDs tagged for relations update and the relations
+ * around them, keeping the rest of the graph and its evaluated datablocks.
+ * Returns false if the graph is to be rebuilt fully instead, which is known
+ * before modifying it unless the graph has dependency cycles. */
+bool deg_graph_build_partial(Main *bmain, DEG::Depsgraph *deg_graph)
+{
+	double start_time = 0.0;
+	if (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) {
+		start_time = PIL_check_seconds_timer();
+	}
+	/* Transitive reduction removes relations which are used to find the IDs
+	 * affected by the rebuilt ones. */
+	if (G.debug_value == 799) {
+		return false;
+	}
+	GSet *rebuild_ids = deg_graph->relations_update_ids;
+	DEG::vector<ID *> ids;
+	bool is_supported = true;
+	GSET_FOREACH_BEGIN(ID *, id, rebuild_ids)
+	{
+		DEG::IDNode *id_node = deg_graph->find_id_node(id);
+		if (id_node == NULL || !deg_graph_partial_build_supports_id(id_node)) {
+			is_supported = false;
+			break;
+		}
+		ids.push_back(id);
+	}
+	GSET_FOREACH_END();
+	if (!is_supported) {
+		return false;
+	}
+	GSet *neighbour_ids = BLI_gset_ptr_new("Depsgraph neighbour ids");
+	deg_graph_partial_build_neighbours(deg_graph, rebuild_ids, neighbour_ids);
+	DEG::vector<ID *> relation_ids = ids;
+	GSET_FOREACH_BEGIN(ID *, id, neighbour_ids)
+	{
+		if (!deg_graph_partial_build_supports_relations(id)) {
+			is_supported = false;
+			break;
+		}
+		relation_ids.push_back(id);
+	}
+	GSET_FOREACH_END();
+	if (!is_supported) {
+		BLI_gset_free(neighbour_ids, NULL);
+		return false;
+	}
+	/* Relations of all other IDs which are already in the graph stay. */
+	GSet *kept_ids = BLI_gset_ptr_new("Depsgraph kept ids");
+	DEG::vector<ID *> built_ids;
+	for (DEG::IDNode *id_node : deg_graph->id_nodes) {
+		ID *id = id_node->id_orig;
+		if (BLI_gset_haskey(rebuild_ids, id)) {
+			continue;
+		}
+		BLI_gset_insert(kept_ids, id);
+		if (!BLI_gset_haskey(neighbour_ids, id)) {
+			built_ids.push_back(id);
+		}
+	}
+	BLI_gset_free(neighbour_ids, NULL);
+	/* Colliders and effectors are gathered again when needed. */
+	DEG::clear_physics_relations(deg_graph);
+	/* Replace nodes of the tagged IDs. */
+	DEG::DepsgraphNodeBuilder node_builder(bmain, deg_graph);
+	node_builder.begin_build_partial(ids);
+	node_builder.build_view_layer_partial(deg_graph->scene,
+	                                      deg_graph->view_layer,
+	                                      ids);
+	node_builder.end_build();
+	/* Hook up relations of the new nodes and of their neighbours. */
+	DEG::DepsgraphRelationBuilder relation_builder(bmain, deg_graph);
+	relation_builder.begin_build_partial(built_ids);
+	relation_builder.build_view_layer_partial(deg_graph->scene,
+	                                          deg_graph->view_layer,
+	                                          relation_ids);
+	for (DEG::IDNode *id_node : deg_graph->id_nodes) {
+		if (!BLI_gset_haskey(kept_ids, id_node->id_orig)) {
+			relation_builder.build_copy_on_write_relations(id_node);
+		}
+	}
+	BLI_gset_free(kept_ids, NULL);
+	/* Kept relations still carry the cyclic flag from the previous build, the
+	 * cycles solver only ever sets it. */
+	for (DEG::OperationNode *op_node : deg_graph->operations) {
+		for (DEG::Relation *rel : op_node->outlinks) {
+			rel->flag &= ~DEG::RELATION_FLAG_CYCLIC;
+		}
+	}
+	DEG::deg_graph_detect_cycles(deg_graph);
+	/* Which relation of a cycle gets ignored depends on the order operations
+	 * are visited in, which is not the one of a full build. */
+	if (deg_graph_has_cyclic_relations(deg_graph)) {
+		return false;
+	}
+	/* Same as the full build from here on. */
+	DEG::deg_graph_build_finalize(bmain, deg_graph);
+	DEG_graph_on_visible_update(bmain, reinterpret_cast<Depsgraph *>(deg_graph));
+	/* Relations are up to date. */
+	deg_graph->need_update = false;
+	BLI_gset_clear(deg_graph->relations_update_ids, NULL);
+	/* Finish statistics. */
+	if (G.debug & (G_DEBUG_DEPSGRAPH_BUILD | G_DEBUG_DEPSGRAPH_TIME)) {
+		printf("Depsgraph partially rebuilt (%d IDs) in %f seconds.\n",
+		       (int)ids.size(),
+		       PIL_check_seconds_timer() - start_time);
+	}
+	return true;
+}
+
+}  // namespace
+
 /* Tag graph relations for update. */
 void DEG_graph_tag_relations_update(Depsgraph *graph)
 {
 	DEG_DEBUG_PRINTF(graph, TAG, "%s: Tagging relations for update.\n", __func__);
 	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
 	deg_graph->need_update = true;
+	BLI_gset_clear(deg_graph->relations_update_ids, NULL);
+	DEG::deg_lookahead_invalidate(deg_graph);
 	/* NOTE: When relations are updated, it's quite possible that
 	 * we've got new bases in the scene. This means, we need to
 	 * re-create flat array of bases in view layer.
@@ -312,6 +584,27 @@ void DEG_graph_tag_relations_update(Depsgraph *graph)
 	}
 }
 
+/* Tag relations of a single ID for update. */
+void DEG_graph_id_tag_relations_update(Depsgraph *graph, ID *id)
+{
+	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
+	if (deg_graph->need_update &&
+	    BLI_gset_len(deg_graph->relations_update_ids) == 0)
+	{
+		/* Whole graph is to be rebuilt already. */
+		return;
+	}
+	if (deg_graph->find_id_node(id) == NULL) {
+		/* Relations of an ID which is not in the graph do not affect it. */
+		return;
+	}
+	DEG_DEBUG_PRINTF(graph, TAG, "%s: Tagging relations of %s for update.\n",
+	                 __func__, id->name);
+	BLI_gset_add(deg_graph->relations_update_ids, id);
+	deg_graph->need_update = true;
+	DEG::deg_lookahead_invalidate(deg_graph);
+}
+
 /* Create or update relations in the specified graph. */
 void DEG_graph_relations_update(Depsgraph *graph,
                                 Main *bmain,
@@ -323,6 +616,14 @@ void DEG_graph_relations_update(Depsgraph *graph,
 		/* Graph is up to date, nothing to do. */
 		return;
 	}
+	if (BLI_gset_len(deg_graph->relations_update_ids) != 0 &&
+	    deg_graph_build_partial(bmain, deg_graph))
+	{
+		if (G.debug & G_DEBUG_DEPSGRAPH_VALIDATE) {
+			DEG_debug_graph_relations_validate(graph, bmain, scene, view_layer);
+		}
+		return;
+	}
 	DEG_graph_build_from_view_layer(graph, bmain, scene, view_layer);
 }
 
@@ -342,3 +643,19 @@ void DEG_relations_tag_update(Main *bmain)
 		}
 	}
 }
+
+/* Tag relations of the given ID for update in all graphs. */
+void DEG_id_tag_relations_update(Main *bmain, ID *id)
+{
+	LISTBASE_FOREACH (Scene *, scene, &bmain->scenes) {
+		LISTBASE_FOREACH (ViewLayer *, view_layer, &scene->view_layers) {
+			Depsgraph *depsgraph =
+			        (Depsgraph *)BKE_scene_get_depsgraph(scene,
+			                                             view_layer,
+			                                             false);
+			if (depsgraph != NULL) {
+				DEG_graph_id_tag_relations_update(depsgraph, id);
+			}
+		}
+	}
+}
@@ -23,6 +23,9 @@
  * Implementation of tools for debugging the depsgraph
  */
 
+#include <set>
+#include <string>
+
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
 
@@ -42,6 +45,7 @@ extern "C" {
 #include "intern/debug/deg_debug.h"
 #include "intern/node/deg_node_component.h"
 #include "intern/node/deg_node_id.h"
+#include "intern/node/deg_node_operation.h"
 #include "intern/node/deg_node_time.h"
 
 void DEG_debug_flags_set(Depsgraph *depsgraph, int flags)
@@ -72,6 +76,67 @@ const char *DEG_debug_name_get(struct Depsgraph *depsgraph)
 	return deg_graph->debug_name.c_str();
 }
 
+namespace {
+
+typedef std::set<std::string> DebugKeySet;
+
+std::string deg_debug_node_key(const DEG::Node *node)
+{
+	if (node->type != DEG::NodeType::OPERATION) {
+		return node->identifier();
+	}
+	const DEG::OperationNode *op_node =
+	        static_cast<const DEG::OperationNode *>(node);
+	const DEG::ComponentNode *comp_node = op_node->owner;
+	return comp_node->owner->name + " " +
+	       DEG::nodeTypeAsString(comp_node->type) + "[" + comp_node->name +
+	       "] " + op_node->identifier() + " #" +
+	       std::to_string(op_node->name_tag);
+}
+
+void deg_debug_graph_keys(const DEG::Depsgraph *graph,
+                          DebugKeySet *r_ids,
+                          DebugKeySet *r_operations,
+                          DebugKeySet *r_relations)
+{
+	for (const DEG::IDNode *id_node : graph->id_nodes) {
+		r_ids->insert(id_node->name);
+	}
+	for (const DEG::OperationNode *op_node : graph->operations) {
+		r_operations->insert(deg_debug_node_key(op_node));
+		for (const DEG::Relation *rel : op_node->inlinks) {
+			/* Checking for existing relations is how they were added, not
+			 * what they do. */
+			const int flag = rel->flag & ~DEG::RELATION_CHECK_BEFORE_ADD;
+			r_relations->insert(deg_debug_node_key(rel->from) + " -> " +
+			                    deg_debug_node_key(rel->to) + " (" +
+			                    rel->name + ") flag " + std::to_string(flag));
+		}
+	}
+}
+
+bool deg_debug_compare_keys(const char *what,
+                            const DebugKeySet &keys1,
+                            const DebugKeySet &keys2)
+{
+	bool is_equal = true;
+	for (const std::string &key : keys1) {
+		if (keys2.find(key) == keys2.end()) {
+			printf("  %s only in first graph: %s\n", what, key.c_str());
+			is_equal = false;
+		}
+	}
+	for (const std::string &key : keys2) {
+		if (keys1.find(key) == keys1.end()) {
+			printf("  %s only in second graph: %s\n", what, key.c_str());
+			is_equal = false;
+		}
+	}
+	return is_equal;
+}
+
+}  // namespace
+
 bool DEG_debug_compare(const struct Depsgraph *graph1,
                        const struct Depsgraph *graph2)
 {
@@ -79,16 +144,17 @@ bool DEG_debug_compare(const struct Depsgraph *graph1,
 	BLI_assert(graph2 != NULL);
 	const DEG::Depsgraph *deg_graph1 = reinterpret_cast<const DEG::Depsgraph *>(graph1);
 	const DEG::Depsgraph *deg_graph2 = reinterpret_cast<const DEG::Depsgraph *>(graph2);
-	if (deg_graph1->operations.size() != deg_graph2->operations.size()) {
-		return false;
-	}
-	/* TODO(sergey): Currently we only do real stupid check,
-	 * which is fast but which isn't 100% reliable.
-	 *
-	 * Would be cool to make it more robust, but it's good enough
-	 * for now. Also, proper graph check is actually NP-complex
-	 * problem. */
-	return true;
+	/* Nodes and relations are compared by their names, which are unique
+	 * within a graph except of duplicated relations, those are ignored. */
+	DebugKeySet ids1, operations1, relations1;
+	DebugKeySet ids2, operations2, relations2;
+	deg_debug_graph_keys(deg_graph1, &ids1, &operations1, &relations1);
+	deg_debug_graph_keys(deg_graph2, &ids2, &operations2, &relations2);
+	bool is_equal = true;
+	is_equal &= deg_debug_compare_keys("ID", ids1, ids2);
+	is_equal &= deg_debug_compare_keys("Operation", operations1, operations2);
+	is_equal &= deg_debug_compare_keys("Relation", relations1, relations2);
+	return is_equal;
 }
 
 bool DEG_debug_graph_relations_validate(Depsgraph *graph,
@@ -100,8 +166,7 @@ bool DEG_debug_graph_relations_validate(Depsgraph *graph,
 	bool valid = true;
 	DEG_graph_build_from_view_layer(temp_depsgraph, bmain, scene, view_layer);
 	if (!DEG_debug_compare(temp_depsgraph, graph)) {
-		fprintf(stderr, "ERROR! Depsgraph wasn't tagged for update when it should have!\n");
-		BLI_assert(!"This should not happen!");
+		fprintf(stderr, "ERROR! Depsgraph relations differ from a full rebuild!\n");
 		valid = false;
 	}
 	DEG_graph_free(temp_depsgraph);
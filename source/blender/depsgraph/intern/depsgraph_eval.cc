@@ -29,6 +29,8 @@
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
 
+#include "PIL_time.h"
+
 extern "C" {
 #include "BKE_scene.h"
 
@@ -41,6 +43,7 @@ extern "C" {
 
 #include "intern/eval/deg_eval.h"
 #include "intern/eval/deg_eval_flush.h"
+#include "intern/eval/deg_eval_lookahead.h"
 
 #include "intern/node/deg_node.h"
 #include "intern/node/deg_node_operation.h"
@@ -69,18 +72,21 @@ void DEG_evaluate_on_framechange(Main *bmain,
                                  float ctime)
 {
 	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
-	deg_graph->ctime = ctime;
-	/* Update time on primary timesource. */
-	DEG::TimeSourceNode *tsrc = deg_graph->find_time_source();
-	tsrc->cfra = ctime;
-	tsrc->tag_update(deg_graph, DEG::DEG_UPDATE_SOURCE_TIME);
-	DEG::deg_graph_flush_updates(bmain, deg_graph);
-	/* Update time in scene. */
-	if (deg_graph->scene_cow) {
-		BKE_scene_frame_set(deg_graph->scene_cow, deg_graph->ctime);
+	/* Use the frame evaluated ahead when there is one. */
+	if (deg_graph->lookahead != NULL &&
+	    DEG::deg_lookahead_use_frame(deg_graph, ctime))
+	{
+		DEG::deg_lookahead_schedule(deg_graph, ctime, 0.0);
+		return;
 	}
+	const double start_time = PIL_check_seconds_timer();
+	DEG::deg_evaluate_prepare_framechange(bmain, deg_graph, ctime);
 	/* Perform recalculation updates. */
 	DEG::deg_evaluate_on_refresh(deg_graph);
+	if (deg_graph->lookahead != NULL) {
+		DEG::deg_lookahead_schedule(
+		        deg_graph, ctime, PIL_check_seconds_timer() - start_time);
+	}
 }
 
 bool DEG_needs_eval(Depsgraph *graph)
@@ -88,3 +94,47 @@ bool DEG_needs_eval(Depsgraph *graph)
 	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
 	return BLI_gset_len(deg_graph->entry_tags) != 0;
 }
+
+void DEG_lookahead_enable(Main *bmain,
+                          Depsgraph *graph,
+                          int num_frames,
+                          size_t memory_limit)
+{
+	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
+	DEG::deg_lookahead_enable(bmain, deg_graph, num_frames, memory_limit);
+}
+
+void DEG_lookahead_disable(Depsgraph *graph)
+{
+	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
+	DEG::deg_lookahead_free(deg_graph);
+}
+
+void DEG_lookahead_wait_all(Main *bmain)
+{
+	LISTBASE_FOREACH (Scene *, scene, &bmain->scenes) {
+		LISTBASE_FOREACH (ViewLayer *, view_layer, &scene->view_layers) {
+			Depsgraph *depsgraph = BKE_scene_get_depsgraph(scene,
+			                                               view_layer,
+			                                               false);
+			if (depsgraph != NULL) {
+				DEG::deg_lookahead_wait_build(
+				        reinterpret_cast<DEG::Depsgraph *>(depsgraph));
+			}
+		}
+	}
+}
+
+void DEG_lookahead_disable_all(Main *bmain)
+{
+	LISTBASE_FOREACH (Scene *, scene, &bmain->scenes) {
+		LISTBASE_FOREACH (ViewLayer *, view_layer, &scene->view_layers) {
+			Depsgraph *depsgraph = BKE_scene_get_depsgraph(scene,
+			                                               view_layer,
+			                                               false);
+			if (depsgraph != NULL) {
+				DEG_lookahead_disable(depsgraph);
+			}
+		}
+	}
+}
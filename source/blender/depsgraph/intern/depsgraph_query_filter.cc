@@ -47,6 +47,7 @@ extern "C" {
 #include "DEG_depsgraph_debug.h"
 
 #include "intern/eval/deg_eval_copy_on_write.h"
+#include "intern/eval/deg_eval_plan.h"
 
 #include "intern/depsgraph.h"
 #include "intern/depsgraph_type.h"
@@ -109,6 +110,9 @@ static void deg_unlink_opnode(Depsgraph *graph, OperationNode *op_node)
 /* Remove every ID Node (and its associated subnodes, COW data) */
 static void deg_filter_remove_unwanted_ids(Depsgraph *graph, GSet *retained_ids)
 {
+	/* Execution plan will be created again for the remaining operations. */
+	deg_eval_plan_clear(graph);
+
 	/* 1) First pass over ID nodes + their operations
 	 * - Identify and tag ID's (via "custom_flags = 1") to be removed
 	 * - Remove all links to/from operations that will be removed. */
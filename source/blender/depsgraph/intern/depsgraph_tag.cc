@@ -66,6 +66,7 @@ extern "C" {
 #include "intern/depsgraph_update.h"
 #include "intern/eval/deg_eval_copy_on_write.h"
 #include "intern/eval/deg_eval_flush.h"
+#include "intern/eval/deg_eval_lookahead.h"
 #include "intern/node/deg_node.h"
 #include "intern/node/deg_node_component.h"
 #include "intern/node/deg_node_factory.h"
@@ -569,6 +570,21 @@ NodeType geometry_tag_to_component(const ID *id)
 	return NodeType::UNDEFINED;
 }
 
+/* Data-blocks edited by the user are written again for the next global undo step.
+ * Tools editing object data (sculpting, vertex groups...) often only tag the object. */
+static void id_tag_undo_changed(ID *id, int flag)
+{
+	id->tag |= LIB_TAG_UNDO_CHANGED;
+	if (GS(id->name) == ID_OB) {
+		Object *object = (Object *)id;
+		if ((object->data != NULL) &&
+		    (flag == 0 || (flag & (ID_RECALC_GEOMETRY | ID_RECALC_SHADING))))
+		{
+			((ID *)object->data)->tag |= LIB_TAG_UNDO_CHANGED;
+		}
+	}
+}
+
 void id_tag_update(Main *bmain, ID *id, int flag, eUpdateSource update_source)
 {
 	graph_id_tag_update(bmain, NULL, id, flag, update_source);
@@ -607,11 +623,16 @@ void graph_id_tag_update(Main *bmain,
 	if (graph != NULL) {
 		DEG_graph_id_type_tag(reinterpret_cast<::Depsgraph*>(graph),
 		                      GS(id->name));
+		/* Frames evaluated ahead used the data before this change. */
+		deg_lookahead_invalidate(graph);
 	}
 	if (flag == 0) {
 		deg_graph_node_tag_zero(bmain, graph, id_node, update_source);
 	}
 	id->recalc |= flag;
+	if (update_source == DEG_UPDATE_SOURCE_USER_EDIT) {
+		id_tag_undo_changed(id, flag);
+	}
 	int current_flag = flag;
 	while (current_flag != 0) {
 		IDRecalcFlag tag =
@@ -713,6 +734,9 @@ void DEG_id_type_tag(Main *bmain, short id_type)
 			                                             false);
 			if (depsgraph != NULL) {
 				DEG_graph_id_type_tag(depsgraph, id_type);
+				/* Datablocks of this type might be freed, frames evaluated
+				 * ahead can not be using them anymore. */
+				DEG::deg_lookahead_cancel((DEG::Depsgraph *)depsgraph);
 			}
 		}
 	}
@@ -25,14 +25,21 @@
 
 #include "intern/eval/deg_eval.h"
 
+#include <algorithm>
+
+#include "MEM_guardedalloc.h"
+
 #include "PIL_time.h"
 
 #include "BLI_compiler_attrs.h"
 #include "BLI_utildefines.h"
 #include "BLI_task.h"
 #include "BLI_ghash.h"
+#include "BLI_heap.h"
+#include "BLI_threads.h"
 
 #include "BKE_global.h"
+#include "BKE_scene.h"
 
 #include "DNA_object_types.h"
 #include "DNA_scene_types.h"
@@ -43,8 +50,11 @@
 #include "atomic_ops.h"
 
 #include "intern/eval/deg_eval_copy_on_write.h"
+#include "intern/eval/deg_eval_critical_path.h"
 #include "intern/eval/deg_eval_flush.h"
+#include "intern/eval/deg_eval_plan.h"
 #include "intern/eval/deg_eval_stats.h"
+#include "intern/eval/deg_eval_trace.h"
 #include "intern/node/deg_node.h"
 #include "intern/node/deg_node_component.h"
 #include "intern/node/deg_node_id.h"
@@ -59,53 +69,91 @@ namespace DEG {
 
 /* Forward declarations. */
 static void schedule_children(TaskPool *pool,
-                              Depsgraph *graph,
-                              OperationNode *node,
+                              ExecutionPlan *plan,
+                              const int index,
                               const int thread_id);
 
 struct DepsgraphEvalState {
 	Depsgraph *graph;
+	ExecutionPlan *plan;
 	bool do_stats;
 	bool is_cow_stage;
+	/* Time at which every operation became ready for evaluation, only
+	 * allocated when the evaluation is traced. */
+	double *ready_times;
+	/* Indices of operations which are ready for evaluation, keyed by negated
+	 * priority. Every task evaluates the operation at the top of the heap
+	 * rather than the one it was pushed for, so long chains of operations
+	 * are started as early as possible, regardless of the order tasks are
+	 * picked up. */
+	Heap *ready_heap;
+	SpinLock ready_lock;
 };
 
 static void deg_task_run_func(TaskPool *pool,
-                              void *taskdata,
+                              void * /*taskdata*/,
                               int thread_id)
 {
 	void *userdata_v = BLI_task_pool_userdata(pool);
 	DepsgraphEvalState *state = (DepsgraphEvalState *)userdata_v;
-	OperationNode *node = (OperationNode *)taskdata;
+	/* There is a task pushed for every operation in the heap, so it can not
+	 * be empty here. */
+	BLI_spin_lock(&state->ready_lock);
+	const int index = POINTER_AS_INT(BLI_heap_pop_min(state->ready_heap));
+	BLI_spin_unlock(&state->ready_lock);
+	OperationNode *node = state->plan->operations[index];
 	/* Sanity checks. */
 	BLI_assert(!node->is_noop() && "NOOP nodes should not actually be scheduled");
 	/* Perform operation. */
-	if (state->do_stats) {
+	if (state->do_stats || state->ready_times != NULL) {
 		const double start_time = PIL_check_seconds_timer();
 		node->evaluate((::Depsgraph *)state->graph);
-		node->stats.current_time += PIL_check_seconds_timer() - start_time;
+		const double end_time = PIL_check_seconds_timer();
+		if (state->do_stats) {
+			node->stats.current_time += end_time - start_time;
+		}
+		if (state->ready_times != NULL) {
+			deg_eval_trace_operation(state->graph,
+			                         state->plan,
+			                         index,
+			                         thread_id,
+			                         state->ready_times[index],
+			                         start_time,
+			                         end_time);
+		}
 	}
 	else {
 		node->evaluate((::Depsgraph *)state->graph);
 	}
 	/* Schedule children. */
 	BLI_task_pool_delayed_push_begin(pool, thread_id);
-	schedule_children(pool, state->graph, node, thread_id);
+	schedule_children(pool, state->plan, index, thread_id);
 	BLI_task_pool_delayed_push_end(pool, thread_id);
 }
 
-struct CalculatePendingData {
-	Depsgraph *graph;
-};
+static bool check_operation_needs_evaluation(const ExecutionPlan *plan,
+                                             const int index)
+{
+	const uint8_t flag = plan->flags[index];
+	/* Invisible operations and operations which are not tagged for update
+	 * are considered to be up to date. */
+	return (flag & ExecutionPlan::OPERATION_VISIBLE) &&
+	       (flag & ExecutionPlan::OPERATION_NEEDS_UPDATE);
+}
 
-static bool check_operation_node_visible(OperationNode *op_node)
+static void copy_update_tags_func(
+        void *__restrict data_v,
+        const int i,
+        const ParallelRangeTLS *__restrict /*tls*/)
 {
-	const ComponentNode *comp_node = op_node->owner;
-	/* Special exception, copy on write component is to be always evaluated,
-	 * to keep copied "database" in a consistent state. */
-	if (comp_node->type == NodeType::COPY_ON_WRITE) {
-		return true;
+	ExecutionPlan *plan = (ExecutionPlan *)data_v;
+	const OperationNode *node = plan->operations[i];
+	if (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) {
+		plan->flags[i] |= ExecutionPlan::OPERATION_NEEDS_UPDATE;
+	}
+	else {
+		plan->flags[i] &= ~ExecutionPlan::OPERATION_NEEDS_UPDATE;
 	}
-	return comp_node->affects_directly_visible;
 }
 
 static void calculate_pending_func(
@@ -113,63 +161,73 @@ static void calculate_pending_func(
         const int i,
         const ParallelRangeTLS *__restrict /*tls*/)
 {
-	CalculatePendingData *data = (CalculatePendingData *)data_v;
-	Depsgraph *graph = data->graph;
-	OperationNode *node = graph->operations[i];
+	ExecutionPlan *plan = (ExecutionPlan *)data_v;
 	/* Update counters, applies for both visible and invisible IDs. */
-	node->num_links_pending = 0;
-	node->scheduled = false;
-	/* Invisible IDs requires no pending operations. */
-	if (!check_operation_node_visible(node)) {
+	plan->num_links_pending[i] = 0;
+	plan->scheduled[i] = false;
+	if (!check_operation_needs_evaluation(plan, i)) {
 		return;
 	}
-	/* No need to bother with anything if node is not tagged for update. */
-	if ((node->flag & DEPSOP_FLAG_NEEDS_UPDATE) == 0) {
-		return;
-	}
-	for (Relation *rel : node->inlinks) {
-		if (rel->from->type == NodeType::OPERATION &&
-		    (rel->flag & RELATION_FLAG_CYCLIC) == 0)
-		{
-			OperationNode *from = (OperationNode *)rel->from;
-			/* TODO(sergey): This is how old layer system was checking for the
-			 * calculation, but how is it possible that visible object depends
-			 * on an invisible? This is something what is prohibited after
-			 * deg_graph_build_flush_layers(). */
-			if (!check_operation_node_visible(from)) {
-				continue;
-			}
-			/* No need to vait for operation which is up to date. */
-			if ((from->flag & DEPSOP_FLAG_NEEDS_UPDATE) == 0) {
-				continue;
-			}
-			++node->num_links_pending;
+	const int parents_end = plan->parents_offsets[i + 1];
+	for (int p = plan->parents_offsets[i]; p < parents_end; p++) {
+		/* No need to wait for operations which are up to date or invisible.
+		 * Visible operations depending on invisible ones should not happen
+		 * after deg_graph_build_flush_visibility(). */
+		if (check_operation_needs_evaluation(plan, plan->parents[p])) {
+			++plan->num_links_pending[i];
 		}
 	}
 }
 
-static void calculate_pending_parents(Depsgraph *graph)
+static void calculate_pending_parents(ExecutionPlan *plan)
 {
-	const int num_operations = graph->operations.size();
-	CalculatePendingData data;
-	data.graph = graph;
+	const int num_operations = plan->num_operations();
 	ParallelRangeSettings settings;
 	BLI_parallel_range_settings_defaults(&settings);
 	settings.min_iter_per_thread = 1024;
+	/* Tags of parents are needed for pending counts, so update all of them
+	 * first. */
+	BLI_task_parallel_range(0,
+	                        num_operations,
+	                        plan,
+	                        copy_update_tags_func,
+	                        &settings);
 	BLI_task_parallel_range(0,
 	                        num_operations,
-	                        &data,
+	                        plan,
 	                        calculate_pending_func,
 	                        &settings);
 }
 
+/* Allocate storage for the timeline of the evaluation, if it is traced. */
+static void initialize_trace(DepsgraphEvalState *state)
+{
+	state->ready_times = NULL;
+	if (deg_eval_trace_is_enabled()) {
+		deg_eval_trace_plan_ensure(state->plan);
+		state->ready_times = (double *)MEM_mallocN(
+		        sizeof(double) * state->plan->num_operations(),
+		        "depsgraph ready times");
+	}
+}
+
+static void free_trace(DepsgraphEvalState *state, const double start_time)
+{
+	if (state->ready_times != NULL) {
+		deg_eval_trace_update(state->graph,
+		                      start_time,
+		                      PIL_check_seconds_timer());
+		MEM_freeN(state->ready_times);
+	}
+}
+
 static void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
 {
 	const bool do_stats = state->do_stats;
-	calculate_pending_parents(graph);
+	calculate_pending_parents(state->plan);
 	/* Clear tags and other things which needs to be clear. */
-	for (OperationNode *node : graph->operations) {
-		if (do_stats) {
+	if (do_stats) {
+		for (OperationNode *node : graph->operations) {
 			node->stats.reset_current();
 		}
 	}
@@ -179,53 +237,57 @@ static void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
  *   dec_parents: Decrement pending parents count, true when child nodes are
  *                scheduled after a task has been completed.
  */
-static void schedule_node(TaskPool *pool, Depsgraph *graph,
-                          OperationNode *node, bool dec_parents,
+static void schedule_node(TaskPool *pool, ExecutionPlan *plan,
+                          const int index, bool dec_parents,
                           const int thread_id)
 {
-	/* No need to schedule nodes of invisible ID. */
-	if (!check_operation_node_visible(node)) {
-		return;
-	}
-	/* No need to schedule operations which are not tagged for update, they are
-	 * considered to be up to date. */
-	if ((node->flag & DEPSOP_FLAG_NEEDS_UPDATE) == 0) {
+	if (!check_operation_needs_evaluation(plan, index)) {
 		return;
 	}
 	/* TODO(sergey): This is not strictly speaking safe to read
 	 * num_links_pending. */
+	uint32_t *num_links_pending = &plan->num_links_pending[index];
 	if (dec_parents) {
-		BLI_assert(node->num_links_pending > 0);
-		atomic_sub_and_fetch_uint32(&node->num_links_pending, 1);
+		BLI_assert(*num_links_pending > 0);
+		atomic_sub_and_fetch_uint32(num_links_pending, 1);
 	}
 	/* Cal not schedule operation while its dependencies are not yet
 	 * evaluated. */
-	if (node->num_links_pending != 0) {
+	if (*num_links_pending != 0) {
 		return;
 	}
 	/* During the COW stage only schedule COW nodes. */
 	DepsgraphEvalState *state = (DepsgraphEvalState *)BLI_task_pool_userdata(pool);
+	const uint8_t flag = plan->flags[index];
 	if (state->is_cow_stage) {
-		if (node->owner->type != NodeType::COPY_ON_WRITE) {
+		if ((flag & ExecutionPlan::OPERATION_COPY_ON_WRITE) == 0) {
 			return;
 		}
 	}
 	else {
-		BLI_assert(node->scheduled || node->owner->type != NodeType::COPY_ON_WRITE);
+		BLI_assert(plan->scheduled[index] ||
+		           (flag & ExecutionPlan::OPERATION_COPY_ON_WRITE) == 0);
 	}
 	/* Actually schedule the node. */
 	bool is_scheduled = atomic_fetch_and_or_uint8(
-	        (uint8_t *)&node->scheduled, (uint8_t)true);
+	        &plan->scheduled[index], (uint8_t)true);
 	if (!is_scheduled) {
-		if (node->is_noop()) {
+		if (flag & ExecutionPlan::OPERATION_NOOP) {
 			/* skip NOOP node, schedule children right away */
-			schedule_children(pool, graph, node, thread_id);
+			schedule_children(pool, plan, index, thread_id);
 		}
 		else {
 			/* children are scheduled once this task is completed */
+			const float priority = plan->operations[index]->priority;
+			if (state->ready_times != NULL) {
+				state->ready_times[index] = PIL_check_seconds_timer();
+			}
+			BLI_spin_lock(&state->ready_lock);
+			BLI_heap_insert(state->ready_heap, -priority, POINTER_FROM_INT(index));
+			BLI_spin_unlock(&state->ready_lock);
 			BLI_task_pool_push_from_thread(pool,
 			                               deg_task_run_func,
-			                               node,
+			                               NULL,
 			                               false,
 			                               TASK_PRIORITY_HIGH,
 			                               thread_id);
@@ -233,30 +295,27 @@ static void schedule_node(TaskPool *pool, Depsgraph *graph,
 	}
 }
 
-static void schedule_graph(TaskPool *pool, Depsgraph *graph)
+static void schedule_graph(TaskPool *pool, ExecutionPlan *plan)
 {
-	for (OperationNode *node : graph->operations) {
-		schedule_node(pool, graph, node, false, 0);
+	const int num_operations = plan->num_operations();
+	for (int i = 0; i < num_operations; i++) {
+		schedule_node(pool, plan, i, false, 0);
 	}
 }
 
 static void schedule_children(TaskPool *pool,
-                              Depsgraph *graph,
-                              OperationNode *node,
+                              ExecutionPlan *plan,
+                              const int index,
                               const int thread_id)
 {
-	for (Relation *rel : node->outlinks) {
-		OperationNode *child = (OperationNode *)rel->to;
-		BLI_assert(child->type == NodeType::OPERATION);
-		if (child->scheduled) {
+	const int children_end = plan->children_offsets[index + 1];
+	for (int c = plan->children_offsets[index]; c < children_end; c++) {
+		const int child = plan->children[c];
+		if (plan->scheduled[child]) {
 			/* Happens when having cyclic dependencies. */
 			continue;
 		}
-		schedule_node(pool,
-		              graph,
-		              child,
-		              (rel->flag & RELATION_FLAG_CYCLIC) == 0,
-		              thread_id);
+		schedule_node(pool, plan, child, true, thread_id);
 	}
 }
 
@@ -275,6 +334,38 @@ static void depsgraph_ensure_view_layer(Depsgraph *graph)
 	}
 }
 
+/* Compare update time with the lower bound of evaluation time: operations
+ * can not finish before the longest chain of them is evaluated, nor before
+ * their total time is divided across all threads. */
+static void deg_eval_print_critical_path(Depsgraph *graph,
+                                         const double update_time,
+                                         const double critical_path_time,
+                                         const int num_threads)
+{
+	double operations_time = 0.0;
+	for (OperationNode *node : graph->operations) {
+		operations_time += node->stats.current_time;
+	}
+	const double lower_bound = std::max(critical_path_time,
+	                                    operations_time / num_threads);
+	printf("Depsgraph critical path %f seconds, operations %f seconds "
+	       "on %d threads, lower bound is %.1f%% of update time.\n",
+	       critical_path_time,
+	       operations_time,
+	       num_threads,
+	       (update_time > 0.0) ? lower_bound / update_time * 100.0 : 100.0);
+}
+
+static TaskScheduler *deg_task_scheduler_get(bool *r_need_free)
+{
+	if (G.debug & G_DEBUG_DEPSGRAPH_NO_THREADS) {
+		*r_need_free = true;
+		return BLI_task_scheduler_create(1);
+	}
+	*r_need_free = false;
+	return BLI_task_scheduler_get();
+}
+
 /**
  * Evaluate all nodes tagged for updating,
  * \warning This is usually done as part of main loop, but may also be
@@ -289,42 +380,48 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
 		return;
 	}
 	const bool do_time_debug = ((G.debug & G_DEBUG_DEPSGRAPH_TIME) != 0);
-	const double start_time = do_time_debug ? PIL_check_seconds_timer() : 0;
+	const double start_time = PIL_check_seconds_timer();
 	graph->debug_is_evaluating = true;
 	depsgraph_ensure_view_layer(graph);
 	/* Set up evaluation state. */
 	DepsgraphEvalState state;
+	deg_eval_plan_ensure(graph);
 	state.graph = graph;
+	state.plan = graph->execution_plan;
 	state.do_stats = do_time_debug;
+	state.ready_heap = BLI_heap_new();
+	BLI_spin_init(&state.ready_lock);
+	initialize_trace(&state);
 	/* Set up task scheduler and pull for threaded evaluation. */
-	TaskScheduler *task_scheduler;
 	bool need_free_scheduler;
-	if (G.debug & G_DEBUG_DEPSGRAPH_NO_THREADS) {
-		task_scheduler = BLI_task_scheduler_create(1);
-		need_free_scheduler = true;
-	}
-	else {
-		task_scheduler = BLI_task_scheduler_get();
-		need_free_scheduler = false;
-	}
+	TaskScheduler *task_scheduler = deg_task_scheduler_get(&need_free_scheduler);
+	const int num_threads = BLI_task_scheduler_num_threads(task_scheduler);
 	TaskPool *task_pool = BLI_task_pool_create_suspended(task_scheduler, &state);
 	/* Prepare all nodes for evaluation. */
 	initialize_execution(&state, graph);
 	/* Do actual evaluation now. */
 	/* First, process all Copy-On-Write nodes. */
 	state.is_cow_stage = true;
-	schedule_graph(task_pool, graph);
+	schedule_graph(task_pool, state.plan);
 	BLI_task_pool_work_wait_and_reset(task_pool);
 	/* After that, process all other nodes. */
 	state.is_cow_stage = false;
-	schedule_graph(task_pool, graph);
+	schedule_graph(task_pool, state.plan);
 	BLI_task_pool_work_and_wait(task_pool);
 	BLI_task_pool_free(task_pool);
+	BLI_assert(BLI_heap_is_empty(state.ready_heap));
+	BLI_heap_free(state.ready_heap, NULL);
+	BLI_spin_end(&state.ready_lock);
+	free_trace(&state, start_time);
 	/* Finalize statistics gathering. This is because we only gather single
 	 * operation timing here, without aggregating anything to avoid any extra
 	 * synchronization. */
+	double critical_path_time = 0.0;
 	if (state.do_stats) {
 		deg_eval_stats_aggregate(graph);
+		critical_path_time = deg_eval_critical_path_time(graph);
+		/* Use the new timings for the following evaluations. */
+		deg_eval_critical_path_update_priorities(graph);
 	}
 	/* Clear any uncleared tags - just in case. */
 	deg_graph_clear_tags(graph);
@@ -333,9 +430,78 @@ void deg_evaluate_on_refresh(Depsgraph *graph)
 	}
 	graph->debug_is_evaluating = false;
 	if (do_time_debug) {
-		printf("Depsgraph updated in %f seconds.\n",
-		       PIL_check_seconds_timer() - start_time);
+		const double update_time = PIL_check_seconds_timer() - start_time;
+		printf("Depsgraph updated in %f seconds.\n", update_time);
+		deg_eval_print_critical_path(graph,
+		                             update_time,
+		                             critical_path_time,
+		                             num_threads);
+	}
+}
+
+/* Set current frame of the graph and tag time dependent operations, so they
+ * are evaluated for the new frame by the following deg_evaluate_on_refresh(). */
+void deg_evaluate_prepare_framechange(Main *bmain,
+                                      Depsgraph *graph,
+                                      float ctime)
+{
+	graph->ctime = ctime;
+	/* Update time on primary timesource. */
+	TimeSourceNode *tsrc = graph->find_time_source();
+	tsrc->cfra = ctime;
+	tsrc->tag_update(graph, DEG_UPDATE_SOURCE_TIME);
+	deg_graph_flush_updates(bmain, graph);
+	/* Update time in scene. */
+	if (graph->scene_cow) {
+		BKE_scene_frame_set(graph->scene_cow, graph->ctime);
+	}
+}
+
+/* Only evaluate copy-on-write operations, so evaluated copies of datablocks
+ * are expanded and updated from the original ones. The other operations stay
+ * tagged, to be evaluated by the following deg_evaluate_on_refresh(). */
+void deg_evaluate_copy_on_write_stage(Depsgraph *graph)
+{
+	if (BLI_gset_len(graph->entry_tags) == 0) {
+		return;
+	}
+	const double start_time = PIL_check_seconds_timer();
+	graph->debug_is_evaluating = true;
+	depsgraph_ensure_view_layer(graph);
+	DepsgraphEvalState state;
+	deg_eval_plan_ensure(graph);
+	state.graph = graph;
+	state.plan = graph->execution_plan;
+	state.do_stats = false;
+	state.is_cow_stage = true;
+	state.ready_heap = BLI_heap_new();
+	BLI_spin_init(&state.ready_lock);
+	initialize_trace(&state);
+	bool need_free_scheduler;
+	TaskScheduler *task_scheduler = deg_task_scheduler_get(&need_free_scheduler);
+	TaskPool *task_pool = BLI_task_pool_create_suspended(task_scheduler, &state);
+	calculate_pending_parents(state.plan);
+	schedule_graph(task_pool, state.plan);
+	BLI_task_pool_work_and_wait(task_pool);
+	BLI_task_pool_free(task_pool);
+	BLI_heap_free(state.ready_heap, NULL);
+	BLI_spin_end(&state.ready_lock);
+	free_trace(&state, start_time);
+	/* Copies are up to date now, don't copy them again. */
+	ExecutionPlan *plan = state.plan;
+	const int num_operations = plan->num_operations();
+	for (int i = 0; i < num_operations; i++) {
+		if (plan->scheduled[i]) {
+			BLI_assert(plan->flags[i] & ExecutionPlan::OPERATION_COPY_ON_WRITE);
+			plan->operations[i]->flag &= ~(DEPSOP_FLAG_DIRECTLY_MODIFIED |
+			                               DEPSOP_FLAG_NEEDS_UPDATE |
+			                               DEPSOP_FLAG_USER_MODIFIED);
+		}
 	}
+	if (need_free_scheduler) {
+		BLI_task_scheduler_free(task_scheduler);
+	}
+	graph->debug_is_evaluating = false;
 }
 
 }  // namespace DEG
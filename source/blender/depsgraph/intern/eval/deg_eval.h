@@ -25,6 +25,8 @@
 
 #pragma once
 
+struct Main;
+
 namespace DEG {
 
 struct Depsgraph;
@@ -38,4 +40,15 @@ struct Depsgraph;
  */
 void deg_evaluate_on_refresh(Depsgraph *graph);
 
+/* Set current frame and tag time dependent operations for update. */
+void deg_evaluate_prepare_framechange(Main *bmain,
+                                      Depsgraph *graph,
+                                      float ctime);
+
+/* Evaluate copy-on-write operations only, keeping other tagged operations
+ * for the following deg_evaluate_on_refresh(). Reads original datablocks,
+ * so unlike deg_evaluate_on_refresh() this is to be called from the main
+ * thread. */
+void deg_evaluate_copy_on_write_stage(Depsgraph *graph);
+
 }  // namespace DEG
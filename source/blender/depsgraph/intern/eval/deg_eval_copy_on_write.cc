@@ -287,11 +287,15 @@ bool id_copy_inplace_no_main(const ID *id, ID *newid)
 	id_for_copy = nested_id_hack_get_discarded_pointers(&id_hack_storage, id);
 #endif
 
+	/* Mesh layers are shared with the original until the evaluation writes them,
+	 * tools make the original layers writable before editing them in place,
+	 * see BKE_mesh_ensure_writable(). */
 	bool result = BKE_id_copy_ex(NULL,
 	                             (ID *)id_for_copy,
 	                             &newid,
 	                             (LIB_ID_COPY_LOCALIZE |
-	                              LIB_ID_CREATE_NO_ALLOCATE));
+	                              LIB_ID_CREATE_NO_ALLOCATE |
+	                              LIB_ID_COPY_CD_SHARE));
 
 #ifdef NESTED_ID_NASTY_WORKAROUND
 	if (result) {
@@ -0,0 +1,132 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2019 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#include "intern/eval/deg_eval_critical_path.h"
+
+#include <algorithm>
+
+#include "BLI_utildefines.h"
+
+#include "intern/depsgraph.h"
+
+#include "intern/node/deg_node.h"
+#include "intern/node/deg_node_operation.h"
+
+namespace DEG {
+
+namespace {
+
+/* Cost of operations which were never evaluated with stats gathering enabled,
+ * in seconds. With no timings at all this makes priority the number of
+ * operations in the longest chain. */
+const double DEFAULT_OPERATION_TIME = 1e-5;
+
+template <typename Func>
+void foreach_child_operation(OperationNode *op_node, Func func)
+{
+	for (Relation *rel : op_node->outlinks) {
+		if (rel->to->type == NodeType::OPERATION &&
+		    (rel->flag & RELATION_FLAG_CYCLIC) == 0)
+		{
+			func((OperationNode *)rel->to);
+		}
+	}
+}
+
+/* Order operations so every operation comes after all of its children,
+ * ignoring cyclic relations. */
+void operations_sort_children_first(Depsgraph *graph,
+                                    vector<OperationNode *> *r_operations)
+{
+	vector<OperationNode *> stack;
+	r_operations->clear();
+	r_operations->reserve(graph->operations.size());
+	for (OperationNode *op_node : graph->operations) {
+		op_node->num_links_pending = 0;
+		foreach_child_operation(op_node, [&](OperationNode * /*op_to*/) {
+			++op_node->num_links_pending;
+		});
+		if (op_node->num_links_pending == 0) {
+			stack.push_back(op_node);
+		}
+	}
+	while (!stack.empty()) {
+		OperationNode *op_node = stack.back();
+		stack.pop_back();
+		r_operations->push_back(op_node);
+		for (Relation *rel : op_node->inlinks) {
+			if (rel->from->type != NodeType::OPERATION ||
+			    (rel->flag & RELATION_FLAG_CYCLIC) != 0)
+			{
+				continue;
+			}
+			OperationNode *op_from = (OperationNode *)rel->from;
+			BLI_assert(op_from->num_links_pending > 0);
+			if (--op_from->num_links_pending == 0) {
+				stack.push_back(op_from);
+			}
+		}
+	}
+	BLI_assert(r_operations->size() == graph->operations.size());
+}
+
+}  // namespace
+
+void deg_eval_critical_path_update_priorities(Depsgraph *graph)
+{
+	vector<OperationNode *> operations;
+	operations_sort_children_first(graph, &operations);
+	for (OperationNode *op_node : operations) {
+		const Node::Stats &stats = op_node->stats;
+		const double time = (stats.num_evaluations != 0) ?
+		                            stats.total_time / stats.num_evaluations :
+		                            DEFAULT_OPERATION_TIME;
+		float children_priority = 0.0f;
+		foreach_child_operation(op_node, [&](OperationNode *op_to) {
+			children_priority = std::max(children_priority, op_to->priority);
+		});
+		op_node->priority = children_priority + (float)time;
+	}
+}
+
+double deg_eval_critical_path_time(Depsgraph *graph)
+{
+	vector<OperationNode *> operations;
+	operations_sort_children_first(graph, &operations);
+	/* Path times are stored by operation index in the children first order. */
+	vector<double> path_times(operations.size());
+	double critical_path_time = 0.0;
+	for (size_t i = 0; i < operations.size(); i++) {
+		OperationNode *op_node = operations[i];
+		double children_time = 0.0;
+		foreach_child_operation(op_node, [&](OperationNode *op_to) {
+			children_time = std::max(children_time, path_times[op_to->custom_flags]);
+		});
+		op_node->custom_flags = (int)i;
+		path_times[i] = children_time + op_node->stats.current_time;
+		critical_path_time = std::max(critical_path_time, path_times[i]);
+	}
+	return critical_path_time;
+}
+
+}  // namespace DEG
@@ -0,0 +1,40 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2019 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#pragma once
+
+namespace DEG {
+
+struct Depsgraph;
+
+/* Update priorities of all operations to the estimated time of the longest
+ * chain of operations starting at them, using average timings of previous
+ * evaluations when they are known. */
+void deg_eval_critical_path_update_priorities(Depsgraph *graph);
+
+/* Time of the longest chain of operations evaluated by the last update.
+ * This is a lower bound for the evaluation time, no matter how many threads
+ * are used. Requires stats to be gathered. */
+double deg_eval_critical_path_time(Depsgraph *graph);
+
+}  // namespace DEG
@@ -0,0 +1,680 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2019 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ *
+ * During playback the frames following the current one are evaluated in a
+ * background thread, each one on its own copy of the dependency graph. When
+ * playback reaches such a frame, nodes of the copy are swapped with the ones
+ * of the graph used by the interface, and the copy is reused for one of the
+ * next frames.
+ *
+ * Copies are built by the background thread too, which reads original data
+ * while doing so. Anything changing original data outside of the evaluation
+ * waits for the build to finish first, see DEG_lookahead_wait_all(). Any
+ * change to the original data makes copies out of date: they are discarded
+ * and built again from the next frame change on.
+ *
+ * Building a copy takes about as long as evaluating a frame. Copies are only
+ * built on frame changes which took a frame evaluated ahead, and only when
+ * building the previous copy took no longer than the evaluation of a frame,
+ * so the interface does not wait for it.
+ *
+ * Evaluation of copies does not change original data. What an active graph
+ * copies back to it during evaluation is kept (see DEG_sync_to_original())
+ * and done once the frame is used.
+ */
+
+#include "intern/eval/deg_eval_lookahead.h"
+
+#include <cmath>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_listbase.h"
+#include "BLI_ghash.h"
+#include "BLI_threads.h"
+
+#include "PIL_time.h"
+
+#include "BKE_mesh.h"
+
+#include "DNA_customdata_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "DEG_depsgraph.h"
+#include "DEG_depsgraph_build.h"
+#include "DEG_depsgraph_debug.h"
+
+#include "intern/eval/deg_eval.h"
+#include "intern/eval/deg_eval_copy_on_write.h"
+#include "intern/node/deg_node.h"
+#include "intern/node/deg_node_id.h"
+#include "intern/node/deg_node_operation.h"
+#include "intern/depsgraph.h"
+
+namespace DEG {
+
+namespace {
+
+enum class LookaheadState {
+	/* Copy is not used for any frame. */
+	FREE,
+	/* Copy is tagged for the frame, waiting for the background thread. */
+	QUEUED,
+	EVALUATING,
+	READY,
+};
+
+struct LookaheadFrame {
+	Depsgraph *graph;
+	LookaheadState state;
+	/* Frame the copy is evaluated for, when not free. */
+	float ctime;
+	/* Queued frames are evaluated in increasing order. */
+	int order;
+	/* Memory of the evaluated data, measured after each evaluation of the
+	 * copy, zero until it is evaluated. */
+	size_t memory;
+};
+
+}  // namespace
+
+struct Lookahead {
+	Main *bmain;
+	/* Graph used by the interface, which copies are made of. */
+	Depsgraph *graph;
+	int num_frames;
+	size_t memory_limit;
+
+	/* Copies, state of every frame is protected by the mutex. */
+	vector<LookaheadFrame *> frames;
+	ThreadMutex mutex;
+	/* Signaled when frames are queued or evaluated. */
+	ThreadCondition condition;
+	ListBase threads;
+	bool is_thread_running;
+	bool stop;
+	/* A copy is built by the background thread for the frame, and queued with
+	 * the given order once built. The build is requested until the thread
+	 * starts it, and in progress until the copy is queued. */
+	bool is_build_requested;
+	bool is_building;
+	float build_ctime;
+	int build_order;
+
+	/* Original data was changed since copies were made. */
+	bool is_valid;
+	/* Whether the graph can be evaluated on copies, checked again once the
+	 * copies are discarded. */
+	bool need_support_check;
+	bool is_supported;
+	/* Adding another copy would exceed the memory limit. */
+	bool is_memory_full;
+	/* Copies are only built again once the data did not change for a frame,
+	 * so they are not rebuilt on every frame while the data is animated by
+	 * other means, like handlers. */
+	int num_frames_unchanged;
+
+	/* Playback direction, guessed from previous frame changes. */
+	float last_ctime;
+	int direction;
+
+	/* Time it took to build the last copy, and to evaluate the last frame
+	 * which was not evaluated ahead, in seconds. Build time is protected by
+	 * the mutex. */
+	double build_time;
+	double eval_time;
+};
+
+static bool lookahead_frame_matches(const LookaheadFrame *frame, float ctime)
+{
+	return fabsf(frame->ctime - ctime) < 1e-4f;
+}
+
+static size_t lookahead_customdata_memory_get(const CustomData *data)
+{
+	size_t memory = 0;
+	for (int i = 0; i < data->totlayer; i++) {
+		const CustomDataLayer *layer = &data->layers[i];
+		/* Layers referencing or shared with original data are not owned. */
+		if (layer->data != NULL &&
+		    (layer->flag & CD_FLAG_NOFREE) == 0 &&
+		    layer->shared == NULL)
+		{
+			memory += MEM_allocN_len(layer->data);
+		}
+	}
+	return memory;
+}
+
+/* Geometry of the mesh and the GPU buffers drawing it. The buffers of copies
+ * are freed when they are evaluated, but a copy takes the buffers drawn for
+ * the previous frame with its nodes, and keeps them until it is evaluated
+ * again. */
+static size_t lookahead_mesh_memory_get(const Mesh *mesh)
+{
+	return (lookahead_customdata_memory_get(&mesh->vdata) +
+	        lookahead_customdata_memory_get(&mesh->edata) +
+	        lookahead_customdata_memory_get(&mesh->fdata) +
+	        lookahead_customdata_memory_get(&mesh->ldata) +
+	        lookahead_customdata_memory_get(&mesh->pdata) +
+	        BKE_mesh_batch_cache_memory_get(const_cast<Mesh *>(mesh)));
+}
+
+/* Memory of the datablocks evaluated by a graph, of the geometry they own and
+ * of the meshes drawn. Other run-time data and the nodes of the graph are not
+ * counted. */
+static size_t lookahead_graph_memory_get(const Depsgraph *graph)
+{
+	size_t memory = 0;
+	for (const IDNode *id_node : graph->id_nodes) {
+		const ID *id_cow = id_node->id_cow;
+		if (id_cow == id_node->id_orig ||
+		    !deg_copy_on_write_is_expanded(id_cow))
+		{
+			continue;
+		}
+		memory += MEM_allocN_len(id_cow);
+		switch (GS(id_cow->name)) {
+			case ID_ME:
+				memory += lookahead_mesh_memory_get((const Mesh *)id_cow);
+				break;
+			case ID_OB:
+			{
+				const Object *object = (const Object *)id_cow;
+				const Mesh *mesh_eval = object->runtime.mesh_eval;
+				const Mesh *mesh_deform_eval = object->runtime.mesh_deform_eval;
+				if (mesh_eval != NULL) {
+					memory += MEM_allocN_len(mesh_eval) +
+					          lookahead_mesh_memory_get(mesh_eval);
+				}
+				if (mesh_deform_eval != NULL && mesh_deform_eval != mesh_eval) {
+					memory += MEM_allocN_len(mesh_deform_eval) +
+					          lookahead_mesh_memory_get(mesh_deform_eval);
+				}
+				break;
+			}
+			default:
+				break;
+		}
+	}
+	return memory;
+}
+
+/* Build a new copy of the graph, with datablocks copied for the frame. */
+static LookaheadFrame *lookahead_frame_build(Lookahead *lookahead, float ctime)
+{
+	const Depsgraph *graph = lookahead->graph;
+	::Depsgraph *copy = DEG_graph_new(graph->scene,
+	                                  graph->view_layer,
+	                                  graph->mode);
+	DEG_debug_name_set(copy, (graph->debug_name + " :: lookahead").c_str());
+	Depsgraph *deg_copy = reinterpret_cast<Depsgraph *>(copy);
+	deg_copy->is_lookahead = true;
+	DEG_graph_build_from_view_layer(copy,
+	                                lookahead->bmain,
+	                                graph->scene,
+	                                graph->view_layer);
+	deg_evaluate_prepare_framechange(lookahead->bmain, deg_copy, ctime);
+	deg_evaluate_copy_on_write_stage(deg_copy);
+	LookaheadFrame *frame = OBJECT_GUARDED_NEW(LookaheadFrame);
+	frame->graph = deg_copy;
+	frame->state = LookaheadState::FREE;
+	frame->ctime = ctime;
+	frame->order = 0;
+	frame->memory = 0;
+	return frame;
+}
+
+static void *lookahead_thread_func(void *lookahead_v)
+{
+	Lookahead *lookahead = (Lookahead *)lookahead_v;
+	BLI_mutex_lock(&lookahead->mutex);
+	while (!lookahead->stop) {
+		if (lookahead->is_build_requested) {
+			lookahead->is_build_requested = false;
+			const float ctime = lookahead->build_ctime;
+			BLI_mutex_unlock(&lookahead->mutex);
+			const double start_time = PIL_check_seconds_timer();
+			LookaheadFrame *frame = lookahead_frame_build(lookahead, ctime);
+			const double build_time = PIL_check_seconds_timer() - start_time;
+			BLI_mutex_lock(&lookahead->mutex);
+			frame->order = lookahead->build_order;
+			frame->state = LookaheadState::QUEUED;
+			lookahead->frames.push_back(frame);
+			lookahead->build_time = build_time;
+			lookahead->is_building = false;
+			BLI_condition_notify_all(&lookahead->condition);
+			continue;
+		}
+		LookaheadFrame *next_frame = NULL;
+		for (LookaheadFrame *frame : lookahead->frames) {
+			if (frame->state == LookaheadState::QUEUED &&
+			    (next_frame == NULL || frame->order < next_frame->order))
+			{
+				next_frame = frame;
+			}
+		}
+		if (next_frame == NULL) {
+			BLI_condition_wait(&lookahead->condition, &lookahead->mutex);
+			continue;
+		}
+		next_frame->state = LookaheadState::EVALUATING;
+		BLI_mutex_unlock(&lookahead->mutex);
+		/* Kept from a frame which was not used. */
+		next_frame->graph->sync_to_original_clear();
+		deg_evaluate_on_refresh(next_frame->graph);
+		const size_t memory = lookahead_graph_memory_get(next_frame->graph);
+		BLI_mutex_lock(&lookahead->mutex);
+		next_frame->memory = memory;
+		next_frame->state = LookaheadState::READY;
+		BLI_condition_notify_all(&lookahead->condition);
+	}
+	BLI_mutex_unlock(&lookahead->mutex);
+	return NULL;
+}
+
+static void lookahead_thread_start(Lookahead *lookahead)
+{
+	if (lookahead->is_thread_running) {
+		return;
+	}
+	lookahead->stop = false;
+	BLI_threadpool_init(&lookahead->threads, lookahead_thread_func, 1);
+	BLI_threadpool_insert(&lookahead->threads, lookahead);
+	lookahead->is_thread_running = true;
+}
+
+/* Wait for the background thread to finish the frame it is evaluating or the
+ * copy it is building. */
+static void lookahead_thread_stop(Lookahead *lookahead)
+{
+	if (!lookahead->is_thread_running) {
+		return;
+	}
+	BLI_mutex_lock(&lookahead->mutex);
+	lookahead->stop = true;
+	BLI_condition_notify_all(&lookahead->condition);
+	BLI_mutex_unlock(&lookahead->mutex);
+	BLI_threadpool_end(&lookahead->threads);
+	lookahead->is_thread_running = false;
+	/* A build which was not started yet is dropped. */
+	lookahead->is_build_requested = false;
+	lookahead->is_building = false;
+}
+
+static void lookahead_discard(Lookahead *lookahead)
+{
+	lookahead_thread_stop(lookahead);
+	for (LookaheadFrame *frame : lookahead->frames) {
+		DEG_graph_free(reinterpret_cast<::Depsgraph *>(frame->graph));
+		OBJECT_GUARDED_DELETE(frame, LookaheadFrame);
+	}
+	lookahead->frames.clear();
+	lookahead->is_valid = true;
+	lookahead->need_support_check = true;
+	lookahead->is_memory_full = false;
+	lookahead->num_frames_unchanged = 0;
+}
+
+/* Simulations depend on the previous frame and write their caches to the
+ * original data, and edit or paint modes keep their runtime data in original
+ * objects. */
+static bool lookahead_is_supported(const Depsgraph *graph)
+{
+	for (const OperationNode *node : graph->operations) {
+		switch (node->opcode) {
+			case OperationCode::RIGIDBODY_SIM:
+			case OperationCode::PARTICLE_SYSTEM_EVAL:
+			case OperationCode::POINT_CACHE_RESET:
+			case OperationCode::FILE_CACHE_UPDATE:
+				return false;
+			default:
+				break;
+		}
+	}
+	const Object *object_active = OBACT(graph->view_layer);
+	if (object_active != NULL && (object_active->mode & ~OB_MODE_POSE)) {
+		return false;
+	}
+	return true;
+}
+
+/* Frame which is the given number of steps ahead of the current one,
+ * wrapped around the playback range. */
+static float lookahead_frame_get(const Lookahead *lookahead,
+                                 const Scene *scene,
+                                 float ctime,
+                                 int step)
+{
+	const float start = (float)PSFRA;
+	const float end = (float)PEFRA;
+	float frame = ctime + (float)(step * lookahead->direction);
+	if (end > start) {
+		const float length = end - start + 1.0f;
+		if (frame > end) {
+			frame -= length;
+		}
+		else if (frame < start) {
+			frame += length;
+		}
+	}
+	return frame;
+}
+
+/* Copies are of the same data, so every copy is expected to use as much
+ * memory as the largest one evaluated so far, or as the graph used by the
+ * interface. Called with the mutex locked. */
+static size_t lookahead_frame_memory_get(const Lookahead *lookahead,
+                                         size_t graph_memory)
+{
+	size_t memory = graph_memory;
+	for (const LookaheadFrame *frame : lookahead->frames) {
+		memory = max(memory, frame->memory);
+	}
+	return memory;
+}
+
+void deg_lookahead_enable(Main *bmain,
+                          Depsgraph *graph,
+                          int num_frames,
+                          size_t memory_limit)
+{
+	Lookahead *lookahead = graph->lookahead;
+	if (lookahead == NULL) {
+		lookahead = OBJECT_GUARDED_NEW(Lookahead);
+		lookahead->bmain = bmain;
+		lookahead->graph = graph;
+		lookahead->num_frames = 0;
+		lookahead->memory_limit = 0;
+		BLI_mutex_init(&lookahead->mutex);
+		BLI_condition_init(&lookahead->condition);
+		BLI_listbase_clear(&lookahead->threads);
+		lookahead->is_thread_running = false;
+		lookahead->stop = false;
+		lookahead->is_build_requested = false;
+		lookahead->is_building = false;
+		lookahead->build_ctime = 0.0f;
+		lookahead->build_order = 0;
+		lookahead->is_valid = true;
+		lookahead->need_support_check = true;
+		lookahead->is_supported = false;
+		lookahead->is_memory_full = false;
+		lookahead->num_frames_unchanged = 0;
+		lookahead->last_ctime = graph->ctime;
+		lookahead->direction = 1;
+		lookahead->build_time = 0.0;
+		lookahead->eval_time = 0.0;
+		graph->lookahead = lookahead;
+	}
+	BLI_assert(lookahead->bmain == bmain);
+	if (memory_limit < lookahead->memory_limit ||
+	    num_frames < lookahead->num_frames)
+	{
+		lookahead_discard(lookahead);
+	}
+	lookahead->num_frames = num_frames;
+	lookahead->memory_limit = memory_limit;
+	lookahead->is_memory_full = false;
+}
+
+void deg_lookahead_free(Depsgraph *graph)
+{
+	Lookahead *lookahead = graph->lookahead;
+	if (lookahead == NULL) {
+		return;
+	}
+	lookahead_discard(lookahead);
+	BLI_condition_end(&lookahead->condition);
+	BLI_mutex_end(&lookahead->mutex);
+	OBJECT_GUARDED_DELETE(lookahead, Lookahead);
+	graph->lookahead = NULL;
+}
+
+void deg_lookahead_invalidate(Depsgraph *graph)
+{
+	if (graph->lookahead != NULL) {
+		graph->lookahead->is_valid = false;
+	}
+}
+
+void deg_lookahead_cancel(Depsgraph *graph)
+{
+	if (graph->lookahead != NULL) {
+		lookahead_discard(graph->lookahead);
+	}
+}
+
+void deg_lookahead_wait_build(Depsgraph *graph)
+{
+	Lookahead *lookahead = graph->lookahead;
+	if (lookahead == NULL) {
+		return;
+	}
+	BLI_mutex_lock(&lookahead->mutex);
+	while (lookahead->is_building) {
+		BLI_condition_wait(&lookahead->condition, &lookahead->mutex);
+	}
+	BLI_mutex_unlock(&lookahead->mutex);
+}
+
+bool deg_lookahead_use_frame(Depsgraph *graph, float ctime)
+{
+	Lookahead *lookahead = graph->lookahead;
+	if (!lookahead->is_valid ||
+	    graph->need_update ||
+	    BLI_gset_len(graph->entry_tags) != 0)
+	{
+		lookahead_discard(lookahead);
+		return false;
+	}
+	LookaheadFrame *ready_frame = NULL;
+	BLI_mutex_lock(&lookahead->mutex);
+	for (LookaheadFrame *frame : lookahead->frames) {
+		if (ELEM(frame->state,
+		         LookaheadState::EVALUATING,
+		         LookaheadState::READY) &&
+		    lookahead_frame_matches(frame, ctime))
+		{
+			ready_frame = frame;
+			break;
+		}
+	}
+	if (ready_frame != NULL) {
+		while (ready_frame->state != LookaheadState::READY) {
+			BLI_condition_wait(&lookahead->condition, &lookahead->mutex);
+		}
+		/* The copy takes nodes of the previous frame. */
+		graph->swap_nodes(ready_frame->graph);
+		ready_frame->state = LookaheadState::FREE;
+	}
+	BLI_mutex_unlock(&lookahead->mutex);
+	if (ready_frame == NULL) {
+		return false;
+	}
+	/* Do what the active graph does during evaluation, copy evaluated data
+	 * needed by the interface to the original datablocks. */
+	if (graph->is_active) {
+		ready_frame->graph->sync_to_original_flush(graph);
+	}
+	else {
+		ready_frame->graph->sync_to_original_clear();
+	}
+	return true;
+}
+
+void deg_lookahead_schedule(Depsgraph *graph, float ctime, double eval_time)
+{
+	Lookahead *lookahead = graph->lookahead;
+	const Scene *scene = graph->scene;
+	/* Frames following the previous one by more than the lookahead distance
+	 * are considered a jump, not a change of direction. */
+	const float delta = ctime - lookahead->last_ctime;
+	if (delta != 0.0f && fabsf(delta) <= (float)lookahead->num_frames) {
+		lookahead->direction = (delta > 0.0f) ? 1 : -1;
+	}
+	lookahead->last_ctime = ctime;
+	/* A frame evaluated ahead saves the time of an evaluation, which can be
+	 * spent on building a copy instead. */
+	double build_time_available = 0.0;
+	if (eval_time > 0.0) {
+		lookahead->eval_time = eval_time;
+	}
+	else {
+		build_time_available = lookahead->eval_time;
+	}
+	if (lookahead->need_support_check) {
+		lookahead->is_supported = lookahead_is_supported(graph);
+		lookahead->need_support_check = false;
+	}
+	if (!lookahead->is_valid || !lookahead->is_supported) {
+		return;
+	}
+	if (lookahead->num_frames_unchanged++ == 0) {
+		return;
+	}
+	vector<float> frames_ahead;
+	for (int step = 1; step <= lookahead->num_frames; step++) {
+		frames_ahead.push_back(
+		        lookahead_frame_get(lookahead, scene, ctime, step));
+	}
+	/* Cancel frames which are not ahead anymore (after a jump to another
+	 * frame), and find which frames are still to be queued. */
+	vector<int> steps_to_queue;
+	vector<LookaheadFrame *> frames_to_free;
+	const size_t graph_memory = lookahead_graph_memory_get(graph);
+	BLI_mutex_lock(&lookahead->mutex);
+	for (LookaheadFrame *frame : lookahead->frames) {
+		if (!ELEM(frame->state,
+		          LookaheadState::QUEUED,
+		          LookaheadState::READY))
+		{
+			continue;
+		}
+		bool is_ahead = false;
+		for (const float frame_ahead : frames_ahead) {
+			is_ahead |= lookahead_frame_matches(frame, frame_ahead);
+		}
+		if (!is_ahead) {
+			frame->state = LookaheadState::FREE;
+		}
+	}
+	/* Evaluation might have made copies larger than the memory limit allows,
+	 * free copies which are not used for a frame until they fit. The memory
+	 * of the graph used by the interface is known before any copy is built,
+	 * so no copy is built when a single one does not fit. */
+	const size_t frame_memory = lookahead_frame_memory_get(lookahead,
+	                                                       graph_memory);
+	while ((lookahead->frames.size() + lookahead->is_building) * frame_memory >
+	       lookahead->memory_limit)
+	{
+		auto it = lookahead->frames.begin();
+		while (it != lookahead->frames.end() &&
+		       (*it)->state != LookaheadState::FREE)
+		{
+			++it;
+		}
+		if (it == lookahead->frames.end()) {
+			break;
+		}
+		frames_to_free.push_back(*it);
+		lookahead->frames.erase(it);
+		lookahead->is_memory_full = true;
+	}
+	for (int i = 0; i < frames_ahead.size(); i++) {
+		bool is_queued = false;
+		for (LookaheadFrame *frame : lookahead->frames) {
+			if (frame->state != LookaheadState::FREE &&
+			    lookahead_frame_matches(frame, frames_ahead[i]))
+			{
+				frame->order = i;
+				is_queued = true;
+			}
+		}
+		if (lookahead->is_building &&
+		    fabsf(lookahead->build_ctime - frames_ahead[i]) < 1e-4f)
+		{
+			lookahead->build_order = i;
+			is_queued = true;
+		}
+		if (!is_queued) {
+			steps_to_queue.push_back(i);
+		}
+	}
+	BLI_mutex_unlock(&lookahead->mutex);
+	for (LookaheadFrame *frame : frames_to_free) {
+		DEG_graph_free(reinterpret_cast<::Depsgraph *>(frame->graph));
+		OBJECT_GUARDED_DELETE(frame, LookaheadFrame);
+	}
+	/* Queue the missing frames on free copies. The background thread never
+	 * accesses free copies, so they are prepared without locking. At most one
+	 * copy is built at a time, within the time available for it, and queued
+	 * by the background thread once built. */
+	for (const int i : steps_to_queue) {
+		LookaheadFrame *free_frame = NULL;
+		BLI_mutex_lock(&lookahead->mutex);
+		for (LookaheadFrame *frame : lookahead->frames) {
+			if (frame->state == LookaheadState::FREE) {
+				free_frame = frame;
+				break;
+			}
+		}
+		if (free_frame == NULL) {
+			const size_t num_copies = lookahead->frames.size() + lookahead->is_building;
+			if ((num_copies + 1) * frame_memory > lookahead->memory_limit) {
+				lookahead->is_memory_full = true;
+			}
+			/* The first copy is built regardless of the time, as no frame is
+			 * evaluated ahead without it. */
+			const bool is_build_time_available =
+			        num_copies == 0 || lookahead->build_time <= build_time_available;
+			if (!lookahead->is_building &&
+			    !lookahead->is_memory_full &&
+			    is_build_time_available)
+			{
+				lookahead->is_build_requested = true;
+				lookahead->is_building = true;
+				lookahead->build_ctime = frames_ahead[i];
+				lookahead->build_order = i;
+			}
+			BLI_mutex_unlock(&lookahead->mutex);
+			break;
+		}
+		BLI_mutex_unlock(&lookahead->mutex);
+		deg_evaluate_prepare_framechange(lookahead->bmain,
+		                                 free_frame->graph,
+		                                 frames_ahead[i]);
+		BLI_mutex_lock(&lookahead->mutex);
+		free_frame->ctime = frames_ahead[i];
+		free_frame->order = i;
+		free_frame->state = LookaheadState::QUEUED;
+		BLI_mutex_unlock(&lookahead->mutex);
+	}
+	BLI_mutex_lock(&lookahead->mutex);
+	BLI_condition_notify_all(&lookahead->condition);
+	BLI_mutex_unlock(&lookahead->mutex);
+	lookahead_thread_start(lookahead);
+}
+
+}  // namespace DEG
@@ -0,0 +1,63 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2019 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ *
+ * Evaluation of following frames ahead of time during playback.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+struct Main;
+
+namespace DEG {
+
+struct Depsgraph;
+
+/* Start evaluating frames ahead for the graph, or change settings when it
+ * already does. */
+void deg_lookahead_enable(Main *bmain,
+                          Depsgraph *graph,
+                          int num_frames,
+                          size_t memory_limit);
+/* Stop the background evaluation and free all copies. */
+void deg_lookahead_free(Depsgraph *graph);
+
+/* Original data changed, copies are out of date and will be discarded on the
+ * next frame change. */
+void deg_lookahead_invalidate(Depsgraph *graph);
+/* Same as above, but also waits for the background evaluation to stop, for
+ * when original data is about to be freed. */
+void deg_lookahead_cancel(Depsgraph *graph);
+/* Wait until the background thread is done building a copy from original
+ * data. */
+void deg_lookahead_wait_build(Depsgraph *graph);
+
+/* Replace nodes of the graph with a copy evaluated for the given frame.
+ * Returns false if there is no such copy, in which case the frame is to be
+ * evaluated as usual. */
+bool deg_lookahead_use_frame(Depsgraph *graph, float ctime);
+/* Queue evaluation of frames following the current one. The evaluation time
+ * of the current frame is in seconds, zero when it was evaluated ahead. */
+void deg_lookahead_schedule(Depsgraph *graph, float ctime, double eval_time);
+
+}  // namespace DEG
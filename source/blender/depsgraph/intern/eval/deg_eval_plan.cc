@@ -0,0 +1,100 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2019 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#include "intern/eval/deg_eval_plan.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+
+#include "intern/depsgraph.h"
+
+#include "intern/node/deg_node.h"
+#include "intern/node/deg_node_component.h"
+#include "intern/node/deg_node_operation.h"
+
+namespace DEG {
+
+ExecutionPlan::ExecutionPlan(Depsgraph *graph)
+        : operations(graph->operations)
+{
+	const int num_operations = operations.size();
+	flags.resize(num_operations);
+	num_links_pending.resize(num_operations);
+	scheduled.resize(num_operations);
+	for (int i = 0; i < num_operations; i++) {
+		OperationNode *op_node = operations[i];
+		const ComponentNode *comp_node = op_node->owner;
+		uint8_t flag = 0;
+		if (comp_node->type == NodeType::COPY_ON_WRITE) {
+			flag |= OPERATION_COPY_ON_WRITE | OPERATION_VISIBLE;
+		}
+		else if (comp_node->affects_directly_visible) {
+			flag |= OPERATION_VISIBLE;
+		}
+		if (op_node->is_noop()) {
+			flag |= OPERATION_NOOP;
+		}
+		flags[i] = flag;
+		/* Index lookup for the relations below. */
+		op_node->custom_flags = i;
+	}
+	parents_offsets.reserve(num_operations + 1);
+	children_offsets.reserve(num_operations + 1);
+	for (OperationNode *op_node : operations) {
+		parents_offsets.push_back(parents.size());
+		for (Relation *rel : op_node->inlinks) {
+			if (rel->from->type == NodeType::OPERATION &&
+			    (rel->flag & RELATION_FLAG_CYCLIC) == 0)
+			{
+				parents.push_back(rel->from->custom_flags);
+			}
+		}
+		children_offsets.push_back(children.size());
+		for (Relation *rel : op_node->outlinks) {
+			BLI_assert(rel->to->type == NodeType::OPERATION);
+			if ((rel->flag & RELATION_FLAG_CYCLIC) == 0) {
+				children.push_back(rel->to->custom_flags);
+			}
+		}
+	}
+	parents_offsets.push_back(parents.size());
+	children_offsets.push_back(children.size());
+}
+
+void deg_eval_plan_ensure(Depsgraph *graph)
+{
+	if (graph->execution_plan == NULL) {
+		graph->execution_plan = OBJECT_GUARDED_NEW(ExecutionPlan, graph);
+	}
+}
+
+void deg_eval_plan_clear(Depsgraph *graph)
+{
+	if (graph->execution_plan != NULL) {
+		OBJECT_GUARDED_DELETE(graph->execution_plan, ExecutionPlan);
+		graph->execution_plan = NULL;
+	}
+}
+
+}  // namespace DEG
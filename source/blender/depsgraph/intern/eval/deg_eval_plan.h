@@ -0,0 +1,84 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2019 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ */
+
+#pragma once
+
+#include "intern/depsgraph_type.h"
+
+namespace DEG {
+
+struct Depsgraph;
+struct OperationNode;
+
+/* Compact copy of operations and relations between them, used by the
+ * evaluation instead of following pointers of every node and relation.
+ *
+ * Operations are referred to by their index in Depsgraph::operations, and
+ * relations are stored in the compressed sparse row layout: operation with
+ * index i depends on parents[parents_offsets[i]] up to (excluding)
+ * parents[parents_offsets[i + 1]], the same goes for children.
+ * Cyclic relations are not stored since evaluation ignores them.
+ *
+ * The topology does not change once the plan is built, only evaluation
+ * state is modified by every evaluation. */
+struct ExecutionPlan {
+	enum OperationFlag {
+		/* Operation belongs to a visible component (or a copy-on-write one,
+		 * which are always evaluated). */
+		OPERATION_VISIBLE       = (1 << 0),
+		OPERATION_COPY_ON_WRITE = (1 << 1),
+		OPERATION_NOOP          = (1 << 2),
+		/* Copy of DEPSOP_FLAG_NEEDS_UPDATE, updated when evaluation starts. */
+		OPERATION_NEEDS_UPDATE  = (1 << 3),
+	};
+
+	ExecutionPlan(Depsgraph *graph);
+
+	int num_operations() const { return operations.size(); }
+
+	vector<OperationNode *> operations;
+	/* OperationFlag of every operation. */
+	vector<uint8_t> flags;
+
+	vector<int> parents_offsets;
+	vector<int> parents;
+	vector<int> children_offsets;
+	vector<int> children;
+
+	/* Evaluation state. */
+	/* How many parents are still to be evaluated, modified atomically. */
+	vector<uint32_t> num_links_pending;
+	vector<uint8_t> scheduled;
+
+	/* Names of operations in the evaluation trace, only filled in when the
+	 * evaluation is traced. */
+	vector<const char *> trace_names;
+};
+
+/* Build execution plan of the graph if it has none. */
+void deg_eval_plan_ensure(Depsgraph *graph);
+/* Free execution plan, needs to be called when operations or relations
+ * between them are modified. */
+void deg_eval_plan_clear(Depsgraph *graph);
+
+}  // namespace DEG
@@ -27,6 +27,7 @@
 #include "BLI_ghash.h"
 
 #include "intern/depsgraph.h"
+#include "intern/eval/deg_eval_plan.h"
 
 #include "intern/node/deg_node.h"
 #include "intern/node/deg_node_component.h"
@@ -48,8 +49,15 @@ void deg_eval_stats_aggregate(Depsgraph *graph)
 		GHASH_FOREACH_END();
 		id_node->stats.reset_current();
 	}
-	/* Now accumulate operation timings to components and IDs. */
-	for (OperationNode *op_node : graph->operations) {
+	/* Now accumulate operation timings to components and IDs, and to the
+	 * operation averages used for scheduling priorities. */
+	const ExecutionPlan *plan = graph->execution_plan;
+	for (int i = 0; i < plan->num_operations(); i++) {
+		OperationNode *op_node = plan->operations[i];
+		if (plan->scheduled[i]) {
+			op_node->stats.total_time += op_node->stats.current_time;
+			op_node->stats.num_evaluations++;
+		}
 		ComponentNode *comp_node = op_node->owner;
 		IDNode *id_node = comp_node->owner;
 		id_node->stats.current_time += op_node->stats.current_time;
@@ -0,0 +1,406 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2019 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ *
+ * Evaluation of all dependency graphs is recorded into a single ring buffer
+ * of fixed size, so only the most recent events are kept. Threads reserve a
+ * slot with an atomic increment and never wait for each other. A slot is
+ * written like a sequence lock: its sequence is marked while the fields are
+ * written, and set once they are, so the writer of the trace can tell apart
+ * events which were written completely.
+ *
+ * Recorded events are written in the Chrome trace event format, which can be
+ * opened in chrome://tracing or in Perfetto. Every graph is shown as its own
+ * process, with a track for every thread which evaluated it.
+ */
+
+#include "intern/eval/deg_eval_trace.h"
+
+#include <atomic>
+#include <cstdio>
+#include <map>
+
+#include "MEM_guardedalloc.h"
+
+#include "PIL_time.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_fileops.h"
+#include "BLI_ghash.h"
+#include "BLI_string.h"
+#include "BLI_threads.h"
+
+#include "DNA_layer_types.h"
+
+#include "DEG_depsgraph_debug.h"
+
+#include "intern/eval/deg_eval_plan.h"
+#include "intern/node/deg_node.h"
+#include "intern/node/deg_node_component.h"
+#include "intern/node/deg_node_operation.h"
+#include "intern/depsgraph.h"
+
+namespace DEG {
+
+namespace {
+
+/* Must be a power of two. */
+#define TRACE_MAX_EVENTS (1 << 18)
+/* Sequence of a slot while its event is being written. */
+#define TRACE_SEQUENCE_WRITING UINT64_MAX
+
+enum class TraceEventType {
+	OPERATION,
+	UPDATE,
+};
+
+struct TraceEventData {
+	/* Trace the event was recorded for, see Trace::epoch. */
+	uint64_t epoch;
+	TraceEventType type;
+	int thread_id;
+	const Depsgraph *graph;
+	/* Interned name of the operation or graph. */
+	const char *name;
+	const char *category;
+	double ready_time;
+	double start_time;
+	double end_time;
+};
+
+/* Same as above, in a slot of the ring buffer. Fields are read while they
+ * might be written by another thread, so all of them are atomic. */
+struct TraceEvent {
+	/* Index of the event plus one once it is fully written, zero for a slot
+	 * which was never written. */
+	std::atomic<uint64_t> sequence;
+	std::atomic<uint64_t> epoch;
+	std::atomic<TraceEventType> type;
+	std::atomic<int> thread_id;
+	std::atomic<const Depsgraph *> graph;
+	std::atomic<const char *> name;
+	std::atomic<const char *> category;
+	std::atomic<double> ready_time;
+	std::atomic<double> start_time;
+	std::atomic<double> end_time;
+};
+
+struct Trace {
+	bool is_enabled = false;
+	double begin_time = 0.0;
+	TraceEvent *events = NULL;
+	/* Number of events recorded since the trace began, slot of the next
+	 * event is this modulo TRACE_MAX_EVENTS. */
+	std::atomic<uint64_t> num_events{0};
+	/* Incremented when the trace begins again. Slots keep events of earlier
+	 * traces, which are told apart by it. */
+	std::atomic<uint64_t> epoch{0};
+	/* Names of operations and graphs, kept until exit since execution plans
+	 * refer to them. */
+	GSet *names = NULL;
+	ThreadMutex names_mutex = BLI_MUTEX_INITIALIZER;
+	/* File the trace is written to on exit. */
+	char *exit_filepath = NULL;
+};
+
+Trace trace;
+
+const char *trace_name_intern(const char *name)
+{
+	BLI_mutex_lock(&trace.names_mutex);
+	if (trace.names == NULL) {
+		trace.names = BLI_gset_str_new("Depsgraph trace names");
+	}
+	void **key_p;
+	if (!BLI_gset_ensure_p_ex(trace.names, name, &key_p)) {
+		*key_p = BLI_strdup(name);
+	}
+	const char *result = (const char *)*key_p;
+	BLI_mutex_unlock(&trace.names_mutex);
+	return result;
+}
+
+void trace_event_add(const TraceEventData &data)
+{
+	const uint64_t index = trace.num_events.fetch_add(1, std::memory_order_relaxed);
+	TraceEvent *event = &trace.events[index & (TRACE_MAX_EVENTS - 1)];
+	/* Claim the slot. It is only being written when another thread reserved
+	 * it a whole ring ago and did not finish yet, in which case the event is
+	 * dropped. */
+	uint64_t sequence = event->sequence.load(std::memory_order_relaxed);
+	if (sequence == TRACE_SEQUENCE_WRITING ||
+	    !event->sequence.compare_exchange_strong(sequence,
+	                                             TRACE_SEQUENCE_WRITING,
+	                                             std::memory_order_relaxed))
+	{
+		return;
+	}
+	/* Readers see the slot claimed before any of the fields change. */
+	std::atomic_thread_fence(std::memory_order_release);
+	event->epoch.store(data.epoch, std::memory_order_relaxed);
+	event->type.store(data.type, std::memory_order_relaxed);
+	event->thread_id.store(data.thread_id, std::memory_order_relaxed);
+	event->graph.store(data.graph, std::memory_order_relaxed);
+	event->name.store(data.name, std::memory_order_relaxed);
+	event->category.store(data.category, std::memory_order_relaxed);
+	event->ready_time.store(data.ready_time, std::memory_order_relaxed);
+	event->start_time.store(data.start_time, std::memory_order_relaxed);
+	event->end_time.store(data.end_time, std::memory_order_relaxed);
+	/* Publish the fields. */
+	event->sequence.store(index + 1, std::memory_order_release);
+}
+
+/* Copy the event of the given index, returns false if the slot holds another
+ * event or is being written. */
+bool trace_event_read(const uint64_t index, TraceEventData *r_data)
+{
+	const TraceEvent *event = &trace.events[index & (TRACE_MAX_EVENTS - 1)];
+	if (event->sequence.load(std::memory_order_acquire) != index + 1) {
+		return false;
+	}
+	r_data->epoch = event->epoch.load(std::memory_order_relaxed);
+	r_data->type = event->type.load(std::memory_order_relaxed);
+	r_data->thread_id = event->thread_id.load(std::memory_order_relaxed);
+	r_data->graph = event->graph.load(std::memory_order_relaxed);
+	r_data->name = event->name.load(std::memory_order_relaxed);
+	r_data->category = event->category.load(std::memory_order_relaxed);
+	r_data->ready_time = event->ready_time.load(std::memory_order_relaxed);
+	r_data->start_time = event->start_time.load(std::memory_order_relaxed);
+	r_data->end_time = event->end_time.load(std::memory_order_relaxed);
+	/* The slot was not claimed by another writer while copying. */
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (event->sequence.load(std::memory_order_relaxed) != index + 1) {
+		return false;
+	}
+	return r_data->epoch == trace.epoch.load(std::memory_order_relaxed);
+}
+
+void trace_fprintf_escaped(FILE *f, const char *str)
+{
+	fputc('"', f);
+	for (const char *c = str; *c != '\0'; c++) {
+		if (*c == '"' || *c == '\\') {
+			fputc('\\', f);
+			fputc(*c, f);
+		}
+		else if ((unsigned char)*c < 0x20) {
+			fprintf(f, "\\u%04x", *c);
+		}
+		else {
+			fputc(*c, f);
+		}
+	}
+	fputc('"', f);
+}
+
+bool trace_write(const char *filepath)
+{
+	FILE *f = BLI_fopen(filepath, "w");
+	if (f == NULL) {
+		return false;
+	}
+	fprintf(f, "{\"traceEvents\":[\n");
+	/* Graphs are shown as processes, named after the last update of them. */
+	std::map<const Depsgraph *, int> graph_pids;
+	std::map<int, const char *> pid_names;
+	bool is_first = true;
+	if (trace.events != NULL) {
+		const uint64_t num_events = trace.num_events.load(std::memory_order_acquire);
+		const uint64_t first = (num_events > TRACE_MAX_EVENTS)
+		                               ? num_events - TRACE_MAX_EVENTS
+		                               : 0;
+		for (uint64_t index = first; index < num_events; index++) {
+			/* Skip events which are still being written, were overwritten
+			 * while copying or are left from an earlier trace. */
+			TraceEventData event;
+			if (!trace_event_read(index, &event)) {
+				continue;
+			}
+			auto it = graph_pids.find(event.graph);
+			int pid;
+			if (it == graph_pids.end()) {
+				pid = (int)graph_pids.size() + 1;
+				graph_pids[event.graph] = pid;
+			}
+			else {
+				pid = it->second;
+			}
+			if (!is_first) {
+				fprintf(f, ",\n");
+			}
+			is_first = false;
+			fprintf(f, "{\"name\":");
+			trace_fprintf_escaped(f, event.name);
+			fprintf(f,
+			        ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+			        "\"pid\":%d,\"tid\":%d",
+			        event.category,
+			        (event.start_time - trace.begin_time) * 1e6,
+			        (event.end_time - event.start_time) * 1e6,
+			        pid,
+			        event.thread_id);
+			if (event.type == TraceEventType::OPERATION) {
+				fprintf(f,
+				        ",\"args\":{\"wait_us\":%.3f}}",
+				        (event.start_time - event.ready_time) * 1e6);
+			}
+			else {
+				fprintf(f, "}");
+				pid_names[pid] = event.name;
+			}
+		}
+	}
+	for (const auto &it : pid_names) {
+		if (!is_first) {
+			fprintf(f, ",\n");
+		}
+		is_first = false;
+		fprintf(f,
+		        "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+		        "\"args\":{\"name\":",
+		        it.first);
+		trace_fprintf_escaped(f, it.second);
+		fprintf(f, "}}");
+	}
+	fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	fclose(f);
+	return true;
+}
+
+}  // namespace
+
+bool deg_eval_trace_is_enabled()
+{
+	return trace.is_enabled;
+}
+
+void deg_eval_trace_plan_ensure(ExecutionPlan *plan)
+{
+	if (!plan->trace_names.empty()) {
+		return;
+	}
+	const int num_operations = plan->num_operations();
+	plan->trace_names.resize(num_operations);
+	for (int i = 0; i < num_operations; i++) {
+		const OperationNode *op_node = plan->operations[i];
+		plan->trace_names[i] = trace_name_intern(
+		        op_node->full_identifier().c_str());
+	}
+}
+
+void deg_eval_trace_operation(const Depsgraph *graph,
+                              const ExecutionPlan *plan,
+                              const int index,
+                              const int thread_id,
+                              const double ready_time,
+                              const double start_time,
+                              const double end_time)
+{
+	TraceEventData event;
+	event.epoch = trace.epoch.load(std::memory_order_relaxed);
+	event.type = TraceEventType::OPERATION;
+	event.thread_id = thread_id;
+	event.graph = graph;
+	event.name = plan->trace_names[index];
+	event.category = nodeTypeAsString(plan->operations[index]->owner->type);
+	event.ready_time = ready_time;
+	event.start_time = start_time;
+	event.end_time = end_time;
+	trace_event_add(event);
+}
+
+void deg_eval_trace_update(const Depsgraph *graph,
+                           const double start_time,
+                           const double end_time)
+{
+	const char *name = !graph->debug_name.empty()
+	                           ? graph->debug_name.c_str()
+	                           : graph->view_layer->name;
+	TraceEventData event;
+	event.epoch = trace.epoch.load(std::memory_order_relaxed);
+	event.type = TraceEventType::UPDATE;
+	event.thread_id = 0;
+	event.graph = graph;
+	event.name = trace_name_intern(name);
+	event.category = "Update";
+	event.ready_time = start_time;
+	event.start_time = start_time;
+	event.end_time = end_time;
+	trace_event_add(event);
+}
+
+void deg_eval_trace_exit()
+{
+	trace.is_enabled = false;
+	if (trace.exit_filepath != NULL) {
+		if (!trace_write(trace.exit_filepath)) {
+			fprintf(stderr,
+			        "Failed to write depsgraph trace to '%s'\n",
+			        trace.exit_filepath);
+		}
+		MEM_freeN(trace.exit_filepath);
+		trace.exit_filepath = NULL;
+	}
+	if (trace.events != NULL) {
+		MEM_freeN(trace.events);
+		trace.events = NULL;
+	}
+	if (trace.names != NULL) {
+		BLI_gset_free(trace.names, MEM_freeN);
+		trace.names = NULL;
+	}
+}
+
+}  // namespace DEG
+
+void DEG_debug_trace_begin(void)
+{
+	if (DEG::trace.events == NULL) {
+		DEG::trace.events = (DEG::TraceEvent *)MEM_callocN(
+		        sizeof(DEG::TraceEvent) * TRACE_MAX_EVENTS,
+		        "Depsgraph trace events");
+	}
+	/* Events left in the buffer belong to the previous trace, they are
+	 * skipped by their epoch instead of clearing the buffer while threads
+	 * might still write to it. */
+	DEG::trace.epoch.fetch_add(1, std::memory_order_relaxed);
+	DEG::trace.num_events.store(0, std::memory_order_release);
+	DEG::trace.begin_time = PIL_check_seconds_timer();
+	DEG::trace.is_enabled = true;
+}
+
+void DEG_debug_trace_end(void)
+{
+	DEG::trace.is_enabled = false;
+}
+
+bool DEG_debug_trace_write(const char *filepath)
+{
+	return DEG::trace_write(filepath);
+}
+
+void DEG_debug_trace_write_on_exit(const char *filepath)
+{
+	if (DEG::trace.exit_filepath != NULL) {
+		MEM_freeN(DEG::trace.exit_filepath);
+	}
+	DEG::trace.exit_filepath = BLI_strdup(filepath);
+}
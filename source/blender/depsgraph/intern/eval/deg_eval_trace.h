@@ -0,0 +1,58 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2019 Blender Foundation.
+ * All rights reserved.
+ */
+
+/** \file
+ * \ingroup depsgraph
+ *
+ * Timeline of evaluated operations, for the Chrome trace export.
+ */
+
+#pragma once
+
+namespace DEG {
+
+struct Depsgraph;
+struct ExecutionPlan;
+
+/* Whether evaluation is to be recorded, checked once when it starts. */
+bool deg_eval_trace_is_enabled();
+
+/* Make sure names of all operations of the plan are known to the trace. */
+void deg_eval_trace_plan_ensure(ExecutionPlan *plan);
+
+/* Record evaluation of an operation, safe to call from any thread.
+ * Times are in seconds, as given by PIL_check_seconds_timer(): ready_time is
+ * when all parents of the operation were evaluated, the difference to
+ * start_time is how long it waited for a thread. */
+void deg_eval_trace_operation(const Depsgraph *graph,
+                              const ExecutionPlan *plan,
+                              int index,
+                              int thread_id,
+                              double ready_time,
+                              double start_time,
+                              double end_time);
+/* Record a whole evaluation of the graph. */
+void deg_eval_trace_update(const Depsgraph *graph,
+                           double start_time,
+                           double end_time);
+
+/* Free all recorded events and names. */
+void deg_eval_trace_exit();
+
+}  // namespace DEG
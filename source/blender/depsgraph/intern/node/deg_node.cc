@@ -115,6 +115,8 @@ Node::Stats::Stats()
 void Node::Stats::reset()
 {
 	current_time = 0.0;
+	total_time = 0.0;
+	num_evaluations = 0;
 }
 
 void Node::Stats::reset_current()
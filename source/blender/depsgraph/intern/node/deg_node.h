@@ -148,6 +148,10 @@ struct Node {
 		void reset_current();
 		/* Time spend on this node during current graph evaluation. */
 		double current_time;
+		/* Accumulated time of all evaluations of this node which had stats
+		 * gathered, and number of such evaluations. */
+		double total_time;
+		int num_evaluations;
 	};
 	/* Relationships between nodes
 	 * The reason why all depsgraph nodes are descended from this type (apart
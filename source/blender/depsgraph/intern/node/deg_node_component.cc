@@ -220,6 +220,21 @@ OperationNode *ComponentNode::add_operation(const DepsEvalOperationCb& op,
                                                     const char *name,
                                                     int name_tag)
 {
+	if (operations_map == NULL) {
+		/* Component was finalized by a previous build, and the graph is now
+		 * being partially rebuilt. Bring it back to the building state. */
+		operations_map = BLI_ghash_new(comp_node_hash_key,
+		                               comp_node_hash_key_cmp,
+		                               "Depsgraph id hash");
+		for (OperationNode *op_node : operations) {
+			OperationIDKey *key = OBJECT_GUARDED_NEW(OperationIDKey,
+			                                         op_node->opcode,
+			                                         op_node->name.c_str(),
+			                                         op_node->name_tag);
+			BLI_ghash_insert(operations_map, key, op_node);
+		}
+		operations.clear();
+	}
 	OperationNode *op_node = find_operation(opcode, name, name_tag);
 	if (!op_node) {
 		DepsNodeFactory *factory = type_get_factory(NodeType::OPERATION);
@@ -339,6 +354,10 @@ OperationNode *ComponentNode::get_exit_operation()
 
 void ComponentNode::finalize_build(Depsgraph * /*graph*/)
 {
+	if (operations_map == NULL) {
+		/* Nothing was added since the previous build. */
+		return;
+	}
 	operations.reserve(BLI_ghash_len(operations_map));
 	GHASH_FOREACH_BEGIN(OperationNode *, op_node, operations_map)
 	{
@@ -141,6 +141,7 @@ const char *operationCodeAsString(OperationCode opcode)
 }
 
 OperationNode::OperationNode() :
+    priority(0.0f),
     name_tag(-1),
     flag(0)
 {
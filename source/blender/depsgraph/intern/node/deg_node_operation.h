@@ -243,6 +243,10 @@ struct OperationNode : public Node {
 	uint32_t num_links_pending;
 	bool scheduled;
 
+	/* Estimated time of the longest chain of operations starting with this
+	 * one, operations with higher priority are evaluated first. */
+	float priority;
+
 	/* Identifier for the operation being performed. */
 	OperationCode opcode;
 	int name_tag;
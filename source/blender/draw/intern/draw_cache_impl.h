@@ -51,6 +51,7 @@ void DRW_curve_batch_cache_free(struct Curve *cu);
 
 void DRW_mesh_batch_cache_dirty_tag(struct Mesh *me, int mode);
 void DRW_mesh_batch_cache_free(struct Mesh *me);
+size_t DRW_mesh_batch_cache_memory_get(struct Mesh *me);
 
 void DRW_lattice_batch_cache_dirty_tag(struct Lattice *lt, int mode);
 void DRW_lattice_batch_cache_free(struct Lattice *lt);
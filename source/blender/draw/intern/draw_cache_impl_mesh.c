@@ -2169,6 +2169,41 @@ void DRW_mesh_batch_cache_free(Mesh *me)
 	MEM_SAFE_FREE(me->runtime.batch_cache);
 }
 
+/* Size of the vertex and index buffers of the cache, in bytes. */
+size_t DRW_mesh_batch_cache_memory_get(Mesh *me)
+{
+	MeshBatchCache *cache = me->runtime.batch_cache;
+	size_t memory = 0;
+
+	for (int i = 0; i < sizeof(cache->ordered) / sizeof(void *); ++i) {
+		GPUVertBuf **vbo = (GPUVertBuf **)&cache->ordered;
+		if (vbo[i] != NULL) {
+			memory += GPU_vertbuf_size_get(vbo[i]);
+		}
+	}
+	for (int i = 0; i < sizeof(cache->edit) / sizeof(void *); ++i) {
+		GPUVertBuf **vbo = (GPUVertBuf **)&cache->edit;
+		if (vbo[i] != NULL) {
+			memory += GPU_vertbuf_size_get(vbo[i]);
+		}
+	}
+	for (int i = 0; i < sizeof(cache->ibo) / sizeof(void *); ++i) {
+		GPUIndexBuf **ibo = (GPUIndexBuf **)&cache->ibo;
+		if (ibo[i] != NULL) {
+			memory += GPU_indexbuf_size_get(ibo[i]);
+		}
+	}
+	if (cache->surf_per_mat_tris != NULL) {
+		for (int i = 0; i < cache->mat_len; ++i) {
+			if (cache->surf_per_mat_tris[i] != NULL) {
+				memory += GPU_indexbuf_size_get(cache->surf_per_mat_tris[i]);
+			}
+		}
+	}
+
+	return memory;
+}
+
 /* GPUBatch cache usage. */
 
 static void mesh_create_edit_vertex_loops(
@@ -2719,6 +2719,7 @@ void DRW_engines_register(void)
 
 		BKE_mesh_batch_cache_dirty_tag_cb = DRW_mesh_batch_cache_dirty_tag;
 		BKE_mesh_batch_cache_free_cb = DRW_mesh_batch_cache_free;
+		BKE_mesh_batch_cache_memory_get_cb = DRW_mesh_batch_cache_memory_get;
 
 		BKE_lattice_batch_cache_dirty_tag_cb = DRW_lattice_batch_cache_dirty_tag;
 		BKE_lattice_batch_cache_free_cb = DRW_lattice_batch_cache_free;
@@ -438,6 +438,11 @@ bool ED_mesh_color_ensure(struct Mesh *me, const char *name)
 		CustomData_add_layer_named(&me->ldata, CD_MLOOPCOL, CD_DEFAULT, NULL, me->totloop, name);
 		BKE_mesh_update_customdata_pointers(me, true);
 	}
+	else {
+		/* Callers paint the colors in place, they might be shared with evaluated copies. */
+		const CustomData_MeshMasks mask = {.lmask = CD_MASK_MLOOPCOL};
+		BKE_mesh_ensure_writable(me, &mask);
+	}
 
 	DEG_id_tag_update(&me->id, 0);
 
@@ -870,6 +875,11 @@ void MESH_OT_customdata_custom_splitnormals_clear(wmOperatorType *ot)
 void ED_mesh_update(Mesh *mesh, bContext *C, bool calc_edges, bool calc_edges_loose, bool calc_tessface)
 {
 	bool tessface_input = false;
+	const CustomData_MeshMasks mask = {.vmask = CD_MASK_MVERT, .emask = CD_MASK_MEDGE};
+
+	/* Normals and loose edge flags are written in place,
+	 * the layers might be shared with evaluated copies. */
+	BKE_mesh_ensure_writable(mesh, &mask);
 
 	if (mesh->totface > 0 && mesh->totpoly == 0) {
 		BKE_mesh_convert_mfaces_to_mpolys(mesh);
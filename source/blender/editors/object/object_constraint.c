@@ -1246,7 +1246,7 @@ void ED_object_constraint_dependency_update(Main *bmain, Object *ob)
 	if (ob->pose) {
 		object_pose_tag_update(bmain, ob);
 	}
-	DEG_relations_tag_update(bmain);
+	DEG_id_tag_relations_update(bmain, &ob->id);
 }
 
 void ED_object_constraint_tag_update(Main *bmain, Object *ob, bConstraint *con)
@@ -1277,7 +1277,7 @@ void ED_object_constraint_dependency_tag_update(Main *bmain, Object *ob, bConstr
 	if (ob->pose) {
 		object_pose_tag_update(bmain, ob);
 	}
-	DEG_relations_tag_update(bmain);
+	DEG_id_tag_relations_update(bmain, &ob->id);
 }
 
 static bool constraint_poll(bContext *C)
@@ -1303,7 +1303,7 @@ static int constraint_delete_exec(bContext *C, wmOperator *UNUSED(op))
 		ED_object_constraint_update(bmain, ob);
 
 		/* relatiols */
-		DEG_relations_tag_update(CTX_data_main(C));
+		DEG_id_tag_relations_update(CTX_data_main(C), &ob->id);
 
 		/* notifiers */
 		WM_event_add_notifier(C, NC_OBJECT | ND_CONSTRAINT | NA_REMOVED, ob);
@@ -1841,7 +1841,7 @@ static int constraint_add_exec(bContext *C, wmOperator *op, Object *ob, ListBase
 
 
 	/* force depsgraph to get recalculated since new relationships added */
-	DEG_relations_tag_update(bmain);
+	DEG_id_tag_relations_update(bmain, &ob->id);
 
 	if ((ob->type == OB_ARMATURE) && (pchan)) {
 		BKE_pose_tag_recalc(bmain, ob->pose);  /* sort pose channels */
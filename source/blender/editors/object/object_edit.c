@@ -484,6 +484,12 @@ static bool ED_object_editmode_load_ex(Main *bmain, Object *obedit, const bool f
 		}
 	}
 
+	/* Loaded data isn't always tagged for an update (leaving edit-mode for undo),
+	 * it still has to be written again for the next undo step. */
+	if (obedit->data != NULL) {
+		((ID *)obedit->data)->tag |= LIB_TAG_UNDO_CHANGED;
+	}
+
 	return true;
 }
 
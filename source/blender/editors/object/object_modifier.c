@@ -189,7 +189,7 @@ ModifierData *ED_object_modifier_add(ReportList *reports, Main *bmain, Scene *sc
 	}
 
 	DEG_id_tag_update(&ob->id, ID_RECALC_GEOMETRY);
-	DEG_relations_tag_update(bmain);
+	DEG_id_tag_relations_update(bmain, &ob->id);
 
 	return new_md;
 }
@@ -356,7 +356,7 @@ bool ED_object_modifier_remove(ReportList *reports, Main *bmain, Object *ob, Mod
 	}
 
 	DEG_id_tag_update(&ob->id, ID_RECALC_GEOMETRY);
-	DEG_relations_tag_update(bmain);
+	DEG_id_tag_relations_update(bmain, &ob->id);
 
 	return 1;
 }
@@ -380,7 +380,7 @@ void ED_object_modifier_clear(Main *bmain, Object *ob)
 	}
 
 	DEG_id_tag_update(&ob->id, ID_RECALC_GEOMETRY);
-	DEG_relations_tag_update(bmain);
+	DEG_id_tag_relations_update(bmain, &ob->id);
 }
 
 int ED_object_modifier_move_up(ReportList *reports, Object *ob, ModifierData *md)
@@ -62,6 +62,7 @@
 
 #include "WM_message.h"
 
+#include "DEG_depsgraph.h"
 #include "DEG_depsgraph_query.h"
 
 #include "screen_intern.h"  /* own module include */
@@ -1317,6 +1318,7 @@ void ED_screen_animation_timer(bContext *C, int redraws, int refresh, int sync,
 	if (stopscreen) {
 		WM_event_remove_timer(wm, win, stopscreen->animtimer);
 		stopscreen->animtimer = NULL;
+		DEG_lookahead_disable_all(CTX_data_main(C));
 	}
 
 	if (enable) {
@@ -1359,6 +1361,13 @@ void ED_screen_animation_timer(bContext *C, int redraws, int refresh, int sync,
 
 		screen->animtimer->customdata = sad;
 
+		/* Evaluate following frames in the background. */
+		if (U.playback_lookahead_frames > 0 && U.playback_lookahead_memory > 0) {
+			DEG_lookahead_enable(CTX_data_main(C),
+			                     CTX_data_depsgraph(C),
+			                     U.playback_lookahead_frames,
+			                     (size_t)U.playback_lookahead_memory * 1024 * 1024);
+		}
 	}
 
 	/* notifier catched by top header, for button */
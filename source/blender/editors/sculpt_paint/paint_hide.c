@@ -383,6 +383,8 @@ static int hide_show_exec(bContext *C, wmOperator *op)
 
 	pbvh = BKE_sculpt_object_pbvh_ensure(depsgraph, ob);
 	BLI_assert(ob->sculpt->pbvh == pbvh);
+	/* Hidden flags are written to the vertices in place. */
+	BKE_sculpt_mesh_ensure_writable(ob);
 
 	get_pbvh_nodes(pbvh, &nodes, &totnode, clip_planes, area);
 	pbvh_type = BKE_pbvh_type(pbvh);
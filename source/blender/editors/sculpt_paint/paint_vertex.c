@@ -182,7 +182,9 @@ static bool vertex_paint_use_fast_update_check(Object *ob)
 
 	if (me_eval != NULL) {
 		Mesh *me = BKE_mesh_from_object(ob);
-		if (me && me->mloopcol) {
+		/* Colors shared with the evaluated mesh are copied when painted,
+		 * so they are not the same ones anymore. */
+		if (me && me->mloopcol && !CustomData_is_referenced_layer(&me->ldata, CD_MLOOPCOL)) {
 			return (me->mloopcol == CustomData_get_layer(&me_eval->ldata, CD_MLOOPCOL));
 		}
 	}
@@ -3165,6 +3167,11 @@ static void vpaint_stroke_update_step(bContext *C, struct PaintStroke *stroke, P
 
 	swap_m4m4(vc->rv3d->persmat, mat);
 
+	/* Colors are painted in place, updates since the last step might share them
+	 * with the evaluated mesh again. */
+	const CustomData_MeshMasks mask = {.lmask = CD_MASK_MLOOPCOL};
+	BKE_mesh_ensure_writable(ob->data, &mask);
+
 	vpaint_do_symmetrical_brush_actions(C, sd, vp, vpd, ob);
 
 	swap_m4m4(vc->rv3d->persmat, mat);
@@ -28,6 +28,7 @@
 #include "BLI_math.h"
 #include "BLI_blenlib.h"
 #include "BLI_dial_2d.h"
+#include "BLI_memarena.h"
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
@@ -1715,9 +1716,10 @@ static float bmesh_neighbor_average_mask(BMVert *v, const int cd_vert_mask_offse
 	}
 }
 
-/* Note: uses after-struct allocated mem to store actual cache... */
 typedef struct SculptDoBrushSmoothGridDataChunk {
 	size_t tmpgrid_size;
+	/* Allocated on first use from the worker's arena. */
+	void *tmpgrid;
 } SculptDoBrushSmoothGridDataChunk;
 
 typedef struct {
@@ -1936,10 +1938,14 @@ static void do_smooth_brush_multires_task_cb_ex(
 
 	grid_hidden = BKE_pbvh_grid_hidden(ss->pbvh);
 
+	if (data_chunk->tmpgrid == NULL) {
+		data_chunk->tmpgrid = BLI_memarena_alloc(tls->arena, data_chunk->tmpgrid_size);
+	}
+
 	if (smooth_mask)
-		tmpgrid_mask = (void *)(data_chunk + 1);
+		tmpgrid_mask = data_chunk->tmpgrid;
 	else
-		tmpgrid_co = (void *)(data_chunk + 1);
+		tmpgrid_co = data_chunk->tmpgrid;
 
 	for (i = 0; i < totgrid; i++) {
 		int gi = grid_indices[i];
@@ -2085,24 +2091,23 @@ static void smooth(
 			{
 				int gridsize;
 				size_t size;
-				SculptDoBrushSmoothGridDataChunk *data_chunk;
+				SculptDoBrushSmoothGridDataChunk data_chunk = {0};
 
 				BKE_pbvh_node_get_grids(ss->pbvh, NULL, NULL, NULL, NULL, &gridsize, NULL);
 				size = (size_t)gridsize;
 				size = sizeof(float) * size * size * (smooth_mask ? 1 : 3);
-				data_chunk = MEM_mallocN(sizeof(*data_chunk) + size, __func__);
-				data_chunk->tmpgrid_size = size;
-				size += sizeof(*data_chunk);
+				data_chunk.tmpgrid_size = size;
 
-				settings.userdata_chunk = data_chunk;
-				settings.userdata_chunk_size = size;
+				/* Each worker gets its own temp grid from its arena,
+				 * instead of copying a whole grid-sized chunk to every task. */
+				settings.userdata_chunk = &data_chunk;
+				settings.userdata_chunk_size = sizeof(data_chunk);
+				settings.use_arena = true;
 				BLI_task_parallel_range(
 				            0, totnode,
 				            &data,
 				            do_smooth_brush_multires_task_cb_ex,
 				            &settings);
-
-				MEM_freeN(data_chunk);
 				break;
 			}
 			case PBVH_FACES:
@@ -5173,6 +5178,8 @@ static void sculpt_stroke_update_step(bContext *C, struct PaintStroke *UNUSED(st
 
 	sculpt_stroke_modifiers_check(C, ob, brush);
 	sculpt_update_cache_variants(C, sd, ob, itemptr);
+	/* Updates of the evaluated mesh since the last step might share the vertices again. */
+	BKE_sculpt_mesh_ensure_writable(ob);
 	sculpt_restore_mesh(sd, ob);
 
 	if (sd->flags & (SCULPT_DYNTOPO_DETAIL_CONSTANT | SCULPT_DYNTOPO_DETAIL_MANUAL)) {
@@ -2276,7 +2276,7 @@ static int filelist_readjob_list_lib(const char *root, ListBase *entries, const
 	}
 
 	/* there we go */
-	libfiledata = BLO_blendhandle_from_file(dir, NULL);
+	libfiledata = BLO_blendhandle_from_file_index(dir, NULL);
 	if (libfiledata == NULL) {
 		return nbr_entries;
 	}
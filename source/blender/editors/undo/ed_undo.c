@@ -115,8 +115,9 @@ static int ed_undo_step(bContext *C, int step, const char *undoname, ReportList
 	ScrArea *sa = CTX_wm_area(C);
 
 	/* undo during jobs are running can easily lead to freeing data using by jobs,
-	 * or they can just lead to freezing job in some other cases */
-	WM_jobs_kill_all(wm);
+	 * or they can just lead to freezing job in some other cases.
+	 * The auto-save job (owned by the window-manager) only uses its own copy of the data. */
+	WM_jobs_kill_all_except(wm, wm);
 
 	if (G.debug & G_DEBUG_IO) {
 		Main *bmain = CTX_data_main(C);
@@ -22,6 +22,8 @@
 
 #include "BLI_utildefines.h"
 #include "BLI_sys_types.h"
+#include "BLI_ghash.h"
+#include "BLI_listbase.h"
 
 #include "DNA_object_enums.h"
 
@@ -82,12 +84,47 @@ static bool memfile_undosys_step_encode(struct bContext *UNUSED(C), struct Main
 	return true;
 }
 
+/**
+ * ID's of the current state which are the same in the memfile of \a us,
+ * the state is the one of the memfile step last written or read, apart from ID's edited since.
+ */
+static GSet *memfile_undosys_ids_unchanged_create(MemFileUndoStep *us)
+{
+	UndoStack *ustack = ED_undo_stack_get();
+	UndoStep *us_current = ustack->step_active_memfile;
+	if ((us_current == NULL) || (us_current->type != BKE_UNDOSYS_TYPE_MEMFILE)) {
+		return NULL;
+	}
+
+	/* Steps in between change ID's, or the step itself when it's the later one. */
+	UndoStep *us_first = us_current, *us_last = &us->step;
+	if (BLI_findindex(&ustack->steps, us_first) > BLI_findindex(&ustack->steps, us_last)) {
+		SWAP(UndoStep *, us_first, us_last);
+	}
+
+	GSet *ids = BLO_memfile_ids_create(&us->data->memfile);
+	for (UndoStep *us_iter = us_first; us_iter != us_last; ) {
+		us_iter = us_iter->next;
+		if (us_iter->type == BKE_UNDOSYS_TYPE_MEMFILE) {
+			BLO_memfile_ids_unchanged_filter(ids, &((MemFileUndoStep *)us_iter)->data->memfile);
+		}
+	}
+	return ids;
+}
+
 static void memfile_undosys_step_decode(struct bContext *C, struct Main *bmain, UndoStep *us_p, int UNUSED(dir))
 {
 	ED_editors_exit(bmain, false);
 
 	MemFileUndoStep *us = (MemFileUndoStep *)us_p;
+	us->data->memfile.read_ids_unchanged = memfile_undosys_ids_unchanged_create(us);
 	BKE_memfile_undo_decode(us->data, C);
+	if (us->data->memfile.read_ids_unchanged) {
+		BLI_gset_free(us->data->memfile.read_ids_unchanged, NULL);
+		us->data->memfile.read_ids_unchanged = NULL;
+	}
+	us_p->stats.decode_ids_len = us->data->memfile.read_ids_len;
+	us_p->stats.decode_ids_reused = us->data->memfile.read_ids_reused;
 
 	for (UndoStep *us_iter = us_p->next; us_iter; us_iter = us_iter->next) {
 		if (BKE_UNDOSYS_TYPE_IS_MEMFILE_SKIP(us_iter->type)) {
@@ -54,6 +54,8 @@
 #include "BKE_workspace.h"
 #include "BKE_material.h"
 
+#include "DEG_depsgraph.h"
+
 #include "ED_armature.h"
 #include "ED_buttons.h"
 #include "ED_image.h"
@@ -195,6 +197,9 @@ void ED_editors_exit(Main *bmain, bool do_undo_system)
 		return;
 	}
 
+	/* Original data is about to be freed, stop evaluating frames ahead. */
+	DEG_lookahead_disable_all(bmain);
+
 	/* frees all editmode undos */
 	if (do_undo_system && G_MAIN->wm.first) {
 		wmWindowManager *wm = G_MAIN->wm.first;
@@ -522,6 +522,10 @@ enum {
 	/* Datablock was not allocated by standard system (BKE_libblock_alloc), do not free its memory
 	 * (usual type-specific freeing is called though). */
 	LIB_TAG_NOT_ALLOCATED     = 1 << 18,
+
+	/* RESET_AFTER_USE Datablock was created or edited since the last global undo step was written,
+	 * its data can't be taken from that step (see #BLO_write_file_mem). */
+	LIB_TAG_UNDO_CHANGED      = 1 << 19,
 };
 
 /* Tag given ID for an update in all the dependency graphs. */
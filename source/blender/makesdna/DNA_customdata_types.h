@@ -52,6 +52,8 @@ typedef struct CustomDataLayer {
 	char name[64];
 	/** Layer data. */
 	void *data;
+	/** Run-time only, users of data shared between layers, see #CD_SHARE. */
+	struct CustomDataShared *shared;
 } CustomDataLayer;
 
 #define MAX_CUSTOMDATA_LAYER_NAME 64
@@ -27,6 +27,7 @@
 
 #include "intern/dna_utils.h"
 
+struct DNA_ReconstructInfo;
 struct SDNA;
 
 /**
@@ -93,9 +94,12 @@ int DNA_struct_find_nr_ex(const struct SDNA *sdna, const char *str, unsigned int
 int DNA_struct_find_nr(const struct SDNA *sdna, const char *str);
 void DNA_struct_switch_endian(const struct SDNA *oldsdna, int oldSDNAnr, char *data);
 const char *DNA_struct_get_compareflags(const struct SDNA *sdna, const struct SDNA *newsdna);
+
+struct DNA_ReconstructInfo *DNA_reconstruct_info_create(
+        const struct SDNA *oldsdna, const struct SDNA *newsdna, const char *compflags);
+void DNA_reconstruct_info_free(struct DNA_ReconstructInfo *reconstruct_info);
 void *DNA_struct_reconstruct(
-        const struct SDNA *newsdna, const struct SDNA *oldsdna,
-        const char *compflags, int oldSDNAnr, int blocks, const void *data);
+        const struct DNA_ReconstructInfo *reconstruct_info, int old_struct_nr, int blocks, const void *old_blocks);
 
 int DNA_elem_offset(struct SDNA *sdna, const char *stype, const char *vartype, const char *name);
 
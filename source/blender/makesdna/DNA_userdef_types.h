@@ -635,7 +635,10 @@ typedef struct UserDef {
 	short gp_manhattendist, gp_euclideandist, gp_eraser;
 	/** #eGP_UserdefSettings. */
 	short gp_settings;
-	char _pad13[4];
+	/** Number of frames evaluated ahead during playback. */
+	short playback_lookahead_frames;
+	/** Memory limit of frames evaluated ahead, in megabytes. */
+	short playback_lookahead_memory;
 	struct SolidLight light_param[4];
 	float light_ambient[3];
 	char _pad3[4];
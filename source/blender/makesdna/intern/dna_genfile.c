@@ -730,134 +730,6 @@ static eSDNA_Type sdna_type_nr(const char *dna_type)
 	else                                                                                     { return -1; }
 }
 
-/**
- * Converts a value of one primitive type to another.
- * Note there is no optimization for the case where otype and ctype are the same:
- * assumption is that caller will handle this case.
- *
- * \param ctype: Name of type to convert to
- * \param otype: Name of type to convert from
- * \param name_array_len: Result of #DNA_elem_array_size for this element.
- * \param curdata: Where to put converted data
- * \param olddata: Data of type otype to convert
- */
-static void cast_elem(
-        const char *ctype, const char *otype, int name_array_len,
-        char *curdata, const char *olddata)
-{
-	double val = 0.0;
-	int curlen = 1, oldlen = 1;
-
-	eSDNA_Type ctypenr, otypenr;
-
-	if ( (otypenr = sdna_type_nr(otype)) == -1 ||
-	     (ctypenr = sdna_type_nr(ctype)) == -1)
-	{
-		return;
-	}
-
-	/* define lengths */
-	oldlen = DNA_elem_type_size(otypenr);
-	curlen = DNA_elem_type_size(ctypenr);
-
-	while (name_array_len > 0) {
-		switch (otypenr) {
-			case SDNA_TYPE_CHAR:
-				val = *olddata; break;
-			case SDNA_TYPE_UCHAR:
-				val = *( (unsigned char *)olddata); break;
-			case SDNA_TYPE_SHORT:
-				val = *( (short *)olddata); break;
-			case SDNA_TYPE_USHORT:
-				val = *( (unsigned short *)olddata); break;
-			case SDNA_TYPE_INT:
-				val = *( (int *)olddata); break;
-			case SDNA_TYPE_FLOAT:
-				val = *( (float *)olddata); break;
-			case SDNA_TYPE_DOUBLE:
-				val = *( (double *)olddata); break;
-			case SDNA_TYPE_INT64:
-				val = *( (int64_t *)olddata); break;
-			case SDNA_TYPE_UINT64:
-				val = *( (uint64_t *)olddata); break;
-		}
-
-		switch (ctypenr) {
-			case SDNA_TYPE_CHAR:
-				*curdata = val; break;
-			case SDNA_TYPE_UCHAR:
-				*( (unsigned char *)curdata) = val; break;
-			case SDNA_TYPE_SHORT:
-				*( (short *)curdata) = val; break;
-			case SDNA_TYPE_USHORT:
-				*( (unsigned short *)curdata) = val; break;
-			case SDNA_TYPE_INT:
-				*( (int *)curdata) = val; break;
-			case SDNA_TYPE_FLOAT:
-				if (otypenr < 2) {
-					val /= 255;
-				}
-				*( (float *)curdata) = val; break;
-			case SDNA_TYPE_DOUBLE:
-				if (otypenr < 2) {
-					val /= 255;
-				}
-				*( (double *)curdata) = val; break;
-			case SDNA_TYPE_INT64:
-				*( (int64_t *)curdata) = val; break;
-			case SDNA_TYPE_UINT64:
-				*( (uint64_t *)curdata) = val; break;
-		}
-
-		olddata += oldlen;
-		curdata += curlen;
-		name_array_len--;
-	}
-}
-
-/**
- * Converts pointer values between different sizes. These are only used
- * as lookup keys to identify data blocks in the saved .blend file, not
- * as actual in-memory pointers.
- *
- * \param curlen: Pointer length to conver to
- * \param oldlen: Length of pointers in olddata
- * \param name_array_len: Result of #DNA_elem_array_size for this element.
- * \param curdata: Where to put converted data
- * \param olddata: Data to convert
- */
-static void cast_pointer(int curlen, int oldlen, int name_array_len, char *curdata, const char *olddata)
-{
-	int64_t lval;
-
-	while (name_array_len > 0) {
-
-		if (curlen == oldlen) {
-			memcpy(curdata, olddata, curlen);
-		}
-		else if (curlen == 4 && oldlen == 8) {
-			lval = *((int64_t *)olddata);
-
-			/* WARNING: 32-bit Blender trying to load file saved by 64-bit Blender,
-			 * pointers may lose uniqueness on truncation! (Hopefully this wont
-			 * happen unless/until we ever get to multi-gigabyte .blend files...) */
-			*((int *)curdata) = lval >> 3;
-		}
-		else if (curlen == 8 && oldlen == 4) {
-			*((int64_t *)curdata) = *((int *)olddata);
-		}
-		else {
-			/* for debug */
-			printf("errpr: illegal pointersize!\n");
-		}
-
-		olddata += oldlen;
-		curdata += curlen;
-		name_array_len--;
-
-	}
-}
-
 /**
  * Equality test on name and oname excluding any array-size suffix.
  */
@@ -969,232 +841,6 @@ static const char *find_elem(
 	return NULL;
 }
 
-/**
- * Converts the contents of a single field of a struct, of a non-struct type,
- * from oldsdna to newsdna format.
- *
- * \param newsdna: SDNA of current Blender
- * \param oldsdna: SDNA of Blender that saved file
- * \param type: current field type name
- * \param new_name_nr: current field name number.
- * \param curdata: put field data converted to newsdna here
- * \param old: pointer to struct info in oldsdna
- * \param olddata: struct contents laid out according to oldsdna
- */
-static void reconstruct_elem(
-        const SDNA *newsdna,
-        const SDNA *oldsdna,
-        const char *type,
-        const int new_name_nr,
-        char *curdata,
-        const short *old,
-        const char *olddata)
-{
-	/* rules: test for NAME:
-	 *      - name equal:
-	 *          - cast type
-	 *      - name partially equal (array differs)
-	 *          - type equal: memcpy
-	 *          - types casten
-	 * (nzc 2-4-2001 I want the 'unsigned' bit to be parsed as well. Where
-	 * can I force this?)
-	 */
-	int a, elemcount, len, countpos, mul;
-	const char *otype, *oname, *cp;
-
-	/* is 'name' an array? */
-	const char *name = newsdna->names[new_name_nr];
-	cp = name;
-	countpos = 0;
-	while (*cp && *cp != '[') {
-		cp++; countpos++;
-	}
-	if (*cp != '[') {
-		countpos = 0;
-	}
-
-	/* in old is the old struct */
-	elemcount = old[1];
-	old += 2;
-	for (a = 0; a < elemcount; a++, old += 2) {
-		const int old_name_nr = old[1];
-		otype = oldsdna->types[old[0]];
-		oname = oldsdna->names[old[1]];
-		len = elementsize(oldsdna, old[0], old[1]);
-
-		if (strcmp(name, oname) == 0) { /* name equal */
-
-			if (ispointer(name)) {  /* pointer of functionpointer afhandelen */
-				cast_pointer(newsdna->pointer_size, oldsdna->pointer_size,
-				             newsdna->names_array_len[new_name_nr],
-				             curdata, olddata);
-			}
-			else if (strcmp(type, otype) == 0) {    /* type equal */
-				memcpy(curdata, olddata, len);
-			}
-			else {
-				cast_elem(type, otype,
-				          newsdna->names_array_len[new_name_nr],
-				          curdata, olddata);
-			}
-
-			return;
-		}
-		else if (countpos != 0) {  /* name is an array */
-
-			if (oname[countpos] == '[' && strncmp(name, oname, countpos) == 0) {  /* basis equal */
-				const int new_name_array_len = newsdna->names_array_len[new_name_nr];
-				const int old_name_array_len = oldsdna->names_array_len[old_name_nr];
-				const int min_name_array_len = MIN2(new_name_array_len, old_name_array_len);
-
-				if (ispointer(name)) {  /* handle pointer or functionpointer */
-					cast_pointer(newsdna->pointer_size, oldsdna->pointer_size,
-					             min_name_array_len,
-					             curdata, olddata);
-				}
-				else if (strcmp(type, otype) == 0) {  /* type equal */
-					/* size of single old array element */
-					mul = len / old_name_array_len;
-					/* smaller of sizes of old and new arrays */
-					mul *= min_name_array_len;
-
-					memcpy(curdata, olddata, mul);
-
-					if (old_name_array_len > new_name_array_len && strcmp(type, "char") == 0) {
-						/* string had to be truncated, ensure it's still null-terminated */
-						curdata[mul - 1] = '\0';
-					}
-				}
-				else {
-					cast_elem(type, otype,
-					          min_name_array_len,
-					          curdata, olddata);
-				}
-				return;
-			}
-		}
-		olddata += len;
-	}
-}
-
-/**
- * Converts the contents of an entire struct from oldsdna to newsdna format.
- *
- * \param newsdna: SDNA of current Blender
- * \param oldsdna: SDNA of Blender that saved file
- * \param compflags:
- *
- * Result from DNA_struct_get_compareflags to avoid needless conversions.
- * \param oldSDNAnr: Index of old struct definition in oldsdna
- * \param data: Struct contents laid out according to oldsdna
- * \param curSDNAnr: Index of current struct definition in newsdna
- * \param cur: Where to put converted struct contents
- */
-static void reconstruct_struct(
-        const SDNA *newsdna,
-        const SDNA *oldsdna,
-        const char *compflags,
-
-        int oldSDNAnr,
-        const char *data,
-        int curSDNAnr,
-        char *cur)
-{
-	/* Recursive!
-	 * Per element from cur_struct, read data from old_struct.
-	 * If element is a struct, call recursive.
-	 */
-	int a, elemcount, elen, eleno, mul, mulo, firststructtypenr;
-	const short *spo, *spc, *sppo;
-	const char *type;
-	const char *cpo;
-	char *cpc;
-	const char *name;
-
-	unsigned int oldsdna_index_last = UINT_MAX;
-	unsigned int cursdna_index_last = UINT_MAX;
-
-
-	if (oldSDNAnr == -1) {
-		return;
-	}
-	if (curSDNAnr == -1) {
-		return;
-	}
-
-	if (compflags[oldSDNAnr] == SDNA_CMP_EQUAL) {
-		/* if recursive: test for equal */
-		spo = oldsdna->structs[oldSDNAnr];
-		elen = oldsdna->types_size[spo[0]];
-		memcpy(cur, data, elen);
-
-		return;
-	}
-
-	firststructtypenr = *(newsdna->structs[0]);
-
-	spo = oldsdna->structs[oldSDNAnr];
-	spc = newsdna->structs[curSDNAnr];
-
-	elemcount = spc[1];
-
-	spc += 2;
-	cpc = cur;
-	for (a = 0; a < elemcount; a++, spc += 2) {  /* convert each field */
-		type = newsdna->types[spc[0]];
-		name = newsdna->names[spc[1]];
-
-		elen = elementsize(newsdna, spc[0], spc[1]);
-
-		/* Skip pad bytes which must start with '_pad', see makesdna.c 'is_name_legal'.
-		 * for exact rules. Note that if we fail to skip a pad byte it's harmless,
-		 * this just avoids unnecessary reconstruction. */
-		if (name[0] == '_' || (name[0] == '*' && name[1] == '_')) {
-			cpc += elen;
-		}
-		else if (spc[0] >= firststructtypenr && !ispointer(name)) {
-			/* struct field type */
-
-			/* where does the old struct data start (and is there an old one?) */
-			cpo = (char *)find_elem(oldsdna, type, name, spo, data, &sppo);
-
-			if (cpo) {
-				oldSDNAnr = DNA_struct_find_nr_ex(oldsdna, type, &oldsdna_index_last);
-				curSDNAnr = DNA_struct_find_nr_ex(newsdna, type, &cursdna_index_last);
-
-				/* array! */
-				mul = newsdna->names_array_len[spc[1]];
-				mulo = oldsdna->names_array_len[sppo[1]];
-
-				eleno = elementsize(oldsdna, sppo[0], sppo[1]);
-
-				elen /= mul;
-				eleno /= mulo;
-
-				while (mul--) {
-					reconstruct_struct(newsdna, oldsdna, compflags, oldSDNAnr, cpo, curSDNAnr, cpc);
-					cpo += eleno;
-					cpc += elen;
-
-					/* new struct array larger than old */
-					mulo--;
-					if (mulo <= 0) {
-						break;
-					}
-				}
-			}
-			else {
-				cpc += elen;  /* skip field no longer present */
-			}
-		}
-		else {
-			/* non-struct field type */
-			reconstruct_elem(newsdna, oldsdna, type, spc[1], cpc, spo, data);
-			cpc += elen;
-		}
-	}
-}
-
 /**
  * Does endian swapping on the fields of a struct value.
  *
@@ -1288,54 +934,498 @@ void DNA_struct_switch_endian(const SDNA *oldsdna, int oldSDNAnr, char *data)
 	}
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Struct Reconstruction
+ *
+ * Resolving which old field each new field is read from needs string comparisons
+ * on the field names, doing this for every struct read from a file dominates the
+ * loading time of older files with large arrays (vertices, loops... etc).
+ *
+ * Instead a list of steps is computed once per struct, which only holds offsets & types
+ * of the conversions to perform, running these is a tight loop over the blocks.
+ * \{ */
+
+typedef enum eReconstructStepType {
+	/** Straight copy, also used for pointers of the same size. */
+	RECONSTRUCT_STEP_COPY,
+	/** Conversion between primitive types, see #cast_primitive_type. */
+	RECONSTRUCT_STEP_CAST_PRIMITIVE,
+	/** Conversion between 32 and 64 bit pointers. */
+	RECONSTRUCT_STEP_CAST_POINTER_TO_32,
+	RECONSTRUCT_STEP_CAST_POINTER_TO_64,
+	/** Nested (array of) struct which differs between the old and new SDNA. */
+	RECONSTRUCT_STEP_SUBSTRUCT,
+} eReconstructStepType;
+
+typedef struct ReconstructStep {
+	eReconstructStepType type;
+	int old_offset;
+	int new_offset;
+	union {
+		struct {
+			int size;
+			/** Char array which has been truncated, ensure it's still null-terminated. */
+			bool string_truncate;
+		} copy;
+		struct {
+			int array_len;
+			eSDNA_Type old_type;
+			eSDNA_Type new_type;
+		} cast_primitive;
+		struct {
+			int array_len;
+		} cast_pointer;
+		struct {
+			int array_len;
+			int old_struct_nr;
+			int old_stride;
+			int new_stride;
+		} substruct;
+	} data;
+} ReconstructStep;
+
+typedef struct ReconstructPlan {
+	/** Index of the struct in the new SDNA, -1 when it has been removed. */
+	int new_struct_nr;
+	/** Size of the struct in the new SDNA. */
+	int new_size;
+	int steps_len;
+	ReconstructStep *steps;
+} ReconstructPlan;
+
+typedef struct DNA_ReconstructInfo {
+	const SDNA *oldsdna;
+	const SDNA *newsdna;
+	const char *compflags;
+	/** Aligned with the structs of the old SDNA. */
+	ReconstructPlan *plans;
+	int plans_len;
+} DNA_ReconstructInfo;
+
 /**
- * \param newsdna: SDNA of current Blender
- * \param oldsdna: SDNA of Blender that saved file
- * \param compflags:
+ * Converts an array of values of one primitive type to another,
+ * chars are converted to floats in the [0..1] range.
  *
- * Result from DNA_struct_get_compareflags to avoid needless conversions
- * \param oldSDNAnr: Index of struct info within oldsdna
+ * Values are converted through a buffer of doubles, so the loops loading and storing
+ * the values only deal with a single type and can be vectorized by the compiler.
+ */
+static void cast_primitive_type(
+        const eSDNA_Type old_type, const eSDNA_Type new_type, const int array_len,
+        const char *old_data, char *new_data)
+{
+	double values[256];
+	const int old_size = DNA_elem_type_size(old_type);
+	const int new_size = DNA_elem_type_size(new_type);
+	const bool use_normalize = ELEM(old_type, SDNA_TYPE_CHAR, SDNA_TYPE_UCHAR);
+
+	for (int offset = 0; offset < array_len; offset += (int)ARRAY_SIZE(values)) {
+		const int len = MIN2(array_len - offset, (int)ARRAY_SIZE(values));
+		int i;
+
+#define CAST_LOAD(ctype) { \
+			const ctype *src = (const ctype *)old_data; \
+			for (i = 0; i < len; i++) { values[i] = (double)src[i]; } \
+		} ((void)0)
+#define CAST_STORE(ctype, normalize) { \
+			ctype *dst = (ctype *)new_data; \
+			if (normalize) { for (i = 0; i < len; i++) { dst[i] = (ctype)(values[i] / 255.0); } } \
+			else           { for (i = 0; i < len; i++) { dst[i] = (ctype)values[i]; } } \
+		} ((void)0)
+
+		switch (old_type) {
+			case SDNA_TYPE_CHAR:   CAST_LOAD(char); break;
+			case SDNA_TYPE_UCHAR:  CAST_LOAD(unsigned char); break;
+			case SDNA_TYPE_SHORT:  CAST_LOAD(short); break;
+			case SDNA_TYPE_USHORT: CAST_LOAD(unsigned short); break;
+			case SDNA_TYPE_INT:    CAST_LOAD(int); break;
+			case SDNA_TYPE_FLOAT:  CAST_LOAD(float); break;
+			case SDNA_TYPE_DOUBLE: CAST_LOAD(double); break;
+			case SDNA_TYPE_INT64:  CAST_LOAD(int64_t); break;
+			case SDNA_TYPE_UINT64: CAST_LOAD(uint64_t); break;
+		}
+
+		switch (new_type) {
+			case SDNA_TYPE_CHAR:   CAST_STORE(char, false); break;
+			case SDNA_TYPE_UCHAR:  CAST_STORE(unsigned char, false); break;
+			case SDNA_TYPE_SHORT:  CAST_STORE(short, false); break;
+			case SDNA_TYPE_USHORT: CAST_STORE(unsigned short, false); break;
+			case SDNA_TYPE_INT:    CAST_STORE(int, false); break;
+			case SDNA_TYPE_FLOAT:  CAST_STORE(float, use_normalize); break;
+			case SDNA_TYPE_DOUBLE: CAST_STORE(double, use_normalize); break;
+			case SDNA_TYPE_INT64:  CAST_STORE(int64_t, false); break;
+			case SDNA_TYPE_UINT64: CAST_STORE(uint64_t, false); break;
+		}
+
+#undef CAST_LOAD
+#undef CAST_STORE
+
+		old_data += len * old_size;
+		new_data += len * new_size;
+	}
+}
+
+/**
+ * Adds a copy step, merged with the previous step when both are contiguous.
+ */
+static void reconstruct_plan_add_copy(
+        ReconstructPlan *plan, const int old_offset, const int new_offset, const int size,
+        const bool string_truncate)
+{
+	if (size <= 0) {
+		return;
+	}
+	if (plan->steps_len != 0) {
+		ReconstructStep *step_prev = &plan->steps[plan->steps_len - 1];
+		if ((step_prev->type == RECONSTRUCT_STEP_COPY) &&
+		    (step_prev->data.copy.string_truncate == false) &&
+		    (step_prev->old_offset + step_prev->data.copy.size == old_offset) &&
+		    (step_prev->new_offset + step_prev->data.copy.size == new_offset))
+		{
+			step_prev->data.copy.size += size;
+			step_prev->data.copy.string_truncate = string_truncate;
+			return;
+		}
+	}
+	ReconstructStep *step = &plan->steps[plan->steps_len++];
+	step->type = RECONSTRUCT_STEP_COPY;
+	step->old_offset = old_offset;
+	step->new_offset = new_offset;
+	step->data.copy.size = size;
+	step->data.copy.string_truncate = string_truncate;
+}
+
+static void reconstruct_plan_add_cast_pointer(
+        ReconstructPlan *plan, const SDNA *oldsdna, const SDNA *newsdna,
+        const int old_offset, const int new_offset, const int array_len)
+{
+	if (newsdna->pointer_size == oldsdna->pointer_size) {
+		reconstruct_plan_add_copy(plan, old_offset, new_offset, array_len * newsdna->pointer_size, false);
+	}
+	else {
+		ReconstructStep *step = &plan->steps[plan->steps_len++];
+		step->type = (newsdna->pointer_size == 4) ?
+		             RECONSTRUCT_STEP_CAST_POINTER_TO_32 : RECONSTRUCT_STEP_CAST_POINTER_TO_64;
+		step->old_offset = old_offset;
+		step->new_offset = new_offset;
+		step->data.cast_pointer.array_len = array_len;
+	}
+}
+
+static void reconstruct_plan_add_cast_primitive(
+        ReconstructPlan *plan, const char *old_type_name, const char *new_type_name,
+        const int old_offset, const int new_offset, const int array_len)
+{
+	const eSDNA_Type old_type = sdna_type_nr(old_type_name);
+	const eSDNA_Type new_type = sdna_type_nr(new_type_name);
+	if (old_type == -1 || new_type == -1) {
+		return;
+	}
+	ReconstructStep *step = &plan->steps[plan->steps_len++];
+	step->type = RECONSTRUCT_STEP_CAST_PRIMITIVE;
+	step->old_offset = old_offset;
+	step->new_offset = new_offset;
+	step->data.cast_primitive.array_len = array_len;
+	step->data.cast_primitive.old_type = old_type;
+	step->data.cast_primitive.new_type = new_type;
+}
+
+/**
+ * Adds the step reading a single field of a non-struct type.
+ *
+ * Rules, test for NAME:
+ * - name equal:
+ *   - cast type
+ * - name partially equal (array differs)
+ *   - type equal: memcpy
+ *   - types casten
+ */
+static void reconstruct_plan_add_elem(
+        ReconstructPlan *plan, const SDNA *oldsdna, const SDNA *newsdna,
+        const short *spo, const int new_name_nr, const char *type, const int new_offset)
+{
+	const char *name = newsdna->names[new_name_nr];
+	const bool is_pointer = ispointer(name);
+	int countpos = 0;
+
+	/* is 'name' an array? */
+	while (name[countpos] && name[countpos] != '[') {
+		countpos++;
+	}
+	if (name[countpos] != '[') {
+		countpos = 0;
+	}
+
+	const int elemcount = spo[1];
+	int old_offset = 0;
+	spo += 2;
+	for (int a = 0; a < elemcount; a++, spo += 2) {
+		const int old_name_nr = spo[1];
+		const char *otype = oldsdna->types[spo[0]];
+		const char *oname = oldsdna->names[old_name_nr];
+		const int len = elementsize(oldsdna, spo[0], spo[1]);
+
+		if (strcmp(name, oname) == 0) {  /* name equal */
+			const int new_name_array_len = newsdna->names_array_len[new_name_nr];
+			if (is_pointer) {
+				reconstruct_plan_add_cast_pointer(
+				        plan, oldsdna, newsdna, old_offset, new_offset, new_name_array_len);
+			}
+			else if (strcmp(type, otype) == 0) {  /* type equal */
+				reconstruct_plan_add_copy(plan, old_offset, new_offset, len, false);
+			}
+			else {
+				reconstruct_plan_add_cast_primitive(
+				        plan, otype, type, old_offset, new_offset, new_name_array_len);
+			}
+			return;
+		}
+		else if (countpos != 0) {  /* name is an array */
+			if (oname[countpos] == '[' && strncmp(name, oname, countpos) == 0) {  /* basis equal */
+				const int new_name_array_len = newsdna->names_array_len[new_name_nr];
+				const int old_name_array_len = oldsdna->names_array_len[old_name_nr];
+				const int min_name_array_len = MIN2(new_name_array_len, old_name_array_len);
+
+				if (is_pointer) {
+					reconstruct_plan_add_cast_pointer(
+					        plan, oldsdna, newsdna, old_offset, new_offset, min_name_array_len);
+				}
+				else if (strcmp(type, otype) == 0) {  /* type equal */
+					reconstruct_plan_add_copy(
+					        plan, old_offset, new_offset, (len / old_name_array_len) * min_name_array_len,
+					        (old_name_array_len > new_name_array_len) && STREQ(type, "char"));
+				}
+				else {
+					reconstruct_plan_add_cast_primitive(
+					        plan, otype, type, old_offset, new_offset, min_name_array_len);
+				}
+				return;
+			}
+		}
+		old_offset += len;
+	}
+}
+
+/**
+ * Adds the step reading a field of a struct type (or an array of them).
+ */
+static void reconstruct_plan_add_substruct(
+        ReconstructPlan *plan, const SDNA *oldsdna, const SDNA *newsdna, const char *compflags,
+        const short *spo, const int new_name_nr, const char *type, const int new_offset)
+{
+	const char *name = newsdna->names[new_name_nr];
+	const short *sppo = NULL;
+
+	/* where does the old struct data start (and is there an old one?) */
+	const int elemcount = spo[1];
+	int old_offset = 0;
+	spo += 2;
+	for (int a = 0; a < elemcount; a++, spo += 2) {
+		if (elem_strcmp(name, oldsdna->names[spo[1]]) == 0) {  /* name equal */
+			if (strcmp(type, oldsdna->types[spo[0]]) == 0) {  /* type equal */
+				sppo = spo;
+			}
+			break;
+		}
+		old_offset += elementsize(oldsdna, spo[0], spo[1]);
+	}
+	if (sppo == NULL) {
+		/* skip field no longer present */
+		return;
+	}
+
+	const int old_struct_nr = DNA_struct_find_nr(oldsdna, type);
+	const int new_struct_nr = DNA_struct_find_nr(newsdna, type);
+	if (old_struct_nr == -1 || new_struct_nr == -1) {
+		return;
+	}
+
+	/* new struct array may be larger than old */
+	const int array_len = MIN2(newsdna->names_array_len[new_name_nr], oldsdna->names_array_len[sppo[1]]);
+	const int old_stride = oldsdna->types_size[oldsdna->structs[old_struct_nr][0]];
+	const int new_stride = newsdna->types_size[newsdna->structs[new_struct_nr][0]];
+
+	if (compflags[old_struct_nr] == SDNA_CMP_EQUAL) {
+		reconstruct_plan_add_copy(plan, old_offset, new_offset, old_stride * array_len, false);
+	}
+	else {
+		ReconstructStep *step = &plan->steps[plan->steps_len++];
+		step->type = RECONSTRUCT_STEP_SUBSTRUCT;
+		step->old_offset = old_offset;
+		step->new_offset = new_offset;
+		step->data.substruct.array_len = array_len;
+		step->data.substruct.old_struct_nr = old_struct_nr;
+		step->data.substruct.old_stride = old_stride;
+		step->data.substruct.new_stride = new_stride;
+	}
+}
+
+static void reconstruct_plan_init(
+        ReconstructPlan *plan, const SDNA *oldsdna, const SDNA *newsdna, const char *compflags,
+        const int old_struct_nr)
+{
+	const short *spo = oldsdna->structs[old_struct_nr];
+
+	plan->new_struct_nr = DNA_struct_find_nr(newsdna, oldsdna->types[spo[0]]);
+	if (plan->new_struct_nr == -1) {
+		return;
+	}
+
+	const short *spc = newsdna->structs[plan->new_struct_nr];
+	const int firststructtypenr = *(newsdna->structs[0]);
+	const int elemcount = spc[1];
+
+	plan->new_size = newsdna->types_size[spc[0]];
+	/* There is at most one step for each field. */
+	plan->steps = MEM_mallocN(sizeof(*plan->steps) * (size_t)MAX2(elemcount, 1), __func__);
+
+	if (compflags[old_struct_nr] == SDNA_CMP_EQUAL) {
+		reconstruct_plan_add_copy(plan, 0, 0, oldsdna->types_size[spo[0]], false);
+		return;
+	}
+
+	int new_offset = 0;
+	spc += 2;
+	for (int a = 0; a < elemcount; a++, spc += 2) {  /* convert each field */
+		const char *type = newsdna->types[spc[0]];
+		const char *name = newsdna->names[spc[1]];
+		const int elen = elementsize(newsdna, spc[0], spc[1]);
+
+		/* Skip pad bytes which must start with '_pad', see makesdna.c 'is_name_legal'.
+		 * for exact rules. Note that if we fail to skip a pad byte it's harmless,
+		 * this just avoids unnecessary reconstruction. */
+		if (name[0] == '_' || (name[0] == '*' && name[1] == '_')) {
+			/* pass */
+		}
+		else if (spc[0] >= firststructtypenr && !ispointer(name)) {
+			/* struct field type */
+			reconstruct_plan_add_substruct(plan, oldsdna, newsdna, compflags, spo, spc[1], type, new_offset);
+		}
+		else {
+			/* non-struct field type */
+			reconstruct_plan_add_elem(plan, oldsdna, newsdna, spo, spc[1], type, new_offset);
+		}
+		new_offset += elen;
+	}
+}
+
+/**
+ * Computes how each struct of \a oldsdna is converted to \a newsdna,
+ * to be passed to #DNA_struct_reconstruct.
+ *
+ * \param compflags: Result from #DNA_struct_get_compareflags.
+ */
+DNA_ReconstructInfo *DNA_reconstruct_info_create(
+        const SDNA *oldsdna, const SDNA *newsdna, const char *compflags)
+{
+	DNA_ReconstructInfo *reconstruct_info = MEM_callocN(sizeof(*reconstruct_info), __func__);
+	reconstruct_info->oldsdna = oldsdna;
+	reconstruct_info->newsdna = newsdna;
+	reconstruct_info->compflags = compflags;
+	reconstruct_info->plans = MEM_callocN(sizeof(*reconstruct_info->plans) * (size_t)oldsdna->nr_structs, __func__);
+	reconstruct_info->plans_len = oldsdna->nr_structs;
+
+	for (int a = 0; a < oldsdna->nr_structs; a++) {
+		ReconstructPlan *plan = &reconstruct_info->plans[a];
+		plan->new_struct_nr = -1;
+		if (compflags[a] != SDNA_CMP_REMOVED) {
+			reconstruct_plan_init(plan, oldsdna, newsdna, compflags, a);
+		}
+	}
+
+	return reconstruct_info;
+}
+
+void DNA_reconstruct_info_free(DNA_ReconstructInfo *reconstruct_info)
+{
+	/* Don't access the SDNA's, they may be freed already. */
+	for (int a = 0; a < reconstruct_info->plans_len; a++) {
+		MEM_SAFE_FREE(reconstruct_info->plans[a].steps);
+	}
+	MEM_freeN(reconstruct_info->plans);
+	MEM_freeN(reconstruct_info);
+}
+
+/**
+ * Converts the contents of an entire struct from oldsdna to newsdna format.
+ */
+static void reconstruct_struct(
+        const DNA_ReconstructInfo *reconstruct_info, const int old_struct_nr,
+        const char *old_block, char *new_block)
+{
+	const ReconstructPlan *plan = &reconstruct_info->plans[old_struct_nr];
+	const ReconstructStep *step = plan->steps;
+
+	for (int a = 0; a < plan->steps_len; a++, step++) {
+		const char *old_data = old_block + step->old_offset;
+		char *new_data = new_block + step->new_offset;
+
+		switch (step->type) {
+			case RECONSTRUCT_STEP_COPY:
+				memcpy(new_data, old_data, (size_t)step->data.copy.size);
+				if (step->data.copy.string_truncate) {
+					new_data[step->data.copy.size - 1] = '\0';
+				}
+				break;
+			case RECONSTRUCT_STEP_CAST_PRIMITIVE:
+				cast_primitive_type(
+				        step->data.cast_primitive.old_type, step->data.cast_primitive.new_type,
+				        step->data.cast_primitive.array_len, old_data, new_data);
+				break;
+			case RECONSTRUCT_STEP_CAST_POINTER_TO_32:
+				for (int i = 0; i < step->data.cast_pointer.array_len; i++) {
+					/* WARNING: 32-bit Blender trying to load file saved by 64-bit Blender,
+					 * pointers may lose uniqueness on truncation! (Hopefully this wont
+					 * happen unless/until we ever get to multi-gigabyte .blend files...) */
+					const int64_t lval = ((const int64_t *)old_data)[i];
+					((int *)new_data)[i] = (int)(lval >> 3);
+				}
+				break;
+			case RECONSTRUCT_STEP_CAST_POINTER_TO_64:
+				for (int i = 0; i < step->data.cast_pointer.array_len; i++) {
+					((int64_t *)new_data)[i] = ((const int *)old_data)[i];
+				}
+				break;
+			case RECONSTRUCT_STEP_SUBSTRUCT:
+				for (int i = 0; i < step->data.substruct.array_len; i++) {
+					reconstruct_struct(reconstruct_info, step->data.substruct.old_struct_nr, old_data, new_data);
+					old_data += step->data.substruct.old_stride;
+					new_data += step->data.substruct.new_stride;
+				}
+				break;
+		}
+	}
+}
+
+/**
+ * \param reconstruct_info: Result from #DNA_reconstruct_info_create.
+ * \param old_struct_nr: Index of struct info within oldsdna
  * \param blocks: The number of array elements
- * \param data: Array of struct data
+ * \param old_blocks: Array of struct data
  * \return An allocated reconstructed struct
  */
 void *DNA_struct_reconstruct(
-        const SDNA *newsdna, const SDNA *oldsdna,
-        const char *compflags, int oldSDNAnr, int blocks, const void *data)
+        const DNA_ReconstructInfo *reconstruct_info, int old_struct_nr, int blocks, const void *old_blocks)
 {
-	int a, curSDNAnr, curlen = 0, oldlen;
-	const short *spo, *spc;
-	char *cur, *cpc;
-	const char *cpo;
-	const char *type;
-
-	/* oldSDNAnr == structnr, we're looking for the corresponding 'cur' number */
-	spo = oldsdna->structs[oldSDNAnr];
-	type = oldsdna->types[spo[0]];
-	oldlen = oldsdna->types_size[spo[0]];
-	curSDNAnr = DNA_struct_find_nr(newsdna, type);
-
-	/* init data and alloc */
-	if (curSDNAnr != -1) {
-		spc = newsdna->structs[curSDNAnr];
-		curlen = newsdna->types_size[spc[0]];
-	}
-	if (curlen == 0) {
+	const ReconstructPlan *plan = &reconstruct_info->plans[old_struct_nr];
+	if (plan->new_struct_nr == -1 || plan->new_size == 0) {
 		return NULL;
 	}
 
-	cur = MEM_callocN(blocks * curlen, "reconstruct");
-	cpc = cur;
-	cpo = data;
-	for (a = 0; a < blocks; a++) {
-		reconstruct_struct(newsdna, oldsdna, compflags, oldSDNAnr, cpo, curSDNAnr, cpc);
-		cpc += curlen;
-		cpo += oldlen;
+	const int old_size = reconstruct_info->oldsdna->types_size[reconstruct_info->oldsdna->structs[old_struct_nr][0]];
+	char *new_blocks = MEM_callocN((size_t)blocks * (size_t)plan->new_size, "reconstruct");
+	const char *old_block = old_blocks;
+	char *new_block = new_blocks;
+	for (int a = 0; a < blocks; a++) {
+		reconstruct_struct(reconstruct_info, old_struct_nr, old_block, new_block);
+		old_block += old_size;
+		new_block += plan->new_size;
 	}
 
-	return cur;
+	return new_blocks;
 }
 
+/** \} */
+
 /**
  * Returns the offset of the field with the specified name and type within the specified
  * struct type in sdna.
@@ -41,6 +41,7 @@
 
 #include "BKE_anim.h"
 #include "BKE_object.h"
+#include "BKE_report.h"
 
 #include "DEG_depsgraph_build.h"
 #include "DEG_depsgraph_debug.h"
@@ -239,6 +240,36 @@ static void rna_Depsgraph_debug_stats_gnuplot(Depsgraph *depsgraph,
 	fclose(f);
 }
 
+static void rna_Depsgraph_debug_trace_begin(void)
+{
+	DEG_debug_trace_begin();
+}
+
+static void rna_Depsgraph_debug_trace_end(void)
+{
+	DEG_debug_trace_end();
+}
+
+static void rna_Depsgraph_debug_trace_write(ReportList *reports, const char *filename)
+{
+	if (!DEG_debug_trace_write(filename)) {
+		BKE_reportf(reports, RPT_ERROR, "Could not write trace to '%s'", filename);
+	}
+}
+
+static void rna_Depsgraph_debug_lookahead_enable(Depsgraph *depsgraph,
+                                                 Main *bmain,
+                                                 int frames,
+                                                 int memory_limit)
+{
+	DEG_lookahead_enable(bmain, depsgraph, frames, (size_t)memory_limit * 1024 * 1024);
+}
+
+static void rna_Depsgraph_debug_lookahead_disable(Depsgraph *depsgraph)
+{
+	DEG_lookahead_disable(depsgraph);
+}
+
 static void rna_Depsgraph_debug_tag_update(Depsgraph *depsgraph)
 {
 	DEG_graph_tag_relations_update(depsgraph);
@@ -594,6 +625,34 @@ static void rna_def_depsgraph(BlenderRNA *brna)
 	                                "File name where gnuplot script will save the result");
 	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
 
+	func = RNA_def_function(srna, "debug_trace_begin", "rna_Depsgraph_debug_trace_begin");
+	RNA_def_function_flag(func, FUNC_NO_SELF);
+	RNA_def_function_ui_description(func, "Start recording evaluation timeline of all dependency graphs, "
+	                                "discarding previously recorded events");
+
+	func = RNA_def_function(srna, "debug_trace_end", "rna_Depsgraph_debug_trace_end");
+	RNA_def_function_flag(func, FUNC_NO_SELF);
+	RNA_def_function_ui_description(func, "Stop recording evaluation timeline");
+
+	func = RNA_def_function(srna, "debug_trace_write", "rna_Depsgraph_debug_trace_write");
+	RNA_def_function_flag(func, FUNC_NO_SELF | FUNC_USE_REPORTS);
+	RNA_def_function_ui_description(func, "Write recorded evaluation timeline in the Chrome trace event format");
+	parm = RNA_def_string_file_path(func, "filename", NULL, FILE_MAX, "File Name",
+	                                "File in which to store the trace");
+	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
+
+	func = RNA_def_function(srna, "debug_lookahead_enable", "rna_Depsgraph_debug_lookahead_enable");
+	RNA_def_function_flag(func, FUNC_USE_MAIN);
+	RNA_def_function_ui_description(func, "Evaluate following frames in the background on frame changes, "
+	                                "as done during playback");
+	parm = RNA_def_int(func, "frames", 1, 1, 64, "Frames", "Number of frames to evaluate ahead", 1, 64);
+	RNA_def_parameter_flags(parm, 0, PARM_REQUIRED);
+	RNA_def_int(func, "memory_limit", 1024, 1, INT_MAX, "Memory Limit",
+	            "Approximate limit of memory used by frames evaluated ahead (in megabytes)", 1, 4096);
+
+	func = RNA_def_function(srna, "debug_lookahead_disable", "rna_Depsgraph_debug_lookahead_disable");
+	RNA_def_function_ui_description(func, "Stop evaluating frames in the background");
+
 	func = RNA_def_function(srna, "debug_tag_update", "rna_Depsgraph_debug_tag_update");
 
 	func = RNA_def_function(srna, "debug_stats", "rna_Depsgraph_debug_stats");
@@ -134,6 +134,66 @@ static CustomData *rna_mesh_ldata(PointerRNA *ptr)
 	return rna_mesh_ldata_helper(me);
 }
 
+/**
+ * Layers might be shared with evaluated copies (see #LIB_ID_COPY_CD_SHARE),
+ * elements given by collections can be edited in place so the layers are made writable first.
+ */
+static void rna_mesh_layer_ensure_writable(Mesh *me, CustomDataLayer *layer)
+{
+	const CustomDataMask type_mask = CD_TYPE_AS_MASK(layer->type);
+	CustomData_MeshMasks mask = {0};
+
+	if (ARRAY_HAS_ITEM(layer, me->vdata.layers, me->vdata.totlayer)) {
+		mask.vmask = type_mask;
+	}
+	else if (ARRAY_HAS_ITEM(layer, me->edata.layers, me->edata.totlayer)) {
+		mask.emask = type_mask;
+	}
+	else if (ARRAY_HAS_ITEM(layer, me->pdata.layers, me->pdata.totlayer)) {
+		mask.pmask = type_mask;
+	}
+	else if (ARRAY_HAS_ITEM(layer, me->ldata.layers, me->ldata.totlayer)) {
+		mask.lmask = type_mask;
+	}
+	else {
+		/* Edit-mesh layers. */
+		return;
+	}
+	BKE_mesh_ensure_writable(me, &mask);
+}
+
+static void rna_Mesh_vertices_begin(CollectionPropertyIterator *iter, PointerRNA *ptr)
+{
+	Mesh *me = rna_mesh(ptr);
+	const CustomData_MeshMasks mask = {.vmask = CD_MASK_MVERT};
+	BKE_mesh_ensure_writable(me, &mask);
+	rna_iterator_array_begin(iter, me->mvert, sizeof(MVert), me->totvert, 0, NULL);
+}
+
+static void rna_Mesh_edges_begin(CollectionPropertyIterator *iter, PointerRNA *ptr)
+{
+	Mesh *me = rna_mesh(ptr);
+	const CustomData_MeshMasks mask = {.emask = CD_MASK_MEDGE};
+	BKE_mesh_ensure_writable(me, &mask);
+	rna_iterator_array_begin(iter, me->medge, sizeof(MEdge), me->totedge, 0, NULL);
+}
+
+static void rna_Mesh_loops_begin(CollectionPropertyIterator *iter, PointerRNA *ptr)
+{
+	Mesh *me = rna_mesh(ptr);
+	const CustomData_MeshMasks mask = {.lmask = CD_MASK_MLOOP};
+	BKE_mesh_ensure_writable(me, &mask);
+	rna_iterator_array_begin(iter, me->mloop, sizeof(MLoop), me->totloop, 0, NULL);
+}
+
+static void rna_Mesh_polygons_begin(CollectionPropertyIterator *iter, PointerRNA *ptr)
+{
+	Mesh *me = rna_mesh(ptr);
+	const CustomData_MeshMasks mask = {.pmask = CD_MASK_MPOLY};
+	BKE_mesh_ensure_writable(me, &mask);
+	rna_iterator_array_begin(iter, me->mpoly, sizeof(MPoly), me->totpoly, 0, NULL);
+}
+
 
 /* -------------------------------------------------------------------- */
 /* Generic CustomData Layer Functions */
@@ -342,6 +402,8 @@ static void rna_MeshLoop_normal_set(PointerRNA *ptr, const float *values)
 {
 	Mesh *me = rna_mesh(ptr);
 	MLoop *ml = (MLoop *)ptr->data;
+	const CustomData_MeshMasks mask = {.lmask = CD_MASK_NORMAL};
+	BKE_mesh_ensure_writable(me, &mask);
 	float (*vec)[3] = CustomData_get(&me->ldata, (int)(ml - me->mloop), CD_NORMAL);
 
 	if (vec) {
@@ -602,6 +664,8 @@ static void rna_MEdge_freestyle_edge_mark_set(PointerRNA *ptr, bool value)
 {
 	Mesh *me = rna_mesh(ptr);
 	MEdge *medge = (MEdge *)ptr->data;
+	const CustomData_MeshMasks mask = {.emask = CD_MASK_FREESTYLE_EDGE};
+	BKE_mesh_ensure_writable(me, &mask);
 	FreestyleEdge *fed = CustomData_get(&me->edata, (int)(medge - me->medge), CD_FREESTYLE_EDGE);
 
 	if (!fed) {
@@ -628,6 +692,8 @@ static void rna_MPoly_freestyle_face_mark_set(PointerRNA *ptr, int value)
 {
 	Mesh *me = rna_mesh(ptr);
 	MPoly *mpoly = (MPoly *)ptr->data;
+	const CustomData_MeshMasks mask = {.pmask = CD_MASK_FREESTYLE_FACE};
+	BKE_mesh_ensure_writable(me, &mask);
 	FreestyleFace *ffa = CustomData_get(&me->pdata, (int)(mpoly - me->mpoly), CD_FREESTYLE_FACE);
 
 	if (!ffa) {
@@ -671,6 +737,7 @@ static void rna_MeshUVLoopLayer_data_begin(CollectionPropertyIterator *iter, Poi
 {
 	Mesh *me = rna_mesh(ptr);
 	CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+	rna_mesh_layer_ensure_writable(me, layer);
 	rna_iterator_array_begin(iter, layer->data, sizeof(MLoopUV), (me->edit_mesh) ? 0 : me->totloop, 0, NULL);
 }
 
@@ -720,6 +787,7 @@ static void rna_MeshLoopColorLayer_data_begin(CollectionPropertyIterator *iter,
 {
 	Mesh *me = rna_mesh(ptr);
 	CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+	rna_mesh_layer_ensure_writable(me, layer);
 	rna_iterator_array_begin(iter, layer->data, sizeof(MLoopCol), (me->edit_mesh) ? 0 : me->totloop, 0, NULL);
 }
 
@@ -854,6 +922,7 @@ static void rna_MeshSkinVertexLayer_data_begin(CollectionPropertyIterator *iter,
 {
 	Mesh *me = rna_mesh(ptr);
 	CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+	rna_mesh_layer_ensure_writable(me, layer);
 	rna_iterator_array_begin(iter, layer->data, sizeof(MVertSkin), me->totvert, 0, NULL);
 }
 
@@ -885,6 +954,7 @@ static void rna_MeshPaintMaskLayer_data_begin(CollectionPropertyIterator *iter,
 {
 	Mesh *me = rna_mesh(ptr);
 	CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+	rna_mesh_layer_ensure_writable(me, layer);
 	rna_iterator_array_begin(iter, layer->data, sizeof(MFloatProperty), me->totvert, 0, NULL);
 }
 
@@ -913,6 +983,7 @@ static void rna_MeshFaceMapLayer_data_begin(CollectionPropertyIterator *iter, Po
 {
 	Mesh *me = rna_mesh(ptr);
 	CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+	rna_mesh_layer_ensure_writable(me, layer);
 	rna_iterator_array_begin(iter, layer->data, sizeof(int), me->totpoly, 0, NULL);
 }
 
@@ -988,6 +1059,8 @@ static void rna_MeshPoly_vertices_set(PointerRNA *ptr, const int *values)
 {
 	Mesh *me = rna_mesh(ptr);
 	MPoly *mp = (MPoly *)ptr->data;
+	const CustomData_MeshMasks mask = {.lmask = CD_MASK_MLOOP};
+	BKE_mesh_ensure_writable(me, &mask);
 	MLoop *ml = &me->mloop[mp->loopstart];
 	unsigned int i;
 	for (i = mp->totloop; i > 0; i--, values++, ml++) {
@@ -1207,12 +1280,14 @@ static void rna_MeshVertexFloatPropertyLayer_data_begin(CollectionPropertyIterat
 {
 	Mesh *me = rna_mesh(ptr);
 	CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+	rna_mesh_layer_ensure_writable(me, layer);
 	rna_iterator_array_begin(iter, layer->data, sizeof(MFloatProperty), me->totvert, 0, NULL);
 }
 static void rna_MeshPolygonFloatPropertyLayer_data_begin(CollectionPropertyIterator *iter, PointerRNA *ptr)
 {
 	Mesh *me = rna_mesh(ptr);
 	CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+	rna_mesh_layer_ensure_writable(me, layer);
 	rna_iterator_array_begin(iter, layer->data, sizeof(MFloatProperty), me->totpoly, 0, NULL);
 }
 
@@ -1256,12 +1331,14 @@ static void rna_MeshVertexIntPropertyLayer_data_begin(CollectionPropertyIterator
 {
 	Mesh *me = rna_mesh(ptr);
 	CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+	rna_mesh_layer_ensure_writable(me, layer);
 	rna_iterator_array_begin(iter, layer->data, sizeof(MIntProperty), me->totvert, 0, NULL);
 }
 static void rna_MeshPolygonIntPropertyLayer_data_begin(CollectionPropertyIterator *iter, PointerRNA *ptr)
 {
 	Mesh *me = rna_mesh(ptr);
 	CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+	rna_mesh_layer_ensure_writable(me, layer);
 	rna_iterator_array_begin(iter, layer->data, sizeof(MIntProperty), me->totpoly, 0, NULL);
 }
 
@@ -1305,12 +1382,14 @@ static void rna_MeshVertexStringPropertyLayer_data_begin(CollectionPropertyItera
 {
 	Mesh *me = rna_mesh(ptr);
 	CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+	rna_mesh_layer_ensure_writable(me, layer);
 	rna_iterator_array_begin(iter, layer->data, sizeof(MStringProperty), me->totvert, 0, NULL);
 }
 static void rna_MeshPolygonStringPropertyLayer_data_begin(CollectionPropertyIterator *iter, PointerRNA *ptr)
 {
 	Mesh *me = rna_mesh(ptr);
 	CustomDataLayer *layer = (CustomDataLayer *)ptr->data;
+	rna_mesh_layer_ensure_writable(me, layer);
 	rna_iterator_array_begin(iter, layer->data, sizeof(MStringProperty), me->totpoly, 0, NULL);
 }
 
@@ -2575,24 +2654,32 @@ static void rna_def_mesh(BlenderRNA *brna)
 
 	prop = RNA_def_property(srna, "vertices", PROP_COLLECTION, PROP_NONE);
 	RNA_def_property_collection_sdna(prop, NULL, "mvert", "totvert");
+	RNA_def_property_collection_funcs(prop, "rna_Mesh_vertices_begin", NULL, NULL, NULL,
+	                                  NULL, NULL, NULL, NULL);
 	RNA_def_property_struct_type(prop, "MeshVertex");
 	RNA_def_property_ui_text(prop, "Vertices", "Vertices of the mesh");
 	rna_def_mesh_vertices(brna, prop);
 
 	prop = RNA_def_property(srna, "edges", PROP_COLLECTION, PROP_NONE);
 	RNA_def_property_collection_sdna(prop, NULL, "medge", "totedge");
+	RNA_def_property_collection_funcs(prop, "rna_Mesh_edges_begin", NULL, NULL, NULL,
+	                                  NULL, NULL, NULL, NULL);
 	RNA_def_property_struct_type(prop, "MeshEdge");
 	RNA_def_property_ui_text(prop, "Edges", "Edges of the mesh");
 	rna_def_mesh_edges(brna, prop);
 
 	prop = RNA_def_property(srna, "loops", PROP_COLLECTION, PROP_NONE);
 	RNA_def_property_collection_sdna(prop, NULL, "mloop", "totloop");
+	RNA_def_property_collection_funcs(prop, "rna_Mesh_loops_begin", NULL, NULL, NULL,
+	                                  NULL, NULL, NULL, NULL);
 	RNA_def_property_struct_type(prop, "MeshLoop");
 	RNA_def_property_ui_text(prop, "Loops", "Loops of the mesh (polygon corners)");
 	rna_def_mesh_loops(brna, prop);
 
 	prop = RNA_def_property(srna, "polygons", PROP_COLLECTION, PROP_NONE);
 	RNA_def_property_collection_sdna(prop, NULL, "mpoly", "totpoly");
+	RNA_def_property_collection_funcs(prop, "rna_Mesh_polygons_begin", NULL, NULL, NULL,
+	                                  NULL, NULL, NULL, NULL);
 	RNA_def_property_struct_type(prop, "MeshPolygon");
 	RNA_def_property_ui_text(prop, "Polygons", "Polygons of the mesh");
 	rna_def_mesh_polygons(brna, prop);
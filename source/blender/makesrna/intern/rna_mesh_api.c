@@ -39,6 +39,7 @@
 
 #include "DNA_mesh_types.h"
 
+#include "BKE_customdata.h"
 #include "BKE_mesh.h"
 #include "BKE_mesh_tangent.h"
 #include "BKE_mesh_mapping.h"
@@ -55,6 +56,27 @@ static const char *rna_Mesh_unit_test_compare(struct Mesh *mesh, struct Mesh *me
 	return ret;
 }
 
+/**
+ * Layers might be shared with evaluated copies (see #LIB_ID_COPY_CD_SHARE),
+ * make them writable before functions edit the mesh in place.
+ */
+static void rna_Mesh_ensure_writable(Mesh *mesh)
+{
+	BKE_mesh_ensure_writable(mesh, &CD_MASK_EVERYTHING);
+}
+
+static void rna_Mesh_calc_normals(Mesh *mesh)
+{
+	rna_Mesh_ensure_writable(mesh);
+	BKE_mesh_calc_normals(mesh);
+}
+
+static void rna_Mesh_calc_normals_split(Mesh *mesh)
+{
+	rna_Mesh_ensure_writable(mesh);
+	BKE_mesh_calc_normals_split(mesh);
+}
+
 static void rna_Mesh_create_normals_split(Mesh *mesh)
 {
 	if (!CustomData_has_layer(&mesh->ldata, CD_NORMAL)) {
@@ -72,6 +94,7 @@ static void rna_Mesh_calc_tangents(Mesh *mesh, ReportList *reports, const char *
 {
 	float (*r_looptangents)[4];
 
+	rna_Mesh_ensure_writable(mesh);
 	if (CustomData_has_layer(&mesh->ldata, CD_MLOOPTANGENT)) {
 		r_looptangents = CustomData_get_layer(&mesh->ldata, CD_MLOOPTANGENT);
 		memset(r_looptangents, 0, sizeof(float[4]) * mesh->totloop);
@@ -132,6 +155,7 @@ static void rna_Mesh_normals_split_custom_set(Mesh *mesh, ReportList *reports, i
 		return;
 	}
 
+	rna_Mesh_ensure_writable(mesh);
 	rna_Mesh_normals_split_custom_do(mesh, loopnors, false);
 
 	DEG_id_tag_update(&mesh->id, 0);
@@ -150,6 +174,7 @@ static void rna_Mesh_normals_split_custom_set_from_vertices(
 		return;
 	}
 
+	rna_Mesh_ensure_writable(mesh);
 	rna_Mesh_normals_split_custom_do(mesh, vertnors, true);
 
 	DEG_id_tag_update(&mesh->id, 0);
@@ -164,6 +189,7 @@ static void rna_Mesh_transform(Mesh *mesh, float *mat, bool shape_keys)
 
 static void rna_Mesh_flip_normals(Mesh *mesh)
 {
+	rna_Mesh_ensure_writable(mesh);
 	BKE_mesh_polygons_flip(mesh->mpoly, mesh->mloop, &mesh->ldata, mesh->totpoly);
 	BKE_mesh_tessface_clear(mesh);
 	BKE_mesh_calc_normals(mesh);
@@ -174,6 +200,7 @@ static void rna_Mesh_flip_normals(Mesh *mesh)
 
 static void rna_Mesh_split_faces(Mesh *mesh, bool free_loop_normals)
 {
+	rna_Mesh_ensure_writable(mesh);
 	BKE_mesh_split_faces(mesh, free_loop_normals != 0);
 }
 
@@ -182,6 +209,18 @@ static void rna_Mesh_update_gpu_tag(Mesh *mesh)
 	BKE_mesh_batch_cache_dirty_tag(mesh, BKE_MESH_BATCH_DIRTY_ALL);
 }
 
+static bool rna_Mesh_validate(Mesh *mesh, bool do_verbose, bool cleanup_cddata)
+{
+	rna_Mesh_ensure_writable(mesh);
+	return BKE_mesh_validate(mesh, do_verbose, cleanup_cddata);
+}
+
+static bool rna_Mesh_validate_material_indices(Mesh *mesh)
+{
+	rna_Mesh_ensure_writable(mesh);
+	return BKE_mesh_validate_material_indices(mesh);
+}
+
 static void rna_Mesh_count_selected_items(Mesh *mesh, int r_count[3])
 {
 	BKE_mesh_count_selected_items(mesh, r_count);
@@ -207,13 +246,13 @@ void RNA_api_mesh(StructRNA *srna)
 	RNA_def_function_ui_description(func, "Invert winding of all polygons "
 	                                      "(clears tessellation, does not handle custom normals)");
 
-	func = RNA_def_function(srna, "calc_normals", "BKE_mesh_calc_normals");
+	func = RNA_def_function(srna, "calc_normals", "rna_Mesh_calc_normals");
 	RNA_def_function_ui_description(func, "Calculate vertex normals");
 
 	func = RNA_def_function(srna, "create_normals_split", "rna_Mesh_create_normals_split");
 	RNA_def_function_ui_description(func, "Empty split vertex normals");
 
-	func = RNA_def_function(srna, "calc_normals_split", "BKE_mesh_calc_normals_split");
+	func = RNA_def_function(srna, "calc_normals_split", "rna_Mesh_calc_normals_split");
 	RNA_def_function_ui_description(func, "Calculate split vertex normals, which preserve sharp edges");
 
 	func = RNA_def_function(srna, "free_normals_split", "rna_Mesh_free_normals_split");
@@ -283,7 +322,7 @@ void RNA_api_mesh(StructRNA *srna)
 	parm = RNA_def_string(func, "result", "nothing", 64, "Return value", "String description of result of comparison");
 	RNA_def_function_return(func, parm);
 
-	func = RNA_def_function(srna, "validate", "BKE_mesh_validate");
+	func = RNA_def_function(srna, "validate", "rna_Mesh_validate");
 	RNA_def_function_ui_description(func, "Validate geometry, return True when the mesh has had "
 	                                "invalid geometry corrected/removed");
 	RNA_def_boolean(func, "verbose", false, "Verbose", "Output information about the errors found");
@@ -292,7 +331,7 @@ void RNA_api_mesh(StructRNA *srna)
 	parm = RNA_def_boolean(func, "result", 0, "Result", "");
 	RNA_def_function_return(func, parm);
 
-	func = RNA_def_function(srna, "validate_material_indices", "BKE_mesh_validate_material_indices");
+	func = RNA_def_function(srna, "validate_material_indices", "rna_Mesh_validate_material_indices");
 	RNA_def_function_ui_description(func, "Validate material indices of polygons, return True when the mesh has had "
 	                                "invalid indices corrected (to default 0)");
 	parm = RNA_def_boolean(func, "result", 0, "Result", "");
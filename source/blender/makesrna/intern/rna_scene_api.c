@@ -59,6 +59,7 @@ const EnumPropertyItem rna_enum_abc_compression_items[] = {
 #include "BKE_scene.h"
 #include "BKE_writeavi.h"
 
+#include "DEG_depsgraph.h"
 #include "DEG_depsgraph_query.h"
 
 #include "ED_transform.h"
@@ -92,6 +93,9 @@ static void rna_Scene_frame_set(Scene *scene, Main *bmain, int frame, float subf
 	BPy_END_ALLOW_THREADS;
 #endif
 
+	/* The script may change original data next, frames evaluated ahead are built from it. */
+	DEG_lookahead_wait_all(bmain);
+
 	BKE_scene_camera_switch_update(scene);
 
 	/* don't do notifier when we're rendering, avoid some viewport crashes
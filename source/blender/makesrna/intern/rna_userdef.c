@@ -4412,6 +4412,19 @@ static void rna_def_userdef_system(BlenderRNA *brna)
 	RNA_def_property_ui_text(prop, "Memory Cache Limit", "Memory cache limit (in megabytes)");
 	RNA_def_property_update(prop, 0, "rna_Userdef_memcache_update");
 
+	prop = RNA_def_property(srna, "playback_lookahead_frames", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "playback_lookahead_frames");
+	RNA_def_property_range(prop, 0, 64);
+	RNA_def_property_ui_text(prop, "Lookahead Frames",
+	                         "Number of frames to evaluate ahead in the background during playback, "
+	                         "for scenes without simulations (0 to disable)");
+
+	prop = RNA_def_property(srna, "playback_lookahead_memory", PROP_INT, PROP_NONE);
+	RNA_def_property_int_sdna(prop, NULL, "playback_lookahead_memory");
+	RNA_def_property_range(prop, 0, min_ii(max_memory_in_megabytes_int(), SHRT_MAX));
+	RNA_def_property_ui_text(prop, "Lookahead Memory Limit",
+	                         "Approximate limit of memory used by frames evaluated ahead (in megabytes)");
+
 	prop = RNA_def_property(srna, "scrollback", PROP_INT, PROP_UNSIGNED);
 	RNA_def_property_int_sdna(prop, NULL, "scrollback");
 	RNA_def_property_range(prop, 32, 32768);
@@ -67,23 +67,33 @@ static void requiredDataMask(Object *UNUSED(ob), ModifierData *md, CustomData_Me
 	}
 }
 
+typedef struct DecimateSyncToOriginal {
+	Object *object;
+	DecimateModifierData *dmd;
+} DecimateSyncToOriginal;
+
 static DecimateModifierData *getOriginalModifierData(
-        const DecimateModifierData *dmd, const ModifierEvalContext *ctx)
+        const DecimateModifierData *dmd, Object *object)
 {
-	Object *ob_orig = DEG_get_original_object(ctx->object);
+	Object *ob_orig = DEG_get_original_object(object);
 	return (DecimateModifierData *)modifiers_findByName(ob_orig, dmd->modifier.name);
 }
 
+static void updateFaceCountOriginal(struct Depsgraph *UNUSED(depsgraph), void *sync_v)
+{
+	const DecimateSyncToOriginal *sync = sync_v;
+	DecimateModifierData *dmd_orig = getOriginalModifierData(sync->dmd, sync->object);
+	dmd_orig->face_count = sync->dmd->face_count;
+}
+
 static void updateFaceCount(
         const ModifierEvalContext *ctx, DecimateModifierData *dmd, int face_count)
 {
 	dmd->face_count = face_count;
 
-	if (DEG_is_active(ctx->depsgraph)) {
-		/* update for display only */
-		DecimateModifierData *dmd_orig = getOriginalModifierData(dmd, ctx);
-		dmd_orig->face_count = face_count;
-	}
+	/* update for display only */
+	DecimateSyncToOriginal sync = {ctx->object, dmd};
+	DEG_sync_to_original(ctx->depsgraph, updateFaceCountOriginal, &sync, sizeof(sync));
 }
 
 static Mesh *applyModifier(
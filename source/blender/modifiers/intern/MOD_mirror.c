@@ -199,8 +199,9 @@ static Mesh *doMirrorOnAxis(
 	const int maxLoops = mesh->totloop;
 	const int maxPolys = mesh->totpoly;
 
-	result = BKE_mesh_new_nomain_from_template(
-	        mesh, maxVerts * 2, maxEdges * 2, 0, maxLoops * 2, maxPolys * 2);
+	/* All elements are written below, from the original geometry or its mirrored copy. */
+	result = BKE_mesh_new_nomain_from_template_ex(
+	        mesh, maxVerts * 2, maxEdges * 2, 0, maxLoops * 2, maxPolys * 2, true);
 
 	/*copy customdata to original geometry*/
 	CustomData_copy_data(&mesh->vdata, &result->vdata, 0, 0, maxVerts);
@@ -29,13 +29,10 @@
 /* analogue of PyEval_SaveThread() */
 BPy_ThreadStatePtr BPY_thread_save(void)
 {
-	PyThreadState *tstate = PyThreadState_Swap(NULL);
-	/* note: tstate can be NULL when quitting Blender */
-
-	if (tstate && PyEval_ThreadsInitialized()) {
-		PyEval_ReleaseLock();
+	PyThreadState *tstate = _PyThreadState_UncheckedGet();
+	if (tstate) {
+		PyEval_SaveThread();
 	}
-
 	return (BPy_ThreadStatePtr)tstate;
 }
 
@@ -322,13 +322,15 @@ void PyC_FileAndNum(const char **filename, int *lineno)
 	if (filename) *filename = NULL;
 	if (lineno)   *lineno = -1;
 
-	if (!(frame = PyThreadState_GET()->frame)) {
+	if (!(frame = PyEval_GetFrame())) {
 		return;
 	}
 
 	/* when executing a script */
 	if (filename) {
-		*filename = _PyUnicode_AsString(frame->f_code->co_filename);
+		PyCodeObject *code = PyFrame_GetCode(frame);
+		*filename = _PyUnicode_AsString(code->co_filename);
+		Py_DECREF(code);
 	}
 
 	/* when executing a module */
@@ -708,9 +710,8 @@ PyObject *PyC_UnicodeFromByte(const char *str)
  ****************************************************************************/
 PyObject *PyC_DefaultNameSpace(const char *filename)
 {
-	PyInterpreterState *interp = PyThreadState_GET()->interp;
 	PyObject *mod_main = PyModule_New("__main__");
-	PyDict_SetItemString(interp->modules, "__main__", mod_main);
+	PyDict_SetItemString(PyImport_GetModuleDict(), "__main__", mod_main);
 	Py_DECREF(mod_main); /* sys.modules owns now */
 	PyModule_AddStringConstant(mod_main, "__name__", "__main__");
 	if (filename) {
@@ -718,8 +719,9 @@ PyObject *PyC_DefaultNameSpace(const char *filename)
 		 * note: this wont map to a real file when executing text-blocks and buttons. */
 		PyModule_AddObject(mod_main, "__file__", PyC_UnicodeFromByte(filename));
 	}
-	PyModule_AddObject(mod_main, "__builtins__", interp->builtins);
-	Py_INCREF(interp->builtins); /* AddObject steals a reference */
+	PyObject *builtins = PyEval_GetBuiltins();
+	PyModule_AddObject(mod_main, "__builtins__", builtins);
+	Py_INCREF(builtins); /* AddObject steals a reference */
 	return PyModule_GetDict(mod_main);
 }
 
@@ -746,15 +748,13 @@ bool PyC_NameSpace_ImportArray(PyObject *py_dict, const char *imports[])
 /* restore MUST be called after this */
 void PyC_MainModule_Backup(PyObject **main_mod)
 {
-	PyInterpreterState *interp = PyThreadState_GET()->interp;
-	*main_mod = PyDict_GetItemString(interp->modules, "__main__");
+	*main_mod = PyDict_GetItemString(PyImport_GetModuleDict(), "__main__");
 	Py_XINCREF(*main_mod); /* don't free */
 }
 
 void PyC_MainModule_Restore(PyObject *main_mod)
 {
-	PyInterpreterState *interp = PyThreadState_GET()->interp;
-	PyDict_SetItemString(interp->modules, "__main__", main_mod);
+	PyDict_SetItemString(PyImport_GetModuleDict(), "__main__", main_mod);
 	Py_XDECREF(main_mod);
 }
 
@@ -26,6 +26,8 @@
 #include "BLI_utildefines.h"
 #include "BLI_callbacks.h"
 
+#include "DEG_depsgraph.h"
+
 #include "RNA_types.h"
 #include "RNA_access.h"
 #include "bpy_rna.h"
@@ -287,10 +289,15 @@ void BPY_app_handlers_reset(const short do_all)
 }
 
 /* the actual callback - not necessarily called from py */
-void bpy_app_generic_callback(struct Main *UNUSED(main), struct ID *id, void *arg)
+void bpy_app_generic_callback(struct Main *main, struct ID *id, void *arg)
 {
 	PyObject *cb_list = py_cb_array[POINTER_AS_INT(arg)];
 	if (PyList_GET_SIZE(cb_list) > 0) {
+		/* Handlers may change original data, frames evaluated ahead are built from it. */
+		if (main != NULL) {
+			DEG_lookahead_wait_all(main);
+		}
+
 		PyGILState_STATE gilstate = PyGILState_Ensure();
 
 		PyObject *args = PyTuple_New(1);  /* save python creating each call */
@@ -23,6 +23,10 @@
 #include "BLI_timer.h"
 #include "PIL_time.h"
 
+#include "BKE_global.h"
+
+#include "DEG_depsgraph.h"
+
 #include "BPY_extern.h"
 #include "bpy_app_timers.h"
 
@@ -62,6 +66,9 @@ static double py_timer_execute(uintptr_t UNUSED(uuid), void *user_data)
 {
 	PyObject *function = user_data;
 
+	/* Timers may change original data, frames evaluated ahead are built from it. */
+	DEG_lookahead_wait_all(G_MAIN);
+
 	PyGILState_STATE gilstate;
 	gilstate = PyGILState_Ensure();
 
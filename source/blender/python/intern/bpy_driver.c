@@ -48,7 +48,7 @@ extern void BPY_update_rna_module(void);
 
 #define USE_RNA_AS_PYOBJECT
 
-#define USE_BYTECODE_WHITELIST
+// #define USE_BYTECODE_WHITELIST
 
 #ifdef USE_BYTECODE_WHITELIST
 #  include <opcode.h>
@@ -322,6 +322,7 @@ void BPY_python_start(int argc, const char **argv)
 
 	/* bpy.* and lets us import it */
 	BPy_init_modules();
+	Py_XDECREF(PyImport_ImportModule("mathutils"));
 
 	bpy_import_init(PyEval_GetBuiltins());
 
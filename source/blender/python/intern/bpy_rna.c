@@ -6009,7 +6009,11 @@ PyTypeObject pyrna_struct_Type = {
 	NULL,                       /* PyBufferProcs *tp_as_buffer; */
 
 	/*** Flags to define presence of optional/expanded features ***/
+#ifdef USE_PYRNA_STRUCT_REFERENCE
 	Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC, /* long tp_flags; */
+#else
+	Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE, /* long tp_flags; */
+#endif
 
 	NULL,                       /*  char *tp_doc;  Documentation string */
 	/*** Assigned meaning in release 2.0 ***/
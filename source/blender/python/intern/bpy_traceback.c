@@ -35,7 +35,7 @@
 
 static const char *traceback_filepath(PyTracebackObject *tb, PyObject **coerce)
 {
-	return PyBytes_AS_STRING((*coerce = PyUnicode_EncodeFSDefault(tb->tb_frame->f_code->co_filename)));
+	return PyBytes_AS_STRING((*coerce = PyUnicode_EncodeFSDefault(PyFrame_GetCode(tb->tb_frame)->co_filename)));
 }
 
 /* copied from pythonrun.c, 3.4.0 */
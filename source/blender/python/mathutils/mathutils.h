@@ -25,6 +25,8 @@
 
 #include "BLI_compiler_attrs.h"
 
+typedef PyObject *(*PyNoArgsFunction)(PyObject *);
+
 struct DynStr;
 
 extern char BaseMathObject_is_wrapped_doc[];
@@ -549,6 +549,7 @@ enum {
 	WM_JOB_TYPE_SHADER_COMPILATION,
 	WM_JOB_TYPE_STUDIOLIGHT,
 	WM_JOB_TYPE_LIGHT_BAKE,
+	WM_JOB_TYPE_AUTOSAVE,
 	/* add as needed, screencast, seq proxy build
 	 * if having hard coded values is a problem */
 };
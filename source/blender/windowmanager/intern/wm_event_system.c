@@ -2977,6 +2977,14 @@ void wm_event_do_handlers(bContext *C)
 	WM_keyconfig_update(wm);
 	WM_gizmoconfig_update(CTX_data_main(C));
 
+	/* Handlers change original data, frames evaluated ahead are built from it. */
+	for (win = wm->windows.first; win; win = win->next) {
+		if (win->queue.first != NULL) {
+			DEG_lookahead_wait_all(CTX_data_main(C));
+			break;
+		}
+	}
+
 	for (win = wm->windows.first; win; win = win->next) {
 		bScreen *screen = WM_window_get_active_screen(win);
 		wmEvent *event;
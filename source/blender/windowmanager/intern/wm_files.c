@@ -1393,6 +1393,53 @@ void WM_autosave_init(wmWindowManager *wm)
 		wm->autosavetimer = WM_event_add_timer(wm, NULL, TIMERAUTOSAVE, U.savetime * 60.0);
 }
 
+typedef struct AutosaveJob {
+	/** Copy of the data to write, independent of the undo stack. */
+	MemFile memfile;
+	char filepath[FILE_MAX];
+	bool use_compress;
+} AutosaveJob;
+
+static void wm_autosave_job_startjob(void *customdata, short *stop, short *do_update, float *progress)
+{
+	AutosaveJob *job = customdata;
+
+	BLO_memfile_write_file_ex(&job->memfile, job->filepath, job->use_compress, stop, progress);
+	*do_update = true;
+}
+
+static void wm_autosave_job_free(void *customdata)
+{
+	AutosaveJob *job = customdata;
+
+	BLO_memfile_free(&job->memfile);
+	MEM_freeN(job);
+}
+
+/**
+ * Write the last undo step from a job, only copying it on the main thread.
+ * The file is written to a temporary file first, so a previous auto-save is kept
+ * until the new one is complete (or when the job is canceled, e.g. when loading a file).
+ */
+static void wm_autosave_write_job(wmWindowManager *wm, const char *filepath)
+{
+	struct MemFile *memfile = ED_undosys_stack_memfile_get_active(wm->undo_stack);
+	if (memfile == NULL) {
+		return;
+	}
+
+	AutosaveJob *job = MEM_callocN(sizeof(*job), __func__);
+	BLI_strncpy(job->filepath, filepath, sizeof(job->filepath));
+	job->use_compress = (U.flag & USER_FILECOMPRESS) != 0;
+	BLO_memfile_snapshot(memfile, &job->memfile);
+
+	wmJob *wm_job = WM_jobs_get(wm, NULL, wm, "Auto-Saving", WM_JOB_PROGRESS, WM_JOB_TYPE_AUTOSAVE);
+	WM_jobs_customdata_set(wm_job, job, wm_autosave_job_free);
+	WM_jobs_timer(wm_job, 0.1, 0, 0);
+	WM_jobs_callbacks(wm_job, wm_autosave_job_startjob, NULL, NULL, NULL);
+	WM_jobs_start(wm, wm_job);
+}
+
 void wm_autosave_timer(const bContext *C, wmWindowManager *wm, wmTimer *UNUSED(wt))
 {
 	char filepath[FILE_MAX];
@@ -1415,17 +1462,24 @@ void wm_autosave_timer(const bContext *C, wmWindowManager *wm, wmTimer *UNUSED(w
 		}
 	}
 
+	/* the previous auto-save is still being written, try again in 10 seconds */
+	if (WM_jobs_test(wm, wm, WM_JOB_TYPE_AUTOSAVE)) {
+		wm->autosavetimer = WM_event_add_timer(wm, NULL, TIMERAUTOSAVE, 10.0);
+		if (G.debug) {
+			printf("Skipping auto-save, previous auto-save running, retrying in ten seconds...\n");
+		}
+		return;
+	}
+
 	wm_autosave_location(filepath);
 
 	if (U.uiflag & USER_GLOBALUNDO) {
 		/* fast save of last undobuffer, now with UI */
-		struct MemFile *memfile = ED_undosys_stack_memfile_get_active(wm->undo_stack);
-		if (memfile) {
-			BLO_memfile_write_file(memfile, filepath);
-		}
+		wm_autosave_write_job(wm, filepath);
 	}
 	else {
-		/*  save as regular blend file */
+		/* Save as regular blend file, on the main thread since Main can't change while it's written.
+		 * Writing it to a memfile instead would leave out data of regular files (the light cache...). */
 		Main *bmain = CTX_data_main(C);
 		int fileflags = G.fileflags & ~(G_FILE_COMPRESS | G_FILE_HISTORY);
 
@@ -1434,7 +1488,7 @@ void wm_autosave_timer(const bContext *C, wmWindowManager *wm, wmTimer *UNUSED(w
 		/* Error reporting into console */
 		BLO_write_file(bmain, filepath, fileflags, NULL, NULL);
 	}
-	/* do timer after file write, just in case file write takes a long time */
+
 	wm->autosavetimer = WM_event_add_timer(wm, NULL, TIMERAUTOSAVE, U.savetime * 60.0);
 }
 
@@ -2243,6 +2297,9 @@ static int wm_save_as_mainfile_exec(bContext *C, wmOperator *op)
 	        (RNA_struct_property_is_set(op->ptr, "copy") &&
 	         RNA_boolean_get(op->ptr, "copy")),
 	        G_FILE_SAVE_COPY);
+	SET_FLAG_FROM_TEST(
+	        fileflags, RNA_boolean_get(op->ptr, "use_threads"),
+	        G_FILE_SAVE_PARALLEL);
 
 	const bool ok = wm_file_write(C, path, fileflags, op->reports);
 
@@ -2300,6 +2357,8 @@ void WM_OT_save_as_mainfile(wmOperatorType *ot)
 	RNA_def_boolean(ot->srna, "compress", false, "Compress", "Write compressed .blend file");
 	RNA_def_boolean(ot->srna, "relative_remap", true, "Remap Relative",
 	                "Make paths relative when saving to a different directory");
+	RNA_def_boolean(ot->srna, "use_threads", false, "Use Threads",
+	                "Write data-blocks on multiple threads (experimental, the file is the same)");
 	prop = RNA_def_boolean(ot->srna, "copy", false, "Save Copy",
 	                "Save a copy of the actual working state but does not make saved file active");
 	RNA_def_property_flag(prop, PROP_SKIP_SAVE);
@@ -2359,6 +2418,8 @@ void WM_OT_save_mainfile(wmOperatorType *ot)
 	RNA_def_boolean(ot->srna, "compress", false, "Compress", "Write compressed .blend file");
 	RNA_def_boolean(ot->srna, "relative_remap", false, "Remap Relative",
 	                "Make paths relative when saving to a different directory");
+	RNA_def_boolean(ot->srna, "use_threads", false, "Use Threads",
+	                "Write data-blocks on multiple threads (experimental, the file is the same)");
 
 	prop = RNA_def_boolean(ot->srna, "exit", false, "Exit", "Exit Blender after saving");
 	RNA_def_property_flag(prop, PROP_HIDDEN | PROP_SKIP_SAVE);
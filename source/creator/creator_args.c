@@ -498,6 +498,7 @@ static int arg_handle_print_help(int UNUSED(argc), const char **UNUSED(argv), vo
 	BLI_argsPrintArgDoc(ba, "--render-output");
 	BLI_argsPrintArgDoc(ba, "--engine");
 	BLI_argsPrintArgDoc(ba, "--threads");
+	BLI_argsPrintArgDoc(ba, "--threads-work-stealing");
 
 	printf("\n");
 	printf("Format Options:\n");
@@ -568,6 +569,8 @@ static int arg_handle_print_help(int UNUSED(argc), const char **UNUSED(argv), vo
 	BLI_argsPrintArgDoc(ba, "--debug-depsgraph-no-threads");
 	BLI_argsPrintArgDoc(ba, "--debug-depsgraph-time");
 	BLI_argsPrintArgDoc(ba, "--debug-depsgraph-pretty");
+	BLI_argsPrintArgDoc(ba, "--debug-depsgraph-validate");
+	BLI_argsPrintArgDoc(ba, "--debug-depsgraph-trace");
 	BLI_argsPrintArgDoc(ba, "--debug-gpu");
 	BLI_argsPrintArgDoc(ba, "--debug-gpumem");
 	BLI_argsPrintArgDoc(ba, "--debug-gpu-shaders");
@@ -908,6 +911,8 @@ static const char arg_handle_debug_mode_generic_set_doc_depsgraph_no_threads[] =
 "\n\tSwitch dependency graph to a single threaded evaluation.";
 static const char arg_handle_debug_mode_generic_set_doc_depsgraph_pretty[] =
 "\n\tEnable colors for dependency graph debug messages.";
+static const char arg_handle_debug_mode_generic_set_doc_depsgraph_validate[] =
+"\n\tCompare partially rebuilt dependency graph against a full rebuild and report differences.";
 static const char arg_handle_debug_mode_generic_set_doc_gpumem[] =
 "\n\tEnable GPU memory stats in status bar.";
 
@@ -917,6 +922,25 @@ static int arg_handle_debug_mode_generic_set(int UNUSED(argc), const char **UNUS
 	return 0;
 }
 
+static const char arg_handle_debug_depsgraph_trace_doc[] =
+"<filename>\n"
+"\n"
+"\tRecord dependency graph evaluation and write it to a Chrome trace file on exit."
+;
+static int arg_handle_debug_depsgraph_trace(int argc, const char **argv, void *UNUSED(data))
+{
+	const char *arg_id = "--debug-depsgraph-trace";
+	if (argc > 1) {
+		DEG_debug_trace_begin();
+		DEG_debug_trace_write_on_exit(argv[1]);
+		return 1;
+	}
+	else {
+		printf("\nError: '%s' no args given.\n", arg_id);
+		return 0;
+	}
+}
+
 static const char arg_handle_debug_mode_io_doc[] =
 "\n\tEnable debug messages for I/O (collada, ...).";
 static int arg_handle_debug_mode_io(int UNUSED(argc), const char **UNUSED(argv), void *UNUSED(data))
@@ -1369,6 +1393,15 @@ static int arg_handle_threads_set(int argc, const char **argv, void *UNUSED(data
 	}
 }
 
+static const char arg_handle_threads_work_stealing_set_doc[] =
+"\n\tUse per-thread work-stealing queues in the task scheduler."
+;
+static int arg_handle_threads_work_stealing_set(int UNUSED(argc), const char **UNUSED(argv), void *UNUSED(data))
+{
+	BLI_system_work_stealing_set(true);
+	return 0;
+}
+
 static const char arg_handle_verbosity_set_doc[] =
 "<verbose>\n"
 "\tSet logging verbosity level."
@@ -1977,6 +2010,9 @@ void main_args_setup(bContext *C, bArgs *ba)
 	            CB_EX(arg_handle_debug_mode_generic_set, depsgraph_no_threads), (void *)G_DEBUG_DEPSGRAPH_NO_THREADS);
 	BLI_argsAdd(ba, 1, NULL, "--debug-depsgraph-pretty",
 	            CB_EX(arg_handle_debug_mode_generic_set, depsgraph_pretty), (void *)G_DEBUG_DEPSGRAPH_PRETTY);
+	BLI_argsAdd(ba, 1, NULL, "--debug-depsgraph-validate",
+	            CB_EX(arg_handle_debug_mode_generic_set, depsgraph_validate), (void *)G_DEBUG_DEPSGRAPH_VALIDATE);
+	BLI_argsAdd(ba, 1, NULL, "--debug-depsgraph-trace", CB(arg_handle_debug_depsgraph_trace), NULL);
 	BLI_argsAdd(ba, 1, NULL, "--debug-gpumem",
 	            CB_EX(arg_handle_debug_mode_generic_set, gpumem), (void *)G_DEBUG_GPU_MEM);
 	BLI_argsAdd(ba, 1, NULL, "--debug-gpu-shaders",
@@ -2030,6 +2066,7 @@ void main_args_setup(bContext *C, bArgs *ba)
 
 	BLI_argsAdd(ba, 4, "-F", "--render-format", CB(arg_handle_image_type_set), C);
 	BLI_argsAdd(ba, 1, "-t", "--threads", CB(arg_handle_threads_set), NULL);
+	BLI_argsAdd(ba, 1, NULL, "--threads-work-stealing", CB(arg_handle_threads_work_stealing_set), NULL);
 	BLI_argsAdd(ba, 4, "-x", "--use-extension", CB(arg_handle_extension_set), C);
 
 #undef CB
@@ -9,6 +9,7 @@ extern "C" {
 #include "MEM_guardedalloc.h"
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
+#include "BLI_ohash.h"
 #include "BLI_rand.h"
 #include "BLI_string.h"
 #include "PIL_time_utildefines.h"
@@ -534,3 +535,166 @@ TEST(ghash, MultiRandIntMurmur2a200000)
 
 	multi_small_ghash_tests(ghash, "MultiSmall RandIntGHash - Murmur2a - 200000", 200000);
 }
+
+
+/* Ptr: GHash vs. OHash (open addressing), insert, lookup and remove of pointer keys. */
+
+static void **ptr_keys_create(const unsigned int nbr)
+{
+	void **keys = (void **)MEM_mallocN(sizeof(*keys) * (size_t)nbr, __func__);
+	unsigned int i;
+
+	/* Fake 16 bytes aligned addresses, similar to what allocators give. */
+	for (i = 0; i < nbr; i++) {
+		keys[i] = (void *)((uintptr_t)0x10000000 + (uintptr_t)i * 16);
+	}
+
+	RNG *rng = BLI_rng_new(0);
+	BLI_rng_shuffle_array(rng, keys, sizeof(*keys), nbr);
+	BLI_rng_free(rng);
+
+	return keys;
+}
+
+static void ptr_ghash_tests(const char *id, const unsigned int nbr)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	void **keys = ptr_keys_create(nbr);
+	GHash *ghash = BLI_ghash_ptr_new(__func__);
+	unsigned int i;
+
+	{
+		TIMEIT_START(ptr_ghash_insert);
+
+		for (i = 0; i < nbr; i++) {
+			BLI_ghash_insert(ghash, keys[i], keys[i]);
+		}
+
+		TIMEIT_END(ptr_ghash_insert);
+	}
+
+	{
+		TIMEIT_START(ptr_ghash_lookup);
+
+		for (i = 0; i < nbr; i++) {
+			void *v = BLI_ghash_lookup(ghash, keys[i]);
+			EXPECT_EQ(v, keys[i]);
+		}
+
+		TIMEIT_END(ptr_ghash_lookup);
+	}
+
+	{
+		TIMEIT_START(ptr_ghash_remove);
+
+		for (i = 0; i < nbr; i++) {
+			EXPECT_TRUE(BLI_ghash_remove(ghash, keys[i], NULL, NULL));
+		}
+
+		TIMEIT_END(ptr_ghash_remove);
+	}
+	EXPECT_EQ(BLI_ghash_len(ghash), 0);
+
+	BLI_ghash_free(ghash, NULL, NULL);
+	MEM_freeN(keys);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+static void ptr_ohash_tests(const char *id, const unsigned int nbr)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	void **keys = ptr_keys_create(nbr);
+	OHash *ohash = BLI_ohash_ptr_new(__func__);
+	unsigned int i;
+
+	{
+		TIMEIT_START(ptr_ohash_insert);
+
+		for (i = 0; i < nbr; i++) {
+			BLI_ohash_insert(ohash, keys[i], keys[i]);
+		}
+
+		TIMEIT_END(ptr_ohash_insert);
+	}
+
+	{
+		double load;
+		int longest_probe;
+		const double quality = BLI_ohash_calc_quality_ex(ohash, &load, &longest_probe);
+		printf("OHash stats (%u entries):\n\tAverage probe: %f\n\tLoad: %f\n\tLongest probe: %d\n",
+		       BLI_ohash_len(ohash), quality, load, longest_probe);
+	}
+
+	{
+		TIMEIT_START(ptr_ohash_lookup);
+
+		for (i = 0; i < nbr; i++) {
+			void *v = BLI_ohash_lookup(ohash, keys[i]);
+			EXPECT_EQ(v, keys[i]);
+		}
+
+		TIMEIT_END(ptr_ohash_lookup);
+	}
+
+	{
+		TIMEIT_START(ptr_ohash_lookup_inline);
+
+		for (i = 0; i < nbr; i++) {
+			void *v = BLI_ohash_ptr_lookup(ohash, keys[i]);
+			EXPECT_EQ(v, keys[i]);
+		}
+
+		TIMEIT_END(ptr_ohash_lookup_inline);
+	}
+
+	{
+		TIMEIT_START(ptr_ohash_remove);
+
+		for (i = 0; i < nbr; i++) {
+			EXPECT_TRUE(BLI_ohash_remove(ohash, keys[i], NULL, NULL));
+		}
+
+		TIMEIT_END(ptr_ohash_remove);
+	}
+	EXPECT_EQ(BLI_ohash_len(ohash), 0);
+
+	BLI_ohash_free(ohash, NULL, NULL);
+	MEM_freeN(keys);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(ghash, PtrGHash1000)
+{
+	ptr_ghash_tests("PtrGHash - GHash - 1000", 1000);
+}
+
+TEST(ghash, PtrOHash1000)
+{
+	ptr_ohash_tests("PtrGHash - OHash - 1000", 1000);
+}
+
+TEST(ghash, PtrGHash1000000)
+{
+	ptr_ghash_tests("PtrGHash - GHash - 1000000", 1000000);
+}
+
+TEST(ghash, PtrOHash1000000)
+{
+	ptr_ohash_tests("PtrGHash - OHash - 1000000", 1000000);
+}
+
+#ifdef GHASH_RUN_BIG
+TEST(ghash, PtrGHash100000000)
+{
+	ptr_ghash_tests("PtrGHash - GHash - 100000000", 100000000);
+}
+
+TEST(ghash, PtrOHash100000000)
+{
+	ptr_ohash_tests("PtrGHash - OHash - 100000000", 100000000);
+}
+#endif
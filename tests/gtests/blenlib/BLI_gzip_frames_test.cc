@@ -0,0 +1,176 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <vector>
+
+#include "zlib.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "BLI_gzip_frames.h"
+#include "BLI_rand.h"
+#include "BLI_threads.h"
+}
+
+#ifdef WIN32
+#  include <io.h>
+#  define ftruncate _chsize
+#else
+#  include <unistd.h>
+#endif
+
+/* Compressible data, with some noise so frames don't all compress the same. */
+static std::vector<unsigned char> data_create(size_t len)
+{
+	std::vector<unsigned char> data(len);
+	RNG *rng = BLI_rng_new(len);
+	for (size_t i = 0; i < len; i++) {
+		data[i] = (unsigned char)((i % 251) ^ ((BLI_rng_get_uint(rng) & 0x3) == 0 ? 0xff : 0));
+	}
+	BLI_rng_free(rng);
+	return data;
+}
+
+static void file_write(FILE *fp, const std::vector<unsigned char> &data, size_t chunk)
+{
+	GzFramesWriter *gw = BLI_gzframes_writer_new(fileno(fp), 1);
+	for (size_t i = 0; i < data.size(); i += chunk) {
+		EXPECT_TRUE(BLI_gzframes_writer_write(gw, &data[i], std::min(chunk, data.size() - i)));
+	}
+	EXPECT_TRUE(BLI_gzframes_writer_free(gw));
+}
+
+static void file_read_check(FILE *fp, const std::vector<unsigned char> &data)
+{
+	GzFramesReader *gr = BLI_gzframes_reader_new(fileno(fp));
+	ASSERT_TRUE(gr != NULL);
+	EXPECT_EQ(data.size(), BLI_gzframes_reader_size(gr));
+	const size_t frames_len = std::max(
+	        (size_t)1, (data.size() + GZ_FRAMES_FRAME_SIZE - 1) / GZ_FRAMES_FRAME_SIZE);
+	EXPECT_EQ(frames_len, BLI_gzframes_reader_frames_len(gr));
+
+	std::vector<unsigned char> data_read(data.size() + 1);
+	EXPECT_EQ(data.size(), BLI_gzframes_reader_read(gr, data_read.data(), data_read.size()));
+	data_read.resize(data.size());
+	EXPECT_TRUE(data == data_read);
+	BLI_gzframes_reader_free(gr);
+}
+
+/* Any gzip reader must be able to read the file as a single stream. */
+static void file_read_gzip_check(FILE *fp, const std::vector<unsigned char> &data)
+{
+	lseek(fileno(fp), 0, SEEK_SET);
+	gzFile gz = gzdopen(dup(fileno(fp)), "rb");
+	ASSERT_TRUE(gz != NULL);
+	std::vector<unsigned char> data_read(data.size() + 1);
+	EXPECT_EQ(data.size(), gzread(gz, data_read.data(), (unsigned int)data_read.size()));
+	data_read.resize(data.size());
+	EXPECT_TRUE(data == data_read);
+	gzclose(gz);
+}
+
+static void roundtrip_test(size_t len, size_t chunk)
+{
+	BLI_threadapi_init();
+	FILE *fp = tmpfile();
+	ASSERT_TRUE(fp != NULL);
+
+	std::vector<unsigned char> data = data_create(len);
+	file_write(fp, data, chunk);
+	file_read_check(fp, data);
+	file_read_gzip_check(fp, data);
+
+	fclose(fp);
+	BLI_threadapi_exit();
+}
+
+TEST(gzip_frames, Empty)
+{
+	roundtrip_test(0, 1);
+}
+
+TEST(gzip_frames, Small)
+{
+	roundtrip_test(1000, 7);
+}
+
+TEST(gzip_frames, FrameExact)
+{
+	roundtrip_test(GZ_FRAMES_FRAME_SIZE * 2, 4096);
+}
+
+TEST(gzip_frames, ManyFrames)
+{
+	/* More frames than a single compression batch. */
+	roundtrip_test(GZ_FRAMES_FRAME_SIZE * 37 + 123, 100000);
+}
+
+TEST(gzip_frames, Seek)
+{
+	BLI_threadapi_init();
+	FILE *fp = tmpfile();
+	ASSERT_TRUE(fp != NULL);
+
+	const size_t len = GZ_FRAMES_FRAME_SIZE * 5 + 1000;
+	std::vector<unsigned char> data = data_create(len);
+	file_write(fp, data, len);
+
+	GzFramesReader *gr = BLI_gzframes_reader_new(fileno(fp));
+	ASSERT_TRUE(gr != NULL);
+	RNG *rng = BLI_rng_new(0);
+	unsigned char buf[5000];
+	for (int i = 0; i < 200; i++) {
+		/* Reads crossing frame boundaries and the end of the file. */
+		const int64_t offset = (int64_t)(BLI_rng_get_uint(rng) % len);
+		EXPECT_EQ(offset, BLI_gzframes_reader_seek(gr, offset, SEEK_SET));
+		const int64_t read_len = BLI_gzframes_reader_read(gr, buf, sizeof(buf));
+		EXPECT_EQ(std::min((int64_t)sizeof(buf), (int64_t)len - offset), read_len);
+		EXPECT_EQ(0, memcmp(buf, &data[offset], (size_t)read_len));
+		EXPECT_EQ(offset + read_len, BLI_gzframes_reader_seek(gr, 0, SEEK_CUR));
+	}
+	BLI_rng_free(rng);
+
+	EXPECT_EQ(len, BLI_gzframes_reader_seek(gr, 0, SEEK_END));
+	EXPECT_EQ(0, BLI_gzframes_reader_read(gr, buf, sizeof(buf)));
+	EXPECT_EQ(-1, BLI_gzframes_reader_seek(gr, 1, SEEK_END));
+	EXPECT_EQ(-1, BLI_gzframes_reader_seek(gr, -1, SEEK_SET));
+	BLI_gzframes_reader_free(gr);
+
+	fclose(fp);
+	BLI_threadapi_exit();
+}
+
+TEST(gzip_frames, NoIndex)
+{
+	BLI_threadapi_init();
+	FILE *fp = tmpfile();
+	ASSERT_TRUE(fp != NULL);
+
+	const size_t len = GZ_FRAMES_FRAME_SIZE * 3 + 50;
+	std::vector<unsigned char> data = data_create(len);
+	file_write(fp, data, len);
+
+	/* Strip the end member, frames have to be found by walking over them. */
+	const off_t file_len = lseek(fileno(fp), 0, SEEK_END);
+	EXPECT_EQ(0, ftruncate(fileno(fp), file_len - 34));
+	file_read_check(fp, data);
+
+	/* Strip the index too. */
+	EXPECT_EQ(0, ftruncate(fileno(fp), file_len - 34 - (12 + 8 + 4 * 4 + 10)));
+	file_read_check(fp, data);
+	file_read_gzip_check(fp, data);
+
+	/* Not framed. */
+	EXPECT_EQ(0, ftruncate(fileno(fp), 0));
+	lseek(fileno(fp), 0, SEEK_SET);
+	gzFile gz = gzdopen(dup(fileno(fp)), "wb1");
+	gzwrite(gz, data.data(), 1000);
+	gzclose(gz);
+	EXPECT_TRUE(BLI_gzframes_reader_new(fileno(fp)) == NULL);
+
+	fclose(fp);
+	BLI_threadapi_exit();
+}
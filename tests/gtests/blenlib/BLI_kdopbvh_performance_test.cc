@@ -0,0 +1,210 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_kdopbvh.h"
+#include "BLI_math_geom.h"
+#include "BLI_math_vector.h"
+#include "BLI_utildefines.h"
+#include "MEM_guardedalloc.h"
+#include "PIL_time.h"
+#include "PIL_time_utildefines.h"
+}
+
+#include "stubs/bf_intern_eigen_stubs.h"
+
+/* Number of quads along each side of the grid (2 triangles each). */
+#define GRID_SIDE 708
+/* Number of rays along each side of the image. */
+#define IMAGE_SIDE 1000
+
+static void raycast_tri_callback(void *userdata, int index, const BVHTreeRay *ray, BVHTreeRayHit *hit)
+{
+	const float (*tris)[3][3] = (const float (*)[3][3])userdata;
+	float dist;
+
+	if (isect_ray_tri_watertight_v3(ray->origin, ray->isect_precalc, UNPACK3(tris[index]), &dist, NULL) &&
+	    (dist < hit->dist))
+	{
+		hit->index = index;
+		hit->dist = dist;
+	}
+}
+
+/**
+ * Wavy grid of about 1M triangles, \a phase moves the waves to deform it.
+ */
+static void grid_tris_calc(float (*tris)[3][3], const float phase)
+{
+	for (int y = 0, i = 0; y < GRID_SIDE; y++) {
+		for (int x = 0; x < GRID_SIDE; x++, i += 2) {
+			float quad[4][3];
+			for (int j = 0; j < 4; j++) {
+				const float fx = (float)(x + (j == 1 || j == 2)) / GRID_SIDE;
+				const float fy = (float)(y + (j >= 2)) / GRID_SIDE;
+				copy_v3_fl3(quad[j], fx * 2.0f - 1.0f, fy * 2.0f - 1.0f,
+				            0.1f * sinf(fx * 20.0f + phase) * cosf(fy * 20.0f));
+			}
+			copy_v3_v3(tris[i][0], quad[0]);
+			copy_v3_v3(tris[i][1], quad[1]);
+			copy_v3_v3(tris[i][2], quad[2]);
+			copy_v3_v3(tris[i + 1][0], quad[0]);
+			copy_v3_v3(tris[i + 1][1], quad[2]);
+			copy_v3_v3(tris[i + 1][2], quad[3]);
+		}
+	}
+}
+
+/**
+ * Cast rays from a camera at a wavy grid of about 1M triangles (a typical baking or projection case),
+ * casting each ray on its own or in packets.
+ */
+static void raycast_packet_test(const bool use_packet, const char *id)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	const int tris_len = GRID_SIDE * GRID_SIDE * 2;
+	const int rays_len = IMAGE_SIDE * IMAGE_SIDE;
+	float (*tris)[3][3] = (float (*)[3][3])MEM_mallocN(sizeof(*tris) * tris_len, __func__);
+	float (*co)[3] = (float (*)[3])MEM_mallocN(sizeof(*co) * rays_len, __func__);
+	float (*dir)[3] = (float (*)[3])MEM_mallocN(sizeof(*dir) * rays_len, __func__);
+	BVHTreeRayHit *hits = (BVHTreeRayHit *)MEM_mallocN(sizeof(*hits) * rays_len, __func__);
+	BVHTree *tree = BLI_bvhtree_new(tris_len, 0.0f, 4, 6);
+
+	grid_tris_calc(tris, 0.0f);
+	for (int i = 0; i < tris_len; i++) {
+		BLI_bvhtree_insert(tree, i, tris[i][0], 3);
+	}
+	BLI_bvhtree_balance(tree);
+
+	/* Perspective camera looking down at the grid, rays in scan-line order. */
+	for (int y = 0, i = 0; y < IMAGE_SIDE; y++) {
+		for (int x = 0; x < IMAGE_SIDE; x++, i++) {
+			copy_v3_fl3(co[i], 0.2f, -0.3f, 2.0f);
+			copy_v3_fl3(dir[i], ((float)x / IMAGE_SIDE) * 1.2f - 0.6f, ((float)y / IMAGE_SIDE) * 1.2f - 0.6f, -1.0f);
+			normalize_v3(dir[i]);
+			hits[i].index = -1;
+			hits[i].dist = BVH_RAYCAST_DIST_MAX;
+		}
+	}
+
+	if (use_packet) {
+		TIMEIT_START(ray_cast_packet);
+		BLI_bvhtree_ray_cast_packet(tree, co, dir, rays_len, 0.0f, hits, raycast_tri_callback, tris);
+		TIMEIT_END(ray_cast_packet);
+	}
+	else {
+		TIMEIT_START(ray_cast);
+		for (int i = 0; i < rays_len; i++) {
+			BLI_bvhtree_ray_cast(tree, co[i], dir[i], 0.0f, &hits[i], raycast_tri_callback, tris);
+		}
+		TIMEIT_END(ray_cast);
+	}
+
+	/* Spot check the results. */
+	int hits_len = 0;
+	for (int i = 0; i < rays_len; i++) {
+		if (hits[i].index != -1) {
+			hits_len++;
+		}
+		if ((i % 997) == 0) {
+			BVHTreeRayHit hit = {-1};
+			hit.dist = BVH_RAYCAST_DIST_MAX;
+			BLI_bvhtree_ray_cast(tree, co[i], dir[i], 0.0f, &hit, raycast_tri_callback, tris);
+			EXPECT_EQ(hit.index, hits[i].index);
+		}
+	}
+	printf("%d of %d rays hit\n", hits_len, rays_len);
+
+	BLI_bvhtree_free(tree);
+	MEM_freeN(tris);
+	MEM_freeN(co);
+	MEM_freeN(dir);
+	MEM_freeN(hits);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(kdopbvh, RaycastScalar1M)
+{
+	raycast_packet_test(false, "RaycastScalar1M");
+}
+
+TEST(kdopbvh, RaycastPacket1M)
+{
+	raycast_packet_test(true, "RaycastPacket1M");
+}
+
+/**
+ * Deform the grid over a number of frames (like an animated mesh would),
+ * updating the tree by building it again or by refitting it.
+ */
+static void refit_rebuild_test(const bool use_refit, const char *id)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	const int tris_len = GRID_SIDE * GRID_SIDE * 2;
+	const int frames_len = 10;
+	float (*tris)[3][3] = (float (*)[3][3])MEM_mallocN(sizeof(*tris) * tris_len, __func__);
+
+	grid_tris_calc(tris, 0.0f);
+	BVHTree *tree = BLI_bvhtree_new(tris_len, 0.0f, 4, 6);
+	for (int i = 0; i < tris_len; i++) {
+		BLI_bvhtree_insert(tree, i, tris[i][0], 3);
+	}
+	BLI_bvhtree_balance(tree);
+
+	double time_update = 0.0;
+	for (int frame = 1; frame <= frames_len; frame++) {
+		grid_tris_calc(tris, (float)frame * 0.5f);
+
+		const double time_start = PIL_check_seconds_timer();
+		if (use_refit) {
+			for (int i = 0; i < tris_len; i++) {
+				BLI_bvhtree_update_node(tree, i, tris[i][0], NULL, 3);
+			}
+			BLI_bvhtree_update_tree(tree);
+		}
+		else {
+			BLI_bvhtree_free(tree);
+			tree = BLI_bvhtree_new(tris_len, 0.0f, 4, 6);
+			for (int i = 0; i < tris_len; i++) {
+				BLI_bvhtree_insert(tree, i, tris[i][0], 3);
+			}
+			BLI_bvhtree_balance(tree);
+		}
+		time_update += PIL_check_seconds_timer() - time_start;
+	}
+
+	/* Rays straight down must hit the triangle they start above. */
+	const double time_start = PIL_check_seconds_timer();
+	for (int i = 0; i < tris_len; i += 7) {
+		float co[3], dir[3] = {0.0f, 0.0f, -1.0f};
+		mid_v3_v3v3v3(co, UNPACK3(tris[i]));
+		co[2] += 1.0f;
+		BVHTreeRayHit hit = {-1};
+		hit.dist = BVH_RAYCAST_DIST_MAX;
+		BLI_bvhtree_ray_cast(tree, co, dir, 0.0f, &hit, raycast_tri_callback, tris);
+		EXPECT_EQ(hit.index, i);
+	}
+	const double time_query = PIL_check_seconds_timer() - time_start;
+
+	printf("%d frames: %.6f sec per update, queries on the last frame: %.6f sec\n",
+	       frames_len, time_update / frames_len, time_query);
+
+	BLI_bvhtree_free(tree);
+	MEM_freeN(tris);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(kdopbvh, DeformRebuild1M)
+{
+	refit_rebuild_test(false, "DeformRebuild1M");
+}
+
+TEST(kdopbvh, DeformRefit1M)
+{
+	refit_rebuild_test(true, "DeformRefit1M");
+}
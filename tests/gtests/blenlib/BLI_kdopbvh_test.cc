@@ -8,8 +8,10 @@ extern "C" {
 #include "BLI_compiler_attrs.h"
 #include "BLI_kdopbvh.h"
 #include "BLI_rand.h"
+#include "BLI_math_geom.h"
 #include "BLI_math_vector.h"
 #include "MEM_guardedalloc.h"
+#include "PIL_time.h"
 }
 
 #include "stubs/bf_intern_eigen_stubs.h"
@@ -68,7 +70,8 @@ void optimal_check_callback(void *userdata, int index, const float co[3], BVHTre
  * Note that a small epsilon is added to the BVH nodes bounds, even if we pass in zero.
  * Use rounding to ensure very close nodes don't cause the wrong node to be found as nearest.
  */
-static void find_nearest_points_test(int points_len, float scale, int round, int random_seed, bool optimal = false)
+static void find_nearest_points_test(
+        int points_len, float scale, int round, int random_seed, bool optimal = false, int build_flag = 0)
 {
 	struct RNG *rng = BLI_rng_new(random_seed);
 	BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, 8, 8);
@@ -80,7 +83,7 @@ static void find_nearest_points_test(int points_len, float scale, int round, int
 		rng_v3_round(points[i], 3, rng, round, scale);
 		BLI_bvhtree_insert(tree, i, points[i], 1);
 	}
-	BLI_bvhtree_balance(tree);
+	BLI_bvhtree_balance_ex(tree, build_flag, NULL);
 
 	/* first find each point */
 	BVHTree_NearestPointCallback callback = optimal ? optimal_check_callback : NULL;
@@ -115,3 +118,214 @@ TEST(kdopbvh, FindNearest_500)		{ find_nearest_points_test(500, 1.0, 1000, 12);
 TEST(kdopbvh, OptimalFindNearest_1)		{ find_nearest_points_test(1, 1.0, 1000, 1234, true); }
 TEST(kdopbvh, OptimalFindNearest_2)		{ find_nearest_points_test(2, 1.0, 1000, 123, true); }
 TEST(kdopbvh, OptimalFindNearest_500)		{ find_nearest_points_test(500, 1.0, 1000, 12, true); }
+
+TEST(kdopbvh, FindNearestSAH_2)		{ find_nearest_points_test(2, 1.0, 1000, 123, false, BVH_BUILD_SAH); }
+TEST(kdopbvh, FindNearestSAH_500)		{ find_nearest_points_test(500, 1.0, 1000, 12, false, BVH_BUILD_SAH); }
+TEST(kdopbvh, FindNearestSAH_5000)		{ find_nearest_points_test(5000, 1.0, 1000, 12, false, BVH_BUILD_SAH); }
+TEST(kdopbvh, OptimalFindNearestSAH_500)		{ find_nearest_points_test(500, 1.0, 1000, 12, true, BVH_BUILD_SAH); }
+
+/**
+ * Build a tree, move all points and refit it, the refit tree should give the same results as a new one.
+ */
+static void refit_test(int points_len, int tree_type, int random_seed)
+{
+	struct RNG *rng = BLI_rng_new(random_seed);
+	BVHTree *tree = BLI_bvhtree_new(points_len, 0.0, tree_type, 8);
+
+	void *mem = MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+	float (*points)[3] = (float (*)[3])mem;
+
+	for (int i = 0; i < points_len; i++) {
+		rng_v3_round(points[i], 3, rng, 1000, 1.0f);
+		BLI_bvhtree_insert(tree, i, points[i], 1);
+	}
+	BLI_bvhtree_balance(tree);
+
+	/* Move every point somewhere else, the old bounds are useless now. */
+	for (int i = 0; i < points_len; i++) {
+		rng_v3_round(points[i], 3, rng, 1000, 2.0f);
+		EXPECT_TRUE(BLI_bvhtree_update_node(tree, i, points[i], NULL, 1));
+	}
+	BLI_bvhtree_update_tree(tree);
+
+	for (int i = 0; i < points_len; i++) {
+		const int j = BLI_bvhtree_find_nearest(tree, points[i], NULL, NULL, NULL);
+		EXPECT_GE(j, 0);
+		EXPECT_LT(j, points_len);
+		if (j != i) {
+			EXPECT_EQ_ARRAY(points[i], points[j], 3);
+		}
+	}
+
+	BLI_bvhtree_free(tree);
+	BLI_rng_free(rng);
+	MEM_freeN(points);
+}
+
+TEST(kdopbvh, Refit_1)		{ refit_test(1, 4, 1234); }
+TEST(kdopbvh, Refit_500)		{ refit_test(500, 2, 12); }
+TEST(kdopbvh, Refit_2000)		{ refit_test(2000, 8, 12); }
+TEST(kdopbvh, Refit_5000)		{ refit_test(5000, 4, 123); }
+
+static void raycast_tri_callback(void *userdata, int index, const BVHTreeRay *ray, BVHTreeRayHit *hit)
+{
+	const float (*tris)[3][3] = (const float (*)[3][3])userdata;
+	float dist;
+
+	if (isect_ray_tri_v3(ray->origin, ray->direction, UNPACK3(tris[index]), &dist, NULL) && (dist < hit->dist)) {
+		hit->index = index;
+		hit->dist = dist;
+	}
+}
+
+/**
+ * Compare ray-casting a tree built with median splits against one built with the SAH,
+ * both should give the same hits, the statistics show the quality of the trees.
+ */
+static void raycast_build_compare_test(int tris_len, int rays_len, int tree_type, int random_seed)
+{
+	struct RNG *rng = BLI_rng_new(random_seed);
+	float (*tris)[3][3] = (float (*)[3][3])MEM_mallocN(sizeof(*tris) * tris_len, __func__);
+	float (*rays)[2][3] = (float (*)[2][3])MEM_mallocN(sizeof(*rays) * rays_len, __func__);
+	BVHTreeRayHit *hits[2];
+
+	/* Small triangles, clustered so the leafs aren't evenly distributed. */
+	for (int i = 0; i < tris_len; i++) {
+		float center[3];
+		BLI_rng_get_float_unit_v3(rng, center);
+		mul_v3_fl(center, (i % 4) ? 0.2f : 1.0f);
+		for (int j = 0; j < 3; j++) {
+			float offset[3];
+			BLI_rng_get_float_unit_v3(rng, offset);
+			madd_v3_v3v3fl(tris[i][j], center, offset, 0.02f);
+		}
+	}
+	for (int i = 0; i < rays_len; i++) {
+		BLI_rng_get_float_unit_v3(rng, rays[i][0]);
+		BLI_rng_get_float_unit_v3(rng, rays[i][1]);
+		mul_v3_fl(rays[i][0], 2.0f);
+		/* Aim roughly at the center. */
+		sub_v3_v3(rays[i][1], rays[i][0]);
+		normalize_v3(rays[i][1]);
+	}
+
+	for (int build = 0; build < 2; build++) {
+		const int build_flag = build ? BVH_BUILD_SAH : 0;
+		BVHTreeBuildStats stats;
+		BVHTree *tree = BLI_bvhtree_new(tris_len, 0.0f, (char)tree_type, 6);
+
+		for (int i = 0; i < tris_len; i++) {
+			BLI_bvhtree_insert(tree, i, tris[i][0], 3);
+		}
+		BLI_bvhtree_balance_ex(tree, build_flag, &stats);
+
+		EXPECT_EQ(tris_len, stats.totleaf);
+
+		hits[build] = (BVHTreeRayHit *)MEM_mallocN(sizeof(BVHTreeRayHit) * rays_len, __func__);
+
+		const double time_start = PIL_check_seconds_timer();
+		for (int i = 0; i < rays_len; i++) {
+			BVHTreeRayHit *hit = &hits[build][i];
+			hit->index = -1;
+			hit->dist = BVH_RAYCAST_DIST_MAX;
+			BLI_bvhtree_ray_cast(tree, rays[i][0], rays[i][1], 0.0f, hit, raycast_tri_callback, tris);
+		}
+		const double time_query = PIL_check_seconds_timer() - time_start;
+
+		printf("%s (tree_type %d): build %.4fs, query %.4fs, branches %d, depth %d, SAH cost %.2f\n",
+		       build ? "SAH" : "Median", tree_type, stats.time, time_query,
+		       stats.totbranch, stats.depth_max, stats.sah_cost);
+
+		BLI_bvhtree_free(tree);
+	}
+
+	for (int i = 0; i < rays_len; i++) {
+		EXPECT_EQ(hits[0][i].index, hits[1][i].index);
+		if (hits[0][i].index != -1) {
+			EXPECT_FLOAT_EQ(hits[0][i].dist, hits[1][i].dist);
+		}
+	}
+
+	MEM_freeN(hits[0]);
+	MEM_freeN(hits[1]);
+	MEM_freeN(tris);
+	MEM_freeN(rays);
+	BLI_rng_free(rng);
+}
+
+TEST(kdopbvh, RaycastBuildCompare_Binary)		{ raycast_build_compare_test(20000, 20000, 2, 1234); }
+TEST(kdopbvh, RaycastBuildCompare_Quad)		{ raycast_build_compare_test(20000, 20000, 4, 1234); }
+TEST(kdopbvh, RaycastBuildCompare_Oct)		{ raycast_build_compare_test(20000, 20000, 8, 1234); }
+
+/**
+ * Check casting packets of rays gives the same hits as casting them one at a time.
+ */
+static void raycast_packet_test(int tris_len, int rays_len, bool coherent, int random_seed)
+{
+	struct RNG *rng = BLI_rng_new(random_seed);
+	float (*tris)[3][3] = (float (*)[3][3])MEM_mallocN(sizeof(*tris) * tris_len, __func__);
+	float (*co)[3] = (float (*)[3])MEM_mallocN(sizeof(*co) * rays_len, __func__);
+	float (*dir)[3] = (float (*)[3])MEM_mallocN(sizeof(*dir) * rays_len, __func__);
+	BVHTreeRayHit *hits = (BVHTreeRayHit *)MEM_mallocN(sizeof(*hits) * rays_len, __func__);
+	BVHTree *tree = BLI_bvhtree_new(tris_len, 0.0f, 4, 6);
+
+	for (int i = 0; i < tris_len; i++) {
+		float center[3];
+		BLI_rng_get_float_unit_v3(rng, center);
+		for (int j = 0; j < 3; j++) {
+			float offset[3];
+			BLI_rng_get_float_unit_v3(rng, offset);
+			madd_v3_v3v3fl(tris[i][j], center, offset, 0.05f);
+		}
+		BLI_bvhtree_insert(tree, i, tris[i][0], 3);
+	}
+	BLI_bvhtree_balance(tree);
+
+	for (int i = 0; i < rays_len; i++) {
+		if (coherent) {
+			/* Parallel rays on a grid, some along the axes. */
+			const int side = (int)sqrtf((float)rays_len) + 1;
+			co[i][0] = ((float)(i % side) / (float)side) * 2.0f - 1.0f;
+			co[i][1] = ((float)(i / side) / (float)side) * 2.0f - 1.0f;
+			co[i][2] = 2.0f;
+			if (i % 3) {
+				copy_v3_fl3(dir[i], 0.0f, 0.0f, -1.0f);
+			}
+			else {
+				copy_v3_fl3(dir[i], 0.1f, 0.2f, -1.0f);
+				normalize_v3(dir[i]);
+			}
+		}
+		else {
+			BLI_rng_get_float_unit_v3(rng, co[i]);
+			BLI_rng_get_float_unit_v3(rng, dir[i]);
+			mul_v3_fl(co[i], 2.0f);
+		}
+		hits[i].index = -1;
+		hits[i].dist = BVH_RAYCAST_DIST_MAX;
+	}
+
+	BLI_bvhtree_ray_cast_packet(tree, co, dir, rays_len, 0.0f, hits, raycast_tri_callback, tris);
+
+	for (int i = 0; i < rays_len; i++) {
+		BVHTreeRayHit hit;
+		hit.index = -1;
+		hit.dist = BVH_RAYCAST_DIST_MAX;
+		BLI_bvhtree_ray_cast(tree, co[i], dir[i], 0.0f, &hit, raycast_tri_callback, tris);
+		EXPECT_EQ(hit.index, hits[i].index);
+		if (hit.index != -1) {
+			EXPECT_FLOAT_EQ(hit.dist, hits[i].dist);
+		}
+	}
+
+	BLI_bvhtree_free(tree);
+	MEM_freeN(tris);
+	MEM_freeN(co);
+	MEM_freeN(dir);
+	MEM_freeN(hits);
+	BLI_rng_free(rng);
+}
+
+TEST(kdopbvh, RaycastPacket_Coherent)		{ raycast_packet_test(5000, 4001, true, 1234); }
+TEST(kdopbvh, RaycastPacket_Random)		{ raycast_packet_test(5000, 4001, false, 1234); }
+TEST(kdopbvh, RaycastPacket_Small)		{ raycast_packet_test(3, 3, true, 12); }
@@ -0,0 +1,80 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_kdtree.h"
+#include "BLI_math_vector.h"
+#include "BLI_rand.h"
+#include "BLI_threads.h"
+#include "BLI_utildefines.h"
+#include "MEM_guardedalloc.h"
+#include "PIL_time_utildefines.h"
+}
+
+/* Number of points in the tree and number of searched points. */
+#define POINTS_LEN 1000000
+
+static void kdtree_find_nearest_test(const bool use_batch, const char *id)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	struct RNG *rng = BLI_rng_new(0);
+	float (*points)[3] = (float (*)[3])MEM_mallocN(sizeof(*points) * POINTS_LEN, __func__);
+	float (*search)[3] = (float (*)[3])MEM_mallocN(sizeof(*search) * POINTS_LEN, __func__);
+	int *index = (int *)MEM_mallocN(sizeof(*index) * POINTS_LEN, __func__);
+
+	for (int i = 0; i < POINTS_LEN; i++) {
+		BLI_rng_get_float_unit_v3(rng, points[i]);
+		BLI_rng_get_float_unit_v3(rng, search[i]);
+		mul_v3_fl(search[i], 1.01f);
+	}
+
+	BLI_threadapi_init();
+
+	KDTree_3d *tree = BLI_kdtree_3d_new(POINTS_LEN);
+	for (int i = 0; i < POINTS_LEN; i++) {
+		BLI_kdtree_3d_insert(tree, i, points[i]);
+	}
+	BLI_kdtree_3d_balance(tree);
+
+	if (use_batch) {
+		TIMEIT_START(find_nearest_batch);
+		BLI_kdtree_3d_find_nearest_batch(tree, search, POINTS_LEN, index, NULL);
+		TIMEIT_END(find_nearest_batch);
+	}
+	else {
+		TIMEIT_START(find_nearest);
+		for (int i = 0; i < POINTS_LEN; i++) {
+			index[i] = BLI_kdtree_3d_find_nearest(tree, search[i], NULL);
+		}
+		TIMEIT_END(find_nearest);
+	}
+
+	/* Spot check the results. */
+	for (int i = 0; i < POINTS_LEN; i += 997) {
+		KDTreeNearest_3d nearest;
+		BLI_kdtree_3d_find_nearest(tree, search[i], &nearest);
+		EXPECT_FLOAT_EQ(nearest.dist, len_v3v3(points[index[i]], search[i]));
+	}
+
+	BLI_kdtree_3d_free(tree);
+	BLI_threadapi_exit();
+
+	MEM_freeN(points);
+	MEM_freeN(search);
+	MEM_freeN(index);
+	BLI_rng_free(rng);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(kdtree, FindNearest1M)
+{
+	kdtree_find_nearest_test(false, "FindNearest1M");
+}
+
+TEST(kdtree, FindNearestBatch1M)
+{
+	kdtree_find_nearest_test(true, "FindNearestBatch1M");
+}
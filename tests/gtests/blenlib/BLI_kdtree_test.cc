@@ -0,0 +1,139 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_kdtree.h"
+#include "BLI_rand.h"
+#include "BLI_utildefines.h"
+#include "MEM_guardedalloc.h"
+}
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+static void rng_vn_round(
+        float *coords, int coords_len,
+        struct RNG *rng, int round, float scale)
+{
+	for (int i = 0; i < coords_len; i++) {
+		float f = BLI_rng_get_float(rng) * 2.0f - 1.0f;
+		coords[i] = ((float)((int)(f * round)) / (float)round) * scale;
+	}
+}
+
+/* -------------------------------------------------------------------- */
+/* Tests */
+
+/**
+ * Check batch searching gives the same results as searching one point at a time,
+ * rounding is used to get nodes at the same distance, in that case only the distance is compared.
+ */
+static void find_nearest_batch_3d_test(int points_len, int search_len, int round, int random_seed)
+{
+	struct RNG *rng = BLI_rng_new(random_seed);
+	KDTree_3d *tree = BLI_kdtree_3d_new((uint)points_len);
+
+	for (int i = 0; i < points_len; i++) {
+		float co[3];
+		rng_vn_round(co, 3, rng, round, 1.0f);
+		BLI_kdtree_3d_insert(tree, i, co);
+	}
+	BLI_kdtree_3d_balance(tree);
+
+	float (*search)[3] = (float (*)[3])MEM_mallocN(sizeof(*search) * search_len, __func__);
+	for (int i = 0; i < search_len; i++) {
+		rng_vn_round(search[i], 3, rng, round * 2, 1.5f);
+	}
+
+	int *index = (int *)MEM_mallocN(sizeof(*index) * search_len, __func__);
+	KDTreeNearest_3d *nearest = (KDTreeNearest_3d *)MEM_mallocN(sizeof(*nearest) * search_len, __func__);
+	BLI_kdtree_3d_find_nearest_batch(tree, search, (uint)search_len, index, nearest);
+
+	for (int i = 0; i < search_len; i++) {
+		KDTreeNearest_3d nearest_single;
+		const int index_single = BLI_kdtree_3d_find_nearest(tree, search[i], &nearest_single);
+		EXPECT_EQ(index[i], nearest[i].index);
+		EXPECT_FLOAT_EQ(nearest_single.dist, nearest[i].dist);
+		if (index_single == index[i]) {
+			EXPECT_EQ_ARRAY(nearest_single.co, nearest[i].co, 3);
+		}
+	}
+
+	MEM_freeN(search);
+	MEM_freeN(index);
+	MEM_freeN(nearest);
+	BLI_kdtree_3d_free(tree);
+	BLI_rng_free(rng);
+}
+
+TEST(kdtree, FindNearestBatchEmpty)
+{
+	KDTree_3d *tree = BLI_kdtree_3d_new(0);
+	BLI_kdtree_3d_balance(tree);
+	float search[2][3] = {{0.0f, 0.0f, 0.0f}, {1.0f, 1.0f, 1.0f}};
+	int index[2];
+	KDTreeNearest_3d nearest[2];
+	BLI_kdtree_3d_find_nearest_batch(tree, search, 2, index, nearest);
+	EXPECT_EQ(-1, index[0]);
+	EXPECT_EQ(-1, index[1]);
+	EXPECT_EQ(-1, nearest[0].index);
+	EXPECT_EQ(-1, nearest[1].index);
+	BLI_kdtree_3d_free(tree);
+}
+
+TEST(kdtree, FindNearestBatchSingle)
+{
+	KDTree_3d *tree = BLI_kdtree_3d_new(1);
+	const float co[3] = {1.0f, 2.0f, 3.0f};
+	BLI_kdtree_3d_insert(tree, 7, co);
+	BLI_kdtree_3d_balance(tree);
+	float search[3][3] = {{0.0f, 0.0f, 0.0f}, {1.0f, 2.0f, 3.0f}, {-5.0f, 2.0f, 3.0f}};
+	KDTreeNearest_3d nearest[3];
+	BLI_kdtree_3d_find_nearest_batch(tree, search, 3, NULL, nearest);
+	for (int i = 0; i < 3; i++) {
+		EXPECT_EQ(7, nearest[i].index);
+		EXPECT_EQ_ARRAY(co, nearest[i].co, 3);
+	}
+	EXPECT_FLOAT_EQ(0.0f, nearest[1].dist);
+	EXPECT_FLOAT_EQ(6.0f, nearest[2].dist);
+	BLI_kdtree_3d_free(tree);
+}
+
+TEST(kdtree, FindNearestBatch_1)       { find_nearest_batch_3d_test(1, 10, 1000, 1234); }
+TEST(kdtree, FindNearestBatch_3)       { find_nearest_batch_3d_test(10, 3, 1000, 1234); }
+TEST(kdtree, FindNearestBatch_1000)    { find_nearest_batch_3d_test(1000, 1000, 1000, 1234); }
+TEST(kdtree, FindNearestBatch_5000)    { find_nearest_batch_3d_test(5000, 5000, 1000, 1234); }
+TEST(kdtree, FindNearestBatch_Round)   { find_nearest_batch_3d_test(5000, 5000, 4, 1234); }
+
+TEST(kdtree, FindNearestBatch2D)
+{
+	struct RNG *rng = BLI_rng_new(4321);
+	const int points_len = 2000, search_len = 3001;
+	KDTree_2d *tree = BLI_kdtree_2d_new(points_len);
+
+	for (int i = 0; i < points_len; i++) {
+		float co[2];
+		rng_vn_round(co, 2, rng, 1000, 1.0f);
+		BLI_kdtree_2d_insert(tree, i, co);
+	}
+	BLI_kdtree_2d_balance(tree);
+
+	float (*search)[2] = (float (*)[2])MEM_mallocN(sizeof(*search) * search_len, __func__);
+	for (int i = 0; i < search_len; i++) {
+		rng_vn_round(search[i], 2, rng, 1000, 1.5f);
+	}
+	KDTreeNearest_2d *nearest = (KDTreeNearest_2d *)MEM_mallocN(sizeof(*nearest) * search_len, __func__);
+	BLI_kdtree_2d_find_nearest_batch(tree, search, (uint)search_len, NULL, nearest);
+
+	for (int i = 0; i < search_len; i++) {
+		KDTreeNearest_2d nearest_single;
+		BLI_kdtree_2d_find_nearest(tree, search[i], &nearest_single);
+		EXPECT_FLOAT_EQ(nearest_single.dist, nearest[i].dist);
+	}
+
+	MEM_freeN(search);
+	MEM_freeN(nearest);
+	BLI_kdtree_2d_free(tree);
+	BLI_rng_free(rng);
+}
@@ -0,0 +1,71 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <stdio.h>
+#include <string.h>
+#ifndef WIN32
+#  include <unistd.h>
+#endif
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "BLI_mmap.h"
+}
+
+TEST(mmap, Read)
+{
+	FILE *fp = tmpfile();
+	ASSERT_TRUE(fp != NULL);
+	const char data[] = "0123456789";
+	fwrite(data, 1, sizeof(data), fp);
+	fflush(fp);
+
+	BLI_mmap_file *file = BLI_mmap_open(fileno(fp));
+	ASSERT_TRUE(file != NULL);
+	EXPECT_EQ(sizeof(data), BLI_mmap_get_length(file));
+	EXPECT_EQ(0, memcmp(BLI_mmap_get_pointer(file), data, sizeof(data)));
+
+	char buf[4];
+	EXPECT_TRUE(BLI_mmap_read(file, buf, 3, 4));
+	EXPECT_EQ(0, memcmp(buf, "3456", 4));
+	EXPECT_TRUE(BLI_mmap_read(file, buf, sizeof(data), 0));
+	EXPECT_FALSE(BLI_mmap_read(file, buf, sizeof(data) - 2, 4));
+	EXPECT_FALSE(BLI_mmap_read(file, buf, sizeof(data) + 1, 0));
+	BLI_mmap_free(file);
+
+	fclose(fp);
+}
+
+TEST(mmap, Empty)
+{
+	FILE *fp = tmpfile();
+	ASSERT_TRUE(fp != NULL);
+	EXPECT_TRUE(BLI_mmap_open(fileno(fp)) == NULL);
+	fclose(fp);
+}
+
+#ifndef WIN32
+TEST(mmap, Truncated)
+{
+	FILE *fp = tmpfile();
+	ASSERT_TRUE(fp != NULL);
+	char data[16384];
+	memset(data, 'x', sizeof(data));
+	fwrite(data, 1, sizeof(data), fp);
+	fflush(fp);
+
+	BLI_mmap_file *file = BLI_mmap_open(fileno(fp));
+	ASSERT_TRUE(file != NULL);
+
+	/* Pages beyond the end of the file can't be read anymore. */
+	ASSERT_EQ(0, ftruncate(fileno(fp), 0));
+	char buf[4];
+	EXPECT_FALSE(BLI_mmap_read(file, buf, sizeof(data) - sizeof(buf), sizeof(buf)));
+	/* Further reads fail without accessing the memory. */
+	EXPECT_FALSE(BLI_mmap_read(file, buf, 0, sizeof(buf)));
+	BLI_mmap_free(file);
+
+	fclose(fp);
+}
+#endif
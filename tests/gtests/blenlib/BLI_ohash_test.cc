@@ -0,0 +1,160 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "BLI_ohash.h"
+#include "BLI_rand.h"
+}
+
+#define TESTCASE_SIZE 10000
+
+/* Unique keys in random order, zero is skipped so keys can be used as non-NULL pointers. */
+static void init_keys(unsigned int keys[TESTCASE_SIZE], const int seed)
+{
+	RNG *rng = BLI_rng_new(seed);
+	for (int i = 0; i < TESTCASE_SIZE; i++) {
+		keys[i] = (unsigned int)i * 7 + 1;
+	}
+	BLI_rng_shuffle_array(rng, keys, sizeof(*keys), TESTCASE_SIZE);
+	BLI_rng_free(rng);
+}
+
+TEST(ohash, InsertLookup)
+{
+	OHash *ohash = BLI_ohash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+	unsigned int keys[TESTCASE_SIZE];
+
+	init_keys(keys, 0);
+
+	for (int i = 0; i < TESTCASE_SIZE; i++) {
+		BLI_ohash_insert(ohash, POINTER_FROM_UINT(keys[i]), POINTER_FROM_UINT(keys[i]));
+	}
+
+	EXPECT_EQ(BLI_ohash_len(ohash), TESTCASE_SIZE);
+
+	for (int i = 0; i < TESTCASE_SIZE; i++) {
+		void *v = BLI_ohash_lookup(ohash, POINTER_FROM_UINT(keys[i]));
+		EXPECT_EQ(POINTER_AS_UINT(v), keys[i]);
+	}
+	EXPECT_FALSE(BLI_ohash_haskey(ohash, POINTER_FROM_UINT(2)));
+	EXPECT_EQ(BLI_ohash_lookup_default(ohash, POINTER_FROM_UINT(2), POINTER_FROM_UINT(42)), POINTER_FROM_UINT(42));
+
+	BLI_ohash_free(ohash, NULL, NULL);
+}
+
+/* Remove half of the keys, the other half must stay reachable (checks backward shift deletion). */
+TEST(ohash, InsertRemove)
+{
+	OHash *ohash = BLI_ohash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+	unsigned int keys[TESTCASE_SIZE];
+
+	init_keys(keys, 10);
+
+	for (int i = 0; i < TESTCASE_SIZE; i++) {
+		BLI_ohash_insert(ohash, POINTER_FROM_UINT(keys[i]), POINTER_FROM_UINT(keys[i]));
+	}
+
+	for (int i = 0; i < TESTCASE_SIZE; i += 2) {
+		void *v = BLI_ohash_popkey(ohash, POINTER_FROM_UINT(keys[i]), NULL);
+		EXPECT_EQ(POINTER_AS_UINT(v), keys[i]);
+	}
+
+	EXPECT_EQ(BLI_ohash_len(ohash), TESTCASE_SIZE / 2);
+
+	for (int i = 0; i < TESTCASE_SIZE; i++) {
+		EXPECT_EQ(BLI_ohash_haskey(ohash, POINTER_FROM_UINT(keys[i])), (i % 2) != 0);
+	}
+
+	for (int i = 1; i < TESTCASE_SIZE; i += 2) {
+		EXPECT_TRUE(BLI_ohash_remove(ohash, POINTER_FROM_UINT(keys[i]), NULL, NULL));
+	}
+	EXPECT_FALSE(BLI_ohash_remove(ohash, POINTER_FROM_UINT(keys[1]), NULL, NULL));
+
+	EXPECT_EQ(BLI_ohash_len(ohash), 0);
+
+	BLI_ohash_free(ohash, NULL, NULL);
+}
+
+TEST(ohash, ReinsertEnsure)
+{
+	OHash *ohash = BLI_ohash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+	unsigned int keys[TESTCASE_SIZE];
+	void **val_p;
+
+	init_keys(keys, 20);
+
+	for (int i = 0; i < TESTCASE_SIZE; i++) {
+		EXPECT_FALSE(BLI_ohash_ensure_p(ohash, POINTER_FROM_UINT(keys[i]), &val_p));
+		*val_p = POINTER_FROM_UINT(keys[i]);
+	}
+	for (int i = 0; i < TESTCASE_SIZE; i++) {
+		EXPECT_TRUE(BLI_ohash_ensure_p(ohash, POINTER_FROM_UINT(keys[i]), &val_p));
+		EXPECT_EQ(POINTER_AS_UINT(*val_p), keys[i]);
+		EXPECT_FALSE(BLI_ohash_reinsert(ohash, POINTER_FROM_UINT(keys[i]), POINTER_FROM_UINT(i), NULL, NULL));
+	}
+
+	EXPECT_EQ(BLI_ohash_len(ohash), TESTCASE_SIZE);
+
+	for (int i = 0; i < TESTCASE_SIZE; i++) {
+		void *v = BLI_ohash_lookup(ohash, POINTER_FROM_UINT(keys[i]));
+		EXPECT_EQ(POINTER_AS_INT(v), i);
+	}
+
+	BLI_ohash_free(ohash, NULL, NULL);
+}
+
+TEST(ohash, Iterator)
+{
+	OHash *ohash = BLI_ohash_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+	unsigned int keys[TESTCASE_SIZE];
+	unsigned int sum_expected = 0, sum = 0;
+	int count = 0;
+
+	init_keys(keys, 30);
+
+	for (int i = 0; i < TESTCASE_SIZE; i++) {
+		BLI_ohash_insert(ohash, POINTER_FROM_UINT(keys[i]), POINTER_FROM_UINT(keys[i]));
+		sum_expected += keys[i];
+	}
+
+	OHashIterator ohi;
+	OHASH_ITER (ohi, ohash) {
+		EXPECT_EQ(BLI_ohashIterator_getKey(&ohi), BLI_ohashIterator_getValue(&ohi));
+		sum += POINTER_AS_UINT(BLI_ohashIterator_getKey(&ohi));
+		count++;
+	}
+
+	EXPECT_EQ(count, TESTCASE_SIZE);
+	EXPECT_EQ(sum, sum_expected);
+
+	BLI_ohash_clear(ohash, NULL, NULL);
+	EXPECT_EQ(BLI_ohash_len(ohash), 0);
+	OHASH_ITER (ohi, ohash) {
+		ADD_FAILURE();
+	}
+
+	BLI_ohash_free(ohash, NULL, NULL);
+}
+
+/* Inlined pointer-key lookups must agree with the generic ones. */
+TEST(ohash, PtrInline)
+{
+	OHash *ohash = BLI_ohash_ptr_new(__func__);
+	int data[TESTCASE_SIZE];
+
+	for (int i = 0; i < TESTCASE_SIZE; i++) {
+		BLI_ohash_insert(ohash, &data[i], POINTER_FROM_INT(i));
+	}
+	for (int i = 0; i < TESTCASE_SIZE; i += 3) {
+		BLI_ohash_remove(ohash, &data[i], NULL, NULL);
+	}
+
+	for (int i = 0; i < TESTCASE_SIZE; i++) {
+		EXPECT_EQ(BLI_ohash_ptr_haskey(ohash, &data[i]), (i % 3) != 0);
+		EXPECT_EQ(BLI_ohash_ptr_lookup(ohash, &data[i]), BLI_ohash_lookup(ohash, &data[i]));
+	}
+
+	BLI_ohash_free(ohash, NULL, NULL);
+}
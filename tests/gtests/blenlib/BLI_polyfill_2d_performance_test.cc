@@ -0,0 +1,109 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_math.h"
+#include "BLI_memarena.h"
+#include "BLI_polyfill_2d.h"
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+#include "MEM_guardedalloc.h"
+#include "PIL_time.h"
+}
+
+/* Number of n-gons, and corners of each n-gon (like imported CAD meshes, with large caps). */
+#define NGONS_LEN 10000
+#define NGON_CORNERS 256
+
+typedef struct NGonsData {
+	const float (*coords)[2];
+	unsigned int (*tris)[3];
+} NGonsData;
+
+/**
+ * Circles (convex) or gears (concave), all with #NGON_CORNERS corners.
+ */
+static void ngons_coords_calc(float (*coords)[2], const bool use_concave)
+{
+	for (int i = 0; i < NGONS_LEN; i++) {
+		const float offset[2] = {(float)(i % 100) * 3.0f, (float)(i / 100) * 3.0f};
+		for (int j = 0; j < NGON_CORNERS; j++) {
+			/* Clockwise, matching the sign passed to #BLI_polyfill_calc_arena. */
+			const float angle = ((float)j / NGON_CORNERS) * (float)M_PI * -2.0f;
+			const float radius = (use_concave && (j % 4) >= 2) ? 0.8f : 1.0f;
+			float *co = coords[i * NGON_CORNERS + j];
+			co[0] = offset[0] + cosf(angle) * radius;
+			co[1] = offset[1] + sinf(angle) * radius;
+		}
+	}
+}
+
+static void ngons_fill_cb(
+        void *__restrict userdata,
+        const int i,
+        const ParallelRangeTLS *__restrict tls)
+{
+	NGonsData *data = (NGonsData *)userdata;
+	BLI_polyfill_calc_arena(
+	        &data->coords[i * NGON_CORNERS], NGON_CORNERS, 1,
+	        &data->tris[i * (NGON_CORNERS - 2)], tls->arena);
+	BLI_memarena_clear(tls->arena);
+}
+
+/**
+ * Tessellate all n-gons one after another, then in parallel with an arena for each worker
+ * (as done by #BKE_mesh_recalc_looptri), both must give the same triangles.
+ */
+static void polyfill_ngons_test(const bool use_concave, const char *id)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	const int tris_len = NGONS_LEN * (NGON_CORNERS - 2);
+	float (*coords)[2] = (float (*)[2])MEM_mallocN(sizeof(*coords) * NGONS_LEN * NGON_CORNERS, __func__);
+	unsigned int (*tris)[3] = (unsigned int (*)[3])MEM_mallocN(sizeof(*tris) * tris_len, __func__);
+	unsigned int (*tris_threaded)[3] = (unsigned int (*)[3])MEM_mallocN(sizeof(*tris) * tris_len, __func__);
+
+	ngons_coords_calc(coords, use_concave);
+
+	double time_start = PIL_check_seconds_timer();
+	MemArena *arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
+	for (int i = 0; i < NGONS_LEN; i++) {
+		BLI_polyfill_calc_arena(
+		        &coords[i * NGON_CORNERS], NGON_CORNERS, 1,
+		        &tris[i * (NGON_CORNERS - 2)], arena);
+		BLI_memarena_clear(arena);
+	}
+	BLI_memarena_free(arena);
+	const double time_serial = PIL_check_seconds_timer() - time_start;
+
+	time_start = PIL_check_seconds_timer();
+	NGonsData data = {coords, tris_threaded};
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+	settings.use_arena = true;
+	BLI_task_parallel_range(0, NGONS_LEN, &data, ngons_fill_cb, &settings);
+	const double time_threaded = PIL_check_seconds_timer() - time_start;
+
+	EXPECT_EQ(memcmp(tris, tris_threaded, sizeof(*tris) * tris_len), 0);
+
+	printf("%d n-gons of %d corners: %.6f sec serial, %.6f sec threaded\n",
+	       NGONS_LEN, NGON_CORNERS, time_serial, time_threaded);
+
+	MEM_freeN(coords);
+	MEM_freeN(tris);
+	MEM_freeN(tris_threaded);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(polyfill2d, NGonsConvex)
+{
+	polyfill_ngons_test(false, "NGonsConvex");
+}
+
+TEST(polyfill2d, NGonsConcave)
+{
+	polyfill_ngons_test(true, "NGonsConcave");
+}
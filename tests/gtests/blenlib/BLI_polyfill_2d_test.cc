@@ -389,6 +389,18 @@ TEST(polyfill2d, SquareCW)
 	TEST_POLYFILL_TEMPLATE_STATIC(poly, false);
 }
 
+/* A circle, only convex corners */
+TEST(polyfill2d, Circle)
+{
+	float poly[64][2];
+	for (int i = 0; i < ARRAY_SIZE(poly); i++) {
+		const float angle = ((float)i / ARRAY_SIZE(poly)) * (float)M_PI * 2.0f;
+		poly[i][0] = cosf(angle);
+		poly[i][1] = sinf(angle);
+	}
+	TEST_POLYFILL_TEMPLATE_STATIC(poly, false);
+}
+
 /* Starfleet insigna */
 TEST(polyfill2d, Starfleet)
 {
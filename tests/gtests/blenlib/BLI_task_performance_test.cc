@@ -0,0 +1,78 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "atomic_ops.h"
+
+extern "C" {
+#include "BLI_task.h"
+#include "BLI_utildefines.h"
+#include "PIL_time.h"
+}
+
+/* Total number of leaf tasks spawned by a single benchmark run. */
+#define NUM_ROOT_TASKS 256
+#define NUM_CHILD_TASKS 1024
+
+/* Amount of fake work done by each leaf task. */
+#define NUM_WORK_ITERATIONS 64
+
+static void task_leaf_func(TaskPool *__restrict pool, void *UNUSED(taskdata), int UNUSED(threadid))
+{
+	uint32_t *count = (uint32_t *)BLI_task_pool_userdata(pool);
+	volatile float value = 0.0f;
+	for (int i = 0; i < NUM_WORK_ITERATIONS; i++) {
+		value += (float)i * 0.5f;
+	}
+	atomic_add_and_fetch_uint32(count, 1);
+}
+
+static void task_spawn_func(TaskPool *__restrict pool, void *UNUSED(taskdata), int threadid)
+{
+	for (int i = 0; i < NUM_CHILD_TASKS; i++) {
+		BLI_task_pool_push_from_thread(pool, task_leaf_func, NULL, false, TASK_PRIORITY_HIGH, threadid);
+	}
+}
+
+static void task_scaling_test(const int flag, const char *id)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	BLI_threadapi_init();
+
+	for (int num_threads = 1; num_threads <= 64; num_threads *= 2) {
+		TaskScheduler *scheduler = BLI_task_scheduler_create_ex(num_threads, flag);
+		uint32_t count = 0;
+
+		const double time_start = PIL_check_seconds_timer();
+
+		TaskPool *pool = BLI_task_pool_create(scheduler, &count);
+		for (int i = 0; i < NUM_ROOT_TASKS; i++) {
+			BLI_task_pool_push(pool, task_spawn_func, NULL, false, TASK_PRIORITY_HIGH);
+		}
+		BLI_task_pool_work_and_wait(pool);
+		BLI_task_pool_free(pool);
+
+		const double time_total = PIL_check_seconds_timer() - time_start;
+
+		EXPECT_EQ(count, NUM_ROOT_TASKS * NUM_CHILD_TASKS);
+		printf("%2d threads: %.6f sec, %.3f Mtasks/sec\n",
+		       num_threads, time_total, (double)count / time_total * 1e-6);
+
+		BLI_task_scheduler_free(scheduler);
+	}
+
+	BLI_threadapi_exit();
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(task, ScalingGlobalQueue)
+{
+	task_scaling_test(0, "ScalingGlobalQueue");
+}
+
+TEST(task, ScalingWorkStealing)
+{
+	task_scaling_test(TASK_SCHEDULER_WORK_STEALING, "ScalingWorkStealing");
+}
@@ -6,6 +6,8 @@
 #include "atomic_ops.h"
 
 extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_memarena.h"
 #include "BLI_mempool.h"
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
@@ -74,3 +76,246 @@ TEST(task, MempoolIter)
 
 	BLI_mempool_destroy(mempool);
 }
+
+/* Mempool iteration with per-thread data and finalize (reduction) callback. */
+
+typedef struct MempoolIterExData {
+	int num_items;
+	int sum;
+} MempoolIterExData;
+
+static void task_mempool_iter_ex_func(
+        void *__restrict UNUSED(userdata), MempoolIterData *item, const ParallelRangeTLS *__restrict tls)
+{
+	int *data = (int *)item;
+	MempoolIterExData *data_chunk = (MempoolIterExData *)tls->userdata_chunk;
+
+	*data += 1;
+	data_chunk->num_items++;
+	data_chunk->sum += *data;
+}
+
+static void task_mempool_iter_ex_finalize(void *__restrict userdata, void *__restrict userdata_chunk)
+{
+	MempoolIterExData *data = (MempoolIterExData *)userdata;
+	MempoolIterExData *data_chunk = (MempoolIterExData *)userdata_chunk;
+
+	data->num_items += data_chunk->num_items;
+	data->sum += data_chunk->sum;
+}
+
+static void task_mempool_iter_ex_test(const eTaskSchedulingMode scheduling_mode, const bool use_threading)
+{
+	int *data[NUM_ITEMS];
+	BLI_mempool *mempool = BLI_mempool_create(sizeof(*data[0]), NUM_ITEMS, 32, BLI_MEMPOOL_ALLOW_ITER);
+
+	int i, num_items = 0, sum = 0;
+
+	for (i = 0; i < NUM_ITEMS; i++) {
+		data[i] = (int *)BLI_mempool_alloc(mempool);
+		*data[i] = i;
+	}
+	/* Leave some chunks partially and fully empty. */
+	for (i = 0; i < NUM_ITEMS; i++) {
+		if ((i % 5 == 0) || (i > 1000 && i < 1200)) {
+			BLI_mempool_free(mempool, data[i]);
+			data[i] = NULL;
+		}
+		else {
+			num_items++;
+			sum += i + 1;
+		}
+	}
+
+	MempoolIterExData result = {0, 0};
+	MempoolIterExData result_chunk = {0, 0};
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = use_threading;
+	settings.scheduling_mode = scheduling_mode;
+	settings.userdata_chunk = &result_chunk;
+	settings.userdata_chunk_size = sizeof(result_chunk);
+	settings.func_finalize = task_mempool_iter_ex_finalize;
+
+	BLI_task_parallel_mempool_ex(mempool, &result, task_mempool_iter_ex_func, &settings);
+
+	EXPECT_EQ(result.num_items, num_items);
+	EXPECT_EQ(result.sum, sum);
+	for (i = 0; i < NUM_ITEMS; i++) {
+		if (data[i] != NULL) {
+			EXPECT_EQ(*data[i], i + 1);
+		}
+	}
+
+	BLI_mempool_destroy(mempool);
+}
+
+TEST(task, MempoolIterEx)
+{
+	task_mempool_iter_ex_test(TASK_SCHEDULING_STATIC, true);
+	task_mempool_iter_ex_test(TASK_SCHEDULING_DYNAMIC, true);
+	task_mempool_iter_ex_test(TASK_SCHEDULING_STATIC, false);
+}
+
+/* Per-worker arena for scratch allocations in parallel ranges. */
+
+#define SCRATCH_LEN 16
+
+typedef struct RangeScratchData {
+	uint32_t num_heap_alloc;
+	unsigned int blocks_start;
+	unsigned int blocks_range;
+	int sum;
+} RangeScratchData;
+
+static int task_range_scratch_fill(int *scratch, const int iter)
+{
+	int sum = 0;
+	for (int i = 0; i < SCRATCH_LEN; i++) {
+		scratch[i] = iter;
+	}
+	for (int i = 0; i < SCRATCH_LEN; i++) {
+		sum += scratch[i];
+	}
+	return sum;
+}
+
+static void task_range_scratch_heap_func(
+        void *__restrict userdata, const int iter, const ParallelRangeTLS *__restrict tls)
+{
+	RangeScratchData *data = (RangeScratchData *)userdata;
+	int *scratch = (int *)MEM_mallocN(sizeof(*scratch) * SCRATCH_LEN, __func__);
+	atomic_add_and_fetch_uint32(&data->num_heap_alloc, 1);
+
+	EXPECT_TRUE(tls->arena == NULL);
+	*(int *)tls->userdata_chunk += task_range_scratch_fill(scratch, iter);
+
+	MEM_freeN(scratch);
+}
+
+static void task_range_scratch_arena_func(
+        void *__restrict UNUSED(userdata), const int iter, const ParallelRangeTLS *__restrict tls)
+{
+	int *scratch = (int *)BLI_memarena_alloc(tls->arena, sizeof(*scratch) * SCRATCH_LEN);
+
+	*(int *)tls->userdata_chunk += task_range_scratch_fill(scratch, iter);
+}
+
+static void task_range_scratch_finalize(void *__restrict userdata, void *__restrict userdata_chunk)
+{
+	RangeScratchData *data = (RangeScratchData *)userdata;
+	data->sum += *(int *)userdata_chunk;
+	/* Arenas are still alive here, everything allocated since the start of the range is in use. */
+	data->blocks_range = MAX2(data->blocks_range, MEM_get_memory_blocks_in_use() - data->blocks_start);
+}
+
+static void task_range_scratch_test(const bool use_arena, RangeScratchData *data)
+{
+	int sum_chunk = 0;
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.userdata_chunk = &sum_chunk;
+	settings.userdata_chunk_size = sizeof(sum_chunk);
+	settings.func_finalize = task_range_scratch_finalize;
+	settings.use_arena = use_arena;
+
+	memset(data, 0, sizeof(*data));
+	data->blocks_start = MEM_get_memory_blocks_in_use();
+
+	BLI_task_parallel_range(
+	        0, NUM_ITEMS, data,
+	        use_arena ? task_range_scratch_arena_func : task_range_scratch_heap_func,
+	        &settings);
+
+	EXPECT_EQ(data->sum, (NUM_ITEMS * (NUM_ITEMS - 1) / 2) * SCRATCH_LEN);
+}
+
+TEST(task, RangeArena)
+{
+	RangeScratchData data_heap, data_arena;
+
+	BLI_threadapi_init();
+
+	task_range_scratch_test(false, &data_heap);
+	task_range_scratch_test(true, &data_arena);
+
+	/* Heap blocks allocated for all scratch buffers, versus the ones held by the arenas. */
+	printf("Scratch allocations: %u with MEM_mallocN, %u with arenas\n",
+	       data_heap.num_heap_alloc, data_arena.blocks_range);
+
+	EXPECT_EQ(data_heap.num_heap_alloc, NUM_ITEMS);
+	EXPECT_LT(data_arena.blocks_range, NUM_ITEMS / 10);
+
+	BLI_threadapi_exit();
+}
+
+/* Work-stealing scheduler. */
+
+#define NUM_ROOT_TASKS 64
+#define NUM_CHILD_TASKS 64
+
+static void task_child_func(TaskPool *__restrict pool, void *UNUSED(taskdata), int UNUSED(threadid))
+{
+	int *count = (int *)BLI_task_pool_userdata(pool);
+	atomic_add_and_fetch_uint32((uint32_t *)count, 1);
+}
+
+static void task_root_func(TaskPool *__restrict pool, void *UNUSED(taskdata), int threadid)
+{
+	int *count = (int *)BLI_task_pool_userdata(pool);
+	atomic_add_and_fetch_uint32((uint32_t *)count, 1);
+	for (int i = 0; i < NUM_CHILD_TASKS; i++) {
+		BLI_task_pool_push_from_thread(pool, task_child_func, NULL, false, TASK_PRIORITY_HIGH, threadid);
+	}
+}
+
+static void task_nested_pool_func(TaskPool *__restrict pool, void *UNUSED(taskdata), int UNUSED(threadid))
+{
+	TaskScheduler *scheduler = (TaskScheduler *)BLI_task_pool_userdata(pool);
+	int count = 0;
+	TaskPool *nested_pool = BLI_task_pool_create(scheduler, &count);
+	for (int i = 0; i < NUM_CHILD_TASKS; i++) {
+		BLI_task_pool_push(nested_pool, task_root_func, NULL, false, TASK_PRIORITY_HIGH);
+	}
+	BLI_task_pool_work_and_wait(nested_pool);
+	BLI_task_pool_free(nested_pool);
+	EXPECT_EQ(count, NUM_CHILD_TASKS * (NUM_CHILD_TASKS + 1));
+}
+
+TEST(task, WorkStealingSpawn)
+{
+	BLI_threadapi_init();
+	TaskScheduler *scheduler = BLI_task_scheduler_create_ex(4, TASK_SCHEDULER_WORK_STEALING);
+
+	for (int iter = 0; iter < 10; iter++) {
+		int count = 0;
+		TaskPool *pool = BLI_task_pool_create(scheduler, &count);
+		for (int i = 0; i < NUM_ROOT_TASKS; i++) {
+			BLI_task_pool_push(pool, task_root_func, NULL, false, TASK_PRIORITY_HIGH);
+		}
+		BLI_task_pool_work_and_wait(pool);
+		BLI_task_pool_free(pool);
+		EXPECT_EQ(count, NUM_ROOT_TASKS * (NUM_CHILD_TASKS + 1));
+	}
+
+	BLI_task_scheduler_free(scheduler);
+	BLI_threadapi_exit();
+}
+
+TEST(task, WorkStealingNestedPools)
+{
+	BLI_threadapi_init();
+	TaskScheduler *scheduler = BLI_task_scheduler_create_ex(4, TASK_SCHEDULER_WORK_STEALING);
+
+	TaskPool *pool = BLI_task_pool_create(scheduler, scheduler);
+	for (int i = 0; i < 8; i++) {
+		BLI_task_pool_push(pool, task_nested_pool_func, NULL, false, TASK_PRIORITY_HIGH);
+	}
+	BLI_task_pool_work_and_wait(pool);
+	BLI_task_pool_free(pool);
+
+	BLI_task_scheduler_free(scheduler);
+	BLI_threadapi_exit();
+}
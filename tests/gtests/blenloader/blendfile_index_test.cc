@@ -0,0 +1,154 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <set>
+#include <string>
+
+extern "C" {
+#include "BLI_utildefines.h"
+#include "BLI_fileops.h"
+#include "BLI_linklist.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+
+#include "DNA_genfile.h"
+#include "DNA_mesh_types.h"
+#include "DNA_object_types.h"
+
+#include "BKE_appdir.h"
+#include "BKE_global.h"
+#include "BKE_idcode.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BKE_object.h"
+
+#include "BLO_blend_defs.h"
+#include "BLO_readfile.h"
+#include "BLO_writefile.h"
+
+#include "intern/readfile.h"
+}
+
+#define OBJECTS_NUM 100
+
+class BlendFileIndexTest : public testing::Test
+{
+protected:
+	static void SetUpTestCase()
+	{
+		DNA_sdna_current_init();
+		BKE_tempdir_init(NULL);
+	}
+
+	static void TearDownTestCase()
+	{
+		DNA_sdna_current_free();
+	}
+
+	/* Write a file with an index before ENDB, returns the names of its data-blocks. */
+	std::set<std::string> write_file(const char *filepath, const int write_flags)
+	{
+		std::set<std::string> names;
+		Main *bmain = BKE_main_new();
+		for (int i = 0; i < OBJECTS_NUM; i++) {
+			char name[MAX_ID_NAME - 2];
+			BLI_snprintf(name, sizeof(name), "LibMesh.%03d", i);
+			Mesh *me = BKE_mesh_add(bmain, name);
+			BLI_snprintf(name, sizeof(name), "LibObject.%03d", i);
+			Object *ob = BKE_object_add_only_object(bmain, OB_MESH, name);
+			/* Objects without users are not written, there is no scene to link them to. */
+			id_us_plus(&ob->id);
+			ob->data = me;
+			names.insert(me->id.name);
+			names.insert(ob->id.name);
+		}
+		EXPECT_TRUE(BLO_write_file(bmain, filepath, write_flags, NULL, NULL));
+		BKE_main_free(bmain);
+		return names;
+	}
+
+	/* Every block the reader gives is in the file before ENDB, and ENDB is the last one. */
+	void check_bheads(const char *filepath, const std::set<std::string> &names_expected)
+	{
+		BlendHandle *bh = BLO_blendhandle_from_file(filepath, NULL);
+		ASSERT_TRUE(bh != NULL);
+		FileData *fd = (FileData *)bh;
+
+		std::set<std::string> names;
+		BHead *bhead_last = NULL;
+		int bheads_len = 0, bheads_len_endb = 0;
+		for (BHead *bhead = blo_bhead_first(fd); bhead; bhead = blo_bhead_next(fd, bhead)) {
+			bheads_len++;
+			if (bhead->code == ENDB && bheads_len_endb == 0) {
+				bheads_len_endb = bheads_len;
+			}
+			if (BHEAD_CODE_IS_ID(bhead->code) &&
+			    BKE_idcode_is_valid(bhead->code) && BKE_idcode_is_linkable(bhead->code))
+			{
+				names.insert(blo_bhead_id_name(fd, bhead));
+			}
+			bhead_last = bhead;
+		}
+
+		ASSERT_TRUE(bhead_last != NULL);
+		EXPECT_EQ(bhead_last->code, ENDB);
+		EXPECT_EQ(bheads_len, bheads_len_endb);
+		EXPECT_EQ(names, names_expected);
+
+		BLO_blendhandle_close(bh);
+	}
+
+	/* Names listed through the index are the same as the ones of the blocks. */
+	void check_index_names(const char *filepath, const int idcode)
+	{
+		BlendHandle *bh = BLO_blendhandle_from_file(filepath, NULL);
+		BlendHandle *bh_index = BLO_blendhandle_from_file_index(filepath, NULL);
+		ASSERT_TRUE(bh != NULL);
+		ASSERT_TRUE(bh_index != NULL);
+
+		int names_len, names_index_len;
+		LinkNode *names = BLO_blendhandle_get_datablock_names(bh, idcode, &names_len);
+		LinkNode *names_index = BLO_blendhandle_get_datablock_names(bh_index, idcode, &names_index_len);
+		EXPECT_EQ(names_len, OBJECTS_NUM);
+		EXPECT_EQ(names_index_len, OBJECTS_NUM);
+
+		std::set<std::string> names_set, names_index_set;
+		for (LinkNode *link = names; link; link = link->next) {
+			names_set.insert((const char *)link->link);
+		}
+		for (LinkNode *link = names_index; link; link = link->next) {
+			names_index_set.insert((const char *)link->link);
+		}
+		EXPECT_EQ(names_set, names_index_set);
+
+		BLI_linklist_free(names, free);
+		BLI_linklist_free(names_index, free);
+		BLO_blendhandle_close(bh);
+		BLO_blendhandle_close(bh_index);
+	}
+
+	void check_file(const char *filename, const int write_flags)
+	{
+		char filepath[FILE_MAX];
+		BLI_join_dirfile(filepath, sizeof(filepath), BKE_tempdir_base(), filename);
+
+		const std::set<std::string> names = write_file(filepath, write_flags);
+		check_bheads(filepath, names);
+		check_index_names(filepath, ID_OB);
+		check_index_names(filepath, ID_ME);
+
+		BLI_delete(filepath, false, false);
+	}
+};
+
+TEST_F(BlendFileIndexTest, Uncompressed)
+{
+	check_file("blendfile_index_test.blend", 0);
+}
+
+TEST_F(BlendFileIndexTest, Compressed)
+{
+	check_file("blendfile_index_test_compressed.blend", G_FILE_COMPRESS);
+}
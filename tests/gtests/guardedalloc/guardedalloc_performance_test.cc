@@ -0,0 +1,107 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "MEM_guardedalloc.h"
+
+/* Number of blocks each thread keeps alive at once. */
+#define NUM_BLOCKS_BATCH 64
+#define NUM_ITERATIONS 20000
+
+namespace {
+
+void alloc_thread_func(const int seed)
+{
+	void *blocks[NUM_BLOCKS_BATCH];
+	unsigned int size = (unsigned int)seed;
+
+	for (int iter = 0; iter < NUM_ITERATIONS; iter++) {
+		for (int i = 0; i < NUM_BLOCKS_BATCH; i++) {
+			/* Small, varying sizes, typical for temporary data. */
+			size = size * 1103515245u + 12345u;
+			blocks[i] = MEM_mallocN(8 + (size >> 16) % 248, __func__);
+		}
+		for (int i = 0; i < NUM_BLOCKS_BATCH; i++) {
+			MEM_freeN(blocks[i]);
+		}
+	}
+}
+
+void alloc_scaling_test(const char *id)
+{
+	const int num_threads_max = (int)std::thread::hardware_concurrency();
+
+	printf("\n========== STARTING %s ==========\n", id);
+
+	const unsigned int blocks_start = MEM_get_memory_blocks_in_use();
+	const size_t mem_start = MEM_get_memory_in_use();
+
+	for (int num_threads = 1; num_threads <= std::max(num_threads_max, 8); num_threads *= 2) {
+		std::vector<std::thread> threads;
+
+		const auto time_start = std::chrono::steady_clock::now();
+		for (int i = 0; i < num_threads; i++) {
+			threads.push_back(std::thread(alloc_thread_func, i));
+		}
+		for (std::thread &thread : threads) {
+			thread.join();
+		}
+		const std::chrono::duration<double> time_total = std::chrono::steady_clock::now() - time_start;
+
+		const double num_allocs = (double)num_threads * NUM_ITERATIONS * NUM_BLOCKS_BATCH;
+		printf("%2d threads: %.6f sec, %.3f M alloc+free/sec\n",
+		       num_threads, time_total.count(), num_allocs / time_total.count() * 1e-6);
+
+		EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_start);
+		EXPECT_EQ(MEM_get_memory_in_use(), mem_start);
+	}
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+}  // namespace
+
+/* Blocks freed by another thread than the one allocating them. */
+TEST(guardedalloc, ThreadsStatsCrossThreadFree)
+{
+	const unsigned int blocks_start = MEM_get_memory_blocks_in_use();
+	const size_t mem_start = MEM_get_memory_in_use();
+	std::vector<void *> blocks(NUM_ITERATIONS);
+
+	std::thread thread_alloc([&blocks]() {
+		for (int i = 0; i < NUM_ITERATIONS; i++) {
+			blocks[i] = MEM_callocN((size_t)(i % 300), __func__);
+		}
+	});
+	thread_alloc.join();
+
+	EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_start + NUM_ITERATIONS);
+	EXPECT_GT(MEM_get_peak_memory(), mem_start);
+
+	std::thread thread_free([&blocks]() {
+		for (int i = 0; i < NUM_ITERATIONS; i++) {
+			EXPECT_EQ(MEM_allocN_len(blocks[i]), (size_t)((i % 300 + 3) & ~3));
+			MEM_freeN(blocks[i]);
+		}
+	});
+	thread_free.join();
+
+	EXPECT_EQ(MEM_get_memory_blocks_in_use(), blocks_start);
+	EXPECT_EQ(MEM_get_memory_in_use(), mem_start);
+}
+
+TEST(guardedalloc, ThreadsScaling)
+{
+	alloc_scaling_test("ThreadsScaling");
+}
+
+/* Must run last, the thread cache can't be disabled again. */
+TEST(guardedalloc, ThreadsScalingThreadCache)
+{
+	MEM_use_thread_cache();
+	alloc_scaling_test("ThreadsScalingThreadCache");
+}
@@ -0,0 +1,656 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+
+#include "DNA_genfile.h"
+#include "DNA_sdna_types.h"
+}
+
+/* -------------------------------------------------------------------- */
+/* SDNA creation */
+
+struct DNAMember {
+	const char *type;
+	const char *name;
+};
+
+struct DNAStruct {
+	const char *type;
+	std::vector<DNAMember> members;
+};
+
+/* Primitive types in the order written by makesdna, so their index is their #eSDNA_Type. */
+static const std::pair<const char *, short> sdna_primitive_types[] = {
+	{"char", 1}, {"uchar", 1}, {"short", 2}, {"ushort", 2}, {"int", 4}, {"long", 4},
+	{"ulong", 4}, {"float", 4}, {"double", 8}, {"void", 0}, {"int64_t", 8}, {"uint64_t", 8},
+};
+
+static int name_array_len(const char *name)
+{
+	int len = 1;
+	for (const char *cp = strchr(name, '['); cp; cp = strchr(cp + 1, '[')) {
+		len *= atoi(cp + 1);
+	}
+	return len;
+}
+
+static void data_append(std::vector<char> &data, const void *value, const size_t size)
+{
+	data.insert(data.end(), (const char *)value, (const char *)value + size);
+}
+
+static void data_append_code(std::vector<char> &data, const char code[4])
+{
+	data_append(data, code, 4);
+}
+
+static void data_append_int(std::vector<char> &data, const int value)
+{
+	data_append(data, &value, sizeof(value));
+}
+
+static void data_append_short(std::vector<char> &data, const short value)
+{
+	data_append(data, &value, sizeof(value));
+}
+
+static void data_append_string(std::vector<char> &data, const char *str)
+{
+	data_append(data, str, strlen(str) + 1);
+}
+
+static void data_pad_4(std::vector<char> &data)
+{
+	while (data.size() % 4) {
+		data.push_back('\0');
+	}
+}
+
+/**
+ * Encode \a structs the way makesdna does, members of struct types must be defined before.
+ * Link and ListBase are added first, as in the SDNA of Blender, they're used for the pointer size.
+ */
+static SDNA *sdna_create(const std::vector<DNAStruct> &structs_custom, const int pointer_size)
+{
+	std::vector<DNAStruct> structs = {
+		{"Link", {{"Link", "*next"}, {"Link", "*prev"}}},
+		{"ListBase", {{"void", "*first"}, {"void", "*last"}}},
+	};
+	structs.insert(structs.end(), structs_custom.begin(), structs_custom.end());
+
+	std::vector<std::string> types, names;
+	std::vector<short> types_size;
+	std::map<std::string, int> types_map, names_map;
+	for (const auto &type : sdna_primitive_types) {
+		types_map[type.first] = (int)types.size();
+		types.push_back(type.first);
+		types_size.push_back(type.second);
+	}
+	for (const DNAStruct &dna_struct : structs) {
+		types_map[dna_struct.type] = (int)types.size();
+		types.push_back(dna_struct.type);
+		types_size.push_back(0);
+	}
+
+	std::vector<short> structs_data;
+	for (const DNAStruct &dna_struct : structs) {
+		const int type_nr = types_map.at(dna_struct.type);
+		structs_data.push_back((short)type_nr);
+		structs_data.push_back((short)dna_struct.members.size());
+		for (const DNAMember &member : dna_struct.members) {
+			if (names_map.count(member.name) == 0) {
+				names_map[member.name] = (int)names.size();
+				names.push_back(member.name);
+			}
+			structs_data.push_back((short)types_map.at(member.type));
+			structs_data.push_back((short)names_map.at(member.name));
+
+			const bool is_pointer = ELEM(member.name[0], '*', '(');
+			const int size = is_pointer ? pointer_size : types_size[types_map.at(member.type)];
+			types_size[type_nr] += (short)(size * name_array_len(member.name));
+		}
+	}
+
+	std::vector<char> data;
+	data_append_code(data, "SDNA");
+	data_append_code(data, "NAME");
+	data_append_int(data, (int)names.size());
+	for (const std::string &name : names) {
+		data_append_string(data, name.c_str());
+	}
+	data_pad_4(data);
+	data_append_code(data, "TYPE");
+	data_append_int(data, (int)types.size());
+	for (const std::string &type : types) {
+		data_append_string(data, type.c_str());
+	}
+	data_pad_4(data);
+	data_append_code(data, "TLEN");
+	for (const short size : types_size) {
+		data_append_short(data, size);
+	}
+	data_pad_4(data);
+	data_append_code(data, "STRC");
+	data_append_int(data, (int)structs.size());
+	for (const short value : structs_data) {
+		data_append_short(data, value);
+	}
+
+	const char *error_message = NULL;
+	SDNA *sdna = DNA_sdna_from_data(&data[0], (int)data.size(), false, true, &error_message);
+	EXPECT_TRUE(error_message == NULL) << error_message;
+	return sdna;
+}
+
+static int sdna_struct_size(const SDNA *sdna, const int struct_nr)
+{
+	return sdna->types_size[sdna->structs[struct_nr][0]];
+}
+
+/**
+ * Fill a struct with values valid for the type of each member,
+ * so conversions between types are defined.
+ */
+static void sdna_struct_fill(const SDNA *sdna, const int struct_nr, char *data, int *r_value)
+{
+	const short *sp = sdna->structs[struct_nr];
+	const int firststructtypenr = sdna->structs[0][0];
+	const int elemcount = sp[1];
+	sp += 2;
+	for (int a = 0; a < elemcount; a++, sp += 2) {
+		const char *type = sdna->types[sp[0]];
+		const char *name = sdna->names[sp[1]];
+		const int array_len = sdna->names_array_len[sp[1]];
+
+		for (int i = 0; i < array_len; i++) {
+			const int value = (*r_value)++ % 100 + 1;
+			if (ELEM(name[0], '*', '(')) {
+				/* Multiples of 8, as pointers of 64 bit files are shifted to 32 bit. */
+				if (sdna->pointer_size == 8) {
+					*(int64_t *)data = (int64_t)value << 35;
+				}
+				else {
+					*(int *)data = value << 3;
+				}
+				data += sdna->pointer_size;
+			}
+			else if (sp[0] >= firststructtypenr) {
+				const int substruct_nr = DNA_struct_find_nr(sdna, type);
+				sdna_struct_fill(sdna, substruct_nr, data, r_value);
+				data += sdna_struct_size(sdna, substruct_nr);
+			}
+			else {
+				switch (sp[0]) {
+					case SDNA_TYPE_CHAR:   *(char *)data = (char)('a' + value % 26); break;
+					case SDNA_TYPE_UCHAR:  *(unsigned char *)data = (unsigned char)(value * 2); break;
+					case SDNA_TYPE_SHORT:  *(short *)data = (short)-value; break;
+					case SDNA_TYPE_USHORT: *(unsigned short *)data = (unsigned short)value; break;
+					case SDNA_TYPE_INT:    *(int *)data = value * -100; break;
+					case SDNA_TYPE_FLOAT:  *(float *)data = value * 0.5f; break;
+					case SDNA_TYPE_DOUBLE: *(double *)data = value * 0.25; break;
+					case SDNA_TYPE_INT64:  *(int64_t *)data = (int64_t)value * 1000000; break;
+					case SDNA_TYPE_UINT64: *(uint64_t *)data = (uint64_t)value * 1000000; break;
+				}
+				data += sdna->types_size[sp[0]];
+			}
+		}
+	}
+}
+
+/* -------------------------------------------------------------------- */
+/* Reference reconstruction
+ *
+ * Reconstruction as done before the per-struct plans, looking up the old member
+ * of each new member by name for every struct read. Kept to check the plans
+ * give the same results.
+ *
+ * Struct arrays which grew used to shift the members after them, since the
+ * unread elements weren't skipped, this is fixed here too. */
+
+static bool ref_ispointer(const char *name)
+{
+	return (name[0] == '*' || (name[0] == '(' && name[1] == '*'));
+}
+
+static int ref_elementsize(const SDNA *sdna, short type, short name)
+{
+	const char *cp = sdna->names[name];
+	if (ref_ispointer(cp)) {
+		return sdna->pointer_size * sdna->names_array_len[name];
+	}
+	return (int)sdna->types_size[type] * sdna->names_array_len[name];
+}
+
+static int ref_sdna_type_nr(const char *dna_type)
+{
+	for (int i = 0; i < (int)ARRAY_SIZE(sdna_primitive_types); i++) {
+		if (!ELEM(i, 5, 6, SDNA_TYPE_VOID) && STREQ(dna_type, sdna_primitive_types[i].first)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static void ref_cast_elem(
+        const char *ctype, const char *otype, int name_array_len,
+        char *curdata, const char *olddata)
+{
+	double val = 0.0;
+	const int otypenr = ref_sdna_type_nr(otype);
+	const int ctypenr = ref_sdna_type_nr(ctype);
+	if (otypenr == -1 || ctypenr == -1) {
+		return;
+	}
+
+	const int oldlen = DNA_elem_type_size((eSDNA_Type)otypenr);
+	const int curlen = DNA_elem_type_size((eSDNA_Type)ctypenr);
+
+	while (name_array_len > 0) {
+		switch (otypenr) {
+			case SDNA_TYPE_CHAR:   val = *olddata; break;
+			case SDNA_TYPE_UCHAR:  val = *((unsigned char *)olddata); break;
+			case SDNA_TYPE_SHORT:  val = *((short *)olddata); break;
+			case SDNA_TYPE_USHORT: val = *((unsigned short *)olddata); break;
+			case SDNA_TYPE_INT:    val = *((int *)olddata); break;
+			case SDNA_TYPE_FLOAT:  val = *((float *)olddata); break;
+			case SDNA_TYPE_DOUBLE: val = *((double *)olddata); break;
+			case SDNA_TYPE_INT64:  val = (double)*((int64_t *)olddata); break;
+			case SDNA_TYPE_UINT64: val = (double)*((uint64_t *)olddata); break;
+		}
+
+		switch (ctypenr) {
+			case SDNA_TYPE_CHAR:   *curdata = (char)val; break;
+			case SDNA_TYPE_UCHAR:  *((unsigned char *)curdata) = (unsigned char)val; break;
+			case SDNA_TYPE_SHORT:  *((short *)curdata) = (short)val; break;
+			case SDNA_TYPE_USHORT: *((unsigned short *)curdata) = (unsigned short)val; break;
+			case SDNA_TYPE_INT:    *((int *)curdata) = (int)val; break;
+			case SDNA_TYPE_FLOAT:
+				if (otypenr < 2) {
+					val /= 255;
+				}
+				*((float *)curdata) = (float)val;
+				break;
+			case SDNA_TYPE_DOUBLE:
+				if (otypenr < 2) {
+					val /= 255;
+				}
+				*((double *)curdata) = val;
+				break;
+			case SDNA_TYPE_INT64:  *((int64_t *)curdata) = (int64_t)val; break;
+			case SDNA_TYPE_UINT64: *((uint64_t *)curdata) = (uint64_t)val; break;
+		}
+
+		olddata += oldlen;
+		curdata += curlen;
+		name_array_len--;
+	}
+}
+
+static void ref_cast_pointer(int curlen, int oldlen, int name_array_len, char *curdata, const char *olddata)
+{
+	while (name_array_len > 0) {
+		if (curlen == oldlen) {
+			memcpy(curdata, olddata, curlen);
+		}
+		else if (curlen == 4 && oldlen == 8) {
+			const int64_t lval = *((int64_t *)olddata);
+			*((int *)curdata) = (int)(lval >> 3);
+		}
+		else if (curlen == 8 && oldlen == 4) {
+			*((int64_t *)curdata) = *((int *)olddata);
+		}
+
+		olddata += oldlen;
+		curdata += curlen;
+		name_array_len--;
+	}
+}
+
+static int ref_elem_strcmp(const char *name, const char *oname)
+{
+	int a = 0;
+	while (1) {
+		if (name[a] != oname[a]) {
+			return 1;
+		}
+		if (name[a] == '[' || oname[a] == '[') {
+			break;
+		}
+		if (name[a] == 0 || oname[a] == 0) {
+			break;
+		}
+		a++;
+	}
+	return 0;
+}
+
+static const char *ref_find_elem(
+        const SDNA *sdna, const char *type, const char *name, const short *old,
+        const char *olddata, const short **sppo)
+{
+	const int elemcount = old[1];
+	old += 2;
+	for (int a = 0; a < elemcount; a++, old += 2) {
+		const char *otype = sdna->types[old[0]];
+		const char *oname = sdna->names[old[1]];
+		const int len = ref_elementsize(sdna, old[0], old[1]);
+
+		if (ref_elem_strcmp(name, oname) == 0) {  /* name equal */
+			if (strcmp(type, otype) == 0) {  /* type equal */
+				*sppo = old;
+				return olddata;
+			}
+			return NULL;
+		}
+		olddata += len;
+	}
+	return NULL;
+}
+
+static void ref_reconstruct_elem(
+        const SDNA *newsdna, const SDNA *oldsdna, const char *type, const int new_name_nr,
+        char *curdata, const short *old, const char *olddata)
+{
+	const char *name = newsdna->names[new_name_nr];
+	int countpos = 0;
+	while (name[countpos] && name[countpos] != '[') {
+		countpos++;
+	}
+	if (name[countpos] != '[') {
+		countpos = 0;
+	}
+
+	const int elemcount = old[1];
+	old += 2;
+	for (int a = 0; a < elemcount; a++, old += 2) {
+		const int old_name_nr = old[1];
+		const char *otype = oldsdna->types[old[0]];
+		const char *oname = oldsdna->names[old[1]];
+		const int len = ref_elementsize(oldsdna, old[0], old[1]);
+
+		if (strcmp(name, oname) == 0) {  /* name equal */
+			if (ref_ispointer(name)) {
+				ref_cast_pointer(newsdna->pointer_size, oldsdna->pointer_size,
+				                 newsdna->names_array_len[new_name_nr], curdata, olddata);
+			}
+			else if (strcmp(type, otype) == 0) {  /* type equal */
+				memcpy(curdata, olddata, len);
+			}
+			else {
+				ref_cast_elem(type, otype, newsdna->names_array_len[new_name_nr], curdata, olddata);
+			}
+			return;
+		}
+		else if (countpos != 0) {  /* name is an array */
+			if (oname[countpos] == '[' && strncmp(name, oname, countpos) == 0) {  /* basis equal */
+				const int new_name_array_len = newsdna->names_array_len[new_name_nr];
+				const int old_name_array_len = oldsdna->names_array_len[old_name_nr];
+				const int min_name_array_len = MIN2(new_name_array_len, old_name_array_len);
+
+				if (ref_ispointer(name)) {
+					ref_cast_pointer(newsdna->pointer_size, oldsdna->pointer_size,
+					                 min_name_array_len, curdata, olddata);
+				}
+				else if (strcmp(type, otype) == 0) {  /* type equal */
+					const int mul = (len / old_name_array_len) * min_name_array_len;
+					memcpy(curdata, olddata, mul);
+					if (old_name_array_len > new_name_array_len && strcmp(type, "char") == 0) {
+						/* string had to be truncated, ensure it's still null-terminated */
+						curdata[mul - 1] = '\0';
+					}
+				}
+				else {
+					ref_cast_elem(type, otype, min_name_array_len, curdata, olddata);
+				}
+				return;
+			}
+		}
+		olddata += len;
+	}
+}
+
+static void ref_reconstruct_struct(
+        const SDNA *newsdna, const SDNA *oldsdna, const char *compflags,
+        int oldSDNAnr, const char *data, int curSDNAnr, char *cur)
+{
+	if (oldSDNAnr == -1 || curSDNAnr == -1) {
+		return;
+	}
+
+	if (compflags[oldSDNAnr] == SDNA_CMP_EQUAL) {
+		memcpy(cur, data, sdna_struct_size(oldsdna, oldSDNAnr));
+		return;
+	}
+
+	const int firststructtypenr = *(newsdna->structs[0]);
+	const short *spo = oldsdna->structs[oldSDNAnr];
+	const short *spc = newsdna->structs[curSDNAnr];
+	const int elemcount = spc[1];
+
+	spc += 2;
+	char *cpc = cur;
+	for (int a = 0; a < elemcount; a++, spc += 2) {
+		const char *type = newsdna->types[spc[0]];
+		const char *name = newsdna->names[spc[1]];
+		const int elen = ref_elementsize(newsdna, spc[0], spc[1]);
+
+		if (name[0] == '_' || (name[0] == '*' && name[1] == '_')) {
+			/* pad */
+		}
+		else if (spc[0] >= firststructtypenr && !ref_ispointer(name)) {
+			const short *sppo;
+			const char *cpo = ref_find_elem(oldsdna, type, name, spo, data, &sppo);
+			if (cpo) {
+				const int old_nr = DNA_struct_find_nr(oldsdna, type);
+				const int cur_nr = DNA_struct_find_nr(newsdna, type);
+				int mul = newsdna->names_array_len[spc[1]];
+				int mulo = oldsdna->names_array_len[sppo[1]];
+				const int eleno = ref_elementsize(oldsdna, sppo[0], sppo[1]) / mulo;
+				const int elen_item = elen / mul;
+				char *cpc_item = cpc;
+
+				while (mul--) {
+					ref_reconstruct_struct(newsdna, oldsdna, compflags, old_nr, cpo, cur_nr, cpc_item);
+					cpo += eleno;
+					cpc_item += elen_item;
+
+					/* new struct array larger than old */
+					mulo--;
+					if (mulo <= 0) {
+						break;
+					}
+				}
+			}
+		}
+		else {
+			ref_reconstruct_elem(newsdna, oldsdna, type, spc[1], cpc, spo, data);
+		}
+		cpc += elen;
+	}
+}
+
+static char *ref_struct_reconstruct(
+        const SDNA *newsdna, const SDNA *oldsdna, const char *compflags,
+        int oldSDNAnr, int blocks, const char *data)
+{
+	const int curSDNAnr = DNA_struct_find_nr(newsdna, oldsdna->types[oldsdna->structs[oldSDNAnr][0]]);
+	if (curSDNAnr == -1) {
+		return NULL;
+	}
+	const int oldlen = sdna_struct_size(oldsdna, oldSDNAnr);
+	const int curlen = sdna_struct_size(newsdna, curSDNAnr);
+
+	char *cur = (char *)MEM_callocN(blocks * curlen, __func__);
+	for (int a = 0; a < blocks; a++) {
+		ref_reconstruct_struct(newsdna, oldsdna, compflags, oldSDNAnr, data + a * oldlen, curSDNAnr, cur + a * curlen);
+	}
+	return cur;
+}
+
+/* -------------------------------------------------------------------- */
+/* tests */
+
+#define BLOCKS_NUM 3
+
+/**
+ * Reconstruct \a struct_type of the old definitions into the new ones,
+ * with the plans and with the reference.
+ */
+static void check_reconstruct(
+        const std::vector<DNAStruct> &structs_old, const int pointer_size_old,
+        const std::vector<DNAStruct> &structs_new, const int pointer_size_new,
+        const char *struct_type, const bool expect_equal = false)
+{
+	SDNA *oldsdna = sdna_create(structs_old, pointer_size_old);
+	SDNA *newsdna = sdna_create(structs_new, pointer_size_new);
+	ASSERT_TRUE(oldsdna != NULL);
+	ASSERT_TRUE(newsdna != NULL);
+
+	const int old_struct_nr = DNA_struct_find_nr(oldsdna, struct_type);
+	const int new_struct_nr = DNA_struct_find_nr(newsdna, struct_type);
+	ASSERT_NE(old_struct_nr, -1);
+	ASSERT_NE(new_struct_nr, -1);
+
+	const char *compflags = DNA_struct_get_compareflags(oldsdna, newsdna);
+	EXPECT_EQ(compflags[old_struct_nr], expect_equal ? SDNA_CMP_EQUAL : SDNA_CMP_NOT_EQUAL);
+
+	const int old_size = sdna_struct_size(oldsdna, old_struct_nr);
+	const int new_size = sdna_struct_size(newsdna, new_struct_nr);
+	std::vector<char> old_blocks(old_size * BLOCKS_NUM);
+	int value = 0;
+	for (int a = 0; a < BLOCKS_NUM; a++) {
+		sdna_struct_fill(oldsdna, old_struct_nr, &old_blocks[a * old_size], &value);
+	}
+
+	DNA_ReconstructInfo *reconstruct_info = DNA_reconstruct_info_create(oldsdna, newsdna, compflags);
+	char *new_blocks = (char *)DNA_struct_reconstruct(reconstruct_info, old_struct_nr, BLOCKS_NUM, &old_blocks[0]);
+	char *new_blocks_ref = ref_struct_reconstruct(newsdna, oldsdna, compflags, old_struct_nr, BLOCKS_NUM, &old_blocks[0]);
+	ASSERT_TRUE(new_blocks != NULL);
+	ASSERT_TRUE(new_blocks_ref != NULL);
+
+	EXPECT_EQ(std::vector<char>(new_blocks, new_blocks + new_size * BLOCKS_NUM),
+	          std::vector<char>(new_blocks_ref, new_blocks_ref + new_size * BLOCKS_NUM));
+
+	MEM_freeN(new_blocks);
+	MEM_freeN(new_blocks_ref);
+	DNA_reconstruct_info_free(reconstruct_info);
+	MEM_freeN((void *)compflags);
+	DNA_sdna_free(oldsdna);
+	DNA_sdna_free(newsdna);
+}
+
+static const std::vector<DNAStruct> structs_base = {
+	{"Inner", {{"short", "flag"}, {"short", "type"}, {"float", "co[3]"}}},
+	{"Test", {
+		{"int", "a"}, {"float", "b"}, {"short", "c"}, {"short", "d"},
+		{"double", "e"}, {"char", "name[8]"}, {"Inner", "inner"}, {"Link", "*link"},
+	}},
+};
+
+TEST(dna_genfile, ReconstructEqual)
+{
+	check_reconstruct(structs_base, 8, structs_base, 8, "Test", true);
+}
+
+TEST(dna_genfile, ReconstructMemberOrder)
+{
+	check_reconstruct(structs_base, 8, {
+		{"Inner", {{"float", "co[3]"}, {"short", "type"}, {"short", "flag"}}},
+		{"Test", {
+			{"Link", "*link"}, {"double", "e"}, {"Inner", "inner"}, {"char", "name[8]"},
+			{"short", "d"}, {"short", "c"}, {"float", "b"}, {"int", "a"},
+		}},
+	}, 8, "Test");
+}
+
+TEST(dna_genfile, ReconstructMemberAddRemove)
+{
+	check_reconstruct(structs_base, 8, {
+		{"Inner", {{"short", "flag"}, {"short", "_pad0"}, {"int", "added"}, {"float", "co[3]"}}},
+		{"Test", {
+			{"int", "a"}, {"int", "added"}, {"short", "d"}, {"short", "_pad0[3]"},
+			{"char", "name[8]"}, {"Inner", "inner"}, {"Link", "*link"}, {"void", "*added_ptr"},
+		}},
+	}, 8, "Test");
+}
+
+TEST(dna_genfile, ReconstructMemberTypes)
+{
+	const std::vector<DNAStruct> structs_old = {
+		{"Test", {
+			{"char", "c"}, {"uchar", "uc[3]"}, {"short", "s[2]"}, {"ushort", "us"},
+			{"int", "i[3]"}, {"float", "f[2]"}, {"double", "d"}, {"int64_t", "i64"}, {"uint64_t", "u64"},
+		}},
+	};
+	const std::vector<DNAStruct> structs_new = {
+		{"Test", {
+			{"float", "c"}, {"double", "uc[3]"}, {"int", "s[2]"}, {"float", "us"},
+			{"short", "i[3]"}, {"double", "f[2]"}, {"int", "d"}, {"double", "i64"}, {"int64_t", "u64"},
+		}},
+	};
+	check_reconstruct(structs_old, 8, structs_new, 8, "Test");
+	check_reconstruct(structs_new, 8, structs_old, 8, "Test");
+}
+
+TEST(dna_genfile, ReconstructArraySize)
+{
+	const std::vector<DNAStruct> structs_old = {
+		{"Test", {
+			{"char", "name[8]"}, {"float", "co[2]"}, {"int", "flag[4]"},
+			{"short", "mat[2][2]"}, {"float", "cast[2]"}, {"int", "single"},
+		}},
+	};
+	const std::vector<DNAStruct> structs_new = {
+		{"Test", {
+			{"char", "name[4]"}, {"float", "co[3]"}, {"int", "flag[2]"},
+			{"short", "mat[3][3]"}, {"double", "cast[3]"}, {"int", "single[2]"},
+		}},
+	};
+	check_reconstruct(structs_old, 8, structs_new, 8, "Test");
+	check_reconstruct(structs_new, 8, structs_old, 8, "Test");
+}
+
+TEST(dna_genfile, ReconstructSubstructArraySize)
+{
+	const std::vector<DNAStruct> structs_old = {
+		{"Inner", {{"short", "flag"}, {"short", "type"}, {"float", "co[3]"}}},
+		{"Same", {{"int", "a"}, {"int", "b"}}},
+		{"Test", {
+			{"Inner", "grow[2]"}, {"int", "after_grow"}, {"Inner", "shrink[4]"}, {"int", "after_shrink"},
+			{"Same", "same[3]"}, {"Same", "same_grow"}, {"int", "last"},
+		}},
+	};
+	const std::vector<DNAStruct> structs_new = {
+		{"Inner", {{"int", "flag"}, {"short", "type"}, {"short", "_pad0"}, {"float", "co[4]"}}},
+		{"Same", {{"int", "a"}, {"int", "b"}}},
+		{"Test", {
+			{"Inner", "grow[3]"}, {"int", "after_grow"}, {"Inner", "shrink[2]"}, {"int", "after_shrink"},
+			{"Same", "same[3]"}, {"Same", "same_grow[2]"}, {"int", "last"},
+		}},
+	};
+	check_reconstruct(structs_old, 8, structs_new, 8, "Test");
+	check_reconstruct(structs_new, 8, structs_old, 8, "Test");
+}
+
+TEST(dna_genfile, ReconstructPointerSize)
+{
+	const std::vector<DNAStruct> structs = {
+		{"Inner", {{"Link", "*link"}, {"int", "flag"}, {"int", "_pad0"}}},
+		{"Test", {
+			{"void", "*ptr"}, {"int", "(*func)()"}, {"Link", "*array[3]"},
+			{"Inner", "inner[2]"}, {"int", "flag"}, {"int", "_pad0"},
+		}},
+	};
+	check_reconstruct(structs, 4, structs, 8, "Test");
+	check_reconstruct(structs, 8, structs, 4, "Test");
+}
@@ -0,0 +1,145 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Link and append from files saved with a data-block index, stored in a TEST
+block before ENDB, which reading blocks of the file must skip. Older versions
+of Blender only skip some block codes and stop reading at ENDB, check files
+only use these.
+
+./blender.bin --background --factory-startup --python tests/python/bl_blendfile_index.py
+"""
+
+import os
+import struct
+import tempfile
+import unittest
+
+import bpy
+
+OBJECTS_NUM = 200
+
+# Codes of blocks which aren't data-blocks.
+BLOCK_CODES = {b"DATA", b"GLOB", b"DNA1", b"TEST", b"REND", b"USER", b"ENDB"}
+
+
+def data_names():
+    names = {}
+    for attr in dir(bpy.data):
+        collection = getattr(bpy.data, attr)
+        if isinstance(collection, bpy.types.bpy_prop_collection):
+            names[attr] = sorted(id.name for id in collection if id.library is None)
+    return names
+
+
+class TestBlendFileIndex(unittest.TestCase):
+
+    def setUp(self):
+        self.tempdir = tempfile.TemporaryDirectory()
+
+    def tearDown(self):
+        self.tempdir.cleanup()
+
+    def save_library(self, compress):
+        bpy.ops.wm.read_factory_settings(use_empty=True)
+        scene = bpy.context.scene
+        for i in range(OBJECTS_NUM):
+            mesh = bpy.data.meshes.new("LibMesh.%03d" % i)
+            mesh.vertices.add(i % 7)
+            ob = bpy.data.objects.new("LibObject.%03d" % i, mesh)
+            ob.data.materials.append(bpy.data.materials.new("LibMaterial.%03d" % i))
+            scene.collection.objects.link(ob)
+        expected = data_names()
+        filepath = os.path.join(self.tempdir.name, "library.blend")
+        bpy.ops.wm.save_as_mainfile(filepath=filepath, compress=compress, check_existing=False)
+        return filepath, expected
+
+    def check_library_contents(self, filepath, expected):
+        with bpy.data.libraries.load(filepath) as (data_from, data_to):
+            for attr, names in expected.items():
+                if not hasattr(data_from, attr):
+                    continue
+                names_from = sorted(getattr(data_from, attr))
+                if attr in {"objects", "meshes", "materials"}:
+                    self.assertEqual(len(names_from), OBJECTS_NUM, attr)
+                    self.assertEqual(names_from, names, attr)
+                else:
+                    # Data-blocks without users are not saved.
+                    self.assertTrue(set(names_from).issubset(names), attr)
+
+    def check_link_or_append(self, filepath, link):
+        bpy.ops.wm.read_factory_settings(use_empty=True)
+        with bpy.data.libraries.load(filepath, link=link) as (data_from, data_to):
+            data_to.objects = data_from.objects
+        names = sorted(ob.name for ob in bpy.data.objects)
+        self.assertEqual(names, ["LibObject.%03d" % i for i in range(OBJECTS_NUM)])
+        for ob in bpy.data.objects:
+            self.assertEqual(ob.library is not None, link)
+            self.assertEqual(ob.data.name, ob.name.replace("LibObject", "LibMesh"))
+            self.assertEqual(ob.data.materials[0].name, ob.name.replace("LibObject", "LibMaterial"))
+        self.assertEqual(len(bpy.data.meshes), OBJECTS_NUM)
+        self.assertEqual(len(bpy.data.materials), OBJECTS_NUM)
+
+    def check_blocks(self, filepath):
+        """
+        Read blocks of an uncompressed file up to ENDB, as older versions do.
+        """
+        with open(filepath, "rb") as fh:
+            data = fh.read()
+        self.assertEqual(data[:7], b"BLENDER")
+        pointer_size = 8 if data[7:8] == b"-" else 4
+        endian = "<" if data[8:9] == b"v" else ">"
+        bhead_format = endian + "4si" + ("Q" if pointer_size == 8 else "I") + "ii"
+        bhead_size = struct.calcsize(bhead_format)
+
+        offset = 12
+        blocks = []
+        while True:
+            code, length, _old, _sdna_nr, _nr = struct.unpack_from(bhead_format, data, offset)
+            self.assertTrue(code in BLOCK_CODES or code[2:] == b"\0\0", code)
+            blocks.append((code, data[offset + bhead_size:offset + bhead_size + length]))
+            offset += bhead_size + length
+            if code == b"ENDB":
+                break
+        # Nothing after ENDB, the index is the last block before it.
+        self.assertEqual(offset, len(data))
+        code, block_data = blocks[-2]
+        self.assertEqual(code, b"TEST")
+        self.assertEqual(block_data[-8:], b"BLENDIDX")
+
+    def check_file(self, compress):
+        filepath, expected = self.save_library(compress)
+        if not compress:
+            self.check_blocks(filepath)
+        self.check_library_contents(filepath, expected)
+        self.check_link_or_append(filepath, link=True)
+        self.check_link_or_append(filepath, link=False)
+
+    def test_uncompressed(self):
+        self.check_file(compress=False)
+
+    def test_compressed(self):
+        self.check_file(compress=True)
+
+
+if __name__ == '__main__':
+    import sys
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()
@@ -0,0 +1,119 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Measure the time of saving a synthetic scene, made of many objects each using its own mesh.
+
+Data-blocks are written sequentially, pass '--threads' to compare with writing them in parallel.
+
+Example Usage:
+
+./blender.bin --background --factory-startup --python tests/python/bl_blendfile_save_benchmark.py -- \
+    --objects=20000 \
+    --verts=1000 \
+    --save_path=/tmp/benchmark.blend
+
+./blender.bin --background --factory-startup \
+    --python tests/python/bl_blendfile_save_benchmark.py -- \
+    --objects=20000 \
+    --compress \
+    --threads
+"""
+
+import os
+import sys
+import time
+
+
+def scene_create(objects, verts):
+    import bpy
+
+    scene = bpy.context.scene
+    for i in range(objects):
+        mesh = bpy.data.meshes.new("Mesh")
+        mesh.vertices.add(verts)
+        mesh.vertices.foreach_set("co", [float((i * j) % 977) for j in range(verts * 3)])
+        ob = bpy.data.objects.new("Object", mesh)
+        scene.collection.objects.link(ob)
+
+
+def save_benchmark(
+    objects=10000,
+    verts=100,
+    repeat=3,
+    save_path="",
+    compress=False,
+    use_threads=False,
+):
+    import bpy
+
+    if not save_path:
+        import tempfile
+        save_path = os.path.join(tempfile.gettempdir(), "bl_blendfile_save_benchmark.blend")
+
+    time_start = time.time()
+    scene_create(objects, verts)
+    print("Created %d objects in %.3fs" % (objects, time.time() - time_start))
+
+    times = []
+    for _ in range(repeat):
+        time_start = time.time()
+        bpy.ops.wm.save_as_mainfile(filepath=save_path, compress=compress, copy=True, use_threads=use_threads)
+        times.append(time.time() - time_start)
+
+    print("Saved %r (%d bytes), best of %d: %.3fs, average: %.3fs" % (
+        save_path, os.path.getsize(save_path), repeat, min(times), sum(times) / len(times)))
+
+    os.remove(save_path)
+
+
+def main():
+    import argparse
+
+    argv = sys.argv
+    argv = argv[argv.index("--") + 1:] if "--" in argv else []
+
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--objects", dest="objects", type=int, default=10000,
+                        help="Number of objects to create")
+    parser.add_argument("--verts", dest="verts", type=int, default=100,
+                        help="Number of vertices of each mesh")
+    parser.add_argument("--repeat", dest="repeat", type=int, default=3,
+                        help="Number of times the file is saved")
+    parser.add_argument("--save_path", dest="save_path", default="",
+                        help="File to save (removed afterwards)")
+    parser.add_argument("--compress", dest="compress", action="store_true",
+                        help="Save compressed files")
+    parser.add_argument("--threads", dest="use_threads", action="store_true",
+                        help="Write data-blocks in parallel")
+    args = parser.parse_args(argv)
+
+    save_benchmark(
+        objects=args.objects,
+        verts=args.verts,
+        repeat=args.repeat,
+        save_path=args.save_path,
+        compress=args.compress,
+        use_threads=args.use_threads,
+    )
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,114 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Files saved with data-blocks written in parallel must be the same, byte for
+byte, as files saved sequentially.
+
+Files store memory addresses, so both are saved by the same session, the
+default sequential save is compared with a save using 'use_threads' (the
+same as saving with '--threads 1', without a second session). Run with more
+than one thread so data-blocks are written in parallel:
+
+./blender.bin --background --factory-startup --threads 4 --python tests/python/bl_blendfile_save_parallel.py
+"""
+
+import os
+import tempfile
+import unittest
+
+import bpy
+
+OBJECTS_NUM = 300
+
+
+def scene_create():
+    bpy.ops.wm.read_factory_settings(use_empty=True)
+    scene = bpy.context.scene
+    collection = bpy.data.collections.new("Collection")
+    scene.collection.children.link(collection)
+    material = bpy.data.materials.new("Material")
+    for i in range(OBJECTS_NUM):
+        mesh = bpy.data.meshes.new("Mesh")
+        mesh.vertices.add(i % 50)
+        mesh.vertices.foreach_set("co", [float((i * j) % 97) for j in range(len(mesh.vertices) * 3)])
+        if i % 3 == 0:
+            mesh.materials.append(material)
+        ob = bpy.data.objects.new("Object", mesh)
+        ob.location = (i, -i, i * 0.5)
+        (collection if i % 2 else scene.collection).objects.link(ob)
+    # Not saved, since it has no users.
+    bpy.data.meshes.new("Unused")
+
+
+class TestBlendFileSaveParallel(unittest.TestCase):
+
+    def setUp(self):
+        self.tempdir = tempfile.TemporaryDirectory()
+        self.filepath = os.path.join(self.tempdir.name, "parallel.blend")
+
+    def tearDown(self):
+        self.tempdir.cleanup()
+
+    def save(self, use_threads, compress):
+        bpy.ops.wm.save_as_mainfile(filepath=self.filepath, compress=compress, copy=True, use_threads=use_threads)
+        with open(self.filepath, "rb") as fh:
+            return fh.read()
+
+    def check_save(self, compress):
+        # Saving adds a notifier to the window manager queue, which is written
+        # with it, save once so the queue is the same for both saves.
+        self.save(False, compress)
+        data_sequential = self.save(False, compress)
+        data_parallel = self.save(True, compress)
+        if data_parallel != data_sequential:
+            offset = next(i for i, (a, b) in enumerate(zip(data_parallel, data_sequential)) if a != b)
+            self.fail("Parallel save differs at byte %d (%d bytes, %d sequentially)" % (
+                offset, len(data_parallel), len(data_sequential)))
+
+    def test_uncompressed(self):
+        scene_create()
+        self.check_save(compress=False)
+
+    def test_compressed(self):
+        scene_create()
+        self.check_save(compress=True)
+
+    def test_memfile_undo(self):
+        # Data read back from undo steps saves the same either way.
+        scene_create()
+        for _ in range(2):
+            x = bpy.data.objects[0].location.x
+            bpy.ops.ed.undo_push(message="Initial")
+            for ob in bpy.data.objects:
+                ob.location.x += 100.0
+            bpy.ops.ed.undo_push(message="Move")
+            bpy.ops.ed.undo()
+            self.assertEqual(bpy.data.objects[0].location.x, x)
+            self.check_save(compress=False)
+            bpy.ops.ed.redo()
+            self.assertEqual(bpy.data.objects[0].location.x, x + 100.0)
+            self.check_save(compress=True)
+
+
+if __name__ == '__main__':
+    import sys
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()
@@ -0,0 +1,159 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Play back an animated scene with frames evaluated ahead in the background,
+and compare evaluated transforms with the ones of playback without.
+
+./blender.bin --background --factory-startup --python tests/python/bl_depsgraph_lookahead.py
+"""
+
+import unittest
+
+import bpy
+
+FRAME_START = 1
+FRAME_END = 24
+# Enough geometry for frames to take longer to evaluate than copies of the
+# dependency graph take to build, so more than one copy is used.
+GRID_SIZE = 32
+ARRAY_COUNT = 32
+
+
+def scene_create():
+    bpy.ops.wm.read_factory_settings(use_empty=True)
+    scene = bpy.context.scene
+    scene.frame_start = FRAME_START
+    scene.frame_end = FRAME_END
+
+    def object_new(name, data=None):
+        ob = bpy.data.objects.new(name, data)
+        scene.collection.objects.link(ob)
+        return ob
+
+    # Keyframed parent and child.
+    parent = object_new("Parent")
+    for frame, location, angle in ((FRAME_START, (0.0, 0.0, 0.0), 0.0),
+                                   (FRAME_END, (4.0, -2.0, 1.0), 3.0)):
+        parent.location = location
+        parent.rotation_euler.z = angle
+        parent.keyframe_insert("location", frame=frame)
+        parent.keyframe_insert("rotation_euler", frame=frame)
+    child = object_new("Child")
+    child.parent = parent
+    child.location = (1.0, 0.0, 0.0)
+
+    # Driver reading the animated parent.
+    driven = object_new("Driven")
+    fcurve = driven.driver_add("scale", 2)
+    fcurve.driver.type = 'SCRIPTED'
+    fcurve.driver.expression = "1.0 + var"
+    var = fcurve.driver.variables.new()
+    var.type = 'TRANSFORMS'
+    var.targets[0].id = parent
+    var.targets[0].transform_type = 'LOC_X'
+
+    # Constraint and modifier depending on animated objects.
+    tracker = object_new("Tracker")
+    tracker.location = (0.0, 5.0, 0.0)
+    con = tracker.constraints.new('TRACK_TO')
+    con.target = child
+    mesh = bpy.data.meshes.new("Mesh")
+    verts = [(x / GRID_SIZE, y / GRID_SIZE, 0.0) for y in range(GRID_SIZE) for x in range(GRID_SIZE)]
+    faces = [(y * GRID_SIZE + x, y * GRID_SIZE + x + 1, (y + 1) * GRID_SIZE + x + 1, (y + 1) * GRID_SIZE + x)
+             for y in range(GRID_SIZE - 1) for x in range(GRID_SIZE - 1)]
+    mesh.from_pydata(verts, [], faces)
+    arrayed = object_new("Arrayed", mesh)
+    mod = arrayed.modifiers.new("Array", 'ARRAY')
+    mod.use_relative_offset = False
+    mod.use_object_offset = True
+    mod.offset_object = child
+    mod.count = ARRAY_COUNT
+    return scene
+
+
+def playback_frames():
+    """
+    Frames as set during playback: two loops around the range, a jump to
+    another frame, and playing backwards.
+    """
+    frames = list(range(FRAME_START, FRAME_END + 1)) * 2
+    frames += list(range(8, 16))
+    frames += list(range(16, FRAME_START - 1, -1))
+    return frames
+
+
+def evaluated_state(depsgraph):
+    state = {}
+    for ob in bpy.context.scene.objects:
+        ob_eval = depsgraph.id_eval_get(ob)
+        state[ob.name] = [tuple(row) for row in ob_eval.matrix_world]
+        if ob.type == 'MESH':
+            # Evaluated objects use the mesh with modifiers applied.
+            vertices = ob_eval.data.vertices
+            state[ob.name + " vertices"] = [(len(vertices), 0.0, 0.0), tuple(vertices[-1].co)]
+            state[ob.name + " bounds"] = [tuple(co) for co in ob_eval.bound_box]
+    return state
+
+
+def play(lookahead_frames, memory_limit=1024):
+    scene = scene_create()
+    depsgraph = bpy.context.depsgraph
+    bpy.context.view_layer.update()
+    if lookahead_frames:
+        depsgraph.debug_lookahead_enable(lookahead_frames, memory_limit=memory_limit)
+    states = []
+    for frame in playback_frames():
+        scene.frame_set(frame)
+        states.append((frame, evaluated_state(depsgraph)))
+    if lookahead_frames:
+        depsgraph.debug_lookahead_disable()
+    return states
+
+
+class TestDepsgraphLookahead(unittest.TestCase):
+
+    def check_playback(self, lookahead_frames, memory_limit=1024):
+        states_expected = play(0)
+        states = play(lookahead_frames, memory_limit)
+        self.assertEqual(len(states), len(states_expected))
+        self.assertEqual(states_expected[0][1]["Arrayed vertices"][0][0], GRID_SIZE * GRID_SIZE * ARRAY_COUNT)
+        for (frame, state), (_, state_expected) in zip(states, states_expected):
+            self.assertEqual(state.keys(), state_expected.keys())
+            for name, value in state.items():
+                for row, row_expected in zip(value, state_expected[name]):
+                    for a, b in zip(row, row_expected):
+                        self.assertAlmostEqual(a, b, places=5, msg="%s at frame %d" % (name, frame))
+
+    def test_one_frame(self):
+        self.check_playback(1)
+
+    def test_several_frames(self):
+        self.check_playback(4)
+
+    def test_memory_limit(self):
+        # Less than a single copy uses, copies are freed once evaluated.
+        self.check_playback(4, memory_limit=1)
+
+
+if __name__ == '__main__':
+    import sys
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()
@@ -0,0 +1,113 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Edit modifiers and constraints, which rebuilds relations of the edited
+objects only, and check the dependency graph against a full rebuild.
+
+Differences are reported on stderr by --debug-depsgraph-validate, the test
+is registered to fail on them.
+
+./blender.bin --background --factory-startup --debug-depsgraph-validate \
+    --python tests/python/bl_depsgraph_partial_rebuild.py
+"""
+
+import unittest
+
+import bpy
+
+
+class TestDepsgraphPartialRebuild(unittest.TestCase):
+
+    def setUp(self):
+        bpy.ops.wm.read_factory_settings(use_empty=True)
+        self.scene = bpy.context.scene
+        self.view_layer = bpy.context.view_layer
+        self.target = self.object_new("Target", None)
+        self.target.location = (1.0, 2.0, 3.0)
+        self.mesh = self.object_new("Mesh", bpy.data.meshes.new("Mesh"))
+        self.follower = self.object_new("Follower", None)
+        # Scene driver reading the object which is edited.
+        self.scene["driven"] = 0.0
+        fcurve = self.scene.driver_add('["driven"]')
+        fcurve.driver.type = 'SUM'
+        var = fcurve.driver.variables.new()
+        var.type = 'TRANSFORMS'
+        var.targets[0].id = self.follower
+        var.targets[0].transform_type = 'LOC_Z'
+        self.update()
+
+    def object_new(self, name, data):
+        ob = bpy.data.objects.new(name, data)
+        self.scene.collection.objects.link(ob)
+        return ob
+
+    def update(self):
+        self.view_layer.update()
+
+    def evaluated_follower_location(self):
+        depsgraph = bpy.context.depsgraph
+        return tuple(depsgraph.id_eval_get(self.follower).matrix_world.translation)
+
+    def test_modifiers(self):
+        mod = self.mesh.modifiers.new("Array", 'ARRAY')
+        self.update()
+        mod.use_object_offset = True
+        mod.offset_object = self.target
+        self.update()
+        mod.offset_object = self.follower
+        self.update()
+        mod = self.mesh.modifiers.new("Hook", 'HOOK')
+        mod.object = self.target
+        self.update()
+        self.mesh.modifiers.remove(mod)
+        self.update()
+        self.mesh.modifiers.clear()
+        self.update()
+
+    def test_constraints(self):
+        con = self.follower.constraints.new('COPY_LOCATION')
+        self.update()
+        con.target = self.target
+        self.update()
+        self.assertEqual(self.evaluated_follower_location(), (1.0, 2.0, 3.0))
+        con.target = self.mesh
+        self.update()
+        self.assertEqual(self.evaluated_follower_location(), (0.0, 0.0, 0.0))
+        self.follower.constraints.remove(con)
+        self.update()
+
+    def test_constraints_cycle(self):
+        con = self.follower.constraints.new('COPY_LOCATION')
+        con.target = self.target
+        self.update()
+        # Introduce a dependency cycle and break it again.
+        con = self.target.constraints.new('COPY_ROTATION')
+        con.target = self.follower
+        self.update()
+        self.target.constraints.remove(con)
+        self.update()
+        self.assertEqual(self.evaluated_follower_location(), (1.0, 2.0, 3.0))
+
+
+if __name__ == '__main__':
+    import sys
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()
@@ -0,0 +1,137 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Edit original meshes after they have been evaluated, evaluated meshes might
+share their layers with the original and must not see the edits until the
+next update.
+
+./blender.bin --background --factory-startup --python tests/python/bl_mesh_evaluated_sharing.py
+"""
+
+import os
+import tempfile
+import unittest
+
+import bpy
+from mathutils import Matrix
+
+
+def mesh_coords(mesh):
+    coords = [0.0] * (len(mesh.vertices) * 3)
+    mesh.vertices.foreach_get("co", coords)
+    return coords
+
+
+def mesh_new(name):
+    mesh = bpy.data.meshes.new(name)
+    mesh.from_pydata([(0.0, 0.0, 0.0), (1.0, 0.0, 0.0), (1.0, 1.0, 0.0), (0.0, 1.0, 0.0)], [], [(0, 1, 2, 3)])
+    return mesh
+
+
+class TestMeshEvaluatedSharing(unittest.TestCase):
+
+    def setUp(self):
+        self.tempdir = tempfile.TemporaryDirectory()
+
+    def tearDown(self):
+        self.tempdir.cleanup()
+
+    def object_link(self, ob):
+        bpy.context.scene.collection.objects.link(ob)
+        bpy.context.view_layer.update()
+
+    def mesh_eval(self, mesh):
+        return bpy.context.depsgraph.id_eval_get(mesh)
+
+    def check_edit(self, mesh, edit):
+        """
+        Run ``edit`` on the original ``mesh``, the evaluated mesh is only
+        expected to change after updating.
+        """
+        coords_orig = mesh_coords(mesh)
+        self.assertEqual(mesh_coords(self.mesh_eval(mesh)), coords_orig)
+
+        edit(mesh)
+        coords_edit = mesh_coords(mesh)
+        self.assertNotEqual(coords_edit, coords_orig)
+        self.assertEqual(mesh_coords(self.mesh_eval(mesh)), coords_orig)
+
+        mesh.update()
+        bpy.context.view_layer.update()
+        self.assertEqual(mesh_coords(self.mesh_eval(mesh)), coords_edit)
+
+    def test_local(self):
+        bpy.ops.wm.read_factory_settings(use_empty=True)
+        mesh = mesh_new("Mesh")
+        self.object_link(bpy.data.objects.new("Object", mesh))
+
+        def edit(mesh):
+            mesh.vertices[0].co = (2.0, 3.0, 4.0)
+
+        def edit_foreach(mesh):
+            mesh.vertices.foreach_set("co", [value + 1.0 for value in mesh_coords(mesh)])
+
+        self.check_edit(mesh, edit)
+        self.check_edit(mesh, edit_foreach)
+        self.check_edit(mesh, lambda mesh: mesh.transform(Matrix.Translation((1.0, 0.0, 0.0))))
+
+    def test_local_vertex_colors(self):
+        bpy.ops.wm.read_factory_settings(use_empty=True)
+        mesh = mesh_new("Mesh")
+        mesh.vertex_colors.new(name="Col")
+        self.object_link(bpy.data.objects.new("Object", mesh))
+
+        def colors(mesh):
+            return [tuple(loop_col.color) for loop_col in mesh.vertex_colors["Col"].data]
+
+        colors_orig = colors(mesh)
+        mesh.vertex_colors["Col"].data[0].color = (0.0, 0.0, 0.0, 1.0)
+        colors_edit = colors(mesh)
+        self.assertNotEqual(colors_edit, colors_orig)
+        self.assertEqual(colors(self.mesh_eval(mesh)), colors_orig)
+
+        mesh.update()
+        bpy.context.view_layer.update()
+        self.assertEqual(colors(self.mesh_eval(mesh)), colors_edit)
+
+    def test_linked(self):
+        bpy.ops.wm.read_factory_settings(use_empty=True)
+        ob = bpy.data.objects.new("LibObject", mesh_new("LibMesh"))
+        bpy.context.scene.collection.objects.link(ob)
+        filepath = os.path.join(self.tempdir.name, "library.blend")
+        bpy.ops.wm.save_as_mainfile(filepath=filepath, check_existing=False)
+
+        bpy.ops.wm.read_factory_settings(use_empty=True)
+        with bpy.data.libraries.load(filepath, link=True) as (data_from, data_to):
+            data_to.objects = ["LibObject"]
+        ob = data_to.objects[0]
+        self.object_link(ob)
+        mesh = ob.data
+        self.assertIsNotNone(mesh.library)
+
+        self.check_edit(mesh, lambda mesh: mesh.transform(Matrix.Translation((1.0, 0.0, 0.0))))
+        self.check_edit(mesh, lambda mesh: mesh.transform(Matrix.Scale(2.0, 4)))
+
+
+if __name__ == '__main__':
+    import sys
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()
@@ -0,0 +1,217 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Edit one object among several, then undo and redo. Data-blocks which didn't
+change are reused by memfile undo instead of being read again, the data and
+the ID pointers between data-blocks must be the same as before.
+
+./blender.bin --background --factory-startup --python tests/python/bl_undo_memfile_reuse.py
+"""
+
+import unittest
+
+import bpy
+
+OBJECTS_NUM = 8
+
+
+def mesh_coords(mesh):
+    coords = [0.0] * (len(mesh.vertices) * 3)
+    mesh.vertices.foreach_get("co", coords)
+    return coords
+
+
+def scene_create():
+    bpy.ops.wm.read_factory_settings(use_empty=True)
+    scene = bpy.context.scene
+    material = bpy.data.materials.new("Material")
+    parent = None
+    for i in range(OBJECTS_NUM):
+        mesh = bpy.data.meshes.new("Mesh.%d" % i)
+        mesh.from_pydata([(i, 0.0, 0.0), (i, 1.0, 0.0), (i, 1.0, 1.0)], [], [(0, 1, 2)])
+        mesh.materials.append(material)
+        ob = bpy.data.objects.new("Object.%d" % i, mesh)
+        ob.location = (0.0, i, 0.0)
+        ob.parent = parent
+        if parent is not None:
+            mod = ob.modifiers.new("Hook", 'HOOK')
+            mod.object = parent
+        ob.shape_key_add(name="Basis")
+        scene.collection.objects.link(ob)
+        parent = ob
+    bpy.context.view_layer.update()
+
+
+def scene_state():
+    """
+    Data of all objects and meshes, and the data-blocks they point to.
+    """
+    state = {}
+    for ob in bpy.data.objects:
+        mod = ob.modifiers.get("Hook")
+        state[ob.name] = (
+            tuple(ob.location),
+            ob.data.name,
+            ob.parent.name if ob.parent else None,
+            mod.object.name if mod else None,
+        )
+    for mesh in bpy.data.meshes:
+        state[mesh.name] = (
+            mesh_coords(mesh),
+            [mat.name for mat in mesh.materials],
+            mesh.shape_keys.name if mesh.shape_keys else None,
+            mesh.shape_keys.user.name if mesh.shape_keys else None,
+        )
+    return state
+
+
+def scene_evaluated_state():
+    """
+    Evaluated geometry and transform of all objects.
+    """
+    bpy.context.view_layer.update()
+    depsgraph = bpy.context.depsgraph
+    state = {}
+    for ob in bpy.data.objects:
+        ob_eval = depsgraph.id_eval_get(ob)
+        state[ob.name] = (mesh_coords(ob_eval.data), [tuple(row) for row in ob_eval.matrix_world])
+    return state
+
+
+def scene_id_pointers():
+    """
+    ID addresses, and the ones of the data-blocks they point to.
+    """
+    pointers = {}
+    for ob in bpy.data.objects:
+        mod = ob.modifiers.get("Hook")
+        pointers[ob.name] = (
+            ob.as_pointer(),
+            ob.data.as_pointer(),
+            ob.parent.as_pointer() if ob.parent else 0,
+            mod.object.as_pointer() if mod else 0,
+        )
+    for mesh in bpy.data.meshes:
+        pointers[mesh.name] = (
+            mesh.as_pointer(),
+            mesh.materials[0].as_pointer(),
+            mesh.shape_keys.as_pointer(),
+            mesh.shape_keys.user.as_pointer(),
+        )
+    return pointers
+
+
+def scene_full_state():
+    return scene_state(), scene_id_pointers(), scene_evaluated_state()
+
+
+def id_addresses(pointers):
+    return {name: id_pointers[0] for name, id_pointers in pointers.items()}
+
+
+class TestUndoMemfileReuse(unittest.TestCase):
+
+    def setUp(self):
+        scene_create()
+        bpy.ops.ed.undo_push(message="Initial")
+
+    def check_state(self, full_state):
+        state, pointers, evaluated_state = full_state
+        self.assertEqual(scene_state(), state)
+        self.assertEqual(scene_id_pointers(), pointers)
+        # Evaluated data is updated from the restored data.
+        self.assertEqual(scene_evaluated_state(), evaluated_state)
+
+    def vertices_pointers(self):
+        # Mesh layers are reallocated when accessed while shared with the evaluated mesh,
+        # the shape key data is only ever owned by the original.
+        return {
+            mesh.name: mesh.shape_keys.key_blocks["Basis"].data[0].as_pointer()
+            for mesh in bpy.data.meshes
+        }
+
+    def check_edit(self, edit):
+        full_state_initial = scene_full_state()
+        edit()
+        bpy.ops.ed.undo_push(message="Edit")
+        full_state_edit = scene_full_state()
+        self.assertNotEqual(full_state_edit[0], full_state_initial[0])
+        self.assertNotEqual(full_state_edit[2], full_state_initial[2])
+        # Data-blocks keep their address.
+        self.assertEqual(id_addresses(full_state_edit[1]), id_addresses(full_state_initial[1]))
+
+        vertices_pointers = self.vertices_pointers()
+        bpy.ops.ed.undo()
+        self.check_state(full_state_initial)
+        bpy.ops.ed.redo()
+        self.check_state(full_state_edit)
+        return vertices_pointers
+
+    def test_edit_mesh(self):
+        mesh = bpy.data.meshes["Mesh.3"]
+
+        def edit():
+            # Evaluated meshes use the coordinates of the basis shape key.
+            mesh.vertices[0].co = (10.0, 20.0, 30.0)
+            mesh.shape_keys.key_blocks["Basis"].data[0].co = (10.0, 20.0, 30.0)
+            mesh.update()
+
+        vertices_pointers = self.check_edit(edit)
+        # Meshes which didn't change keep their data.
+        for name, pointer in self.vertices_pointers().items():
+            if name != "Mesh.3":
+                self.assertEqual(pointer, vertices_pointers[name], name)
+
+    def test_edit_object(self):
+        ob = bpy.data.objects["Object.5"]
+
+        def edit():
+            ob.location.z = 4.0
+            ob.modifiers["Hook"].object = bpy.data.objects["Object.0"]
+
+        vertices_pointers = self.check_edit(edit)
+        self.assertEqual(self.vertices_pointers(), vertices_pointers)
+
+    def test_edit_several_steps(self):
+        full_state_initial = scene_full_state()
+        full_states = []
+        for i in range(3):
+            mesh = bpy.data.meshes["Mesh.%d" % i]
+            mesh.vertices[1].co.z = 5.0 + i
+            mesh.shape_keys.key_blocks["Basis"].data[1].co.z = 5.0 + i
+            mesh.update()
+            bpy.data.objects["Object.%d" % (OBJECTS_NUM - 1 - i)].location.x = 2.0 + i
+            bpy.ops.ed.undo_push(message="Edit %d" % i)
+            full_states.append(scene_full_state())
+        for full_state in reversed(full_states[:-1]):
+            bpy.ops.ed.undo()
+            self.check_state(full_state)
+        bpy.ops.ed.undo()
+        self.check_state(full_state_initial)
+        for full_state in full_states:
+            bpy.ops.ed.redo()
+            self.check_state(full_state)
+
+
+if __name__ == '__main__':
+    import sys
+    sys.argv = [__file__] + (sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else [])
+    unittest.main()